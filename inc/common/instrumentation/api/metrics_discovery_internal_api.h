@@ -174,6 +174,52 @@ namespace MetricsDiscovery
         CONFIG_TYPE_QUERY,
     } TConfigType;
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // Internal IoStream read flags, may be combined with TIoReadFlag:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef enum EIoReadFlagInternal
+    {
+        IO_READ_FLAG_ADAPTIVE = 0x00010000, // Read size and batching driven by the observed report rate, see TIoStreamReadPolicyParams
+    } TIoReadFlagInternal;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream group read backends:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef enum EIoStreamGroupBackend
+    {
+        IO_STREAM_GROUP_BACKEND_POLL = 0, // Wait for all streams, then read each ready stream
+        IO_STREAM_GROUP_BACKEND_IO_URING, // Poll and read of all streams submitted and completed in batches
+    } TIoStreamGroupBackend;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream delivery modes:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef enum EIoStreamDeliveryMode
+    {
+        IO_STREAM_DELIVERY_MODE_RAW = 0,    // Batches of raw reports
+        IO_STREAM_DELIVERY_MODE_CALCULATED, // Batches of raw reports and calculated reports
+    } TIoStreamDeliveryMode;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream delivery executors:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef enum EIoStreamDeliveryExecutor
+    {
+        IO_STREAM_DELIVERY_EXECUTOR_PIPELINED = 0, // Reads on one thread, calculation and callbacks on another
+        IO_STREAM_DELIVERY_EXECUTOR_SINGLE_THREAD, // Reads, calculation and callbacks on a single thread
+    } TIoStreamDeliveryExecutor;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream delivery overflow policies, pipelined executor only:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef enum EIoStreamDeliveryOverflowPolicy
+    {
+        IO_STREAM_DELIVERY_OVERFLOW_BLOCK = 0,   // Reading waits for a free buffer, the OA buffer keeps the backlog
+        IO_STREAM_DELIVERY_OVERFLOW_DROP_OLDEST, // The oldest batch not delivered yet is dropped
+        IO_STREAM_DELIVERY_OVERFLOW_DECIMATE,    // The batch being read keeps every DecimationFactor-th report until a buffer is free, then is dropped or written to OverflowCaptureFile
+        IO_STREAM_DELIVERY_OVERFLOW_CAPTURE,     // The batch being read is written to OverflowCaptureFile until a buffer is free
+    } TIoStreamDeliveryOverflowPolicy;
+
     ////////////////////////////////////////////////////////////////////////////////
     // Register:
     ////////////////////////////////////////////////////////////////////////////////
@@ -321,6 +367,430 @@ namespace MetricsDiscovery
         };
     } TAddCustomMetricParams;
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // Idle run information of a single calculated IoStream report:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIdleRunInfo
+    {
+        uint32_t RawReportCount; // Raw report intervals represented by the calculated report, 1 if not collapsed
+        uint64_t BeginTimestamp; // In ns, 0 if the metric set has no QueryBeginTime information
+        uint64_t EndTimestamp;   // In ns, 0 if the metric set has no QueryBeginTime information
+    } TIdleRunInfo;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Time series block information:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct STimeSeriesBlockInfo
+    {
+        uint64_t FirstTimestamp; // In ns, timestamp of the first row in the block
+        uint64_t LastTimestamp;  // In ns, timestamp of the last row in the block
+        uint32_t RowCount;
+        uint64_t Offset; // In bytes, from the beginning of the encoded data
+        uint64_t Size;   // In bytes
+    } TTimeSeriesBlockInfo;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Raw IoStream data of a single sub device for aggregated calculation:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SSubDeviceRawData
+    {
+        IMetricSetLatest* MetricSet; // The same metric set obtained from the sub device metrics device
+        const uint8_t*    RawData;
+        uint32_t          RawDataSize;
+    } TSubDeviceRawData;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Contiguous run of raw IoStream reports placed in the internal read buffer:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamSpan
+    {
+        const uint8_t* Data;        // First raw report
+        uint32_t       Stride;      // In bytes, distance between raw reports, includes driver record header
+        uint32_t       ReportCount; // Raw reports in the span
+    } TIoStreamSpan;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Raw IoStream reports read without copying, valid until the next read or stream close:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamView
+    {
+        const TIoStreamSpan* Spans;
+        uint32_t             SpanCount;
+        uint32_t             ReportCount; // Raw reports in all spans
+    } TIoStreamView;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Background IoStream reader parameters, applied on the next OpenIoStream:
+    ////////////////////////////////////////////////////////////////////////////////
+    #define MD_IO_STREAM_READER_CPU_AFFINITY_DEVICE -2 // Reader thread runs on CPUs local to the device
+
+    typedef struct SIoStreamReaderParams
+    {
+        bool     Enabled;         // Drain the stream in a background thread, ReadIoStream reads from the ring
+        uint32_t RingReportCount; // Ring capacity in reports, 0 means default
+        int32_t  CpuAffinity;     // CPU the reader thread is bound to, -1 means no affinity, see MD_IO_STREAM_READER_CPU_AFFINITY_DEVICE
+        int32_t  Priority;        // Nice value of the reader thread, 0 means inherited
+    } TIoStreamReaderParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Adaptive IoStream read parameters, used with IO_READ_FLAG_ADAPTIVE:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamReadPolicyParams
+    {
+        uint32_t MinBatchReportCount; // Reads are coalesced until this many reports are read, 0 means default
+        uint32_t MaxLatencyMs;        // Coalescing deadline in milliseconds, 0 means default
+        uint32_t MaxReadSize;         // In bytes, cap of a single read, 0 means default
+    } TIoStreamReadPolicyParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Adaptive IoStream sampling period parameters:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamSamplingControlParams
+    {
+        bool     Enabled;           // Reopen the stream with a longer or shorter sampling period depending on the OA buffer fill level
+        uint32_t MinNsTimerPeriod;  // Lower bound of the sampling period, 0 means the period the stream was opened with
+        uint32_t MaxNsTimerPeriod;  // Upper bound of the sampling period, 0 means default
+        uint32_t TargetFillPercent; // OA buffer fill level kept by the controller, 0 means default
+    } TIoStreamSamplingControlParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream poll parameters, applied on the next OpenIoStream:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamPollParams
+    {
+        bool     Automatic;    // Choose the poll period from the sampling period, OA buffer size and MaxLatencyMs
+        uint32_t PollPeriodNs; // Period the kernel checks the OA buffer for reports with, 0 means kernel default, ignored if Automatic
+        uint32_t MaxLatencyMs; // Automatic choice only, longest delay between a report and the reader wakeup, 0 means default
+    } TIoStreamPollParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream OA buffer parameters, applied on the next OpenIoStream:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamOaBufferParams
+    {
+        bool     Automatic;       // Choose the OA buffer size from the sampling period, report size and DrainIntervalMs, OpenIoStream size is ignored
+        uint32_t DrainIntervalMs; // Automatic choice only, longest expected time between reads, 0 means default
+    } TIoStreamOaBufferParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Reports of a single stream read by an IoStream group:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamGroupRead
+    {
+        IConcurrentGroupLatest* ConcurrentGroup;
+        TIoStreamView           View;   // Valid until the next read of the stream
+        TCompletionCode         Result; // Result of the stream read, as from ReadIoStreamView
+    } TIoStreamGroupRead;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream merger parameters:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamMergerParams
+    {
+        uint32_t SourceReportCount; // Raw reports buffered per source stream, 0 means default
+        uint32_t ToleranceNs;       // Longest delay of a report becoming readable after its timestamp, 0 means default
+    } TIoStreamMergerParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Raw IoStream report placed on the merged timeline:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamMergedReport
+    {
+        uint32_t          SourceIndex; // Source stream, in AddSource order
+        uint64_t          TimestampNs; // Report timestamp converted to CPU time, common to all source streams
+        const uint8_t*    Data;        // Raw report, valid until the next ReadReports
+        uint32_t          DataSize;    // Raw report size in bytes
+        IMetricSetLatest* MetricSet;   // Metric set the report was sampled with, follows metric set switches
+    } TIoStreamMergedReport;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Metric set switch of an opened IoStream, the first one is the stream open:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamMetricSetSwitch
+    {
+        IMetricSetLatest* MetricSet;       // Metric set of reports from the switch on
+        uint64_t          GpuTimestamp;    // Raw report timestamp ticks right before the switch, extended past 32 bit wraps since the first switch, 0 for the stream open
+        uint64_t          GpuTimestampEnd; // Raw report timestamp ticks right after the switch, reports in between have no metric set, 0 for the stream open
+        uint64_t          CpuTimestampNs;  // CPU time of the switch, 0 for the stream open
+    } TIoStreamMetricSetSwitch;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream health statistics, cumulative since the stream was opened or reset:
+    ////////////////////////////////////////////////////////////////////////////////
+    #define MD_IO_STREAM_DRAIN_HISTOGRAM_SIZE 24
+
+    typedef struct SIoStreamStatistics
+    {
+        uint64_t ReadCount;          // Driver reads, including empty ones
+        uint64_t ReportCount;        // Reports read
+        uint64_t ByteCount;          // Raw report bytes read
+        uint64_t ReportLostCount;    // Reads signaling lost reports
+        uint64_t BufferLostCount;    // Reads signaling OA buffer overflow or overrun
+        uint64_t MaxBacklogNs;       // Longest time span of reports drained by a single read, from report timestamps
+        uint64_t ReadLatencyTotalNs; // Time spent in driver reads
+        uint64_t ReadLatencyMaxNs;
+        uint64_t DrainIntervalHistogram[MD_IO_STREAM_DRAIN_HISTOGRAM_SIZE]; // Time between reads returning reports, bucket i counts [2^i, 2^(i+1)) us, the last one above
+    } TIoStreamStatistics;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream capture parameters:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamCaptureParams
+    {
+        uint32_t WriteSize; // In bytes, size of a single sequential write, 0 means default
+        bool     DirectIo;  // Bypass the page cache (O_DIRECT), ignored if not supported by the file system
+        bool     Compress;  // Lossless delta encoding of reports, ignored if not supported by the report layout
+    } TIoStreamCaptureParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream capture file description:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamCaptureInfo
+    {
+        const char* ConcurrentGroupName;
+        const char* MetricSetName;
+        uint32_t    PlatformIndex;
+        uint32_t    RawReportSize;
+        uint32_t    ReportType;       // Raw report layout, TReportType
+        uint32_t    CoreFrequencyMhz; // Last core frequency reported while capturing
+        uint64_t    ReportCount;
+        uint64_t    DataSize;   // In bytes, stored reports
+        bool        Compressed; // Reports are delta encoded
+    } TIoStreamCaptureInfo;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Batch of IoStream reports delivered to the callback, valid until the callback returns:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamDeliveryBatch
+    {
+        IMetricSetLatest*      MetricSet;            // Metric set all reports of the batch were sampled with
+        uint64_t               SequenceNumber;       // Batch number, from 0
+        TCompletionCode        Result;               // *CC_OK*, or the stream read error the delivery stopped on
+        const uint8_t*         RawData;              // Raw reports
+        uint32_t               RawReportCount;       // Raw reports in the batch
+        uint32_t               RawReportSize;        // In bytes
+        const TTypedValue_1_0* Values;               // Calculated mode only, calculated reports of MetricsCount + InformationCount values
+        uint32_t               ValueReportCount;     // Calculated reports, RawReportCount or one less for the first batch after a gap or a metric set switch
+        uint64_t               LostReportCount;      // Reports dropped or captured right before this batch, the batch starts after a gap if not 0
+        uint32_t               DecimatedReportCount; // Reports removed from the batch by decimation, deltas of the kept ones span them
+    } TIoStreamDeliveryBatch;
+
+    typedef void ( *TIoStreamDeliveryCallback )( const TIoStreamDeliveryBatch* batch, void* userData );
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream delivery parameters:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamDeliveryParams
+    {
+        TIoStreamDeliveryMode     Mode;
+        TIoStreamDeliveryCallback Callback;
+        void*                     UserData;         // Passed to the callback
+        uint32_t                  BatchReportCount; // Reports delivered at once, 0 means default
+        uint32_t                  MaxLatencyMs;     // Longest delay of a report delivery in a partial batch, 0 means default
+        TIoStreamDeliveryExecutor Executor;
+        uint32_t                  QueueDepth; // Pipelined executor only, batch buffers shared by read, calculation and callback stages, 0 means default
+
+        TIoStreamDeliveryOverflowPolicy OverflowPolicy;      // Applied when all batch buffers are in use
+        uint32_t                        DecimationFactor;    // Decimate policy only, 0 means default
+        const char*                     OverflowCaptureFile; // Capture policy, or decimate policy once decimation cannot make room, open later with IInternalMetricsDevice::OpenIoStreamCapture
+    } TIoStreamDeliveryParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // IoStream delivery statistics, since the delivery was started:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamDeliveryStatistics
+    {
+        uint32_t BufferCount;             // Batch buffers shared by all stages
+        uint32_t CalculateQueueOccupancy; // Batches read, waiting for calculation
+        uint32_t CalculateQueueMaxOccupancy;
+        uint32_t ExportQueueOccupancy;    // Batches calculated, waiting for the callback
+        uint32_t ExportQueueMaxOccupancy;
+        uint64_t ReadReportCount;         // Reports read from the stream
+        uint64_t DeliveredBatchCount;
+        uint64_t DeliveredReportCount;
+        uint64_t OverflowCount;           // Times all batch buffers were in use when reading needed one
+        uint64_t BlockedTimeNs;           // Time reading waited for a free buffer
+        uint64_t DroppedBatchCount;
+        uint64_t DroppedReportCount;
+        uint64_t DecimatedReportCount;
+        uint64_t CapturedReportCount;
+    } TIoStreamDeliveryStatistics;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // GPU to CPU timestamp correlation model state:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct STimestampCorrelationInfo
+    {
+        uint32_t SampleCount;     // Paired GPU / CPU samples the model is fitted to
+        uint64_t LastSampleCpuNs; // CPU timestamp of the newest sample
+        double   NsPerGpuTick;    // Fitted GPU timestamp period, includes clock drift
+        uint64_t ErrorBoundNs;    // Largest distance of a sample from the model
+    } TTimestampCorrelationInfo;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Side-band sampler parameters:
+    ////////////////////////////////////////////////////////////////////////////////
+    #define MD_SIDE_BAND_ATTRIBUTE_COUNT_MAX 16
+
+    typedef struct SSideBandSamplerParams
+    {
+        uint32_t    PeriodUs;                                     // Sampling period, 0 means default
+        uint32_t    SampleCount;                                  // Samples kept, the oldest ones are overwritten, 0 means default
+        const char* Directory;                                    // Relative attributes are opened in, nullptr means the DRM card SysFs directory
+        uint32_t    AttributeCount;                               // 0 means the default attributes: actual frequency, RC6 residency, throttle reasons, energy
+        const char* Attributes[MD_SIDE_BAND_ATTRIBUTE_COUNT_MAX]; // SysFs / hwmon file paths, may contain glob patterns
+    } TSideBandSamplerParams;
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Single side-band sample:
+    ////////////////////////////////////////////////////////////////////////////////
+    typedef struct SSideBandSample
+    {
+        uint64_t CpuTimestampNs;                           // CLOCK_MONOTONIC time, as GPU timestamps converted by the timestamp correlation
+        uint32_t ValidMask;                                // Bit per attribute read successfully
+        uint64_t Values[MD_SIDE_BAND_ATTRIBUTE_COUNT_MAX]; // Attribute values, in the attribute order
+    } TSideBandSample;
+
+    /////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //   IInternalTimeSeries
+    //
+    // Description:
+    //   Abstract internal interface for compressed time series of calculated
+    //   IoStream reports. Rows are encoded in independent blocks, so each block
+    //   can be decoded separately.
+    //
+    /////////////////////////////////////////////////////////////////////////////
+    class IInternalTimeSeries
+    {
+    public:
+        virtual ~IInternalTimeSeries();
+        virtual uint32_t                    GetColumnCount( void );
+        virtual uint32_t                    GetRowCount( void );
+        virtual uint32_t                    GetBlockCount( void );
+        virtual uint64_t                    GetEncodedSize( void );
+        virtual const TTimeSeriesBlockInfo* GetBlockInfo( uint32_t index );
+        virtual TCompletionCode             FindBlock( uint64_t timestamp, uint32_t* outIndex );
+        virtual TCompletionCode             DecodeBlock( uint32_t index, TTypedValue_1_0* out, uint32_t outSize, uint64_t* outTimestamps, uint32_t outTimestampsCount );
+        virtual TCompletionCode             Clear( void );
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //   IInternalIoStreamGroup
+    //
+    // Description:
+    //   Abstract internal interface for waiting on several opened IO streams,
+    //   possibly from different metrics devices, with a single call. Streams
+    //   are identified by concurrent groups used to open them. Streams should be
+    //   removed from the group before they are closed. ReadReports reads all ready
+    //   streams at once, streams in the group should not be read directly then.
+    //
+    /////////////////////////////////////////////////////////////////////////////
+    class IInternalIoStreamGroup
+    {
+    public:
+        virtual ~IInternalIoStreamGroup();
+        virtual TCompletionCode AddStream( IConcurrentGroupLatest* concurrentGroup );
+        virtual TCompletionCode RemoveStream( IConcurrentGroupLatest* concurrentGroup );
+        virtual uint32_t        GetStreamCount( void );
+        virtual TCompletionCode WaitForReports( uint32_t milliseconds, IConcurrentGroupLatest** outReadyGroups, uint32_t outReadyGroupsCount, uint32_t* outReadyCount );
+        virtual TCompletionCode SetReadBackend( TIoStreamGroupBackend backend );
+        virtual TCompletionCode ReadReports( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount );
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //   IInternalIoStreamMerger
+    //
+    // Description:
+    //   Abstract internal interface for merging opened IO streams, possibly from
+    //   different metrics devices, into a single time ordered sequence of raw
+    //   reports. Report timestamps of every stream are converted to CPU time with
+    //   the timestamp correlation of its metrics device. Streams in the merger
+    //   should not be read directly.
+    //
+    /////////////////////////////////////////////////////////////////////////////
+    class IInternalIoStreamMerger
+    {
+    public:
+        virtual ~IInternalIoStreamMerger();
+        virtual TCompletionCode AddSource( IConcurrentGroupLatest* concurrentGroup, uint32_t* outSourceIndex );
+        virtual uint32_t        GetSourceCount( void );
+        virtual TCompletionCode ReadReports( TIoStreamMergedReport* outReports, uint32_t outReportsCount, uint32_t* outReportCount );
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //   IInternalIoStreamCapture
+    //
+    // Description:
+    //   Abstract internal interface for reading a raw IoStream capture file.
+    //   The captured metric set is recreated from the file together with
+    //   the global symbols of the captured device, so reports are calculated
+    //   as on the device they were captured on.
+    //
+    /////////////////////////////////////////////////////////////////////////////
+    class IInternalIoStreamCapture
+    {
+    public:
+        virtual ~IInternalIoStreamCapture();
+        virtual const TIoStreamCaptureInfo* GetInfo( void );
+        virtual IMetricSetLatest*           GetMetricSet( void );
+        virtual TCompletionCode             ReadReports( uint64_t firstReport, uint32_t* reportCount, uint8_t* out, uint32_t outSize );
+        virtual TCompletionCode             CalculateMetrics( uint64_t firstReport, uint32_t* reportCount, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //   IInternalSideBandSampler
+    //
+    // Description:
+    //   Abstract internal interface for sampling GPU state not present in OA
+    //   reports (actual frequency, RC6 residency, energy, throttle reasons)
+    //   from SysFs / hwmon files with a fixed period on a background thread.
+    //   Samples are timestamped with CPU time, so calculated report intervals
+    //   are joined with them through the timestamp correlation.
+    //
+    /////////////////////////////////////////////////////////////////////////////
+    class IInternalSideBandSampler
+    {
+    public:
+        virtual ~IInternalSideBandSampler();
+        virtual uint32_t        GetAttributeCount( void );
+        virtual const char*     GetAttributeName( uint32_t index );
+        virtual TCompletionCode Start( void );
+        virtual TCompletionCode Stop( void );
+        virtual TCompletionCode GetSamples( uint64_t beginCpuNs, uint64_t endCpuNs, TSideBandSample* outSamples, uint32_t* sampleCount );
+        virtual TCompletionCode GetSampleAt( uint64_t cpuTimestampNs, TSideBandSample* outSample );
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //   IInternalMetricsDevice
+    //
+    // Description:
+    //   Abstract internal interface for the GPU metrics root object.
+    //
+    /////////////////////////////////////////////////////////////////////////////
+    class IInternalMetricsDevice : public IMetricsDeviceLatest
+    {
+    public:
+        virtual ~IInternalMetricsDevice();
+        virtual TCompletionCode OpenIoStreamCapture( const char* fileName, IInternalIoStreamCapture** outCapture );
+        virtual TCompletionCode CloseIoStreamCapture( IInternalIoStreamCapture* capture );
+        virtual TCompletionCode UpdateTimestampCorrelation( bool force, TTimestampCorrelationInfo* outInfo );
+        virtual TCompletionCode ConvertGpuTimestampsToCpu( const uint64_t* gpuTimestamps, uint64_t* cpuTimestampsNs, uint32_t count );
+        virtual TCompletionCode CreateSideBandSampler( const TSideBandSamplerParams* params, IInternalSideBandSampler** outSampler );
+        virtual TCompletionCode DeleteSideBandSampler( IInternalSideBandSampler* sampler );
+    };
+
     /////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -335,7 +805,30 @@ namespace MetricsDiscovery
     {
     public:
         virtual ~IInternalConcurrentGroup();
-        virtual IMetricSetLatest* AddCustomMetricSet( TAddCustomMetricSetParams* params, IMetricSetLatest* referenceMetricSet, bool copyInformationOnly = false );
+        virtual IMetricSetLatest*        AddCustomMetricSet( TAddCustomMetricSetParams* params, IMetricSetLatest* referenceMetricSet, bool copyInformationOnly = false );
+        virtual TCompletionCode          ReadIoStreamView( uint32_t* reportCount, TIoStreamView* outView, uint32_t readFlags );
+        virtual TCompletionCode          SetIoStreamReaderParams( const TIoStreamReaderParams* params );
+        virtual TCompletionCode          SetIoStreamReadPolicy( const TIoStreamReadPolicyParams* params );
+        virtual TCompletionCode          SetIoStreamSamplingControl( const TIoStreamSamplingControlParams* params );
+        virtual TCompletionCode          SetIoStreamPollParams( const TIoStreamPollParams* params );
+        virtual TCompletionCode          SetIoStreamOaBufferParams( const TIoStreamOaBufferParams* params );
+        virtual IInternalIoStreamGroup*  CreateIoStreamGroup( void );
+        virtual TCompletionCode          DeleteIoStreamGroup( IInternalIoStreamGroup* streamGroup );
+        virtual IInternalIoStreamMerger* CreateIoStreamMerger( const TIoStreamMergerParams* params );
+        virtual TCompletionCode          DeleteIoStreamMerger( IInternalIoStreamMerger* streamMerger );
+        virtual TCompletionCode          StartIoStreamCapture( const char* fileName, const TIoStreamCaptureParams* params );
+        virtual TCompletionCode          StopIoStreamCapture( void );
+        virtual TCompletionCode          GetIoStreamStatistics( TIoStreamStatistics* outStatistics );
+        virtual TCompletionCode          ResetIoStreamStatistics( void );
+        virtual TCompletionCode          SwitchIoStreamMetricSet( IMetricSetLatest* metricSet );
+        virtual TCompletionCode          GetIoStreamMetricSetSwitches( TIoStreamMetricSetSwitch* outSwitches, uint32_t* switchCount );
+        virtual IMetricSetLatest*        GetIoStreamReportMetricSet( const uint8_t* rawReport );
+        virtual TCompletionCode          PauseIoStream( void );
+        virtual TCompletionCode          ResumeIoStream( void );
+        virtual TCompletionCode          SetIoStreamOpenPaused( bool openPaused );
+        virtual TCompletionCode          StartIoStreamDelivery( const TIoStreamDeliveryParams* params );
+        virtual TCompletionCode          StopIoStreamDelivery( void );
+        virtual TCompletionCode          GetIoStreamDeliveryStatistics( TIoStreamDeliveryStatistics* outStatistics );
     };
 
     /////////////////////////////////////////////////////////////////////////////**
@@ -354,7 +847,14 @@ namespace MetricsDiscovery
         using IMetricSet_1_0::AddCustomMetric; // To avoid hiding by 1.0 interface function
 
         virtual ~IInternalMetricSet();
-        virtual IMetricLatest* AddCustomMetric( TAddCustomMetricParams* params );
+        virtual IMetricLatest*       AddCustomMetric( TAddCustomMetricParams* params );
+        virtual TCompletionCode      CalculateMetricsCollapsed( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount );
+        virtual IInternalTimeSeries* CreateTimeSeries( uint32_t blockRowCount );
+        virtual TCompletionCode      DeleteTimeSeries( IInternalTimeSeries* timeSeries );
+        virtual TCompletionCode      CalculateMetricsEncoded( const uint8_t* rawData, uint32_t rawDataSize, IInternalTimeSeries* timeSeries, uint32_t* outReportCount );
+        virtual TCompletionCode      CalculateMetricsAggregated( const TSubDeviceRawData* subDeviceData, uint32_t subDeviceCount, uint64_t toleranceNs, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
+        virtual TCompletionCode      CalculateMetricsView( const TIoStreamView* view, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
+        virtual TCompletionCode      CalculateIoStreamMetrics( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
     };
 
 }; // namespace MetricsDiscovery
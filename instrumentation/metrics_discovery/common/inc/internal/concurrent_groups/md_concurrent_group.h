@@ -67,6 +67,7 @@ namespace MetricsDiscoveryInternal
         // Non-API:
         CMetricSet* AddMetricSet( const char* symbolicName, const char* shortName, uint32_t apiMask, uint32_t categoryMask, uint32_t snapshotReportSize, uint32_t deltaReportSize, TReportType reportType, TByteArrayLatest* platformMask, const char* availabilityEquation = nullptr, uint32_t gtMask = GT_TYPE_ALL, bool isCustom = false );
         CMetricSet* GetMatchingMetricSet( const char* symbolName, TByteArrayLatest* platformMask, uint32_t gtMask, bool findWithTrueAvailabilityEquation = false );
+        CMetricSet* GetMetricSetByName( const char* symbolName );
 
         CInformation*       AddInformation( const char* symbolName, const char* shortName, const char* longName, const char* groupName, uint32_t apiMask, TInformationType informationType, const char* informationUnits, const char* availabilityEquation, uint32_t informationXmlId );
         CInformation*       AddInformation( CInformation* information );
@@ -138,7 +139,7 @@ namespace MetricsDiscoveryInternal
 
         TCompletionCode Lock();
         TCompletionCode Unlock();
-        TCompletionCode WriteCConcurrentGroupToFile( FILE* metricFile );
+        TCompletionCode WriteCConcurrentGroupToFile( FILE* metricFile, CMetricSet* metricSet = nullptr );
 
     protected:
         IMetricSetLatest* AddCustomMetricSet( CMetricSet* referenceMetricSet, const char* signalName, const char* symbolName, const char* shortName, uint32_t apiMask, uint32_t categoryMask, TByteArrayLatest* platformMask, uint32_t gtMask, uint32_t rawReportSize, uint32_t queryReportSize, const char* complementarySetsList, TApiSpecificId_1_0 apiSpecificId, TRegisterSet* startRegSets, uint32_t startRegSetsCount, const char* availabilityEquation, TReportType reportType, bool copyInformationOnly = false );
@@ -13,6 +13,32 @@ SPDX-License-Identifier: MIT
 #pragma once
 
 #include "md_concurrent_group.h"
+#include "md_io_stream_capture.h"
+#include "md_io_stream_delivery.h"
+#include "md_io_stream_read_policy.h"
+#include "md_io_stream_sampling_control.h"
+#include "md_io_stream_statistics.h"
+
+#include <atomic>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Metric set switches of an opened stream kept for report attribution.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_METRIC_SET_SWITCH_MAX 1024
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     GPU timestamp prediction used to extend 32 bit report timestamps past
+//     their wraps: tolerated drift of the GPU clock ahead of the CPU one and
+//     CPU time after which the prediction is anchored to a GPU timestamp again.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_TIMESTAMP_MARGIN_NS        MD_SECOND_IN_NS
+#define MD_IO_STREAM_TIMESTAMP_ANCHOR_PERIOD_NS ( 10 * MD_SECOND_IN_NS )
 
 using namespace MetricsDiscovery;
 
@@ -48,7 +74,30 @@ namespace MetricsDiscoveryInternal
         IInformation_1_0*       GetIoGpuContextInformation( uint32_t index );
 
         // Internal API (IInternalConcurrentGroup):
-        virtual IMetricSetLatest* AddCustomMetricSet( TAddCustomMetricSetParams* params, IMetricSetLatest* referenceMetricSet, bool copyInformationOnly = false );
+        virtual IMetricSetLatest*        AddCustomMetricSet( TAddCustomMetricSetParams* params, IMetricSetLatest* referenceMetricSet, bool copyInformationOnly = false );
+        virtual TCompletionCode          ReadIoStreamView( uint32_t* reportCount, TIoStreamView* outView, uint32_t readFlags );
+        virtual TCompletionCode          SetIoStreamReaderParams( const TIoStreamReaderParams* params );
+        virtual TCompletionCode          SetIoStreamReadPolicy( const TIoStreamReadPolicyParams* params );
+        virtual TCompletionCode          SetIoStreamSamplingControl( const TIoStreamSamplingControlParams* params );
+        virtual TCompletionCode          SetIoStreamPollParams( const TIoStreamPollParams* params );
+        virtual TCompletionCode          SetIoStreamOaBufferParams( const TIoStreamOaBufferParams* params );
+        virtual IInternalIoStreamGroup*  CreateIoStreamGroup( void );
+        virtual TCompletionCode          DeleteIoStreamGroup( IInternalIoStreamGroup* streamGroup );
+        virtual IInternalIoStreamMerger* CreateIoStreamMerger( const TIoStreamMergerParams* params );
+        virtual TCompletionCode          DeleteIoStreamMerger( IInternalIoStreamMerger* streamMerger );
+        virtual TCompletionCode          StartIoStreamCapture( const char* fileName, const TIoStreamCaptureParams* params );
+        virtual TCompletionCode          StopIoStreamCapture( void );
+        virtual TCompletionCode          GetIoStreamStatistics( TIoStreamStatistics* outStatistics );
+        virtual TCompletionCode          ResetIoStreamStatistics( void );
+        virtual TCompletionCode          SwitchIoStreamMetricSet( IMetricSetLatest* metricSet );
+        virtual TCompletionCode          GetIoStreamMetricSetSwitches( TIoStreamMetricSetSwitch* outSwitches, uint32_t* switchCount );
+        virtual IMetricSetLatest*        GetIoStreamReportMetricSet( const uint8_t* rawReport );
+        virtual TCompletionCode          PauseIoStream( void );
+        virtual TCompletionCode          ResumeIoStream( void );
+        virtual TCompletionCode          SetIoStreamOpenPaused( bool openPaused );
+        virtual TCompletionCode          StartIoStreamDelivery( const TIoStreamDeliveryParams* params );
+        virtual TCompletionCode          StopIoStreamDelivery( void );
+        virtual TCompletionCode          GetIoStreamDeliveryStatistics( TIoStreamDeliveryStatistics* outStatistics );
 
     public:
         // Constructor & Destructor:
@@ -58,9 +107,13 @@ namespace MetricsDiscoveryInternal
         COAConcurrentGroup( const COAConcurrentGroup& )            = delete; // Delete copy-constructor
         COAConcurrentGroup& operator=( const COAConcurrentGroup& ) = delete; // Delete assignment operator
 
-        CMetricSet*               GetIoMetricSet();
-        const TStreamType         GetStreamType() const;
-        const GTDI_OA_BUFFER_TYPE GetOaBufferType() const;
+        CMetricSet*                    GetIoMetricSet();
+        const TStreamType              GetStreamType() const;
+        const GTDI_OA_BUFFER_TYPE      GetOaBufferType() const;
+        const TIoStreamReaderParams&   GetIoStreamReaderParams() const;
+        const TIoStreamPollParams&     GetIoStreamPollParams() const;
+        const TIoStreamOaBufferParams& GetIoStreamOaBufferParams() const;
+        bool                           IsIoStreamPaused() const;
 
         void* GetStreamEventHandle();
         void  SetStreamEventHandle( void* streamEventHandle );
@@ -75,18 +128,48 @@ namespace MetricsDiscoveryInternal
         void                    AddIoMeasurementInfoPredefined( void );
         CInformation*           AddIoGpuContextInformation( const char* name, const char* shortName, const char* longName, const char* group, TInformationType informationType, const char* informationUnits );
         void                    SetIoMeasurementInfoPredefined( const TIoMeasurementInfoType ioMeasurementInfoType, const uint32_t value, uint32_t& index );
+        void                    SetIoMeasurementInfo( const uint32_t frequency, const GTDIReadCounterStreamExceptions& exceptions );
+        TCompletionCode         ReadIoStreamAdaptive( uint32_t* reportCount, char* reportData, const uint32_t readFlags );
+        void                    UpdateSamplingPeriod( const uint32_t reportCount, const TCompletionCode readResult, const GTDIReadCounterStreamExceptions& exceptions );
         virtual TCompletionCode GetStreamTypeFromSamplingType( const TSamplingType samplingType, TStreamType& streamType ) const;
+        TCompletionCode         TakeIoStreamGpuTimestamp( uint64_t& gpuTimestamp );
+        uint64_t                GetIoStreamTimestampBound( const uint64_t cpuTimestampNs ) const;
+        void                    UpdateIoStreamTimestampBound( void );
+
+        static uint64_t ExtendIoStreamTimestamp( const uint64_t timestamp, const uint64_t bound );
 
     protected:
         // Variables:
-        TStreamType                m_streamType;
-        const GTDI_OA_BUFFER_TYPE  m_oaBufferType;
-        CMetricSet*                m_ioMetricSet;
-        bool                       m_contextTagsEnabled;
-        uint32_t                   m_processId;
-        void*                      m_streamEventHandle;
-        std::vector<CInformation*> m_ioMeasurementInfoVector;
-        std::vector<CInformation*> m_ioGpuContextInfoVector;
+        TStreamType                           m_streamType;
+        const GTDI_OA_BUFFER_TYPE             m_oaBufferType;
+        CMetricSet*                           m_ioMetricSet;
+        bool                                  m_contextTagsEnabled;
+        uint32_t                              m_processId;
+        void*                                 m_streamEventHandle;
+        TIoStreamReaderParams                 m_ioStreamReaderParams;
+        TIoStreamPollParams                   m_ioStreamPollParams;
+        TIoStreamOaBufferParams               m_ioStreamOaBufferParams;
+        CIoStreamReadPolicy                   m_ioStreamReadPolicy;
+        CIoStreamSamplingControl              m_ioStreamSamplingControl;
+        uint32_t                              m_nsTimerPeriod;         // Sampling period of the opened stream
+        uint32_t                              m_pendingNsTimerPeriod;  // Sampling period applied after the next drained read, 0 if none
+        uint32_t                              m_oaBufferSize;          // OA buffer size requested on open
+        bool                                  m_samplingPeriodChanged; // Stream reopened since the last read
+        bool                                  m_ioStreamPaused;        // Sampling of the opened stream paused
+        bool                                  m_ioStreamOpenPaused;    // Next OpenIoStream opens the stream paused
+        TCompletionCode                       m_ioStreamDeferredError; // Adaptive read error after reports were read, returned by the next read
+        CIoStreamCapture                      m_ioStreamCapture;
+        CIoStreamDelivery                     m_ioStreamDelivery;
+        CIoStreamStatistics                   m_ioStreamStatistics;
+        std::vector<CInformation*>            m_ioMeasurementInfoVector;
+        std::vector<CInformation*>            m_ioGpuContextInfoVector;
+        std::vector<IInternalIoStreamGroup*>  m_ioStreamGroupsVector;
+        std::vector<IInternalIoStreamMerger*> m_ioStreamMergersVector;
+        std::vector<TIoStreamMetricSetSwitch> m_ioStreamMetricSetSwitches; // Metric sets of the opened stream, the first one it was opened with
+        uint64_t                              m_ioStreamTimestampFrequency; // GPU timestamp frequency of the opened stream
+        uint64_t                              m_ioStreamAnchorGpuTimestamp; // Extended GPU timestamp ticks taken at m_ioStreamAnchorCpuNs
+        uint64_t                              m_ioStreamAnchorCpuNs;        // CPU time of the last GPU timestamp taken, 0 if none
+        std::atomic<uint64_t>                 m_ioStreamTimestampBound;     // Extended GPU timestamp ticks no read report is later than
 
     protected:
         // Static variables:
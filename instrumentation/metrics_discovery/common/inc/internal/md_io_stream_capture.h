@@ -0,0 +1,191 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_capture.h
+
+//     Abstract:   C++ Metrics Discovery internal raw IoStream capture header
+
+#pragma once
+
+#include "md_io_stream_codec.h"
+#include "md_types.h"
+
+#include <cstdio>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     IoStream capture file layout. The header is followed by the metrics
+//     device description of the captured metric set (custom metrics file 3.0
+//     format), padded to the alignment. Reports start at HeaderSize, either
+//     raw or as a sequence of encoded blocks, see CIoStreamCodec.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_CAPTURE_FILE_KEY      "MD_IO_STREAM_CAPTURE_1_0\n"
+#define MD_IO_STREAM_CAPTURE_ALIGNMENT     4096              // Direct IO block alignment
+#define MD_IO_STREAM_CAPTURE_WRITE_SIZE    ( 1 * MD_MBYTE )  // Default single write size
+#define MD_IO_STREAM_CAPTURE_MAX_NAME_SIZE 128
+
+#define MD_IO_STREAM_CAPTURE_ENCODING_RAW   0 // Raw reports
+#define MD_IO_STREAM_CAPTURE_ENCODING_DELTA 1 // CIoStreamCodec blocks
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Forward declarations:                                                     //
+    ///////////////////////////////////////////////////////////////////////////////
+    class CMetricsDevice;
+    class CMetricSet;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Encoded block of a compressed capture:                                    //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamCaptureBlock
+    {
+        uint64_t FirstReport;
+        uint64_t Offset; // In the capture file
+        uint32_t ReportCount;
+        uint32_t EncodedSize;
+    } TIoStreamCaptureBlock;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // IoStream capture file header:                                             //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamCaptureHeader
+    {
+        char     Key[32];
+        uint32_t HeaderSize;      // Offset of the first raw report
+        uint32_t DescriptionSize; // Size of the metrics device description following the header
+        uint32_t PlatformIndex;
+        uint32_t GtType;
+        uint32_t RawReportSize;
+        uint32_t ReportType;
+        uint32_t CoreFrequencyMhz;
+        uint32_t Encoding;
+        uint64_t ReportCount;     // Written when the capture stops, 0 if it did not stop
+        char     ConcurrentGroupName[MD_IO_STREAM_CAPTURE_MAX_NAME_SIZE];
+        char     MetricSetName[MD_IO_STREAM_CAPTURE_MAX_NAME_SIZE];
+    } TIoStreamCaptureHeader;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Description:
+    //     Writes raw IoStream reports to a capture file with large sequential
+    //     writes, so the stream can be recorded at full rate and calculated later.
+    //     Reports are staged in an aligned buffer, which allows bypassing
+    //     the page cache with direct IO. Optionally reports are delta encoded
+    //     in blocks with CIoStreamCodec.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamCapture
+    {
+    public:
+        // Constructor & Destructor:
+        CIoStreamCapture( CMetricsDevice& device );
+        virtual ~CIoStreamCapture();
+
+        CIoStreamCapture( const CIoStreamCapture& )            = delete; // Delete copy-constructor
+        CIoStreamCapture& operator=( const CIoStreamCapture& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Start( const char* fileName, CMetricSet& metricSet, const TIoStreamCaptureParams* params );
+        TCompletionCode Stop();
+        bool            IsStarted() const;
+
+        TCompletionCode Write( const uint8_t* reportData, const uint32_t reportCount );
+        TCompletionCode Write( const TIoStreamView& view, const uint32_t reportSize );
+        void            SetCoreFrequency( const uint32_t coreFrequencyMhz );
+
+    private:
+        TCompletionCode WriteHeader();
+        void            Append( const uint8_t* data, const uint32_t size );
+        void            EncodeBlock();
+        TCompletionCode Flush( const bool finalFlush );
+
+    private:
+        // Variables:
+        CMetricsDevice&        m_device;
+        FILE*                  m_file;
+        TIoStreamCaptureHeader m_header;
+        bool                   m_directIo;
+        bool                   m_writeFailed;
+
+        std::vector<uint8_t> m_bufferStorage; // Over-allocated to align m_buffer
+        uint8_t*             m_buffer;
+        uint32_t             m_bufferSize;
+        uint32_t             m_bufferOffset;
+
+        // Compression:
+        CIoStreamCodec       m_codec;
+        std::vector<uint8_t> m_blockReports; // Reports of the block being collected
+        uint32_t             m_blockReportCount;
+        std::vector<uint8_t> m_encodedBlock;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Description:
+    //     Raw IoStream capture file opened for offline calculation. The captured
+    //     metric set is recreated in a private metrics device, created on
+    //     the same adapter as the host device, with the platform and global
+    //     symbols of the captured device.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamCaptureFile : public IInternalIoStreamCapture
+    {
+    public:
+        // Internal API (IInternalIoStreamCapture):
+        virtual const TIoStreamCaptureInfo* GetInfo( void );
+        virtual IMetricSetLatest*           GetMetricSet( void );
+        virtual TCompletionCode             ReadReports( uint64_t firstReport, uint32_t* reportCount, uint8_t* out, uint32_t outSize );
+        virtual TCompletionCode             CalculateMetrics( uint64_t firstReport, uint32_t* reportCount, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
+
+    public:
+        // Constructor & Destructor:
+        CIoStreamCaptureFile( CMetricsDevice& hostDevice );
+        virtual ~CIoStreamCaptureFile();
+
+        CIoStreamCaptureFile( const CIoStreamCaptureFile& )            = delete; // Delete copy-constructor
+        CIoStreamCaptureFile& operator=( const CIoStreamCaptureFile& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Open( const char* fileName );
+
+    private:
+        TCompletionCode ReadBlockIndex();
+        TCompletionCode ReadEncodedReports( uint64_t firstReport, const uint32_t reportCount, uint8_t* out, const uint32_t outSize );
+
+    private:
+        // Variables:
+        CMetricsDevice&        m_hostDevice;
+        CMetricsDevice*        m_device; // Private device with the captured metric set
+        CMetricSet*            m_metricSet;
+        FILE*                  m_file;
+        uint64_t               m_fileSize;
+        TIoStreamCaptureHeader m_header;
+        TIoStreamCaptureInfo   m_info;
+        std::vector<uint8_t>   m_rawData;
+        uint64_t               m_nextReport; // Report following the last calculated one, continues from the saved report
+
+        // Compressed capture:
+        CIoStreamCodec                     m_codec;
+        std::vector<TIoStreamCaptureBlock> m_blocks;
+        std::vector<uint8_t>               m_encodedBlock;
+        std::vector<uint8_t>               m_decodedBlock;
+        uint32_t                           m_decodedBlockIndex; // Block cached in m_decodedBlock, UINT32_MAX if none
+    };
+} // namespace MetricsDiscoveryInternal
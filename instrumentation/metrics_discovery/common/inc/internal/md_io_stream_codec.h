@@ -0,0 +1,93 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_codec.h
+
+//     Abstract:   C++ Metrics Discovery internal lossless raw report codec header
+
+#pragma once
+
+#include "md_types.h"
+
+#include <vector>
+
+#define MD_IO_STREAM_CODEC_BLOCK_REPORTS 256 // Default reports in a single encoded block
+#define MD_IO_STREAM_CODEC_PADDING       8   // Zero bytes after each block, allow 64 bit loads past the last column
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Raw report column encodings:                                              //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef enum EIoStreamCodecMode
+    {
+        IO_STREAM_CODEC_MODE_DELTA32 = 0, // Zigzag 32 bit delta, wrapping counters
+        IO_STREAM_CODEC_MODE_DELTA8,      // Zigzag delta of each byte, packed 40 bit counter high bytes
+        IO_STREAM_CODEC_MODE_XOR,         // Xor with previous, ids and flags
+        // ...
+        IO_STREAM_CODEC_MODE_LAST
+    } TIoStreamCodecMode;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Encoded block header:                                                     //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamCodecBlockHeader
+    {
+        uint32_t ReportCount;
+        uint32_t EncodedSize; // In bytes, whole block including this header and padding
+    } TIoStreamCodecBlockHeader;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Description:
+    //     Lossless codec for sequences of raw OA reports. A report is split into
+    //     32 bit columns. Each block stores its first report as is and every
+    //     following report as per column deltas against the previous one.
+    //     For each block and column the cheapest encoding is chosen and all
+    //     values of the column are bit packed with a single width, so decoding
+    //     is a branch free unpack followed by a per row reconstruction over
+    //     contiguous columns. Byte lane deltas are tried only for report types
+    //     with 40 bit A counters, where high bytes of 4 counters share a column.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamCodec
+    {
+    public:
+        // Constructor & Destructor:
+        CIoStreamCodec( const uint32_t adapterId );
+        virtual ~CIoStreamCodec();
+
+        CIoStreamCodec( const CIoStreamCodec& )            = delete; // Delete copy-constructor
+        CIoStreamCodec& operator=( const CIoStreamCodec& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Initialize( const uint32_t reportSize, const TReportType reportType );
+
+        TCompletionCode Encode( const uint8_t* reports, const uint32_t reportCount, std::vector<uint8_t>& out );
+        TCompletionCode Decode( const uint8_t* block, const uint32_t blockSize, uint8_t* out, const uint32_t outSize, uint32_t& reportCount );
+
+    private:
+        void     WriteColumn( std::vector<uint8_t>& out, const uint32_t column, const uint32_t mode, const uint32_t width, const uint32_t rowCount );
+        uint32_t GetColumnSize( const uint32_t mode, const uint32_t width, const uint32_t rowCount ) const;
+
+    private:
+        // Variables:
+        const uint32_t m_adapterId;
+        uint32_t       m_reportSize;
+        uint32_t       m_columnCount;
+        bool           m_useByteLanes;
+
+        std::vector<uint32_t> m_values; // Row major packed values of the current block
+        std::vector<uint32_t> m_masks;  // Decoding only, per column masks of the chosen mode
+    };
+} // namespace MetricsDiscoveryInternal
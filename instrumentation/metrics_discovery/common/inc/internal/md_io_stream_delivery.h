@@ -0,0 +1,160 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_delivery.h
+
+//     Abstract:   C++ Metrics Discovery callback driven IoStream delivery header
+
+#pragma once
+
+#include "md_io_stream_capture.h"
+#include "md_types.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defines used by the IoStream delivery.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_DELIVERY_DEFAULT_BATCH_REPORTS 4096
+#define MD_IO_STREAM_DELIVERY_DEFAULT_LATENCY_MS    100
+#define MD_IO_STREAM_DELIVERY_DEFAULT_QUEUE_DEPTH   4
+#define MD_IO_STREAM_DELIVERY_MIN_QUEUE_DEPTH       2   // Pipelined executor, the read thread always holds one buffer
+#define MD_IO_STREAM_DELIVERY_SINGLE_THREAD_BUFFERS 2   // Reports behind a metric set switch are moved to a new batch before the held one is delivered
+#define MD_IO_STREAM_DELIVERY_DEFAULT_DECIMATION    4
+#define MD_IO_STREAM_DELIVERY_MAX_DECIMATION        64  // Kept reports must be closer than the 32-bit counter wrap
+#define MD_IO_STREAM_DELIVERY_STOP_CHECK_MS         100 // Longest single wait for reports
+#define MD_IO_STREAM_DELIVERY_HOLD_WAIT_MS          10  // Longest wait for reports while a ready batch waits for a free buffer
+#define MD_IO_STREAM_DELIVERY_NO_BUFFER             UINT32_MAX
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Forward declarations:                                                     //
+    ///////////////////////////////////////////////////////////////////////////////
+    class COAConcurrentGroup;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Batch buffer passed between the delivery stages:                          //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamDeliveryBuffer
+    {
+        std::vector<uint8_t>         RawData;              // Batch reports
+        uint32_t                     ReportCount;
+        IMetricSetLatest*            MetricSet;            // Metric set of all batch reports, nullptr until the first report
+        TCompletionCode              Result;               // Read or calculation error
+        uint64_t                     SequenceNumber;       // Assigned on submit
+        uint64_t                     LostReportCount;      // Reports dropped or captured right before the batch
+        uint32_t                     DecimatedReportCount; // Reports removed by decimation
+        uint32_t                     DecimatedPrefixCount; // Leading reports kept by decimation, not decimated again
+        std::vector<TTypedValue_1_0> Values;               // Calculated reports
+        uint32_t                     ValueReportCount;
+    } TIoStreamDeliveryBuffer;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Description:
+    //     Owns the wait / read / calculate loop of an opened IO Stream and pushes
+    //     ready batches to a client callback. The read thread waits for reports
+    //     and reads them directly into a free batch buffer, a batch is submitted
+    //     once full, once its oldest report waited MaxLatencyMs or at a metric set
+    //     switch. With the pipelined executor reading, calculation and callbacks
+    //     run on separate threads connected by queues. A fixed number of buffers
+    //     bounds the queues; when all are in use the overflow policy decides,
+    //     in user space, whether reading blocks, the oldest batch is dropped,
+    //     the batch being read is decimated or written to a raw capture. The metric
+    //     set calculator keeps the last report of the previous batch, so no report
+    //     interval is lost between calculated batches. Batch data is valid only
+    //     during the callback. The callback
+    //     must not call stream functions of the concurrent group, nor calculate
+    //     with the delivered metric set.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamDelivery
+    {
+    public:
+        // Constructor & Destructor:
+        CIoStreamDelivery( COAConcurrentGroup& concurrentGroup );
+        virtual ~CIoStreamDelivery();
+
+        CIoStreamDelivery( const CIoStreamDelivery& )            = delete; // Delete copy-constructor
+        CIoStreamDelivery& operator=( const CIoStreamDelivery& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Start( const TIoStreamDeliveryParams& params, const uint32_t adapterId, const uint32_t rawReportSize );
+        TCompletionCode Stop();
+        bool            IsStarted() const;
+        bool            IsReadThread() const;
+        void            GetStatistics( TIoStreamDeliveryStatistics& statistics );
+
+    private:
+        void     ReadThread();
+        void     CalculateThread();
+        void     ExportThread();
+        uint32_t AcquireBuffer();
+        bool     DropOldestBuffer();
+        void     ReleaseBuffer( const uint32_t index );
+        void     SubmitBuffer( const uint32_t index );
+        bool     HasFreeBuffer();
+        uint32_t AppendReports( uint32_t index, const uint32_t reportCount );
+        void     HandleOverflow( TIoStreamDeliveryBuffer& buffer );
+        void     Decimate( TIoStreamDeliveryBuffer& buffer );
+        void     Calculate( TIoStreamDeliveryBuffer& buffer );
+        void     Export( TIoStreamDeliveryBuffer& buffer );
+
+        IMetricSetLatest* GetReportMetricSet( TIoStreamDeliveryBuffer& buffer, const uint32_t report );
+        uint8_t*          GetReport( TIoStreamDeliveryBuffer& buffer, const uint32_t report );
+
+    private:
+        // Variables:
+        COAConcurrentGroup&     m_concurrentGroup;
+        TIoStreamDeliveryParams m_params;
+        uint32_t                m_adapterId;
+        uint32_t                m_rawReportSize;
+        uint64_t                m_sequenceNumber; // Next batch, read thread only
+
+        // Guarded by m_mutex:
+        std::vector<TIoStreamDeliveryBuffer> m_buffers;
+        std::deque<uint32_t>                 m_freeBuffers;
+        std::deque<uint32_t>                 m_calculateQueue;
+        std::deque<uint32_t>                 m_exportQueue;
+        std::mutex                           m_mutex;
+        std::condition_variable              m_freeCondition;
+        std::condition_variable              m_calculateCondition;
+        std::condition_variable              m_exportCondition;
+        TIoStreamDeliveryStatistics          m_statistics;
+        uint64_t                             m_pendingLostReportCount; // Lost reports not attached to a batch yet
+        bool                                 m_readDone;               // Read thread submitted its last batch
+        bool                                 m_calculateDone;          // Calculate thread passed on its last batch
+
+        std::thread       m_readThread;
+        std::thread       m_calculateThread;
+        std::thread       m_exportThread;
+        std::atomic<bool> m_stop;
+
+        // Read thread only:
+        CIoStreamCapture m_overflowCapture;
+        uint64_t         m_transitionReportCount; // Reports dropped at a metric set switch, lost before the next batch
+
+        // Calculating thread only:
+        IMetricSetLatest* m_lastMetricSet; // Metric set of the previous calculated batch
+    };
+} // namespace MetricsDiscoveryInternal
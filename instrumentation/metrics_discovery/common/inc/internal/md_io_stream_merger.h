@@ -0,0 +1,103 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_merger.h
+
+//     Abstract:   C++ Metrics Discovery internal IoStream timeline merger header
+
+#pragma once
+
+#include "md_types.h"
+
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defaults of the IoStream merger.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_MERGER_SOURCE_REPORTS 4096    // Raw reports buffered per source stream
+#define MD_IO_STREAM_MERGER_TOLERANCE_NS   1000000 // 1 ms, delay of a report becoming readable after its timestamp
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    // Forward declarations //
+    class COAConcurrentGroup;
+    class CMetricSet;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Single source stream of the merger:                                       //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamMergerSource
+    {
+        COAConcurrentGroup*            ConcurrentGroup;
+        CMetricSet*                    MetricSet;   // Metric set the stream was opened with
+        uint32_t                       ReportSize;  // Raw report size
+        TReportType                    ReportType;  // Raw report layout
+        std::vector<uint8_t>           Reports;     // Ring of buffered raw reports
+        std::vector<uint64_t>          Timestamps;  // CPU time of the buffered raw reports
+        std::vector<IMetricSetLatest*> MetricSets;  // Metric sets of the buffered raw reports
+        std::vector<uint8_t>           ReadBuffer;  // Copying reads, if the stream cannot be read in place
+        uint32_t                       Head;        // Ring index of the oldest buffered report
+        uint32_t                       Count;       // Buffered reports
+        uint64_t                       WatermarkNs; // Reports not read yet are not older than this
+        bool                           Finished;    // Stream cannot be read anymore
+    } TIoStreamMergerSource;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Description:
+    //     K-way merge of raw reports of several opened IO streams into a single
+    //     time ordered sequence. Every stream is drained into a bounded ring with
+    //     report timestamps converted to CPU time by its metrics device timestamp
+    //     correlation, so streams of different devices and clock domains share
+    //     a timeline. A report is returned only when no source can deliver an
+    //     older one anymore: its ring holds older reports, or it was drained
+    //     after the report time plus the tolerance. Memory use is constant.
+    //     Reports carry the metric set they were sampled with, so a source keeps
+    //     being merged across metric set switches of its stream.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamMerger : public IInternalIoStreamMerger
+    {
+    public:
+        // Internal API (IInternalIoStreamMerger):
+        virtual TCompletionCode AddSource( IConcurrentGroupLatest* concurrentGroup, uint32_t* outSourceIndex );
+        virtual uint32_t        GetSourceCount( void );
+        virtual TCompletionCode ReadReports( TIoStreamMergedReport* outReports, uint32_t outReportsCount, uint32_t* outReportCount );
+
+    public:
+        // Constructor & Destructor:
+        CIoStreamMerger( const uint32_t adapterId, const TIoStreamMergerParams* params );
+        virtual ~CIoStreamMerger();
+
+        CIoStreamMerger( const CIoStreamMerger& )            = delete; // Delete copy-constructor
+        CIoStreamMerger& operator=( const CIoStreamMerger& ) = delete; // Delete assignment operator
+
+    private:
+        void            Refill( TIoStreamMergerSource& source );
+        TCompletionCode ReadSource( TIoStreamMergerSource& source, uint32_t& reportCount, TIoStreamView& view, TIoStreamSpan& span );
+
+    private:
+        // Variables:
+        const uint32_t                             m_adapterId;
+        const uint32_t                             m_sourceReportCount;
+        const uint32_t                             m_toleranceNs;
+        std::vector<TIoStreamMergerSource>         m_sources;
+        std::vector<std::pair<uint64_t, uint32_t>> m_heap;          // Oldest buffered report time and source index
+        std::vector<uint64_t>                      m_gpuTimestamps; // Reused for every refill
+        std::vector<uint64_t>                      m_cpuTimestamps; // Reused for every refill
+    };
+} // namespace MetricsDiscoveryInternal
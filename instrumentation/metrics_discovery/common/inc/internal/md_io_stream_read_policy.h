@@ -0,0 +1,69 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_read_policy.h
+
+//     Abstract:   C++ Metrics Discovery internal adaptive IoStream read policy header
+
+#pragma once
+
+#include "md_types.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defaults of the adaptive IoStream read policy.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_READ_POLICY_MIN_BATCH_REPORTS 64                 // Reports coalesced before returning
+#define MD_IO_STREAM_READ_POLICY_MAX_LATENCY_MS    10                 // Coalescing deadline
+#define MD_IO_STREAM_READ_POLICY_MAX_READ_SIZE     ( 256 * MD_KBYTE ) // Single read cap, fits in L2
+#define MD_IO_STREAM_READ_POLICY_RATE_WEIGHT       0.25               // Weight of the newest rate sample
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Description:
+    //     Tracks the observed IoStream report arrival rate and derives the size
+    //     of the next read from the volume expected to be pending, capped to
+    //     a cache friendly size. Also tells how long to wait until a minimum
+    //     batch is expected to be available.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamReadPolicy
+    {
+    public:
+        // Constructor & Destructor:
+        CIoStreamReadPolicy();
+        virtual ~CIoStreamReadPolicy();
+
+        CIoStreamReadPolicy( const CIoStreamReadPolicy& )            = delete; // Delete copy-constructor
+        CIoStreamReadPolicy& operator=( const CIoStreamReadPolicy& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        void                             SetParams( const TIoStreamReadPolicyParams* params );
+        const TIoStreamReadPolicyParams& GetParams() const;
+        void                             Reset();
+
+        uint32_t GetReadReportCount( const uint32_t reportSize, const uint32_t maxReportCount );
+        uint32_t GetWaitTimeMs( const uint32_t missingReportCount );
+        void     Update( const uint32_t readReportCount );
+
+    private:
+        // Variables:
+        TIoStreamReadPolicyParams m_params;
+        double                    m_reportRate; // Reports per nanosecond, 0 if not known yet
+        uint64_t                  m_lastReadTimeNs;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,75 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_sampling_control.h
+
+//     Abstract:   C++ Metrics Discovery internal adaptive IoStream sampling period controller header
+
+#pragma once
+
+#include "md_types.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defaults of the adaptive IoStream sampling period controller.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_SAMPLING_CONTROL_MAX_PERIOD_NS   ( 100 * MD_NSEC_PER_MSEC ) // Default upper bound of the sampling period
+#define MD_IO_STREAM_SAMPLING_CONTROL_TARGET_FILL     50                         // Default OA buffer fill level target in percents
+#define MD_IO_STREAM_SAMPLING_CONTROL_DECREASE_CYCLES 8                          // Consecutive low fill drain cycles before the period is halved
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Description:
+    //     Chooses the IoStream sampling period from the OA buffer fill level.
+    //     Reports read since the buffer was last drained empty are the backlog
+    //     the buffer had to hold. When the backlog exceeds the target fill level
+    //     or reports are lost the period is doubled. When the backlog stays
+    //     below a quarter of the target, so it remains below half of the target
+    //     after the report rate doubles, the period is halved. Periods are kept
+    //     within the given bounds.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamSamplingControl
+    {
+    public:
+        // Constructor & Destructor:
+        CIoStreamSamplingControl();
+        virtual ~CIoStreamSamplingControl();
+
+        CIoStreamSamplingControl( const CIoStreamSamplingControl& )            = delete; // Delete copy-constructor
+        CIoStreamSamplingControl& operator=( const CIoStreamSamplingControl& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        void                                  SetParams( const TIoStreamSamplingControlParams* params );
+        const TIoStreamSamplingControlParams& GetParams() const;
+        bool                                  IsEnabled() const;
+        void                                  Start( const uint32_t nsTimerPeriod, const uint32_t bufferSize, const uint32_t reportSize );
+        void                                  SetPeriod( const uint32_t nsTimerPeriod );
+
+        uint32_t Update( const uint32_t readReportCount, const bool drained, const bool reportsLost );
+
+    private:
+        // Variables:
+        TIoStreamSamplingControlParams m_params;
+        uint32_t                       m_nsTimerPeriod;
+        uint32_t                       m_minNsTimerPeriod;
+        uint32_t                       m_maxNsTimerPeriod;
+        uint32_t                       m_bufferReportCount; // OA buffer capacity in reports
+        uint64_t                       m_backlogReportCount;
+        uint32_t                       m_lowFillCycleCount;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,59 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_statistics.h
+
+//     Abstract:   C++ Metrics Discovery internal IoStream health statistics header
+
+#pragma once
+
+#include "md_types.h"
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Description:
+    //     Cumulative health counters of an opened IoStream: volume read, lost
+    //     report and lost buffer events, read latency, time between drains and
+    //     the backlog drained by a single read. The backlog is estimated from
+    //     timestamps of the first and the last drained report, so no additional
+    //     GPU timestamp queries are needed.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamStatistics
+    {
+    public:
+        // Constructor & Destructor:
+        CIoStreamStatistics();
+        virtual ~CIoStreamStatistics();
+
+        CIoStreamStatistics( const CIoStreamStatistics& )            = delete; // Delete copy-constructor
+        CIoStreamStatistics& operator=( const CIoStreamStatistics& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        void                       SetReportLayout( const TReportType reportType, const uint64_t timestampFrequency );
+        void                       Reset();
+        const TIoStreamStatistics& Get() const;
+
+        void                       AddRead( const uint64_t startTimeNs, const TIoStreamView& view, const uint32_t reportSize, const GTDIReadCounterStreamExceptions& exceptions );
+        void                       AddRead( const uint64_t startTimeNs, const uint8_t* reportData, const uint32_t reportCount, const uint32_t reportSize, const GTDIReadCounterStreamExceptions& exceptions );
+
+    private:
+        // Variables:
+        TIoStreamStatistics m_statistics;
+        uint64_t            m_lastDrainTimeNs;
+        TReportType         m_reportType;
+        uint64_t            m_timestampFrequency;
+    };
+} // namespace MetricsDiscoveryInternal
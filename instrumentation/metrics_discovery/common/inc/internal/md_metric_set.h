@@ -35,6 +35,7 @@ namespace MetricsDiscoveryInternal
     class CMetricsCalculator;
     class CMetricsDevice;
     class CRegisterSet;
+    class CTimeSeries;
 
     union SCalculationContext;
     using TCalculationContext = SCalculationContext;
@@ -187,7 +188,14 @@ namespace MetricsDiscoveryInternal
                  const char*       signalName );
 
         // Internal API (IInternalMetricSet):
-        virtual IMetricLatest* AddCustomMetric( TAddCustomMetricParams* params );
+        virtual IMetricLatest*       AddCustomMetric( TAddCustomMetricParams* params );
+        virtual TCompletionCode      CalculateMetricsCollapsed( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount );
+        virtual IInternalTimeSeries* CreateTimeSeries( uint32_t blockRowCount );
+        virtual TCompletionCode      DeleteTimeSeries( IInternalTimeSeries* timeSeries );
+        virtual TCompletionCode      CalculateMetricsEncoded( const uint8_t* rawData, uint32_t rawDataSize, IInternalTimeSeries* timeSeries, uint32_t* outReportCount );
+        virtual TCompletionCode      CalculateMetricsAggregated( const TSubDeviceRawData* subDeviceData, uint32_t subDeviceCount, uint64_t toleranceNs, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
+        virtual TCompletionCode      CalculateMetricsView( const TIoStreamView* view, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
+        virtual TCompletionCode      CalculateIoStreamMetrics( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount );
 
     public:
         // Constructor & Destructor:
@@ -243,6 +251,7 @@ namespace MetricsDiscoveryInternal
 
         CConcurrentGroup*   GetConcurrentGroup();
         CMetricsCalculator* GetMetricsCalculator();
+        void                DiscardSavedReport();
         CMetricsDevice&     GetMetricsDevice();
         TByteArrayLatest*   GetPlatformMask();
 
@@ -273,6 +282,9 @@ namespace MetricsDiscoveryInternal
         void            UseApiFilteredVariables( bool enable );
         void            RefreshCachedMetricsAndInformation();
         void            ClearCachedMetricsAndInformation();
+        TCompletionCode CalculateMetricsInternal( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TTypedValue_1_0* outMaxValues, uint32_t outMaxValuesSize, bool doIdleCollapsing, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount, bool splitAtSwitches );
+        TCompletionCode CalculateIoStreamRuns( const uint8_t* rawData, uint32_t rawReportSize, uint32_t rawReportCount, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TTypedValue_1_0* outMaxValues, uint32_t outMaxValuesSize, bool doIdleCollapsing, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount );
+        bool            IsIoStreamReportOfOtherMetricSet( const uint8_t* rawReport );
         TCompletionCode ValidateCalculateMetricsParams( uint32_t rawDataSize, uint32_t rawReportSize, uint32_t outSize, uint32_t rawReportCount, uint32_t outMaxValuesSize );
         void            InitializeCalculationManager( TMeasurementType measurementType, CCalculationManager** calculationManager, bool init );
         TCompletionCode InitializeCalculationContext( TCalculationContext& context, CCalculationManager* calculationManager, TMeasurementType measurementType, TTypedValue_1_0* out, TTypedValue_1_0* outMaxValues, const uint8_t* rawData, uint32_t rawReportCount, bool init );
@@ -320,6 +332,8 @@ namespace MetricsDiscoveryInternal
         TPmRegsConfigInfo   m_pmRegsConfigInfo;
         CMetricsCalculator* m_metricsCalculator;
 
+        std::vector<CTimeSeries*> m_timeSeriesVector;
+
     private:
         // Static variables:
         static constexpr uint32_t METRICS_VECTOR_INCREASE            = 64;
@@ -0,0 +1,94 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_metrics_aggregator.h
+
+//     Abstract:   C++ Metrics Discovery internal sub device metrics aggregation header
+
+#pragma once
+
+#include "md_types.h"
+
+#include <vector>
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Forward declarations:                                                     //
+    ///////////////////////////////////////////////////////////////////////////////
+    class CMetricSet;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Aggregation types:                                                        //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef enum EAggregationType
+    {
+        AGGREGATION_TYPE_SUM = 0,          // Counts and throughputs
+        AGGREGATION_TYPE_WEIGHTED_AVERAGE, // Percentages, ratios, frequencies and durations, weighted by GpuTime
+        AGGREGATION_TYPE_OR,               // Flags
+        AGGREGATION_TYPE_FIRST,            // Taken from the first sub device
+    } TAggregationType;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Calculated reports of a single sub device:                                //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SSubDeviceReports
+    {
+        CMetricSet*                  MetricSet;
+        const uint8_t*               RawData;
+        uint32_t                     RawDataSize;
+        std::vector<TTypedValue_1_0> Reports;
+        uint32_t                     ReportCount;
+        TCompletionCode              Result;
+    } TSubDeviceReports;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Description:
+    //     Calculates the same metric set on all sub devices (tiles) in parallel,
+    //     aligns calculated reports by GPU timestamp and combines them into
+    //     device level reports.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CMetricsAggregator
+    {
+    public:
+        // Constructor & Destructor:
+        CMetricsAggregator( CMetricSet& metricSet );
+        virtual ~CMetricsAggregator();
+
+        CMetricsAggregator( const CMetricsAggregator& )            = delete; // Delete copy-constructor
+        CMetricsAggregator& operator=( const CMetricsAggregator& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Calculate( const TSubDeviceRawData* subDeviceData, const uint32_t subDeviceCount, const uint64_t toleranceNs, TTypedValue_1_0* out, const uint32_t outSize, uint32_t* outReportCount );
+
+    private:
+        TCompletionCode        AddSubDevice( const TSubDeviceRawData& subDeviceData );
+        TAggregationType       GetAggregationType( const uint32_t metricIndex );
+        const TTypedValue_1_0* FindReport( const TSubDeviceReports& subDevice, uint32_t& position, const uint64_t timestamp, const uint64_t toleranceNs );
+        uint64_t               GetDefaultTolerance();
+        void                   CombineReports( const std::vector<const TTypedValue_1_0*>& reports, TTypedValue_1_0* out );
+
+    private:
+        // Variables:
+        CMetricSet&                    m_metricSet; // Defines output layout
+        const uint32_t                 m_adapterId;
+        const uint32_t                 m_metricsCount;
+        const uint32_t                 m_metricsAndInformationCount;
+        int32_t                        m_timestampIndex; // QueryBeginTime information
+        int32_t                        m_gpuTimeIndex;   // GpuTime metric, used as weight
+        std::vector<TAggregationType>  m_aggregationTypes;
+        std::vector<TSubDeviceReports> m_subDevices;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -12,8 +12,11 @@ SPDX-License-Identifier: MIT
 
 #pragma once
 
+#include "md_stream_buffer.h"
 #include "md_symbol_set.h"
+#include "md_timestamp_correlation.h"
 
+#include <atomic>
 #include <vector>
 
 #define MD_METRICS_FILE_KEY     "CUSTOM_METRICS_FILE\n"
@@ -32,6 +35,7 @@ namespace MetricsDiscoveryInternal
     class CAdapter;
     class CConcurrentGroup;
     class CDriverInterface;
+    class CIoStreamCaptureFile;
     class CMetricSet;
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -56,7 +60,7 @@ namespace MetricsDiscoveryInternal
     //     GPU metrics root object. Stores all the concurrent groups and global symbols.
     //
     //////////////////////////////////////////////////////////////////////////////
-    class CMetricsDevice : public IMetricsDeviceLatest
+    class CMetricsDevice : public IInternalMetricsDevice
     {
     public:
         virtual IConcurrentGroupLatest* GetConcurrentGroup( uint32_t index );
@@ -75,6 +79,14 @@ namespace MetricsDiscoveryInternal
         virtual TCompletionCode           GetLastError();
         virtual TCompletionCode           GetGpuCpuTimestamps( uint64_t* gpuTimestampNs, uint64_t* cpuTimestampNs, uint32_t* cpuId );
 
+        // Internal API (IInternalMetricsDevice):
+        virtual TCompletionCode OpenIoStreamCapture( const char* fileName, IInternalIoStreamCapture** outCapture );
+        virtual TCompletionCode CloseIoStreamCapture( IInternalIoStreamCapture* capture );
+        virtual TCompletionCode UpdateTimestampCorrelation( bool force, TTimestampCorrelationInfo* outInfo );
+        virtual TCompletionCode ConvertGpuTimestampsToCpu( const uint64_t* gpuTimestamps, uint64_t* cpuTimestampsNs, uint32_t count );
+        virtual TCompletionCode CreateSideBandSampler( const TSideBandSamplerParams* params, IInternalSideBandSampler** outSampler );
+        virtual TCompletionCode DeleteSideBandSampler( IInternalSideBandSampler* sampler );
+
     public:
         // Constructor & Destructor:
         CMetricsDevice( CAdapter& adapter, CDriverInterface& driverInterface, const uint32_t subDeviceIndex = 0 );
@@ -91,13 +103,17 @@ namespace MetricsDiscoveryInternal
         bool            IsPavpDisabled( uint32_t capabilities );
 
         TCompletionCode SaveToFile( const char* fileName, const uint32_t minMajorApiVersion = 0, const uint32_t minMinorApiVersion = 0 );
+        TCompletionCode WriteToFile( FILE* metricFile, const uint32_t minMajorApiVersion, const uint32_t minMinorApiVersion, CMetricSet* metricSet = nullptr );
         TCompletionCode OpenFromFile( const char* fileName );
+        TCompletionCode OpenFromFileBuffer( uint8_t* metricFileBuffer, const uint32_t fileSize, const uint32_t fileVersion );
 
         CConcurrentGroup* GetConcurrentGroupByName( const char* symbolicName );
         CDriverInterface& GetDriverInterface();
         CAdapter&         GetAdapter();
         CSymbolSet&       GetSymbolSet();
         uint32_t          GetPlatformIndex();
+        TGTType           GetGtType();
+        void              SetPlatform( const uint32_t platformIndex, const TGTType gtType );
         bool              IsOpenedFromFile();
         uint64_t          ConvertGpuTimestampToNs( const uint64_t gpuTimestampTicks, const uint64_t gpuTimestampFrequency );
 
@@ -110,11 +126,15 @@ namespace MetricsDiscoveryInternal
         uint32_t GetOaBufferCount();
 
         // Performance stream.
-        int32_t               GetStreamId();
-        int32_t               GetStreamConfigId();
-        void                  SetStreamId( const int32_t id );
-        void                  SetStreamConfigId( const int32_t id );
-        std::vector<uint8_t>& GetStreamBuffer();
+        int32_t                     GetStreamId();
+        int32_t                     GetStreamConfigId();
+        uint32_t                    GetStreamGeneration();
+        void                        SetStreamId( const int32_t id );
+        void                        SetStreamConfigId( const int32_t id );
+        bool                        IsStreamPaused();
+        void                        SetStreamPaused( const bool paused );
+        CStreamBuffer&              GetStreamBuffer();
+        std::vector<TIoStreamSpan>& GetStreamSpans();
 
     private:
         // Methods to read from file must be used in correct order
@@ -130,17 +150,23 @@ namespace MetricsDiscoveryInternal
 
     private:
         // Variables:
-        TMetricsDeviceParamsLatest     m_params;
-        std::vector<CConcurrentGroup*> m_groupsVector;
-        std::vector<IOverrideLatest*>  m_overridesVector;
-        CAdapter&                      m_adapter;
-        CDriverInterface&              m_driverInterface;
-        CSymbolSet                     m_symbolSet;
+        TMetricsDeviceParamsLatest             m_params;
+        std::vector<CConcurrentGroup*>         m_groupsVector;
+        std::vector<IOverrideLatest*>          m_overridesVector;
+        std::vector<CIoStreamCaptureFile*>     m_ioStreamCapturesVector;
+        std::vector<IInternalSideBandSampler*> m_sideBandSamplersVector;
+        CAdapter&                              m_adapter;
+        CDriverInterface&                      m_driverInterface;
+        CSymbolSet                             m_symbolSet;
+        CTimestampCorrelation                  m_timestampCorrelation;
 
         // Stream:
-        int32_t              m_streamId;
-        int32_t              m_streamConfigId;
-        std::vector<uint8_t> m_streamBuffer;
+        int32_t                    m_streamId;
+        int32_t                    m_streamConfigId;
+        uint32_t                   m_streamGeneration; // Incremented on every stream open, fd numbers are reused
+        std::atomic<bool>          m_streamPaused; // Stream disabled, checked by the background reader
+        CStreamBuffer              m_streamBuffer;
+        std::vector<TIoStreamSpan> m_streamSpans; // Reports placed in m_streamBuffer by the last read
 
         // Sub device:
         uint32_t m_subDeviceIndex;
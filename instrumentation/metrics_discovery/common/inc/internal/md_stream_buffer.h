@@ -0,0 +1,86 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_stream_buffer.h
+
+//     Abstract:   C++ Metrics Discovery internal stream buffer header
+
+#pragma once
+
+#include "md_types.h"
+
+#include <cstddef>
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProvider
+    //
+    // Description:
+    //     Allocator of large stream path buffers. Allocations may be rounded up,
+    //     so the allocated size is returned and has to be passed back to Free.
+    //     Default implementation allocates from the heap, driver interfaces may
+    //     provide memory with better placement (huge pages, device NUMA node).
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CBufferProvider
+    {
+    public:
+        virtual ~CBufferProvider() = default;
+
+        virtual uint8_t* Allocate( const size_t size, size_t& allocatedSize );
+        virtual void     Free( uint8_t* data, const size_t allocatedSize );
+
+        static CBufferProvider& GetDefault();
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Description:
+    //     Growable byte buffer allocated by a buffer provider. Used instead of
+    //     std::vector for stream reads, so the memory placement can be chosen
+    //     and the buffer is never zero filled on resize. Growing keeps content,
+    //     shrinking keeps the allocation.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CStreamBuffer
+    {
+    public:
+        // Constructor & Destructor:
+        CStreamBuffer();
+        virtual ~CStreamBuffer();
+
+        CStreamBuffer( const CStreamBuffer& )            = delete; // Delete copy-constructor
+        CStreamBuffer& operator=( const CStreamBuffer& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        void            SetProvider( CBufferProvider* provider );
+        TCompletionCode Reserve( const size_t size );
+        TCompletionCode Resize( const size_t size );
+        void            Release();
+
+        uint8_t* GetData();
+        size_t   GetSize() const;
+        size_t   GetCapacity() const;
+        bool     IsEmpty() const;
+
+    private:
+        // Variables:
+        CBufferProvider* m_provider;
+        uint8_t*         m_data;
+        size_t           m_size;
+        size_t           m_capacity; // Allocated size
+    };
+} // namespace MetricsDiscoveryInternal
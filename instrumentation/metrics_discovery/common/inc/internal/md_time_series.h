@@ -0,0 +1,98 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_time_series.h
+
+//     Abstract:   C++ Metrics Discovery internal compressed time series header
+
+#pragma once
+
+#include "md_types.h"
+
+#include <vector>
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Time series column encoding state:                                        //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct STimeSeriesColumnState
+    {
+        TValueType ValueType;
+        uint64_t   PrevValue;    // Previous value, float stored as its bits
+        uint32_t   PrevLeading;  // Float only, leading zeros of the previous meaningful xor bits
+        uint32_t   PrevTrailing; // Float only, trailing zeros of the previous meaningful xor bits
+    } TTimeSeriesColumnState;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Description:
+    //     Compressed time series of calculated reports. Each row is a timestamp
+    //     and one value per metric / information. Timestamps are stored as
+    //     delta-of-delta, float columns are xor compressed (Gorilla), integer
+    //     columns as zigzag varint deltas and flags as single bits.
+    //     Rows are grouped into blocks encoded from scratch, which together
+    //     with the block index allows random access.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CTimeSeries : public IInternalTimeSeries
+    {
+    public:
+        // Internal API (IInternalTimeSeries):
+        virtual uint32_t                    GetColumnCount( void );
+        virtual uint32_t                    GetRowCount( void );
+        virtual uint32_t                    GetBlockCount( void );
+        virtual uint64_t                    GetEncodedSize( void );
+        virtual const TTimeSeriesBlockInfo* GetBlockInfo( uint32_t index );
+        virtual TCompletionCode             FindBlock( uint64_t timestamp, uint32_t* outIndex );
+        virtual TCompletionCode             DecodeBlock( uint32_t index, TTypedValue_1_0* out, uint32_t outSize, uint64_t* outTimestamps, uint32_t outTimestampsCount );
+        virtual TCompletionCode             Clear( void );
+
+    public:
+        // Constructor & Destructor:
+        CTimeSeries( const uint32_t adapterId, const uint32_t columnCount, const uint32_t blockRowCount );
+        virtual ~CTimeSeries();
+
+        CTimeSeries( const CTimeSeries& )            = delete; // Delete copy-constructor
+        CTimeSeries& operator=( const CTimeSeries& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode AppendRow( const TTypedValue_1_0* row, const uint64_t timestamp );
+
+    private:
+        void StartBlock( const TTypedValue_1_0* row, const uint64_t timestamp );
+        void EncodeFloat( TTimeSeriesColumnState& state, const uint32_t bits );
+        void WriteBits( const uint64_t value, const uint32_t bitCount );
+        void WriteVarInt( const uint64_t value );
+
+        uint64_t ReadBits( const uint8_t* data, uint64_t& bitPosition, const uint32_t bitCount );
+        uint64_t ReadVarInt( const uint8_t* data, uint64_t& bitPosition );
+        uint32_t DecodeFloat( const uint8_t* data, uint64_t& bitPosition, TTimeSeriesColumnState& state );
+
+    private:
+        // Variables:
+        const uint32_t m_adapterId;
+        const uint32_t m_columnCount;
+        const uint32_t m_blockRowCount;
+
+        std::vector<uint8_t>                m_data;
+        uint64_t                            m_bitCount; // Bits written to m_data
+        std::vector<TTimeSeriesBlockInfo>   m_blocks;
+        std::vector<TTimeSeriesColumnState> m_columns;
+        uint32_t                            m_rowCount;
+
+        // Timestamp encoding state of the current block:
+        uint64_t m_prevTimestamp;
+        int64_t  m_prevTimestampDelta;
+    };
+} // namespace MetricsDiscoveryInternal
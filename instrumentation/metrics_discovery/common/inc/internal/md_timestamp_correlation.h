@@ -0,0 +1,115 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_timestamp_correlation.h
+
+//     Abstract:   C++ Metrics Discovery internal GPU to CPU timestamp correlation header
+
+#pragma once
+
+#include "md_types.h"
+
+#include <atomic>
+#include <mutex>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defaults of the GPU to CPU timestamp correlation.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_TIMESTAMP_CORRELATION_SAMPLES         16                         // Paired samples the model is fitted to
+#define MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS ( 100 * MD_NSEC_PER_MSEC ) // Minimal time between rate limited samples
+#define MD_TIMESTAMP_CORRELATION_MAX_DRIFT_PPM   1000                       // Fitted periods further from nominal are ignored
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Paired GPU / CPU timestamp sample:                                        //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct STimestampCorrelationSample
+    {
+        uint64_t GpuTicks; // Unwrapped, continues past 32 bit wraparounds
+        uint64_t CpuNs;
+    } TTimestampCorrelationSample;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Linear GPU to CPU timestamp model:                                        //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct STimestampCorrelationModel
+    {
+        uint32_t BaseTicks; // Low 32 bits of the newest sample GPU timestamp
+        uint64_t BaseCpuNs; // Model CPU time at BaseTicks
+        double   NsPerTick;
+        uint64_t ErrorBoundNs;
+    } TTimestampCorrelationModel;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Description:
+    //     Maps GPU timestamps to CPU time with a linear model fitted by least
+    //     squares to the recent paired GPU / CPU samples, so the fitted period
+    //     follows the drift between both clocks. The model is anchored at
+    //     the newest sample and only the low 32 bits of GPU timestamps are used,
+    //     as in reports. Timestamps within 2^31 ticks of the anchor convert
+    //     correctly across a wraparound. Samples are unwrapped with the GPU time
+    //     predicted from the elapsed CPU time, so sparse samples are fine too.
+    //     The model is published with a sequence lock: conversions are lock free
+    //     and never see a partially updated model.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CTimestampCorrelation
+    {
+    public:
+        // Constructor & Destructor:
+        CTimestampCorrelation();
+        virtual ~CTimestampCorrelation();
+
+        CTimestampCorrelation( const CTimestampCorrelation& )            = delete; // Delete copy-constructor
+        CTimestampCorrelation& operator=( const CTimestampCorrelation& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        void     SetFrequency( const uint64_t gpuTimestampFrequency );
+        uint64_t GetFrequency() const;
+        bool     IsSampleNeeded( const uint64_t timeNs ) const;
+        void     AddSample( const uint64_t gpuTicks, const uint64_t cpuNs, const uint64_t timeNs );
+        void     GetInfo( TTimestampCorrelationInfo& info );
+
+        bool            GetModel( TTimestampCorrelationModel& model ) const;
+        uint64_t        GpuTicksToCpuNs( const uint64_t gpuTicks ) const;
+        static uint64_t GpuTicksToCpuNs( const TTimestampCorrelationModel& model, const uint64_t gpuTicks );
+
+    private:
+        void Fit();
+        void Publish( const TTimestampCorrelationModel& model );
+
+    private:
+        // Variables:
+        uint64_t                    m_gpuTimestampFrequency;
+        double                      m_nominalNsPerTick;
+        TTimestampCorrelationSample m_samples[MD_TIMESTAMP_CORRELATION_SAMPLES]; // Ring of the newest samples
+        uint32_t                    m_sampleCount;
+        uint32_t                    m_sampleIndex;    // Next ring slot
+        uint64_t                    m_lastSampleTime; // Caller time of the newest sample, for rate limiting
+        double                      m_nsPerTick;      // Period used to unwrap the next sample
+        uint64_t                    m_errorBoundNs;
+        std::mutex                  m_mutex; // Serializes sample updates
+
+        // Published model:
+        std::atomic<uint32_t> m_sequence; // Odd while the model is being updated
+        std::atomic<uint32_t> m_modelBaseTicks;
+        std::atomic<uint64_t> m_modelBaseCpuNs;
+        std::atomic<double>   m_modelNsPerTick; // 0 if there is no model
+        std::atomic<uint64_t> m_modelErrorBoundNs;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -27,6 +27,7 @@ namespace MetricsDiscoveryInternal
     class CMetricsDevice;
     class CMetricSet;
     class CEquation;
+    class CTimeSeries;
 
     ///////////////////////////////////////////////////////////////////////////////
     //      * Common calculation context:
@@ -64,12 +65,25 @@ namespace MetricsDiscoveryInternal
     typedef struct SStreamCalculationContext : public TCommonCalculationContext
     {
         // MetricSet
-        int32_t ContextIdIdx;
-        int32_t ReportReasonIdx;
+        int32_t     ContextIdIdx;
+        int32_t     ReportReasonIdx;
+        int32_t     QueryBeginTimeIdx;
+        TReportType ReportType;
 
         // ContextFiltering
         bool DoContextFiltering; // Required - not supported
 
+        // Idle collapsing
+        bool          DoIdleCollapsing; // Collapse runs of reports without activity into a single output report
+        TIdleRunInfo* OutIdleRunInfo;   // Optional, one entry per output report
+
+        // Encoding
+        CTimeSeries*    OutTimeSeries;       // Optional, if set reports are encoded instead of being stored in Out
+        TCompletionCode OutTimeSeriesResult; // Encoding failure stops the calculation
+
+        // Input
+        uint32_t RawReportStride; // Distance between raw reports, RawReportSize unless reports are read in place
+
         // Calculation
         const uint8_t* PrevRawDataPtr;
         uint32_t       PrevRawReportNumber;
@@ -135,5 +149,6 @@ namespace MetricsDiscoveryInternal
 
     private:
         int32_t GetInformationIndex( const char* symbolName, CMetricSet* set );
+        void    CollapseIdleReports( TStreamCalculationContext& context );
     };
 } // namespace MetricsDiscoveryInternal
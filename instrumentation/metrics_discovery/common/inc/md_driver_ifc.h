@@ -97,7 +97,7 @@ namespace MetricsDiscoveryInternal
 
     public:
         // Creation, destruction and debug settings static:
-        static CDriverInterface* CreateInstance( CAdapterHandle& adapterHandle );
+        static CDriverInterface* CreateInstance( CAdapterHandle& adapterHandle, const TAdapterParams_1_9& adapterParams );
         static void              ReleaseResources();
         static void              ReadDebugLogSettings();
         static bool              IsSupportEnableRequired();
@@ -131,12 +131,21 @@ namespace MetricsDiscoveryInternal
         // Stream:
         virtual TCompletionCode OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize )                                                              = 0;
         virtual TCompletionCode ReadIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, char* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions ) = 0;
+        virtual TCompletionCode ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )               = 0;
+        virtual TCompletionCode PauseIoStream( COAConcurrentGroup& oaConcurrentGroup, const bool pause )                                                                                                                    = 0;
+        virtual TCompletionCode SwitchIoStream( COAConcurrentGroup& oaConcurrentGroup, CMetricSet& metricSet )                                                                                                              = 0;
         virtual TCompletionCode CloseIoStream( COAConcurrentGroup& oaConcurrentGroup )                                                                                                                                      = 0;
         virtual TCompletionCode HandleIoStreamExceptions( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& reportCount, const GTDIReadCounterStreamExceptions exceptions )                        = 0;
         virtual TCompletionCode WaitForIoStreamReports( COAConcurrentGroup& oaConcurrentGroup, const uint32_t milliseconds )                                                                                                = 0;
         virtual bool            IsIoMeasurementInfoAvailable( const TIoMeasurementInfoType ioMeasurementInfoType )                                                                                                          = 0;
         virtual bool            IsStreamTypeSupported( const TStreamType streamType )                                                                                                                                       = 0;
 
+        // Stream group:
+        virtual IInternalIoStreamGroup* CreateIoStreamGroup() = 0;
+
+        // Side-band:
+        virtual IInternalSideBandSampler* CreateSideBandSampler( const TSideBandSamplerParams& params ) = 0;
+
         // Overrides:
         virtual TCompletionCode SetFrequencyOverride( const TSetFrequencyOverrideParams_1_2* params )                                            = 0;
         virtual TCompletionCode SetQueryOverride( TOverrideType overrideType, uint32_t oaBufferSize, const TSetQueryOverrideParams_1_2* params ) = 0;
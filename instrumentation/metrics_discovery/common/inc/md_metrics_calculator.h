@@ -717,6 +717,43 @@ namespace MetricsDiscoveryInternal
             m_savedReportPresent = false;
         }
 
+        //////////////////////////////////////////////////////////////////////////////
+        //
+        // Class:
+        //    CMetricsCalculator
+        //
+        // Method:
+        //     IsIdleReport
+        //
+        // Description:
+        //     Checks whether there was no activity between two raw IoStream reports,
+        //     i.e. counter regions (A, B and C counters) of both reports are bitwise
+        //     equal. Report header with timestamp and gpu ticks is not compared, so
+        //     all counter deltas between such reports are zero.
+        //
+        // Input:
+        //     const uint8_t* rawReportLast - (IN) last raw report
+        //     const uint8_t* rawReportPrev - (IN) previous raw report
+        //     uint32_t       rawReportSize - size of a single raw report
+        //     TReportType    reportType    - raw report layout
+        //
+        // Output:
+        //     bool - true if counters of both reports are equal
+        //
+        //////////////////////////////////////////////////////////////////////////////
+        inline bool IsIdleReport( const uint8_t* rawReportLast, const uint8_t* rawReportPrev, uint32_t rawReportSize, TReportType reportType )
+        {
+            // Counters follow report id, timestamp, context id and gpu ticks header fields
+            const uint32_t countersOffset = 4 * GetRawReportHeaderFieldSize( reportType );
+
+            if( rawReportLast == nullptr || rawReportPrev == nullptr || rawReportSize <= countersOffset )
+            {
+                return false;
+            }
+
+            return memcmp( rawReportLast + countersOffset, rawReportPrev + countersOffset, rawReportSize - countersOffset ) == 0;
+        }
+
         //////////////////////////////////////////////////////////////////////////////
         //
         // Class:
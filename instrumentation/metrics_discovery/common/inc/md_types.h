@@ -24,6 +24,8 @@ SPDX-License-Identifier: MIT
 #define MD_MBYTE           1048576
 #define MD_MHERTZ          1000000
 #define MD_NSEC_PER_SEC    1000000000ULL
+#define MD_NSEC_PER_MSEC   1000000ULL
+#define MD_NSEC_PER_USEC   1000ULL
 #define MD_INTEL_VENDOR_ID 0x8086
 
 #define MD_ROOT_DEVICE_INDEX 0
@@ -59,6 +61,92 @@ namespace MetricsDiscoveryInternal
         OA_REPORT_TYPE_LAST,
     } TReportType;
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery Types
+    //
+    // Function:
+    //     IsOamReportType
+    //
+    // Description:
+    //     Checks whether raw reports of the given type are Oam reports, which
+    //     have 64 bit header fields instead of 32 bit ones.
+    //
+    // Input:
+    //     const TReportType reportType - raw report layout
+    //
+    // Output:
+    //     bool                         - true for Oam report types
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    inline bool IsOamReportType( const TReportType reportType )
+    {
+        switch( reportType )
+        {
+            case OA_REPORT_TYPE_128B_OAM:
+            case OA_REPORT_TYPE_192B_MPEC8LL_NOA16:
+            case OA_REPORT_TYPE_128B_MPEC8_NOA16:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery Types
+    //
+    // Function:
+    //     GetRawReportHeaderFieldSize
+    //
+    // Description:
+    //     Returns size of a raw report header field. The header consists of
+    //     report id, timestamp, context id and gpu ticks, counters follow it.
+    //
+    // Input:
+    //     const TReportType reportType - raw report layout
+    //
+    // Output:
+    //     uint32_t                     - header field size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    inline uint32_t GetRawReportHeaderFieldSize( const TReportType reportType )
+    {
+        return IsOamReportType( reportType ) ? sizeof( uint64_t ) : sizeof( uint32_t );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery Types
+    //
+    // Function:
+    //     GetRawReportTimestamp
+    //
+    // Description:
+    //     Returns GPU timestamp of a raw report, the second header field.
+    //
+    // Input:
+    //     const uint8_t*    rawReport  - raw report
+    //     const TReportType reportType - raw report layout
+    //
+    // Output:
+    //     uint64_t                     - timestamp in ticks, 32 bit for Oa reports
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    inline uint64_t GetRawReportTimestamp( const uint8_t* rawReport, const TReportType reportType )
+    {
+        const uint32_t fieldSize = GetRawReportHeaderFieldSize( reportType );
+        uint64_t       timestamp = 0;
+
+        // Little endian, the lower half of 64 bit timestamp holds the 32 bit one
+        iu_memcpy_s( &timestamp, sizeof( timestamp ), rawReport + fieldSize, fieldSize );
+        return timestamp;
+    }
+
     ///////////////////////////////////////////////////////////////////////////////
     // Stream types:                                                             //
     ///////////////////////////////////////////////////////////////////////////////
@@ -100,6 +188,8 @@ namespace MetricsDiscoveryInternal
         IO_MEASUREMENT_INFO_BUFFER_OVERFLOW,
         IO_MEASUREMENT_INFO_BUFFER_OVERRUN,
         IO_MEASUREMENT_INFO_COUNTERS_OVERFLOW,
+        IO_MEASUREMENT_INFO_SAMPLING_PERIOD_NS,
+        IO_MEASUREMENT_INFO_SAMPLING_PERIOD_CHANGED,
         // ...
         IO_MEASUREMENT_INFO_LAST,
     } TIoMeasurementInfoType;
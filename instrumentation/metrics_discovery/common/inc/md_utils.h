@@ -120,7 +120,8 @@ namespace MetricsDiscoveryInternal
     TCompletionCode GetNamedSemaphore( const char* semaphoreName, void** semaphorePtr, const uint32_t adapterId );
     TCompletionCode ReleaseNamedSemaphore( void** semaphorePtr, const uint32_t adapterId );
 
-    int32_t GetFileSize( FILE* pFile, const uint32_t adapterId );
+    int32_t  GetFileSize( FILE* pFile, const uint32_t adapterId );
+    uint64_t GetTimeNs();
 
     TByteArrayLatest* GetCopiedByteArray( const TByteArrayLatest* byteArray, const uint32_t adapterId );
     TByteArrayLatest  GetByteArrayFromCStringMask( const char* cstring, const uint32_t adapterId );
@@ -368,6 +368,48 @@ namespace MetricsDiscoveryInternal
         return nullptr;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CConcurrentGroup
+    //
+    // Method:
+    //     GetMetricSetByName
+    //
+    // Description:
+    //     Returns metric set with a given name, looking at available sets first,
+    //     then at sets unavailable on the current platform.
+    //
+    // Input:
+    //     const char* symbolName - name of a metric set to look for
+    //
+    // Output:
+    //     CMetricSet*            - found metric set or nullptr
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CMetricSet* CConcurrentGroup::GetMetricSetByName( const char* symbolName )
+    {
+        MD_CHECK_PTR_RET_A( m_device.GetAdapter().GetAdapterId(), symbolName, nullptr );
+
+        for( auto& metricSet : m_setsVector )
+        {
+            if( metricSet && strcmp( symbolName, metricSet->GetParams()->SymbolName ) == 0 )
+            {
+                return metricSet;
+            }
+        }
+
+        for( auto& otherMetricSet : m_otherSetsList )
+        {
+            if( otherMetricSet && strcmp( symbolName, otherMetricSet->GetParams()->SymbolName ) == 0 )
+            {
+                return otherMetricSet;
+            }
+        }
+
+        return nullptr;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -595,16 +637,18 @@ namespace MetricsDiscoveryInternal
     //     WriteCConcurrentGroupToFile
     //
     // Description:
-    //     Writes concurrent group to file.
+    //     Writes concurrent group to file. If a metric set is given, only this
+    //     set is written, custom or not.
     //
     // Input:
-    //     FILE* metricFile - handle to metric file file
+    //     FILE*       metricFile - handle to metric file file
+    //     CMetricSet* metricSet  - (optional) the only metric set to write
     //
     // Output:
-    //     TCompletionCode  - result of operation
+    //     TCompletionCode        - result of operation
     //
     //////////////////////////////////////////////////////////////////////////////
-    TCompletionCode CConcurrentGroup::WriteCConcurrentGroupToFile( FILE* metricFile )
+    TCompletionCode CConcurrentGroup::WriteCConcurrentGroupToFile( FILE* metricFile, CMetricSet* metricSet /* = nullptr */ )
     {
         const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
         if( metricFile == nullptr )
@@ -618,6 +662,14 @@ namespace MetricsDiscoveryInternal
         WriteCStringToFile( m_params.Description, metricFile, adapterId );
         fwrite( &m_params.MeasurementTypeMask, sizeof( m_params.MeasurementTypeMask ), 1, metricFile );
 
+        if( metricSet != nullptr )
+        {
+            const uint32_t count = 1;
+            fwrite( &count, sizeof( count ), 1, metricFile );
+
+            return metricSet->WriteCMetricSetToFile( metricFile );
+        }
+
         // m_setsVector & m_otherSetsList
         uint32_t count = GetCustomSetCount();
         fwrite( &count, sizeof( count ), 1, metricFile );
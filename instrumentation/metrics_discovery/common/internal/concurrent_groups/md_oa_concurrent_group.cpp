@@ -13,8 +13,10 @@ SPDX-License-Identifier: MIT
 #include "md_oa_concurrent_group.h"
 #include "md_information.h"
 #include "md_calculation.h"
+#include "md_io_stream_merger.h"
 #include "md_driver_ifc.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace MetricsDiscoveryInternal
@@ -69,6 +71,194 @@ namespace MetricsDiscoveryInternal
         return ret;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SetIoStreamReaderParams
+    //
+    // Description:
+    //     Sets background IoStream reader parameters used by the next OpenIoStream.
+    //     With the reader enabled, the stream is drained by an internal thread into
+    //     a ring of reports and ReadIoStream reads reports from the ring.
+    //
+    // Input:
+    //     const TIoStreamReaderParams* params - reader parameters, nullptr disables the reader
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::SetIoStreamReaderParams( const TIoStreamReaderParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        // change is disallowed if stream is already opened
+        if( m_ioMetricSet != nullptr )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: Failed to set IoStream reader params, stream already opened" );
+            return CC_ERROR_GENERAL;
+        }
+
+        if( params == nullptr )
+        {
+            m_ioStreamReaderParams = { false, 0, -1, 0 };
+        }
+        else
+        {
+            m_ioStreamReaderParams = *params;
+        }
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "IoStream reader: %s, ring reports: %u, cpu: %d, priority: %d", m_ioStreamReaderParams.Enabled ? "enabled" : "disabled", m_ioStreamReaderParams.RingReportCount, m_ioStreamReaderParams.CpuAffinity, m_ioStreamReaderParams.Priority );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SetIoStreamReadPolicy
+    //
+    // Description:
+    //     Sets parameters of reads done with IO_READ_FLAG_ADAPTIVE. May be changed
+    //     while the stream is opened, the observed report rate is kept.
+    //
+    // Input:
+    //     const TIoStreamReadPolicyParams* params - policy parameters, nullptr means defaults
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::SetIoStreamReadPolicy( const TIoStreamReadPolicyParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        m_ioStreamReadPolicy.SetParams( params );
+
+        auto& policyParams = m_ioStreamReadPolicy.GetParams();
+        MD_LOG_A( adapterId, LOG_DEBUG, "IoStream read policy: min batch: %u, max latency: %u ms, max read size: %u", policyParams.MinBatchReportCount, policyParams.MaxLatencyMs, policyParams.MaxReadSize );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SetIoStreamSamplingControl
+    //
+    // Description:
+    //     Sets parameters of the adaptive sampling period controller. When enabled
+    //     the stream is reopened with a doubled period if reports are lost or
+    //     the OA buffer fills above the target, and with a halved period while
+    //     the buffer stays mostly empty. Reads returning the first reports after
+    //     a change set the SamplingPeriodChanged measurement information, so
+    //     calculation does not compute deltas across the reopen.
+    //     Takes effect on the next OpenIoStream.
+    //
+    // Input:
+    //     const TIoStreamSamplingControlParams* params - controller parameters, nullptr disables the controller
+    //
+    // Output:
+    //     TCompletionCode                              - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::SetIoStreamSamplingControl( const TIoStreamSamplingControlParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        m_ioStreamSamplingControl.SetParams( params );
+
+        auto& controlParams = m_ioStreamSamplingControl.GetParams();
+        MD_LOG_A( adapterId, LOG_DEBUG, "IoStream sampling control: enabled: %u, min period: %u ns, max period: %u ns, target fill: %u%%", controlParams.Enabled, controlParams.MinNsTimerPeriod, controlParams.MaxNsTimerPeriod, controlParams.TargetFillPercent );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SetIoStreamPollParams
+    //
+    // Description:
+    //     Sets the period the kernel checks the OA buffer for new reports with,
+    //     which bounds how often a reader waiting for reports is woken up.
+    //     The automatic choice wakes the reader as rarely as the latency target
+    //     allows, but before the OA buffer is half full. Ignored by kernels
+    //     not supporting the poll period. Takes effect on the next OpenIoStream.
+    //
+    // Input:
+    //     const TIoStreamPollParams* params - poll parameters, nullptr means kernel default
+    //
+    // Output:
+    //     TCompletionCode                   - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::SetIoStreamPollParams( const TIoStreamPollParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        if( params == nullptr )
+        {
+            m_ioStreamPollParams = { false, 0, 0 };
+        }
+        else
+        {
+            m_ioStreamPollParams = *params;
+        }
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "IoStream poll: automatic: %u, period: %u ns, max latency: %u ms", m_ioStreamPollParams.Automatic, m_ioStreamPollParams.PollPeriodNs, m_ioStreamPollParams.MaxLatencyMs );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SetIoStreamOaBufferParams
+    //
+    // Description:
+    //     Sets how the OA buffer size is chosen. The automatic choice sizes the
+    //     buffer to hold the reports sampled during two drain intervals, so
+    //     a reader keeping up with the interval does not overflow it. Otherwise
+    //     the size passed to OpenIoStream is used. Sizes are limited to those
+    //     supported by the kernel, OpenIoStream returns the size used.
+    //     Takes effect on the next OpenIoStream.
+    //
+    // Input:
+    //     const TIoStreamOaBufferParams* params - OA buffer parameters, nullptr means OpenIoStream size
+    //
+    // Output:
+    //     TCompletionCode                       - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::SetIoStreamOaBufferParams( const TIoStreamOaBufferParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        if( params == nullptr )
+        {
+            m_ioStreamOaBufferParams = { false, 0 };
+        }
+        else
+        {
+            m_ioStreamOaBufferParams = *params;
+        }
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "IoStream OA buffer: automatic: %u, drain interval: %u ms", m_ioStreamOaBufferParams.Automatic, m_ioStreamOaBufferParams.DrainIntervalMs );
+        return CC_OK;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -102,10 +292,25 @@ namespace MetricsDiscoveryInternal
         MD_CHECK_CC_RET_A( adapterId, ret );
 
         CDriverInterface& driverInterface = m_device.GetDriverInterface();
-        ret                               = driverInterface.OpenIoStream( *this, processId, *nsTimerPeriod, *oaBufferSize );
+        const uint32_t    oaBufferSizeIn  = *oaBufferSize;
+
+        m_ioStreamPaused = m_ioStreamOpenPaused;
+
+        ret = driverInterface.OpenIoStream( *this, processId, *nsTimerPeriod, *oaBufferSize );
+        if( ret != CC_OK )
+        {
+            m_ioStreamPaused = false;
+        }
         MD_CHECK_CC_RET_A( adapterId, ret );
         MD_LOG_A( adapterId, LOG_DEBUG, "Stream opened using type: %u", m_streamType );
 
+        m_nsTimerPeriod         = *nsTimerPeriod;
+        m_oaBufferSize          = oaBufferSizeIn;
+        m_samplingPeriodChanged = false;
+        m_pendingNsTimerPeriod  = 0;
+        m_ioStreamDeferredError = CC_OK;
+        m_ioStreamSamplingControl.Start( *nsTimerPeriod, *oaBufferSize, m_ioMetricSet->GetParams()->RawReportSize );
+
         m_processId            = processId;
         m_contextTagsEnabled   = m_ioMetricSet->HasInformation( "ContextId" );
         CMetricsCalculator* mc = m_ioMetricSet->GetMetricsCalculator();
@@ -116,6 +321,18 @@ namespace MetricsDiscoveryInternal
         {
             mc->DiscardSavedReport();
         }
+        m_ioStreamReadPolicy.Reset();
+
+        TTypedValueLatest* timestampFrequency = m_device.GetGlobalSymbolValueByName( "GpuTimestampFrequency" );
+        m_ioStreamStatistics.SetReportLayout( m_ioMetricSet->GetReportType(), timestampFrequency ? timestampFrequency->ValueUInt32 : 0 );
+        m_ioStreamStatistics.Reset();
+
+        m_ioStreamMetricSetSwitches.clear();
+        m_ioStreamMetricSetSwitches.push_back( { m_ioMetricSet, 0, 0, 0 } );
+        m_ioStreamTimestampFrequency = timestampFrequency ? timestampFrequency->ValueUInt32 : 0;
+        m_ioStreamAnchorGpuTimestamp = 0;
+        m_ioStreamAnchorCpuNs        = 0;
+        m_ioStreamTimestampBound     = 0;
 
         MD_LOG_EXIT_A( adapterId );
         return ret;
@@ -132,60 +349,915 @@ namespace MetricsDiscoveryInternal
     // Description:
     //     Reads data from previously opened IO Stream. Returns *CC_READ_PENDING* if not all
     //     data was read. Additionally, at the end of ReadIoStream GpuContextIds are read and updated.
+    //     Fails while the stream is delivered by StartIoStreamDelivery.
     //
     // Input:
     //     uint32_t        reportCount - (in/out) requested number of reports to read / reports read from the stream
     //     char*           reportData  - (out) pointer to the read data
-    //     uint32_t        readFlags   - read flags (see TIoReadFlag enum), 0 is ok
+    //     uint32_t        readFlags   - read flags (see TIoReadFlag and TIoReadFlagInternal enums), 0 is ok
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* or *CC_READ_PENDING* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::ReadIoStream( uint32_t* reportCount, char* reportData, uint32_t readFlags )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, reportData, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, reportCount, CC_ERROR_INVALID_PARAMETER );
+
+        if( m_ioMetricSet == nullptr )
+        {
+            *reportCount = 0;
+            MD_LOG_A( adapterId, LOG_ERROR, "stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+        if( m_ioStreamDelivery.IsStarted() && !m_ioStreamDelivery.IsReadThread() )
+        {
+            *reportCount = 0;
+            MD_LOG_A( adapterId, LOG_ERROR, "error: stream is read by the IoStream delivery" );
+            return CC_ERROR_GENERAL;
+        }
+        if( *reportCount == 0 )
+        {
+            MD_LOG_A( adapterId, LOG_DEBUG, "0 reports to read" );
+            return CC_OK;
+        }
+
+        TCompletionCode ret = CC_OK;
+
+        // Paused stream has no new reports to wait for
+        if( ( readFlags & IO_READ_FLAG_ADAPTIVE ) && !m_ioStreamPaused )
+        {
+            ret = ReadIoStreamAdaptive( reportCount, reportData, readFlags & ~IO_READ_FLAG_ADAPTIVE );
+        }
+        else
+        {
+            auto&                           driverInterface = m_device.GetDriverInterface();
+            uint32_t                        frequency       = 0;
+            GTDIReadCounterStreamExceptions exceptions      = {};
+            const uint64_t                  startTimeNs     = GetTimeNs();
+
+            ret = driverInterface.ReadIoStream( *this, readFlags & ~IO_READ_FLAG_ADAPTIVE, reportData, *reportCount, frequency, exceptions );
+            if( ret == CC_OK || ret == CC_READ_PENDING )
+            {
+                m_ioStreamStatistics.AddRead( startTimeNs, reinterpret_cast<const uint8_t*>( reportData ), *reportCount, m_ioMetricSet->GetParams()->RawReportSize, exceptions );
+                driverInterface.HandleIoStreamExceptions( *this, m_processId, *reportCount, exceptions );
+
+                SetIoMeasurementInfo( frequency, exceptions );
+                UpdateSamplingPeriod( *reportCount, ret, exceptions );
+            }
+        }
+
+        if( ret == CC_OK || ret == CC_READ_PENDING )
+        {
+            UpdateIoStreamTimestampBound();
+        }
+
+        // Capture write errors are reported by StopIoStreamCapture, the read itself succeeded
+        if( m_ioStreamCapture.IsStarted() && ( ret == CC_OK || ret == CC_READ_PENDING ) )
+        {
+            m_ioStreamCapture.Write( reinterpret_cast<const uint8_t*>( reportData ), *reportCount );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     ReadIoStreamAdaptive
+    //
+    // Description:
+    //     Reads data from previously opened IO Stream sizing each read to the volume
+    //     expected from the observed report rate. Reads are coalesced into the output
+    //     buffer until the minimum batch is read, the buffer is full or the latency
+    //     deadline passes, waiting for the stream in between. Requested report count
+    //     is the output buffer capacity. If a read or wait fails after some reports
+    //     were read, these reports are returned with *CC_OK* and the error is
+    //     returned by the next call.
+    //
+    // Input:
+    //     uint32_t*      reportCount - (in/out) output buffer capacity in reports / reports read from the stream
+    //     char*          reportData  - (out) pointer to the read data
+    //     const uint32_t readFlags   - read flags passed to the driver
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* or *CC_READ_PENDING* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::ReadIoStreamAdaptive( uint32_t* reportCount, char* reportData, const uint32_t readFlags )
+    {
+        auto&                           driverInterface = m_device.GetDriverInterface();
+        auto&                           policyParams    = m_ioStreamReadPolicy.GetParams();
+        const uint32_t                  reportSize      = m_ioMetricSet->GetParams()->RawReportSize;
+        const uint32_t                  maxReportCount  = *reportCount;
+        const uint64_t                  deadlineNs      = GetTimeNs() + policyParams.MaxLatencyMs * MD_NSEC_PER_MSEC;
+        uint32_t                        readReportCount = 0;
+        uint32_t                        frequency       = 0;
+        GTDIReadCounterStreamExceptions exceptions      = {};
+        TCompletionCode                 ret             = m_ioStreamDeferredError;
+
+        if( ret != CC_OK )
+        {
+            MD_LOG_A( m_device.GetAdapter().GetAdapterId(), LOG_ERROR, "ERROR: deferred IoStream read error: %u", ret );
+
+            m_ioStreamDeferredError = CC_OK;
+            *reportCount            = 0;
+            return ret;
+        }
+
+        while( true )
+        {
+            uint32_t                        reportsToRead  = m_ioStreamReadPolicy.GetReadReportCount( reportSize, maxReportCount - readReportCount );
+            GTDIReadCounterStreamExceptions readExceptions = {};
+            const uint64_t                  startTimeNs    = GetTimeNs();
+            char*                           readData       = reportData + readReportCount * reportSize;
+
+            ret = driverInterface.ReadIoStream( *this, readFlags, readData, reportsToRead, frequency, readExceptions );
+            if( ret != CC_OK && ret != CC_READ_PENDING )
+            {
+                break;
+            }
+
+            m_ioStreamStatistics.AddRead( startTimeNs, reinterpret_cast<const uint8_t*>( readData ), reportsToRead, reportSize, readExceptions );
+
+            driverInterface.HandleIoStreamExceptions( *this, m_processId, reportsToRead, readExceptions );
+            m_ioStreamReadPolicy.Update( reportsToRead );
+
+            readReportCount += reportsToRead;
+            exceptions.ReportLost |= readExceptions.ReportLost;
+            exceptions.BufferOverflow |= readExceptions.BufferOverflow;
+            exceptions.BufferOverrun |= readExceptions.BufferOverrun;
+            exceptions.CountersOverflow |= readExceptions.CountersOverflow;
+            exceptions.FrequencyChanged |= readExceptions.FrequencyChanged;
+
+            if( readReportCount >= maxReportCount || readReportCount >= policyParams.MinBatchReportCount )
+            {
+                break;
+            }
+
+            const uint64_t timeNs = GetTimeNs();
+            if( timeNs >= deadlineNs )
+            {
+                break;
+            }
+
+            // Wait for the rest of the batch, but not past the deadline
+            const uint32_t remainingMs = static_cast<uint32_t>( ( deadlineNs - timeNs + MD_NSEC_PER_MSEC - 1 ) / MD_NSEC_PER_MSEC );
+            const uint32_t waitMs      = std::min( m_ioStreamReadPolicy.GetWaitTimeMs( policyParams.MinBatchReportCount - readReportCount ), remainingMs );
+
+            const TCompletionCode waitRet = driverInterface.WaitForIoStreamReports( *this, waitMs );
+            if( waitRet != CC_OK && waitRet != CC_WAIT_TIMEOUT )
+            {
+                ret = waitRet;
+                break;
+            }
+        }
+
+        *reportCount = readReportCount;
+
+        if( ret != CC_OK && ret != CC_READ_PENDING )
+        {
+            if( readReportCount == 0 )
+            {
+                return ret;
+            }
+
+            // Reports already read are not lost, the error is returned by the next read
+            m_ioStreamDeferredError = ret;
+            ret                     = CC_OK;
+        }
+        else
+        {
+            ret = ( readReportCount < maxReportCount ) ? CC_READ_PENDING : CC_OK;
+        }
+
+        SetIoMeasurementInfo( frequency, exceptions );
+        UpdateSamplingPeriod( readReportCount, ret, exceptions );
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     ReadIoStreamView
+    //
+    // Description:
+    //     Reads data from previously opened IO Stream like ReadIoStream, but reports are
+    //     not copied to the user buffer. Returned view points to reports placed in
+    //     the internal stream buffer and is valid until the next read or stream close.
+    //     Each report is preceded by the driver record header, so reports are laid out
+    //     with the span stride bigger than the raw report size. Fails while the stream
+    //     is delivered by StartIoStreamDelivery.
+    //
+    // Input:
+    //     uint32_t*      reportCount - (in/out) requested number of reports to read / reports read from the stream
+    //     TIoStreamView* outView     - (out) view of the read reports
+    //     uint32_t       readFlags   - read flags (see TIoReadFlag enum), 0 is ok
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* or *CC_READ_PENDING* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::ReadIoStreamView( uint32_t* reportCount, TIoStreamView* outView, uint32_t readFlags )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, outView, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, reportCount, CC_ERROR_INVALID_PARAMETER );
+
+        *outView = {};
+
+        if( m_ioMetricSet == nullptr )
+        {
+            *reportCount = 0;
+            MD_LOG_A( adapterId, LOG_ERROR, "stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+        if( m_ioStreamDelivery.IsStarted() )
+        {
+            *reportCount = 0;
+            MD_LOG_A( adapterId, LOG_ERROR, "error: stream is read by the IoStream delivery" );
+            return CC_ERROR_GENERAL;
+        }
+        if( *reportCount == 0 )
+        {
+            MD_LOG_A( adapterId, LOG_DEBUG, "0 reports to read" );
+            return CC_OK;
+        }
+
+        auto&                           driverInterface = m_device.GetDriverInterface();
+        uint32_t                        frequency       = 0;
+        GTDIReadCounterStreamExceptions exceptions      = {};
+        const uint64_t                  startTimeNs     = GetTimeNs();
+
+        auto ret = driverInterface.ReadIoStreamView( *this, readFlags, *reportCount, frequency, exceptions );
+        if( ret == CC_OK || ret == CC_READ_PENDING )
+        {
+            driverInterface.HandleIoStreamExceptions( *this, m_processId, *reportCount, exceptions );
+
+            auto& streamSpans = m_device.GetStreamSpans();
+
+            outView->Spans       = streamSpans.data();
+            outView->SpanCount   = static_cast<uint32_t>( streamSpans.size() );
+            outView->ReportCount = *reportCount;
+
+            m_ioStreamStatistics.AddRead( startTimeNs, *outView, m_ioMetricSet->GetParams()->RawReportSize, exceptions );
+            SetIoMeasurementInfo( frequency, exceptions );
+            UpdateIoStreamTimestampBound();
+
+            if( m_ioStreamCapture.IsStarted() )
+            {
+                m_ioStreamCapture.Write( *outView, m_ioMetricSet->GetParams()->RawReportSize );
+            }
+
+            // Reopen keeps the metrics device stream buffer, so the view stays valid
+            UpdateSamplingPeriod( *reportCount, ret, exceptions );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     CreateIoStreamGroup
+    //
+    // Description:
+    //     Creates an empty stream group for waiting on several IO streams at once.
+    //     Streams of concurrent groups from other metrics devices may be added too.
+    //     The stream group is owned by this concurrent group.
+    //
+    // Output:
+    //     IInternalIoStreamGroup* - created stream group, nullptr if not supported
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IInternalIoStreamGroup* COAConcurrentGroup::CreateIoStreamGroup( void )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        IInternalIoStreamGroup* streamGroup = m_device.GetDriverInterface().CreateIoStreamGroup();
+        MD_CHECK_PTR_RET_A( adapterId, streamGroup, nullptr );
+
+        m_ioStreamGroupsVector.push_back( streamGroup );
+
+        return streamGroup;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     DeleteIoStreamGroup
+    //
+    // Description:
+    //     Deletes stream group created with CreateIoStreamGroup.
+    //
+    // Input:
+    //     IInternalIoStreamGroup* streamGroup - stream group to delete
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::DeleteIoStreamGroup( IInternalIoStreamGroup* streamGroup )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        auto it = std::find( m_ioStreamGroupsVector.begin(), m_ioStreamGroupsVector.end(), streamGroup );
+        if( streamGroup == nullptr || it == m_ioStreamGroupsVector.end() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: stream group not created by this concurrent group" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        m_ioStreamGroupsVector.erase( it );
+        MD_SAFE_DELETE( streamGroup );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     CreateIoStreamMerger
+    //
+    // Description:
+    //     Creates an empty merger of IO streams into a single timeline. Streams
+    //     of concurrent groups from other metrics devices may be added too.
+    //     The merger is owned by this concurrent group.
+    //
+    // Input:
+    //     const TIoStreamMergerParams* params - merger parameters, nullptr means defaults
+    //
+    // Output:
+    //     IInternalIoStreamMerger*            - created merger, nullptr if failed
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IInternalIoStreamMerger* COAConcurrentGroup::CreateIoStreamMerger( const TIoStreamMergerParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        IInternalIoStreamMerger* streamMerger = new( std::nothrow ) CIoStreamMerger( adapterId, params );
+        MD_CHECK_PTR_RET_A( adapterId, streamMerger, nullptr );
+
+        m_ioStreamMergersVector.push_back( streamMerger );
+
+        return streamMerger;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     DeleteIoStreamMerger
+    //
+    // Description:
+    //     Deletes merger created with CreateIoStreamMerger.
+    //
+    // Input:
+    //     IInternalIoStreamMerger* streamMerger - merger to delete
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::DeleteIoStreamMerger( IInternalIoStreamMerger* streamMerger )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        auto it = std::find( m_ioStreamMergersVector.begin(), m_ioStreamMergersVector.end(), streamMerger );
+        if( streamMerger == nullptr || it == m_ioStreamMergersVector.end() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: stream merger not created by this concurrent group" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        m_ioStreamMergersVector.erase( it );
+        MD_SAFE_DELETE( streamMerger );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     StartIoStreamCapture
+    //
+    // Description:
+    //     Starts writing raw reports of the opened IO Stream to a capture file.
+    //     Reports returned by ReadIoStream and ReadIoStreamView are appended
+    //     with large sequential writes, so metrics may be calculated offline
+    //     with IInternalMetricsDevice::OpenIoStreamCapture. The capture is
+    //     stopped with StopIoStreamCapture or when the stream is closed.
+    //
+    // Input:
+    //     const char*                   fileName - capture file path
+    //     const TIoStreamCaptureParams* params   - capture parameters, nullptr means defaults
+    //
+    // Output:
+    //     TCompletionCode                        - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::StartIoStreamCapture( const char* fileName, const TIoStreamCaptureParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        if( m_ioMetricSet == nullptr )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+
+        return m_ioStreamCapture.Start( fileName, *m_ioMetricSet, params );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     StopIoStreamCapture
+    //
+    // Description:
+    //     Writes remaining captured reports and closes the capture file.
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok), error if any capture write failed
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::StopIoStreamCapture( void )
+    {
+        return m_ioStreamCapture.Stop();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamStatistics
+    //
+    // Description:
+    //     Returns health counters of the IO Stream accumulated since it was opened
+    //     or since the last ResetIoStreamStatistics. Counters are updated by reads,
+    //     so they should be queried from the reading thread.
+    //
+    // Input:
+    //     TIoStreamStatistics* outStatistics - (out) stream statistics
+    //
+    // Output:
+    //     TCompletionCode                    - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::GetIoStreamStatistics( TIoStreamStatistics* outStatistics )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+        MD_CHECK_PTR_RET_A( adapterId, outStatistics, CC_ERROR_INVALID_PARAMETER );
+
+        *outStatistics = m_ioStreamStatistics.Get();
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     ResetIoStreamStatistics
+    //
+    // Description:
+    //     Clears IO Stream health counters.
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::ResetIoStreamStatistics( void )
+    {
+        m_ioStreamStatistics.Reset();
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SwitchIoStreamMetricSet
+    //
+    // Description:
+    //     Switches the opened IO Stream to another metric set of this group
+    //     without closing it, so no reports are lost. Both metric sets have to
+    //     use the same report format. GPU timestamps sampled right before and
+    //     right after the new configuration is programmed are recorded, extended
+    //     past 32 bit wraps, and reports are attributed to metric sets by their
+    //     timestamps, see GetIoStreamReportMetricSet, and calculated by
+    //     CalculateIoStreamMetrics of their metric set. Reports sampled in
+    //     between may use either configuration, so they are attributed to no
+    //     metric set and not calculated. Fails without switching if the first timestamp
+    //     cannot be taken. Not allowed while the stream is captured,
+    //     as a capture holds a single metric set, nor while it is delivered
+    //     by StartIoStreamDelivery.
+    //
+    // Input:
+    //     IMetricSetLatest* metricSet - metric set to switch to
+    //
+    // Output:
+    //     TCompletionCode             - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::SwitchIoStreamMetricSet( IMetricSetLatest* metricSet )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+        MD_CHECK_PTR_RET_A( adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
+
+        if( m_ioMetricSet == nullptr )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: IoStream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+        if( m_ioStreamDelivery.IsStarted() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: IoStream delivery has to be stopped before metric set switch" );
+            return CC_ERROR_GENERAL;
+        }
+
+        auto newMetricSet = static_cast<CMetricSet*>( metricSet );
+        if( newMetricSet->GetConcurrentGroup() != this )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "Error: Given metric set belongs to another concurrent group." );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        if( newMetricSet == m_ioMetricSet )
+        {
+            return CC_OK;
+        }
+
+        if( newMetricSet->GetReportType() != m_ioMetricSet->GetReportType() || newMetricSet->GetParams()->RawReportSize != m_ioMetricSet->GetParams()->RawReportSize )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: report format of opened IoStream cannot change" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        if( m_ioStreamCapture.IsStarted() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: IoStream capture has to be stopped before metric set switch" );
+            return CC_ERROR_GENERAL;
+        }
+
+        TIoStreamMetricSetSwitch metricSetSwitch = { newMetricSet, 0, 0, 0 };
+
+        // Reports would be attributed to a wrong metric set without the switch timestamp
+        if( TakeIoStreamGpuTimestamp( metricSetSwitch.GpuTimestamp ) != CC_OK )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: metric set switch timestamp not available" );
+            return CC_ERROR_GENERAL;
+        }
+        metricSetSwitch.CpuTimestampNs = m_ioStreamAnchorCpuNs;
+
+        TCompletionCode ret = m_device.GetDriverInterface().SwitchIoStream( *this, *newMetricSet );
+        MD_CHECK_CC_RET_A( adapterId, ret );
+
+        // The switch is done, so the transition is bounded by the predicted timestamp instead
+        if( TakeIoStreamGpuTimestamp( metricSetSwitch.GpuTimestampEnd ) != CC_OK )
+        {
+            MD_LOG_A( adapterId, LOG_WARNING, "metric set switch end timestamp not available, predicted" );
+            metricSetSwitch.GpuTimestampEnd = GetIoStreamTimestampBound( GetTimeNs() );
+        }
+
+        if( m_ioStreamMetricSetSwitches.size() >= MD_IO_STREAM_METRIC_SET_SWITCH_MAX )
+        {
+            m_ioStreamMetricSetSwitches.erase( m_ioStreamMetricSetSwitches.begin() );
+        }
+        m_ioStreamMetricSetSwitches.push_back( metricSetSwitch );
+
+        // Reports read so far were sampled before the switch
+        m_ioStreamTimestampBound = std::max( GetIoStreamTimestampBound( m_ioStreamAnchorCpuNs ), metricSetSwitch.GpuTimestampEnd );
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "IoStream metric set switched: %s -> %s, gpu timestamps: %llu - %llu", m_ioMetricSet->GetParams()->SymbolName, newMetricSet->GetParams()->SymbolName, static_cast<unsigned long long>( metricSetSwitch.GpuTimestamp ), static_cast<unsigned long long>( metricSetSwitch.GpuTimestampEnd ) );
+
+        m_ioMetricSet        = newMetricSet;
+        m_contextTagsEnabled = m_ioMetricSet->HasInformation( "ContextId" );
+
+        // Delta calculation must not use a report of the previous metric set
+        CMetricsCalculator* mc = m_ioMetricSet->GetMetricsCalculator();
+        if( mc != nullptr )
+        {
+            mc->DiscardSavedReport();
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamMetricSetSwitches
+    //
+    // Description:
+    //     Returns metric set switches of the opened IO Stream, oldest first.
+    //     The first one is the metric set the stream was opened with, unless
+    //     more than MD_IO_STREAM_METRIC_SET_SWITCH_MAX switches were made.
+    //
+    // Input:
+    //     TIoStreamMetricSetSwitch* outSwitches - (out) switches, nullptr to query the count
+    //     uint32_t*                 switchCount - (in/out) outSwitches size / returned switches
+    //
+    // Output:
+    //     TCompletionCode                       - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::GetIoStreamMetricSetSwitches( TIoStreamMetricSetSwitch* outSwitches, uint32_t* switchCount )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+        MD_CHECK_PTR_RET_A( adapterId, switchCount, CC_ERROR_INVALID_PARAMETER );
+
+        const uint32_t count = static_cast<uint32_t>( m_ioStreamMetricSetSwitches.size() );
+
+        if( outSwitches == nullptr )
+        {
+            *switchCount = count;
+            return CC_OK;
+        }
+
+        *switchCount = std::min( *switchCount, count );
+        std::copy( m_ioStreamMetricSetSwitches.begin(), m_ioStreamMetricSetSwitches.begin() + *switchCount, outSwitches );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamReportMetricSet
+    //
+    // Description:
+    //     Returns metric set the given raw report of the opened IO Stream was
+    //     sampled with: the newest switch not later than the report timestamp.
+    //     Reports sampled while a switch was programmed have no metric set.
+    //     The report timestamp is extended past 32 bit wraps to the latest value
+    //     not later than the newest read report, so reports have to be attributed
+    //     within 2^32 ticks (about 220 s at 19.2 MHz) of the latest stream read.
+    //
+    // Input:
+    //     const uint8_t* rawReport - raw report read from the stream
+    //
+    // Output:
+    //     IMetricSetLatest*        - metric set, nullptr if the stream is not opened or during a switch
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IMetricSetLatest* COAConcurrentGroup::GetIoStreamReportMetricSet( const uint8_t* rawReport )
+    {
+        if( rawReport == nullptr || m_ioStreamMetricSetSwitches.empty() )
+        {
+            return nullptr;
+        }
+
+        if( m_ioStreamMetricSetSwitches.size() == 1 )
+        {
+            return m_ioStreamMetricSetSwitches[0].MetricSet;
+        }
+
+        const uint64_t reportTimestamp = ExtendIoStreamTimestamp( GetRawReportTimestamp( rawReport, m_ioMetricSet->GetReportType() ), m_ioStreamTimestampBound );
+
+        for( size_t i = m_ioStreamMetricSetSwitches.size() - 1; i > 0; --i )
+        {
+            if( reportTimestamp >= m_ioStreamMetricSetSwitches[i].GpuTimestamp )
+            {
+                return ( reportTimestamp >= m_ioStreamMetricSetSwitches[i].GpuTimestampEnd ) ? m_ioStreamMetricSetSwitches[i].MetricSet : nullptr;
+            }
+        }
+
+        return m_ioStreamMetricSetSwitches[0].MetricSet;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     PauseIoStream
+    //
+    // Description:
+    //     Stops sampling of the opened IO Stream without closing it, e.g. outside
+    //     of a profiled region. The stream keeps its metric set, sampling period
+    //     and background reader. Reports not read yet are drained by the driver
+    //     before sampling stops and returned by the following reads, once they
+    //     are read, reads of a paused stream return no reports.
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::PauseIoStream( void )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        if( m_ioMetricSet == nullptr )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+        if( m_ioStreamPaused )
+        {
+            return CC_OK;
+        }
+
+        TCompletionCode ret = m_device.GetDriverInterface().PauseIoStream( *this, true );
+        MD_CHECK_CC_RET_A( adapterId, ret );
+
+        m_ioStreamPaused = true;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     ResumeIoStream
+    //
+    // Description:
+    //     Restarts sampling of the paused IO Stream. The report saved by the last
+    //     calculation is discarded, so no delta is computed across the paused
+    //     gap, and the read policy learns the report rate again.
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::ResumeIoStream( void )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        if( m_ioMetricSet == nullptr )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+        if( !m_ioStreamPaused )
+        {
+            return CC_OK;
+        }
+
+        TCompletionCode ret = m_device.GetDriverInterface().PauseIoStream( *this, false );
+        MD_CHECK_CC_RET_A( adapterId, ret );
+
+        m_ioStreamPaused = false;
+        m_ioStreamReadPolicy.Reset();
+
+        CMetricsCalculator* mc = m_ioMetricSet->GetMetricsCalculator();
+        if( mc != nullptr )
+        {
+            mc->DiscardSavedReport();
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SetIoStreamOpenPaused
+    //
+    // Description:
+    //     Sets whether the stream is opened paused, so sampling starts only with
+    //     ResumeIoStream. Takes effect on the next OpenIoStream.
+    //
+    // Input:
+    //     bool openPaused - *true* to open the stream paused
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::SetIoStreamOpenPaused( bool openPaused )
+    {
+        m_ioStreamOpenPaused = openPaused;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     StartIoStreamDelivery
+    //
+    // Description:
+    //     Starts pushing reports of the opened IO Stream to a callback. The library
+    //     waits for, reads and optionally calculates reports on its own threads
+    //     and invokes the callback with batches, valid until the callback returns.
+    //     Until StopIoStreamDelivery, reads and metric set switches of the stream
+    //     fail, the delivery is stopped when the stream is closed.
+    //
+    // Input:
+    //     const TIoStreamDeliveryParams* params - delivery parameters
+    //
+    // Output:
+    //     TCompletionCode                       - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::StartIoStreamDelivery( const TIoStreamDeliveryParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+        MD_CHECK_PTR_RET_A( adapterId, params, CC_ERROR_INVALID_PARAMETER );
+
+        if( m_ioMetricSet == nullptr )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+
+        return m_ioStreamDelivery.Start( *params, adapterId, m_ioMetricSet->GetParams()->RawReportSize );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     StopIoStreamDelivery
+    //
+    // Description:
+    //     Stops the delivery after reports already read are delivered. Must not
+    //     be called from the callback.
+    //
+    // Output:
+    //     TCompletionCode - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::StopIoStreamDelivery( void )
+    {
+        return m_ioStreamDelivery.Stop();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamDeliveryStatistics
+    //
+    // Description:
+    //     Returns queue occupancy and overflow statistics of the running or
+    //     the last IO Stream delivery.
     //
     // Output:
-    //     TCompletionCode - result of operation (*CC_OK* or *CC_READ_PENDING* is ok)
+    //     TIoStreamDeliveryStatistics* outStatistics - delivery statistics
+    //     TCompletionCode                            - result of operation (*CC_OK* is ok)
     //
     //////////////////////////////////////////////////////////////////////////////
-    TCompletionCode COAConcurrentGroup::ReadIoStream( uint32_t* reportCount, char* reportData, uint32_t readFlags )
+    TCompletionCode COAConcurrentGroup::GetIoStreamDeliveryStatistics( TIoStreamDeliveryStatistics* outStatistics )
     {
-        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
-
-        MD_CHECK_PTR_RET_A( adapterId, reportData, CC_ERROR_INVALID_PARAMETER );
-        MD_CHECK_PTR_RET_A( adapterId, reportCount, CC_ERROR_INVALID_PARAMETER );
-
-        if( m_ioMetricSet == nullptr )
-        {
-            *reportCount = 0;
-            MD_LOG_A( adapterId, LOG_ERROR, "stream not opened" );
-            return CC_ERROR_GENERAL;
-        }
-        if( *reportCount == 0 )
-        {
-            MD_LOG_A( adapterId, LOG_DEBUG, "0 reports to read" );
-            return CC_OK;
-        }
-
-        auto&                           driverInterface = m_device.GetDriverInterface();
-        uint32_t                        frequency       = 0;
-        GTDIReadCounterStreamExceptions exceptions      = {};
-
-        auto ret = driverInterface.ReadIoStream( *this, readFlags, reportData, *reportCount, frequency, exceptions );
-        if( ret == CC_OK || ret == CC_READ_PENDING )
-        {
-            driverInterface.HandleIoStreamExceptions( *this, m_processId, *reportCount, exceptions );
-
-            // Order (indices) should be in sync with AddIoMeasurementInfoPredefined()
-            uint32_t index = 0;
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_CORE_FREQUENCY_MHZ, frequency, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_FREQUENCY_CHANGED, exceptions.FrequencyChanged, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_FREQUENCY_CHANGED_INVALID, exceptions.FrequencyChangedInvalid, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_SLICE_SHUTDOWN, exceptions.SliceShutdown, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_REPORT_LOST, exceptions.ReportLost, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_DATA_OUTSTANDING, exceptions.DataOutstanding, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_BUFFER_OVERFLOW, exceptions.BufferOverflow, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_BUFFER_OVERRUN, exceptions.BufferOverrun, index );
-            SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_COUNTERS_OVERFLOW, exceptions.CountersOverflow, index );
-
-            m_params.IoMeasurementInformationCount = m_ioMeasurementInfoVector.size();
-        }
+        MD_CHECK_PTR_RET_A( m_device.GetAdapter().GetAdapterId(), outStatistics, CC_ERROR_INVALID_PARAMETER );
 
-        return ret;
+        m_ioStreamDelivery.GetStatistics( *outStatistics );
+        return CC_OK;
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -213,6 +1285,14 @@ namespace MetricsDiscoveryInternal
         TCompletionCode   ret             = CC_OK;
         CDriverInterface& driverInterface = m_device.GetDriverInterface();
 
+        // Reports already read are delivered before the stream is closed
+        ret = m_ioStreamDelivery.Stop();
+        if( ret != CC_OK )
+        {
+            MD_LOG_EXIT_A( adapterId );
+            return ret;
+        }
+
         ret = driverInterface.CloseIoStream( *this );
         if( ret != CC_OK )
         {
@@ -220,9 +1300,16 @@ namespace MetricsDiscoveryInternal
             return ret;
         }
 
+        if( m_ioStreamCapture.IsStarted() )
+        {
+            m_ioStreamCapture.Stop();
+        }
+
         // m_processId is not cleared after close to define if context filtering was used.
         // Stream reopen will override m_processId
-        m_ioMetricSet = nullptr;
+        m_ioMetricSet    = nullptr;
+        m_ioStreamPaused = false;
+        m_ioStreamMetricSetSwitches.clear();
         MD_LOG_EXIT_A( adapterId );
         return ret;
     }
@@ -533,6 +1620,8 @@ namespace MetricsDiscoveryInternal
 
         ClearVector( m_ioMeasurementInfoVector );
         ClearVector( m_ioGpuContextInfoVector );
+        ClearVector( m_ioStreamGroupsVector );
+        ClearVector( m_ioStreamMergersVector );
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -595,6 +1684,87 @@ namespace MetricsDiscoveryInternal
         return m_oaBufferType;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamReaderParams
+    //
+    // Description:
+    //     Returns background IoStream reader parameters.
+    //
+    // Output:
+    //     const TIoStreamReaderParams& - reader parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TIoStreamReaderParams& COAConcurrentGroup::GetIoStreamReaderParams() const
+    {
+        return m_ioStreamReaderParams;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamPollParams
+    //
+    // Description:
+    //     Returns IoStream poll parameters.
+    //
+    // Output:
+    //     const TIoStreamPollParams& - poll parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TIoStreamPollParams& COAConcurrentGroup::GetIoStreamPollParams() const
+    {
+        return m_ioStreamPollParams;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamOaBufferParams
+    //
+    // Description:
+    //     Returns OA buffer parameters used on OpenIoStream.
+    //
+    // Output:
+    //     const TIoStreamOaBufferParams& - OA buffer parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TIoStreamOaBufferParams& COAConcurrentGroup::GetIoStreamOaBufferParams() const
+    {
+        return m_ioStreamOaBufferParams;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     IsIoStreamPaused
+    //
+    // Description:
+    //     Returns whether sampling of the stream is paused. While the stream
+    //     is being opened, tells whether it is opened paused.
+    //
+    // Output:
+    //     bool - *true* if paused
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool COAConcurrentGroup::IsIoStreamPaused() const
+    {
+        return m_ioStreamPaused;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -660,8 +1830,30 @@ namespace MetricsDiscoveryInternal
         , m_contextTagsEnabled( false )
         , m_processId( 0 )
         , m_streamEventHandle( nullptr )
+        , m_ioStreamReaderParams{ false, 0, -1, 0 }
+        , m_ioStreamPollParams{ false, 0, 0 }
+        , m_ioStreamOaBufferParams{ false, 0 }
+        , m_ioStreamReadPolicy()
+        , m_ioStreamSamplingControl()
+        , m_nsTimerPeriod( 0 )
+        , m_pendingNsTimerPeriod( 0 )
+        , m_oaBufferSize( 0 )
+        , m_samplingPeriodChanged( false )
+        , m_ioStreamPaused( false )
+        , m_ioStreamOpenPaused( false )
+        , m_ioStreamDeferredError( CC_OK )
+        , m_ioStreamCapture( device )
+        , m_ioStreamDelivery( *this )
+        , m_ioStreamStatistics()
         , m_ioMeasurementInfoVector()
         , m_ioGpuContextInfoVector()
+        , m_ioStreamGroupsVector()
+        , m_ioStreamMergersVector()
+        , m_ioStreamMetricSetSwitches()
+        , m_ioStreamTimestampFrequency( 0 )
+        , m_ioStreamAnchorGpuTimestamp( 0 )
+        , m_ioStreamAnchorCpuNs( 0 )
+        , m_ioStreamTimestampBound( 0 )
     {
         AddIoMeasurementInfoPredefined();
 
@@ -760,6 +1952,14 @@ namespace MetricsDiscoveryInternal
         {
             AddIoMeasurementInformation( "CountersOverflow", "Counters Overflow", "The flag indicating that counters overflows occurred between two consecutive readings.", "Report Meta Data", INFORMATION_TYPE_FLAG, nullptr );
         }
+        if( driverInterface.IsIoMeasurementInfoAvailable( IO_MEASUREMENT_INFO_SAMPLING_PERIOD_NS ) )
+        {
+            AddIoMeasurementInformation( "SamplingPeriod", "Sampling Period", "The sampling period of the stream the reports were read from.", "Report Meta Data", INFORMATION_TYPE_VALUE, "nanoseconds" );
+        }
+        if( driverInterface.IsIoMeasurementInfoAvailable( IO_MEASUREMENT_INFO_SAMPLING_PERIOD_CHANGED ) )
+        {
+            AddIoMeasurementInformation( "SamplingPeriodChanged", "Sampling Period Changed", "The flag indicating that the stream was reopened with a different sampling period before the first report of this read.", "Report Meta Data", INFORMATION_TYPE_FLAG, nullptr );
+        }
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -833,6 +2033,136 @@ namespace MetricsDiscoveryInternal
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     SetIoMeasurementInfo
+    //
+    // Description:
+    //     Sets all predefined IoMeasurementInformation values after successful read.
+    //
+    // Input:
+    //     const uint32_t                         frequency  - gpu core frequency in MHz
+    //     const GTDIReadCounterStreamExceptions& exceptions - exceptions returned by read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COAConcurrentGroup::SetIoMeasurementInfo( const uint32_t frequency, const GTDIReadCounterStreamExceptions& exceptions )
+    {
+        // Order (indices) should be in sync with AddIoMeasurementInfoPredefined()
+        uint32_t index = 0;
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_CORE_FREQUENCY_MHZ, frequency, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_FREQUENCY_CHANGED, exceptions.FrequencyChanged, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_FREQUENCY_CHANGED_INVALID, exceptions.FrequencyChangedInvalid, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_SLICE_SHUTDOWN, exceptions.SliceShutdown, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_REPORT_LOST, exceptions.ReportLost, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_DATA_OUTSTANDING, exceptions.DataOutstanding, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_BUFFER_OVERFLOW, exceptions.BufferOverflow, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_BUFFER_OVERRUN, exceptions.BufferOverrun, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_COUNTERS_OVERFLOW, exceptions.CountersOverflow, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_SAMPLING_PERIOD_NS, m_nsTimerPeriod, index );
+        SetIoMeasurementInfoPredefined( IO_MEASUREMENT_INFO_SAMPLING_PERIOD_CHANGED, m_samplingPeriodChanged, index );
+
+        m_samplingPeriodChanged = false;
+
+        m_params.IoMeasurementInformationCount = m_ioMeasurementInfoVector.size();
+
+        m_ioStreamCapture.SetCoreFrequency( frequency );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     UpdateSamplingPeriod
+    //
+    // Description:
+    //     Passes the read result to the sampling period controller and reopens
+    //     the stream if the controller asks for a different period. Closing
+    //     the stream drops reports left in the OA buffer, so a requested period
+    //     is kept pending until a read drains the buffer (CC_READ_PENDING), then
+    //     only reports sampled during the reopen are missed. The reopened stream
+    //     gets a new stream id, stream groups follow it through the metrics device
+    //     stream generation. If the stream cannot be opened with the new period,
+    //     the previous one is restored. Skipped while the stream is paused.
+    //
+    // Input:
+    //     const uint32_t                         reportCount - reports returned by the read
+    //     const TCompletionCode                  readResult  - result of the read
+    //     const GTDIReadCounterStreamExceptions& exceptions  - exceptions returned by the read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COAConcurrentGroup::UpdateSamplingPeriod( const uint32_t reportCount, const TCompletionCode readResult, const GTDIReadCounterStreamExceptions& exceptions )
+    {
+        // Empty reads of a paused stream say nothing about the report rate
+        if( m_ioStreamPaused )
+        {
+            return;
+        }
+
+        const bool     reportsLost            = exceptions.ReportLost || exceptions.BufferOverflow;
+        const uint32_t requestedNsTimerPeriod = m_ioStreamSamplingControl.Update( reportCount, readResult == CC_READ_PENDING, reportsLost );
+
+        if( requestedNsTimerPeriod != 0 )
+        {
+            m_pendingNsTimerPeriod = requestedNsTimerPeriod;
+        }
+
+        if( m_pendingNsTimerPeriod == 0 || readResult != CC_READ_PENDING )
+        {
+            return;
+        }
+
+        const uint32_t nsTimerPeriod = m_pendingNsTimerPeriod;
+        m_pendingNsTimerPeriod       = 0;
+
+        const uint32_t    adapterId       = m_device.GetAdapter().GetAdapterId();
+        CDriverInterface& driverInterface = m_device.GetDriverInterface();
+
+        TCompletionCode ret = driverInterface.CloseIoStream( *this );
+        if( ret != CC_OK )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: cannot close stream to change sampling period" );
+            return;
+        }
+
+        uint32_t newNsTimerPeriod = nsTimerPeriod;
+        uint32_t oaBufferSize     = m_oaBufferSize;
+
+        ret = driverInterface.OpenIoStream( *this, m_processId, newNsTimerPeriod, oaBufferSize );
+        if( ret != CC_OK )
+        {
+            MD_LOG_A( adapterId, LOG_WARNING, "cannot reopen stream with sampling period %u ns, restoring %u ns", nsTimerPeriod, m_nsTimerPeriod );
+
+            newNsTimerPeriod = m_nsTimerPeriod;
+            oaBufferSize     = m_oaBufferSize;
+
+            ret = driverInterface.OpenIoStream( *this, m_processId, newNsTimerPeriod, oaBufferSize );
+            if( ret != CC_OK )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: cannot reopen stream, next reads will fail" );
+                return;
+            }
+        }
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "Sampling period changed: %u -> %u ns", m_nsTimerPeriod, newNsTimerPeriod );
+
+        m_samplingPeriodChanged = m_samplingPeriodChanged || newNsTimerPeriod != m_nsTimerPeriod;
+        m_nsTimerPeriod         = newNsTimerPeriod;
+        m_ioStreamSamplingControl.SetPeriod( newNsTimerPeriod );
+        m_ioStreamReadPolicy.Reset();
+
+        CMetricsCalculator* mc = m_ioMetricSet->GetMetricsCalculator();
+        if( mc != nullptr )
+        {
+            mc->DiscardSavedReport();
+        }
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -863,4 +2193,152 @@ namespace MetricsDiscoveryInternal
         return CC_ERROR_NOT_SUPPORTED;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     TakeIoStreamGpuTimestamp
+    //
+    // Description:
+    //     Takes GPU timestamp of the opened IO Stream in raw report ticks, extended
+    //     past 32 bit wraps by the prediction from the previous one, and anchors
+    //     the prediction to it. The first timestamp starts at the second wrap, so
+    //     reports sampled before it are extended below it.
+    //
+    // Input:
+    //     uint64_t& gpuTimestamp - (out) extended GPU timestamp ticks
+    //
+    // Output:
+    //     TCompletionCode        - result of operation (*CC_OK* is ok)
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode COAConcurrentGroup::TakeIoStreamGpuTimestamp( uint64_t& gpuTimestamp )
+    {
+        const uint64_t frequency            = m_ioStreamTimestampFrequency;
+        uint64_t       gpuTimestampNs       = 0;
+        uint64_t       cpuTimestampNs       = 0;
+        uint64_t       correlationIndicator = 0;
+        uint32_t       cpuId                = 0;
+
+        if( frequency == 0 )
+        {
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        TCompletionCode ret = m_device.GetDriverInterface().GetGpuCpuTimestamps( m_device, &gpuTimestampNs, &cpuTimestampNs, &cpuId, &correlationIndicator );
+        if( ret != CC_OK )
+        {
+            return ret;
+        }
+
+        // Driver CPU timestamps may use another clock than the prediction
+        const uint64_t cpuNs = GetTimeNs();
+
+        // The driver scales 32 bit ticks down to ns, so rounding up restores them exactly
+        const uint64_t ticks = ( gpuTimestampNs / MD_SECOND_IN_NS ) * frequency + ( ( gpuTimestampNs % MD_SECOND_IN_NS ) * frequency + MD_SECOND_IN_NS - 1 ) / MD_SECOND_IN_NS;
+
+        m_ioStreamAnchorGpuTimestamp = ( m_ioStreamAnchorCpuNs == 0 )
+            ? ( ticks & UINT32_MAX ) + ( 1ULL << 32 )
+            : ExtendIoStreamTimestamp( ticks, GetIoStreamTimestampBound( cpuNs ) );
+        m_ioStreamAnchorCpuNs = cpuNs;
+
+        gpuTimestamp = m_ioStreamAnchorGpuTimestamp;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     GetIoStreamTimestampBound
+    //
+    // Description:
+    //     Predicts extended GPU timestamp ticks at the given CPU time from the last
+    //     GPU timestamp taken. Drift of the GPU clock ahead of the CPU one is
+    //     covered by MD_IO_STREAM_TIMESTAMP_MARGIN_NS, so no report sampled
+    //     before the given time is later than the returned bound.
+    //
+    // Input:
+    //     const uint64_t cpuTimestampNs - CPU time, see GetTimeNs
+    //
+    // Output:
+    //     uint64_t                      - extended GPU timestamp ticks bound
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t COAConcurrentGroup::GetIoStreamTimestampBound( const uint64_t cpuTimestampNs ) const
+    {
+        const uint64_t frequency = m_ioStreamTimestampFrequency;
+        const uint64_t elapsedNs = ( cpuTimestampNs > m_ioStreamAnchorCpuNs ) ? cpuTimestampNs - m_ioStreamAnchorCpuNs : 0;
+
+        return m_ioStreamAnchorGpuTimestamp
+            + ( elapsedNs / MD_SECOND_IN_NS ) * frequency
+            + ( elapsedNs % MD_SECOND_IN_NS ) * frequency / MD_SECOND_IN_NS
+            + MD_IO_STREAM_TIMESTAMP_MARGIN_NS * frequency / MD_SECOND_IN_NS;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     UpdateIoStreamTimestampBound
+    //
+    // Description:
+    //     Moves the bound report timestamps are extended against past reports
+    //     just read. Done only after a metric set switch, as reports are not
+    //     told apart by timestamps before. The prediction is anchored to a new
+    //     GPU timestamp once MD_IO_STREAM_TIMESTAMP_ANCHOR_PERIOD_NS passes, so
+    //     the CPU clock drift does not accumulate.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COAConcurrentGroup::UpdateIoStreamTimestampBound( void )
+    {
+        if( m_ioStreamMetricSetSwitches.size() <= 1 )
+        {
+            return;
+        }
+
+        const uint64_t cpuTimestampNs = GetTimeNs();
+        uint64_t       gpuTimestamp   = 0;
+
+        if( cpuTimestampNs - m_ioStreamAnchorCpuNs >= MD_IO_STREAM_TIMESTAMP_ANCHOR_PERIOD_NS && TakeIoStreamGpuTimestamp( gpuTimestamp ) != CC_OK )
+        {
+            MD_LOG_A( m_device.GetAdapter().GetAdapterId(), LOG_WARNING, "GPU timestamp not available, report timestamps predicted from CPU time" );
+        }
+
+        m_ioStreamTimestampBound = GetIoStreamTimestampBound( cpuTimestampNs );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COAConcurrentGroup
+    //
+    // Method:
+    //     ExtendIoStreamTimestamp
+    //
+    // Description:
+    //     Extends low 32 bits of a report timestamp past their wraps to the latest
+    //     value not later than the given bound.
+    //
+    // Input:
+    //     const uint64_t timestamp - raw report timestamp ticks, higher bits ignored
+    //     const uint64_t bound     - extended timestamp ticks the report is not later than
+    //
+    // Output:
+    //     uint64_t                 - extended timestamp ticks
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t COAConcurrentGroup::ExtendIoStreamTimestamp( const uint64_t timestamp, const uint64_t bound )
+    {
+        const uint64_t extended = ( bound & ~static_cast<uint64_t>( UINT32_MAX ) ) | ( timestamp & UINT32_MAX );
+
+        return ( extended > bound && extended > UINT32_MAX ) ? extended - ( 1ULL << 32 ) : extended;
+    }
+
 } // namespace MetricsDiscoveryInternal
@@ -1146,7 +1146,7 @@ namespace MetricsDiscoveryInternal
 
         if( !m_driverInterface )
         {
-            m_driverInterface = CDriverInterface::CreateInstance( *m_adapterHandle );
+            m_driverInterface = CDriverInterface::CreateInstance( *m_adapterHandle, m_params );
         }
 
         if( m_driverInterface )
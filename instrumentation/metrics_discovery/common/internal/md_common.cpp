@@ -241,6 +241,98 @@ namespace MetricsDiscovery
     {
         return nullptr;
     }
+    TCompletionCode IInternalConcurrentGroup::ReadIoStreamView( uint32_t* reportCount, TIoStreamView* outView, uint32_t readFlags )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::SetIoStreamReaderParams( const TIoStreamReaderParams* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::SetIoStreamReadPolicy( const TIoStreamReadPolicyParams* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::SetIoStreamSamplingControl( const TIoStreamSamplingControlParams* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::SetIoStreamPollParams( const TIoStreamPollParams* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::SetIoStreamOaBufferParams( const TIoStreamOaBufferParams* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalIoStreamGroup* IInternalConcurrentGroup::CreateIoStreamGroup( void )
+    {
+        return nullptr;
+    }
+    TCompletionCode IInternalConcurrentGroup::DeleteIoStreamGroup( IInternalIoStreamGroup* streamGroup )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalIoStreamMerger* IInternalConcurrentGroup::CreateIoStreamMerger( const TIoStreamMergerParams* params )
+    {
+        return nullptr;
+    }
+    TCompletionCode IInternalConcurrentGroup::DeleteIoStreamMerger( IInternalIoStreamMerger* streamMerger )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::StartIoStreamCapture( const char* fileName, const TIoStreamCaptureParams* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::StopIoStreamCapture( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::GetIoStreamStatistics( TIoStreamStatistics* outStatistics )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::ResetIoStreamStatistics( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::SwitchIoStreamMetricSet( IMetricSetLatest* metricSet )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::GetIoStreamMetricSetSwitches( TIoStreamMetricSetSwitch* outSwitches, uint32_t* switchCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IMetricSetLatest* IInternalConcurrentGroup::GetIoStreamReportMetricSet( const uint8_t* rawReport )
+    {
+        return nullptr;
+    }
+    TCompletionCode IInternalConcurrentGroup::PauseIoStream( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::ResumeIoStream( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::SetIoStreamOpenPaused( bool openPaused )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::StartIoStreamDelivery( const TIoStreamDeliveryParams* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::StopIoStreamDelivery( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalConcurrentGroup::GetIoStreamDeliveryStatistics( TIoStreamDeliveryStatistics* outStatistics )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
     IInternalMetricSet::~IInternalMetricSet()
     {
     }
@@ -248,6 +340,184 @@ namespace MetricsDiscovery
     {
         return nullptr;
     }
+    TCompletionCode IInternalMetricSet::CalculateMetricsCollapsed( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalTimeSeries* IInternalMetricSet::CreateTimeSeries( uint32_t blockRowCount )
+    {
+        return nullptr;
+    }
+    TCompletionCode IInternalMetricSet::DeleteTimeSeries( IInternalTimeSeries* timeSeries )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricSet::CalculateMetricsEncoded( const uint8_t* rawData, uint32_t rawDataSize, IInternalTimeSeries* timeSeries, uint32_t* outReportCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricSet::CalculateMetricsAggregated( const TSubDeviceRawData* subDeviceData, uint32_t subDeviceCount, uint64_t toleranceNs, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricSet::CalculateMetricsView( const TIoStreamView* view, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricSet::CalculateIoStreamMetrics( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalIoStreamGroup::~IInternalIoStreamGroup()
+    {
+    }
+    TCompletionCode IInternalIoStreamGroup::AddStream( IConcurrentGroupLatest* concurrentGroup )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalIoStreamGroup::RemoveStream( IConcurrentGroupLatest* concurrentGroup )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    uint32_t IInternalIoStreamGroup::GetStreamCount( void )
+    {
+        return 0;
+    }
+    TCompletionCode IInternalIoStreamGroup::WaitForReports( uint32_t milliseconds, IConcurrentGroupLatest** outReadyGroups, uint32_t outReadyGroupsCount, uint32_t* outReadyCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalIoStreamGroup::SetReadBackend( TIoStreamGroupBackend backend )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalIoStreamGroup::ReadReports( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalIoStreamMerger::~IInternalIoStreamMerger()
+    {
+    }
+    TCompletionCode IInternalIoStreamMerger::AddSource( IConcurrentGroupLatest* concurrentGroup, uint32_t* outSourceIndex )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    uint32_t IInternalIoStreamMerger::GetSourceCount( void )
+    {
+        return 0;
+    }
+    TCompletionCode IInternalIoStreamMerger::ReadReports( TIoStreamMergedReport* outReports, uint32_t outReportsCount, uint32_t* outReportCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalIoStreamCapture::~IInternalIoStreamCapture()
+    {
+    }
+    const TIoStreamCaptureInfo* IInternalIoStreamCapture::GetInfo( void )
+    {
+        return nullptr;
+    }
+    IMetricSetLatest* IInternalIoStreamCapture::GetMetricSet( void )
+    {
+        return nullptr;
+    }
+    TCompletionCode IInternalIoStreamCapture::ReadReports( uint64_t firstReport, uint32_t* reportCount, uint8_t* out, uint32_t outSize )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalIoStreamCapture::CalculateMetrics( uint64_t firstReport, uint32_t* reportCount, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalSideBandSampler::~IInternalSideBandSampler()
+    {
+    }
+    uint32_t IInternalSideBandSampler::GetAttributeCount( void )
+    {
+        return 0;
+    }
+    const char* IInternalSideBandSampler::GetAttributeName( uint32_t index )
+    {
+        return nullptr;
+    }
+    TCompletionCode IInternalSideBandSampler::Start( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalSideBandSampler::Stop( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalSideBandSampler::GetSamples( uint64_t beginCpuNs, uint64_t endCpuNs, TSideBandSample* outSamples, uint32_t* sampleCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalSideBandSampler::GetSampleAt( uint64_t cpuTimestampNs, TSideBandSample* outSample )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalMetricsDevice::~IInternalMetricsDevice()
+    {
+    }
+    TCompletionCode IInternalMetricsDevice::OpenIoStreamCapture( const char* fileName, IInternalIoStreamCapture** outCapture )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricsDevice::CloseIoStreamCapture( IInternalIoStreamCapture* capture )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricsDevice::UpdateTimestampCorrelation( bool force, TTimestampCorrelationInfo* outInfo )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricsDevice::ConvertGpuTimestampsToCpu( const uint64_t* gpuTimestamps, uint64_t* cpuTimestampsNs, uint32_t count )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricsDevice::CreateSideBandSampler( const TSideBandSamplerParams* params, IInternalSideBandSampler** outSampler )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalMetricsDevice::DeleteSideBandSampler( IInternalSideBandSampler* sampler )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    IInternalTimeSeries::~IInternalTimeSeries()
+    {
+    }
+    uint32_t IInternalTimeSeries::GetColumnCount( void )
+    {
+        return 0;
+    }
+    uint32_t IInternalTimeSeries::GetRowCount( void )
+    {
+        return 0;
+    }
+    uint32_t IInternalTimeSeries::GetBlockCount( void )
+    {
+        return 0;
+    }
+    uint64_t IInternalTimeSeries::GetEncodedSize( void )
+    {
+        return 0;
+    }
+    const TTimeSeriesBlockInfo* IInternalTimeSeries::GetBlockInfo( uint32_t index )
+    {
+        return nullptr;
+    }
+    TCompletionCode IInternalTimeSeries::FindBlock( uint64_t timestamp, uint32_t* outIndex )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalTimeSeries::DecodeBlock( uint32_t index, TTypedValue_1_0* out, uint32_t outSize, uint64_t* outTimestamps, uint32_t outTimestampsCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    TCompletionCode IInternalTimeSeries::Clear( void )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
     IAdapterGroup_1_6::~IAdapterGroup_1_6()
     {
     }
@@ -0,0 +1,1042 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_capture.cpp
+
+//     Abstract:   C++ Metrics Discovery internal raw IoStream capture implementation
+
+#include "md_io_stream_capture.h"
+#include "md_adapter.h"
+#include "md_concurrent_group.h"
+#include "md_metric_set.h"
+#include "md_metrics_device.h"
+
+#include "md_utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     CIoStreamCapture constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     CMetricsDevice& device - parent metrics device
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamCapture::CIoStreamCapture( CMetricsDevice& device )
+        : m_device( device )
+        , m_file( nullptr )
+        , m_header{}
+        , m_directIo( false )
+        , m_writeFailed( false )
+        , m_bufferStorage()
+        , m_buffer( nullptr )
+        , m_bufferSize( 0 )
+        , m_bufferOffset( 0 )
+        , m_codec( device.GetAdapter().GetAdapterId() )
+        , m_blockReports()
+        , m_blockReportCount( 0 )
+        , m_encodedBlock()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     ~CIoStreamCapture
+    //
+    // Description:
+    //     Destructor. Stops the capture if still started.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamCapture::~CIoStreamCapture()
+    {
+        if( IsStarted() )
+        {
+            Stop();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     Start
+    //
+    // Description:
+    //     Creates the capture file and writes its header together with
+    //     the description of the captured metric set. The file is then reopened
+    //     unbuffered, so reports are written only with full aligned chunks.
+    //
+    // Input:
+    //     const char*                   fileName  - capture file path
+    //     CMetricSet&                   metricSet - metric set the stream is opened with
+    //     const TIoStreamCaptureParams* params    - capture parameters, nullptr means defaults
+    //
+    // Output:
+    //     TCompletionCode                         - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCapture::Start( const char* fileName, CMetricSet& metricSet, const TIoStreamCaptureParams* params )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, fileName, CC_ERROR_INVALID_PARAMETER );
+
+        if( IsStarted() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: capture already started" );
+            return CC_ALREADY_INITIALIZED;
+        }
+
+        const uint32_t writeSize = ( params && params->WriteSize ) ? params->WriteSize : MD_IO_STREAM_CAPTURE_WRITE_SIZE;
+        const bool     directIo  = params && params->DirectIo;
+        const bool     compress  = params && params->Compress;
+
+        m_header = {};
+        iu_strcpy_s( m_header.Key, sizeof( m_header.Key ), MD_IO_STREAM_CAPTURE_FILE_KEY );
+        iu_strncpy_s( m_header.ConcurrentGroupName, sizeof( m_header.ConcurrentGroupName ), metricSet.GetConcurrentGroup()->GetParams()->SymbolName, sizeof( m_header.ConcurrentGroupName ) - 1 );
+        iu_strncpy_s( m_header.MetricSetName, sizeof( m_header.MetricSetName ), metricSet.GetParams()->SymbolName, sizeof( m_header.MetricSetName ) - 1 );
+        m_header.PlatformIndex = m_device.GetPlatformIndex();
+        m_header.GtType        = static_cast<uint32_t>( m_device.GetGtType() );
+        m_header.RawReportSize = metricSet.GetParams()->RawReportSize;
+        m_header.ReportType    = static_cast<uint32_t>( metricSet.GetReportType() );
+        m_header.Encoding      = MD_IO_STREAM_CAPTURE_ENCODING_RAW;
+
+        if( compress )
+        {
+            if( m_codec.Initialize( m_header.RawReportSize, metricSet.GetReportType() ) == CC_OK )
+            {
+                m_header.Encoding = MD_IO_STREAM_CAPTURE_ENCODING_DELTA;
+            }
+            else
+            {
+                MD_LOG_A( adapterId, LOG_WARNING, "Report layout not supported by the codec, capture will not be compressed" );
+            }
+        }
+
+        iu_fopen_s( &m_file, fileName, "wb" );
+        MD_CHECK_PTR_RET_A( adapterId, m_file, CC_ERROR_FILE_NOT_FOUND );
+
+        // Description of the captured metric set, followed by padding up to the first report
+        fwrite( &m_header, sizeof( m_header ), 1, m_file );
+
+        TCompletionCode ret = m_device.WriteToFile( m_file, 0, 0, &metricSet );
+        if( ret != CC_OK )
+        {
+            fclose( m_file );
+            m_file = nullptr;
+            return ret;
+        }
+
+        const int64_t descriptionEnd = ftell( m_file );
+        const int64_t headerSize     = ( descriptionEnd + MD_IO_STREAM_CAPTURE_ALIGNMENT - 1 ) / MD_IO_STREAM_CAPTURE_ALIGNMENT * MD_IO_STREAM_CAPTURE_ALIGNMENT;
+
+        for( int64_t i = descriptionEnd; i < headerSize; ++i )
+        {
+            fputc( 0, m_file );
+        }
+
+        m_header.HeaderSize      = static_cast<uint32_t>( headerSize );
+        m_header.DescriptionSize = static_cast<uint32_t>( descriptionEnd - sizeof( m_header ) );
+
+        fclose( m_file );
+        m_file = nullptr;
+
+        // Reports are written unbuffered from the aligned staging buffer
+        iu_fopen_s( &m_file, fileName, "r+b" );
+        MD_CHECK_PTR_RET_A( adapterId, m_file, CC_ERROR_FILE_NOT_FOUND );
+
+        setvbuf( m_file, nullptr, _IONBF, 0 );
+
+        m_writeFailed = false;
+        ret           = WriteHeader();
+        if( ret != CC_OK )
+        {
+            fclose( m_file );
+            m_file = nullptr;
+            return ret;
+        }
+
+        m_directIo = directIo && iu_fdirect( m_file, true );
+        if( directIo && !m_directIo )
+        {
+            MD_LOG_A( adapterId, LOG_WARNING, "Direct IO not supported, capture file will use the page cache" );
+        }
+
+        m_bufferSize   = std::max<uint32_t>( writeSize / MD_IO_STREAM_CAPTURE_ALIGNMENT, 1 ) * MD_IO_STREAM_CAPTURE_ALIGNMENT;
+        m_bufferOffset = 0;
+        m_bufferStorage.resize( m_bufferSize + MD_IO_STREAM_CAPTURE_ALIGNMENT );
+        m_blockReportCount = 0;
+        m_blockReports.resize( ( m_header.Encoding == MD_IO_STREAM_CAPTURE_ENCODING_DELTA ) ? MD_IO_STREAM_CODEC_BLOCK_REPORTS * m_header.RawReportSize : 0 );
+
+        const uintptr_t address = reinterpret_cast<uintptr_t>( m_bufferStorage.data() );
+        m_buffer                = m_bufferStorage.data() + ( MD_IO_STREAM_CAPTURE_ALIGNMENT - address % MD_IO_STREAM_CAPTURE_ALIGNMENT ) % MD_IO_STREAM_CAPTURE_ALIGNMENT;
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "Capture started: %s, write size: %u, direct IO: %u, encoding: %u", fileName, m_bufferSize, m_directIo, m_header.Encoding );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     Stop
+    //
+    // Description:
+    //     Writes buffered reports, updates the header with the captured
+    //     report count and closes the capture file.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success, *CC_ERROR_GENERAL* if any write failed
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCapture::Stop()
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        if( !IsStarted() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: capture not started" );
+            return CC_ERROR_GENERAL;
+        }
+
+        if( m_blockReportCount )
+        {
+            EncodeBlock();
+        }
+
+        Flush( true );
+
+        if( m_directIo )
+        {
+            iu_fdirect( m_file, false );
+            m_directIo = false;
+        }
+
+        WriteHeader();
+
+        if( fclose( m_file ) != 0 )
+        {
+            m_writeFailed = true;
+        }
+        m_file = nullptr;
+
+        m_bufferStorage.clear();
+        m_bufferStorage.shrink_to_fit();
+        m_buffer = nullptr;
+
+        m_blockReports.clear();
+        m_blockReports.shrink_to_fit();
+        m_encodedBlock.clear();
+        m_encodedBlock.shrink_to_fit();
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "Capture stopped, reports: %llu", static_cast<unsigned long long>( m_header.ReportCount ) );
+
+        return m_writeFailed ? CC_ERROR_GENERAL : CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     IsStarted
+    //
+    // Description:
+    //     Returns true if the capture file is opened.
+    //
+    // Output:
+    //     bool - true if started
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoStreamCapture::IsStarted() const
+    {
+        return m_file != nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     Write
+    //
+    // Description:
+    //     Appends contiguous raw reports to the capture.
+    //
+    // Input:
+    //     const uint8_t* reportData  - raw reports
+    //     const uint32_t reportCount - raw reports count
+    //
+    // Output:
+    //     TCompletionCode            - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCapture::Write( const uint8_t* reportData, const uint32_t reportCount )
+    {
+        const TIoStreamSpan span = { reportData, m_header.RawReportSize, reportCount };
+        const TIoStreamView view = { &span, 1, reportCount };
+
+        return Write( view, m_header.RawReportSize );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     Write
+    //
+    // Description:
+    //     Appends raw reports of a stream view to the capture. Reports are staged
+    //     in the aligned buffer, which is written when full. With compression
+    //     reports are collected to blocks, which are encoded when full.
+    //
+    // Input:
+    //     const TIoStreamView& view       - raw reports
+    //     const uint32_t       reportSize - raw report size
+    //
+    // Output:
+    //     TCompletionCode                 - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCapture::Write( const TIoStreamView& view, const uint32_t reportSize )
+    {
+        if( !IsStarted() || reportSize != m_header.RawReportSize )
+        {
+            return CC_ERROR_GENERAL;
+        }
+
+        for( uint32_t i = 0; i < view.SpanCount; ++i )
+        {
+            const TIoStreamSpan& span = view.Spans[i];
+
+            for( uint32_t j = 0; j < span.ReportCount; ++j )
+            {
+                const uint8_t* report = span.Data + static_cast<size_t>( j ) * span.Stride;
+
+                if( m_header.Encoding == MD_IO_STREAM_CAPTURE_ENCODING_RAW )
+                {
+                    Append( report, reportSize );
+                    continue;
+                }
+
+                iu_memcpy_s( m_blockReports.data() + m_blockReportCount * reportSize, m_blockReports.size() - m_blockReportCount * reportSize, report, reportSize );
+
+                if( ++m_blockReportCount == MD_IO_STREAM_CODEC_BLOCK_REPORTS )
+                {
+                    EncodeBlock();
+                }
+            }
+
+            m_header.ReportCount += span.ReportCount;
+        }
+
+        return m_writeFailed ? CC_ERROR_GENERAL : CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     SetCoreFrequency
+    //
+    // Description:
+    //     Stores the last core frequency returned by the stream read.
+    //
+    // Input:
+    //     const uint32_t coreFrequencyMhz - gpu core frequency in MHz
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamCapture::SetCoreFrequency( const uint32_t coreFrequencyMhz )
+    {
+        if( coreFrequencyMhz )
+        {
+            m_header.CoreFrequencyMhz = coreFrequencyMhz;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     WriteHeader
+    //
+    // Description:
+    //     Rewrites the header at the beginning of the capture file. Must not be
+    //     used with direct IO enabled, the header is not aligned.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCapture::WriteHeader()
+    {
+        const int64_t position = ftell( m_file );
+
+        if( fseek( m_file, 0, SEEK_SET ) != 0 || fwrite( &m_header, sizeof( m_header ), 1, m_file ) != 1 )
+        {
+            m_writeFailed = true;
+            return CC_ERROR_GENERAL;
+        }
+
+        fseek( m_file, std::max<int64_t>( position, m_header.HeaderSize ), SEEK_SET );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     Append
+    //
+    // Description:
+    //     Copies data to the aligned buffer, writing each filled chunk.
+    //
+    // Input:
+    //     const uint8_t* data - data to write
+    //     const uint32_t size - data size
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamCapture::Append( const uint8_t* data, const uint32_t size )
+    {
+        uint32_t copied = 0;
+
+        // Data may be split between two chunks
+        while( copied < size )
+        {
+            const uint32_t chunkSize = std::min( size - copied, m_bufferSize - m_bufferOffset );
+
+            iu_memcpy_s( m_buffer + m_bufferOffset, m_bufferSize - m_bufferOffset, data + copied, chunkSize );
+            m_bufferOffset += chunkSize;
+            copied += chunkSize;
+
+            if( m_bufferOffset == m_bufferSize )
+            {
+                Flush( false );
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     EncodeBlock
+    //
+    // Description:
+    //     Encodes collected reports as a single block and appends it.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamCapture::EncodeBlock()
+    {
+        m_encodedBlock.clear();
+
+        if( m_codec.Encode( m_blockReports.data(), m_blockReportCount, m_encodedBlock ) == CC_OK )
+        {
+            Append( m_encodedBlock.data(), static_cast<uint32_t>( m_encodedBlock.size() ) );
+        }
+        else
+        {
+            m_writeFailed = true;
+        }
+
+        m_blockReportCount = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCapture
+    //
+    // Method:
+    //     Flush
+    //
+    // Description:
+    //     Writes the staged reports. With direct IO the final partial chunk is
+    //     padded with zeros to the alignment, the padding is not counted
+    //     in the header.
+    //
+    // Input:
+    //     const bool finalFlush - true if the last chunk is written
+    //
+    // Output:
+    //     TCompletionCode       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCapture::Flush( const bool finalFlush )
+    {
+        uint32_t writeSize = m_bufferOffset;
+
+        if( writeSize == 0 )
+        {
+            return CC_OK;
+        }
+
+        if( finalFlush && m_directIo )
+        {
+            writeSize = ( writeSize + MD_IO_STREAM_CAPTURE_ALIGNMENT - 1 ) / MD_IO_STREAM_CAPTURE_ALIGNMENT * MD_IO_STREAM_CAPTURE_ALIGNMENT;
+            memset( m_buffer + m_bufferOffset, 0, writeSize - m_bufferOffset );
+        }
+
+        m_bufferOffset = 0;
+
+        if( fwrite( m_buffer, 1, writeSize, m_file ) != writeSize )
+        {
+            if( !m_writeFailed )
+            {
+                MD_LOG_A( m_device.GetAdapter().GetAdapterId(), LOG_ERROR, "error: capture write failed" );
+            }
+            m_writeFailed = true;
+            return CC_ERROR_GENERAL;
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     CIoStreamCaptureFile constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     CMetricsDevice& hostDevice - metrics device the capture is opened on
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamCaptureFile::CIoStreamCaptureFile( CMetricsDevice& hostDevice )
+        : m_hostDevice( hostDevice )
+        , m_device( nullptr )
+        , m_metricSet( nullptr )
+        , m_file( nullptr )
+        , m_fileSize( 0 )
+        , m_header{}
+        , m_info{}
+        , m_rawData()
+        , m_nextReport( 0 )
+        , m_codec( hostDevice.GetAdapter().GetAdapterId() )
+        , m_blocks()
+        , m_encodedBlock()
+        , m_decodedBlock()
+        , m_decodedBlockIndex( UINT32_MAX )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     ~CIoStreamCaptureFile
+    //
+    // Description:
+    //     Destructor. Closes the capture file and releases the private device.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamCaptureFile::~CIoStreamCaptureFile()
+    {
+        if( m_file != nullptr )
+        {
+            fclose( m_file );
+        }
+
+        MD_SAFE_DELETE( m_device );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     Open
+    //
+    // Description:
+    //     Opens the capture file and recreates the captured metric set from
+    //     its description. Captures which did not stop, e.g. because the process
+    //     crashed, have no report count in the header, their reports are counted
+    //     from the file content.
+    //
+    // Input:
+    //     const char* fileName - capture file path
+    //
+    // Output:
+    //     TCompletionCode      - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCaptureFile::Open( const char* fileName )
+    {
+        const uint32_t adapterId = m_hostDevice.GetAdapter().GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, fileName, CC_ERROR_INVALID_PARAMETER );
+
+        iu_fopen_s( &m_file, fileName, "rb" );
+        MD_CHECK_PTR_RET_A( adapterId, m_file, CC_ERROR_FILE_NOT_FOUND );
+
+        const int64_t fileSize = ( fseek( m_file, 0, SEEK_END ) == 0 ) ? ftell( m_file ) : -1;
+        if( fileSize < 0 || fseek( m_file, 0, SEEK_SET ) != 0 )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: cannot get capture file size" );
+            return CC_ERROR_GENERAL;
+        }
+        m_fileSize = static_cast<uint64_t>( fileSize );
+
+        if( iu_fread_s( &m_header, sizeof( m_header ), sizeof( m_header ), 1, m_file ) != 1 ||
+            strncmp( m_header.Key, MD_IO_STREAM_CAPTURE_FILE_KEY, sizeof( MD_IO_STREAM_CAPTURE_FILE_KEY ) ) != 0 ||
+            m_header.RawReportSize == 0 ||
+            m_header.DescriptionSize <= sizeof( MD_METRICS_FILE_KEY_3_0 ) ||
+            m_header.HeaderSize < sizeof( m_header ) + static_cast<uint64_t>( m_header.DescriptionSize ) ||
+            m_header.HeaderSize > m_fileSize )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: invalid capture file" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        m_header.ConcurrentGroupName[MD_IO_STREAM_CAPTURE_MAX_NAME_SIZE - 1] = '\0';
+        m_header.MetricSetName[MD_IO_STREAM_CAPTURE_MAX_NAME_SIZE - 1]       = '\0';
+
+        std::vector<uint8_t> description( m_header.DescriptionSize );
+        if( iu_fread_s( description.data(), description.size(), 1, description.size(), m_file ) != description.size() ||
+            memcmp( description.data(), MD_METRICS_FILE_KEY_3_0, sizeof( MD_METRICS_FILE_KEY_3_0 ) ) != 0 )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: invalid capture file description" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        // Private device, so captured symbols do not override the host device ones
+        m_device = new( std::nothrow ) CMetricsDevice( m_hostDevice.GetAdapter(), m_hostDevice.GetDriverInterface(), m_hostDevice.GetSubDeviceIndex() );
+        MD_CHECK_PTR_RET_A( adapterId, m_device, CC_ERROR_NO_MEMORY );
+
+        m_device->SetPlatform( m_header.PlatformIndex, static_cast<TGTType>( m_header.GtType ) );
+
+        TCompletionCode ret = m_device->OpenFromFileBuffer( description.data(), m_header.DescriptionSize, CUSTOM_METRICS_FILE_VERSION_3 );
+        MD_CHECK_CC_RET_A( adapterId, ret );
+
+        CConcurrentGroup* group = m_device->GetConcurrentGroupByName( m_header.ConcurrentGroupName );
+        MD_CHECK_PTR_RET_A( adapterId, group, CC_ERROR_INVALID_PARAMETER );
+
+        m_metricSet = group->GetMetricSetByName( m_header.MetricSetName );
+        MD_CHECK_PTR_RET_A( adapterId, m_metricSet, CC_ERROR_INVALID_PARAMETER );
+
+        m_info.ConcurrentGroupName = m_header.ConcurrentGroupName;
+        m_info.MetricSetName       = m_header.MetricSetName;
+        m_info.PlatformIndex       = m_header.PlatformIndex;
+        m_info.RawReportSize       = m_header.RawReportSize;
+        m_info.ReportType          = m_header.ReportType;
+        m_info.CoreFrequencyMhz    = m_header.CoreFrequencyMhz;
+        m_info.Compressed          = m_header.Encoding == MD_IO_STREAM_CAPTURE_ENCODING_DELTA;
+
+        if( m_info.Compressed )
+        {
+            ret = m_codec.Initialize( m_header.RawReportSize, static_cast<TReportType>( m_header.ReportType ) );
+            MD_CHECK_CC_RET_A( adapterId, ret );
+
+            ret = ReadBlockIndex();
+            MD_CHECK_CC_RET_A( adapterId, ret );
+
+            m_info.DataSize = 0;
+            for( auto& block : m_blocks )
+            {
+                m_info.DataSize += block.EncodedSize;
+            }
+        }
+        else if( m_header.Encoding == MD_IO_STREAM_CAPTURE_ENCODING_RAW )
+        {
+            const uint64_t capturedCount = ( m_fileSize - m_header.HeaderSize ) / m_header.RawReportSize;
+
+            if( m_header.ReportCount == 0 )
+            {
+                m_header.ReportCount = capturedCount;
+            }
+            else if( m_header.ReportCount > capturedCount )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: capture file truncated, reports: %llu, expected: %llu", static_cast<unsigned long long>( capturedCount ), static_cast<unsigned long long>( m_header.ReportCount ) );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+
+            m_info.DataSize = m_header.ReportCount * m_header.RawReportSize;
+        }
+        else
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: unknown capture encoding: %u", m_header.Encoding );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        m_info.ReportCount = m_header.ReportCount;
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "Capture opened: %s, %s, reports: %llu", m_header.ConcurrentGroupName, m_header.MetricSetName, static_cast<unsigned long long>( m_header.ReportCount ) );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     GetInfo
+    //
+    // Description:
+    //     Returns description of the capture.
+    //
+    // Output:
+    //     const TIoStreamCaptureInfo* - capture description
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TIoStreamCaptureInfo* CIoStreamCaptureFile::GetInfo( void )
+    {
+        return &m_info;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     GetMetricSet
+    //
+    // Description:
+    //     Returns the recreated captured metric set. It can be used to set API
+    //     filtering and to get metric and information params.
+    //
+    // Output:
+    //     IMetricSetLatest* - captured metric set
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IMetricSetLatest* CIoStreamCaptureFile::GetMetricSet( void )
+    {
+        return m_metricSet;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     ReadReports
+    //
+    // Description:
+    //     Reads captured raw reports.
+    //
+    // Input:
+    //     uint64_t  firstReport - index of the first report to read
+    //     uint32_t* reportCount - (in/out) requested reports / reports read, fewer at the end of capture
+    //     uint8_t*  out         - (out) raw reports
+    //     uint32_t  outSize     - output buffer size in bytes
+    //
+    // Output:
+    //     TCompletionCode       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCaptureFile::ReadReports( uint64_t firstReport, uint32_t* reportCount, uint8_t* out, uint32_t outSize )
+    {
+        const uint32_t adapterId = m_hostDevice.GetAdapter().GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, reportCount, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, out, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, m_file, CC_ERROR_GENERAL );
+
+        const uint32_t reportSize = m_header.RawReportSize;
+        const uint64_t available  = ( firstReport < m_header.ReportCount ) ? m_header.ReportCount - firstReport : 0;
+        const uint32_t count      = static_cast<uint32_t>( std::min<uint64_t>( std::min<uint64_t>( *reportCount, available ), outSize / reportSize ) );
+
+        *reportCount = 0;
+
+        if( count == 0 )
+        {
+            return CC_OK;
+        }
+
+        if( m_info.Compressed )
+        {
+            const TCompletionCode ret = ReadEncodedReports( firstReport, count, out, outSize );
+
+            *reportCount = ( ret == CC_OK ) ? count : 0;
+            return ret;
+        }
+
+        if( fseek( m_file, static_cast<long>( m_header.HeaderSize + firstReport * reportSize ), SEEK_SET ) != 0 )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: capture seek failed" );
+            return CC_ERROR_GENERAL;
+        }
+
+        *reportCount = static_cast<uint32_t>( iu_fread_s( out, outSize, reportSize, count, m_file ) );
+
+        return ( *reportCount == count ) ? CC_OK : CC_ERROR_GENERAL;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     CalculateMetrics
+    //
+    // Description:
+    //     Reads captured raw reports and calculates them with the captured metric
+    //     set, like CalculateMetrics of the metric set. A call continuing where
+    //     the previous one ended calculates its first report against the report
+    //     saved by the metric set. Otherwise the saved report is discarded and
+    //     the report preceding the first one is read as its previous report,
+    //     so the first report of the capture is not calculated.
+    //
+    // Input:
+    //     uint64_t         firstReport    - index of the first report to calculate
+    //     uint32_t*        reportCount    - (in/out) requested reports / raw reports read
+    //     TTypedValue_1_0* out            - (out) calculated values
+    //     uint32_t         outSize        - output buffer size in values
+    //     uint32_t*        outReportCount - (out) calculated reports
+    //
+    // Output:
+    //     TCompletionCode                 - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCaptureFile::CalculateMetrics( uint64_t firstReport, uint32_t* reportCount, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        const uint32_t adapterId = m_hostDevice.GetAdapter().GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, reportCount, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, outReportCount, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, m_metricSet, CC_ERROR_GENERAL );
+
+        const bool     continued     = firstReport == m_nextReport;
+        const uint32_t previousCount = ( !continued && firstReport > 0 && *reportCount < UINT32_MAX ) ? 1 : 0;
+        uint32_t       readCount     = *reportCount + previousCount;
+
+        *outReportCount = 0;
+
+        if( !continued )
+        {
+            m_metricSet->DiscardSavedReport();
+        }
+
+        m_rawData.resize( static_cast<size_t>( readCount ) * m_header.RawReportSize );
+
+        TCompletionCode ret = ReadReports( firstReport - previousCount, &readCount, m_rawData.data(), static_cast<uint32_t>( m_rawData.size() ) );
+        if( ret != CC_OK )
+        {
+            *reportCount = 0;
+            m_nextReport = UINT64_MAX;
+            MD_LOG_A( adapterId, LOG_ERROR, "error: cannot read captured reports" );
+            return ret;
+        }
+
+        *reportCount = readCount > previousCount ? readCount - previousCount : 0;
+        m_nextReport = firstReport + *reportCount;
+
+        if( readCount == 0 )
+        {
+            return CC_OK;
+        }
+
+        return m_metricSet->CalculateMetrics( m_rawData.data(), readCount * m_header.RawReportSize, out, outSize, outReportCount, false );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     ReadBlockIndex
+    //
+    // Description:
+    //     Walks encoded block headers of a compressed capture and stores
+    //     their positions for random access. Blocks are validated against
+    //     the file size before they are read. For a capture which did not stop,
+    //     blocks are read up to the end of the file, a truncated last block is
+    //     ignored, and the report count is taken from the blocks.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCaptureFile::ReadBlockIndex()
+    {
+        const uint32_t adapterId   = m_hostDevice.GetAdapter().GetAdapterId();
+        const bool     stopped     = m_header.ReportCount != 0;
+        uint64_t       offset      = m_header.HeaderSize;
+        uint64_t       reportCount = 0;
+
+        m_blocks.clear();
+
+        while( stopped ? reportCount < m_header.ReportCount : offset + sizeof( TIoStreamCodecBlockHeader ) <= m_fileSize )
+        {
+            TIoStreamCodecBlockHeader blockHeader = {};
+
+            if( fseek( m_file, static_cast<long>( offset ), SEEK_SET ) != 0 ||
+                iu_fread_s( &blockHeader, sizeof( blockHeader ), sizeof( blockHeader ), 1, m_file ) != 1 )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: capture block read failed at: %llu", static_cast<unsigned long long>( offset ) );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+
+            if( !stopped && blockHeader.ReportCount == 0 )
+            {
+                break; // Padding after the last written block
+            }
+
+            if( blockHeader.ReportCount == 0 ||
+                blockHeader.ReportCount > MD_IO_STREAM_CODEC_BLOCK_REPORTS ||
+                blockHeader.EncodedSize <= sizeof( blockHeader ) )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: invalid capture block at: %llu", static_cast<unsigned long long>( offset ) );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+
+            if( blockHeader.EncodedSize > m_fileSize - offset )
+            {
+                if( !stopped )
+                {
+                    MD_LOG_A( adapterId, LOG_WARNING, "warning: truncated capture block ignored at: %llu", static_cast<unsigned long long>( offset ) );
+                    break;
+                }
+
+                MD_LOG_A( adapterId, LOG_ERROR, "error: capture block exceeds the file at: %llu", static_cast<unsigned long long>( offset ) );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+
+            m_blocks.push_back( { reportCount, offset, blockHeader.ReportCount, blockHeader.EncodedSize } );
+
+            offset += blockHeader.EncodedSize;
+            reportCount += blockHeader.ReportCount;
+        }
+
+        if( stopped && reportCount != m_header.ReportCount )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: capture blocks hold %llu reports, expected: %llu", static_cast<unsigned long long>( reportCount ), static_cast<unsigned long long>( m_header.ReportCount ) );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        m_header.ReportCount = reportCount;
+        m_decodedBlockIndex  = UINT32_MAX;
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCaptureFile
+    //
+    // Method:
+    //     ReadEncodedReports
+    //
+    // Description:
+    //     Reads reports of a compressed capture. Blocks are decoded as a whole,
+    //     the last decoded block is kept for sequential reads.
+    //
+    // Input:
+    //     uint64_t       firstReport - index of the first report to read
+    //     const uint32_t reportCount - reports to read, all must be captured
+    //     uint8_t*       out         - (out) raw reports
+    //     const uint32_t outSize     - output buffer size in bytes
+    //
+    // Output:
+    //     TCompletionCode            - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCaptureFile::ReadEncodedReports( uint64_t firstReport, const uint32_t reportCount, uint8_t* out, const uint32_t outSize )
+    {
+        const uint32_t adapterId  = m_hostDevice.GetAdapter().GetAdapterId();
+        const uint32_t reportSize = m_header.RawReportSize;
+        uint32_t       readCount  = 0;
+
+        while( readCount < reportCount )
+        {
+            // Last block starting before the report
+            auto block = std::upper_bound( m_blocks.begin(), m_blocks.end(), firstReport, []( const uint64_t report, const TIoStreamCaptureBlock& item )
+                { return report < item.FirstReport; } );
+            if( block == m_blocks.begin() )
+            {
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+            --block;
+
+            const uint32_t blockIndex = static_cast<uint32_t>( std::distance( m_blocks.begin(), block ) );
+
+            if( blockIndex != m_decodedBlockIndex )
+            {
+                uint32_t decodedCount = 0;
+
+                m_decodedBlockIndex = UINT32_MAX;
+                m_encodedBlock.resize( block->EncodedSize );
+                m_decodedBlock.resize( static_cast<size_t>( block->ReportCount ) * reportSize );
+
+                if( fseek( m_file, static_cast<long>( block->Offset ), SEEK_SET ) != 0 ||
+                    iu_fread_s( m_encodedBlock.data(), m_encodedBlock.size(), 1, m_encodedBlock.size(), m_file ) != m_encodedBlock.size() )
+                {
+                    MD_LOG_A( adapterId, LOG_ERROR, "error: capture block read failed" );
+                    return CC_ERROR_GENERAL;
+                }
+
+                TCompletionCode ret = m_codec.Decode( m_encodedBlock.data(), block->EncodedSize, m_decodedBlock.data(), static_cast<uint32_t>( m_decodedBlock.size() ), decodedCount );
+                MD_CHECK_CC_RET_A( adapterId, ret );
+
+                if( decodedCount != block->ReportCount )
+                {
+                    return CC_ERROR_INVALID_PARAMETER;
+                }
+
+                m_decodedBlockIndex = blockIndex;
+            }
+
+            const uint32_t blockOffset = static_cast<uint32_t>( firstReport - block->FirstReport );
+            const uint32_t count       = std::min( block->ReportCount - blockOffset, reportCount - readCount );
+
+            iu_memcpy_s( out + static_cast<size_t>( readCount ) * reportSize, outSize - readCount * reportSize, m_decodedBlock.data() + static_cast<size_t>( blockOffset ) * reportSize, static_cast<size_t>( count ) * reportSize );
+
+            readCount += count;
+            firstReport += count;
+        }
+
+        return CC_OK;
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,579 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_codec.cpp
+
+//     Abstract:   C++ Metrics Discovery internal lossless raw report codec implementation
+
+#include "md_io_stream_codec.h"
+
+#include "md_utils.h"
+
+#include <cstring>
+
+#define MD_IO_STREAM_CODEC_MODE_SHIFT 6
+#define MD_IO_STREAM_CODEC_WIDTH_MASK 0x3F
+#define MD_IO_STREAM_CODEC_BYTE_LANES 4
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery IoStream Codec
+    //
+    // Function:
+    //     ZigZagEncode32 / ZigZagDecode32 / ZigZagEncode8 / ZigZagDecode8
+    //
+    // Description:
+    //     Maps signed deltas to unsigned values, so small negative deltas, e.g.
+    //     of wrapped counters, are packed with a few bits as well. The byte
+    //     variants work on all 4 byte lanes of a column at once.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint32_t ZigZagEncode32( const uint32_t delta )
+    {
+        return ( delta << 1 ) ^ static_cast<uint32_t>( static_cast<int32_t>( delta ) >> 31 );
+    }
+
+    static inline uint32_t ZigZagDecode32( const uint32_t value )
+    {
+        return ( value >> 1 ) ^ ( 0 - ( value & 1 ) );
+    }
+
+    static inline uint32_t ZigZagEncode8( const uint32_t delta )
+    {
+        const uint32_t sign = ( delta >> 7 ) & 0x01010101;
+        return ( ( delta << 1 ) & 0xFEFEFEFE ) ^ ( sign * 0xFF );
+    }
+
+    static inline uint32_t ZigZagDecode8( const uint32_t value )
+    {
+        const uint32_t sign = value & 0x01010101;
+        return ( ( value >> 1 ) & 0x7F7F7F7F ) ^ ( sign * 0xFF );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery IoStream Codec
+    //
+    // Function:
+    //     Sub8 / Add8
+    //
+    // Description:
+    //     Subtracts / adds 4 byte lanes without carries between them.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint32_t Sub8( const uint32_t value, const uint32_t prev )
+    {
+        return ( ( value | 0x80808080 ) - ( prev & 0x7F7F7F7F ) ) ^ ( ( value ^ ~prev ) & 0x80808080 );
+    }
+
+    static inline uint32_t Add8( const uint32_t prev, const uint32_t delta )
+    {
+        return ( ( prev & 0x7F7F7F7F ) + ( delta & 0x7F7F7F7F ) ) ^ ( ( prev ^ delta ) & 0x80808080 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery IoStream Codec
+    //
+    // Function:
+    //     GetBitWidth
+    //
+    // Description:
+    //     Returns number of bits needed to store the value.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint32_t GetBitWidth( uint32_t value )
+    {
+        uint32_t width = 0;
+        for( ; value; value >>= 1 )
+        {
+            ++width;
+        }
+        return width;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery IoStream Codec
+    //
+    // Function:
+    //     LoadColumn
+    //
+    // Description:
+    //     Returns 32 bit column of a raw report. Reports are not aligned.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint32_t LoadColumn( const uint8_t* report, const uint32_t column )
+    {
+        uint32_t value = 0;
+        memcpy( &value, report + column * sizeof( uint32_t ), sizeof( value ) );
+        return value;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery IoStream Codec
+    //
+    // Function:
+    //     GetColumnValue
+    //
+    // Description:
+    //     Returns value stored for a column of a report in the given mode.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint32_t GetColumnValue( const uint32_t mode, const uint32_t value, const uint32_t prev )
+    {
+        switch( mode )
+        {
+            case IO_STREAM_CODEC_MODE_DELTA8:
+                return ZigZagEncode8( Sub8( value, prev ) );
+            case IO_STREAM_CODEC_MODE_XOR:
+                return value ^ prev;
+            default:
+                return ZigZagEncode32( value - prev );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Method:
+    //     CIoStreamCodec constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     const uint32_t adapterId - adapter id for logging
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamCodec::CIoStreamCodec( const uint32_t adapterId )
+        : m_adapterId( adapterId )
+        , m_reportSize( 0 )
+        , m_columnCount( 0 )
+        , m_useByteLanes( false )
+        , m_values()
+        , m_masks()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Method:
+    //     ~CIoStreamCodec
+    //
+    // Description:
+    //     Destructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamCodec::~CIoStreamCodec()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Method:
+    //     Initialize
+    //
+    // Description:
+    //     Sets raw report layout. Report size must be a multiple of 32 bits.
+    //
+    // Input:
+    //     const uint32_t    reportSize - raw report size
+    //     const TReportType reportType - raw report layout
+    //
+    // Output:
+    //     TCompletionCode              - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCodec::Initialize( const uint32_t reportSize, const TReportType reportType )
+    {
+        if( reportSize == 0 || reportSize % sizeof( uint32_t ) )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "raw report size not supported: %u", reportSize );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        m_reportSize  = reportSize;
+        m_columnCount = reportSize / sizeof( uint32_t );
+
+        // Layouts with A counters above 32 bits keep their high bytes packed
+        switch( reportType )
+        {
+            case OA_REPORT_TYPE_192B_A29_NOA16:
+            case OA_REPORT_TYPE_256B_A45_NOA16:
+            case OA_REPORT_TYPE_128B_A29:
+            case OA_REPORT_TYPE_192B_MPEC8LL_NOA16:
+                m_useByteLanes = true;
+                break;
+
+            default:
+                m_useByteLanes = false;
+                break;
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Method:
+    //     Encode
+    //
+    // Description:
+    //     Encodes raw reports as a single independently decodable block and
+    //     appends it to the output. Block layout: header, first report, one
+    //     descriptor byte per column (mode and bit width), bit packed columns
+    //     each starting at a byte boundary, padding.
+    //
+    // Input:
+    //     const uint8_t*        reports     - contiguous raw reports
+    //     const uint32_t        reportCount - raw reports count
+    //     std::vector<uint8_t>& out         - (out) encoded block is appended
+    //
+    // Output:
+    //     TCompletionCode                   - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCodec::Encode( const uint8_t* reports, const uint32_t reportCount, std::vector<uint8_t>& out )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, reports, CC_ERROR_INVALID_PARAMETER );
+
+        if( m_columnCount == 0 || reportCount == 0 )
+        {
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        const size_t blockOffset = out.size();
+
+        // Header is patched at the end, first report is stored as is
+        out.resize( blockOffset + sizeof( TIoStreamCodecBlockHeader ) );
+        out.insert( out.end(), reports, reports + m_reportSize );
+
+        // Mode candidates, width of all values of each column
+        std::vector<uint32_t> orMasks( m_columnCount * IO_STREAM_CODEC_MODE_LAST, 0 );
+        uint32_t*             orDelta32 = orMasks.data();
+        uint32_t*             orDelta8  = orDelta32 + m_columnCount;
+        uint32_t*             orXor     = orDelta8 + m_columnCount;
+
+        for( uint32_t i = 1; i < reportCount; ++i )
+        {
+            const uint8_t* report = reports + static_cast<size_t>( i ) * m_reportSize;
+            const uint8_t* prev   = report - m_reportSize;
+
+            for( uint32_t j = 0; j < m_columnCount; ++j )
+            {
+                const uint32_t value     = LoadColumn( report, j );
+                const uint32_t prevValue = LoadColumn( prev, j );
+
+                orDelta32[j] |= ZigZagEncode32( value - prevValue );
+                orDelta8[j] |= ZigZagEncode8( Sub8( value, prevValue ) );
+                orXor[j] |= value ^ prevValue;
+            }
+        }
+
+        const size_t descriptorOffset = out.size();
+        out.resize( descriptorOffset + m_columnCount );
+
+        for( uint32_t j = 0; j < m_columnCount; ++j )
+        {
+            const uint32_t lanes       = orDelta8[j];
+            uint32_t       mode        = IO_STREAM_CODEC_MODE_DELTA32;
+            uint32_t       width       = GetBitWidth( orDelta32[j] );
+            const uint32_t xorWidth    = GetBitWidth( orXor[j] );
+            const uint32_t delta8Width = GetBitWidth( ( lanes | ( lanes >> 8 ) | ( lanes >> 16 ) | ( lanes >> 24 ) ) & 0xFF );
+
+            if( xorWidth < width )
+            {
+                mode  = IO_STREAM_CODEC_MODE_XOR;
+                width = xorWidth;
+            }
+            if( m_useByteLanes && delta8Width * MD_IO_STREAM_CODEC_BYTE_LANES < width )
+            {
+                mode  = IO_STREAM_CODEC_MODE_DELTA8;
+                width = delta8Width;
+            }
+
+            out[descriptorOffset + j] = static_cast<uint8_t>( ( mode << MD_IO_STREAM_CODEC_MODE_SHIFT ) | width );
+        }
+
+        for( uint32_t j = 0; j < m_columnCount; ++j )
+        {
+            const uint8_t descriptor = out[descriptorOffset + j];
+
+            m_values.resize( reportCount );
+            for( uint32_t i = 1; i < reportCount; ++i )
+            {
+                const uint8_t* report = reports + static_cast<size_t>( i ) * m_reportSize;
+                m_values[i] = GetColumnValue( descriptor >> MD_IO_STREAM_CODEC_MODE_SHIFT, LoadColumn( report, j ), LoadColumn( report - m_reportSize, j ) );
+            }
+
+            WriteColumn( out, j, descriptor >> MD_IO_STREAM_CODEC_MODE_SHIFT, descriptor & MD_IO_STREAM_CODEC_WIDTH_MASK, reportCount );
+        }
+
+        out.resize( out.size() + MD_IO_STREAM_CODEC_PADDING, 0 );
+
+        const TIoStreamCodecBlockHeader header = { reportCount, static_cast<uint32_t>( out.size() - blockOffset ) };
+        memcpy( out.data() + blockOffset, &header, sizeof( header ) );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Method:
+    //     Decode
+    //
+    // Description:
+    //     Decodes a block created with Encode. Columns are unpacked to row major
+    //     deltas first, then reports are rebuilt row by row, applying the mode of
+    //     each column with masks, so the inner loop has no branches.
+    //
+    // Input:
+    //     const uint8_t* block       - encoded block
+    //     const uint32_t blockSize   - available bytes, at least the encoded block size
+    //     uint8_t*       out         - (out) raw reports
+    //     const uint32_t outSize     - output buffer size
+    //     uint32_t&      reportCount - (out) decoded reports
+    //
+    // Output:
+    //     TCompletionCode            - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamCodec::Decode( const uint8_t* block, const uint32_t blockSize, uint8_t* out, const uint32_t outSize, uint32_t& reportCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, block, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, out, CC_ERROR_INVALID_PARAMETER );
+
+        TIoStreamCodecBlockHeader header = {};
+        reportCount                      = 0;
+
+        if( m_columnCount == 0 || blockSize < sizeof( header ) )
+        {
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        memcpy( &header, block, sizeof( header ) );
+
+        const uint32_t columnsOffset = sizeof( header ) + m_reportSize + m_columnCount;
+        const uint8_t* descriptors   = block + sizeof( header ) + m_reportSize;
+
+        if( header.ReportCount == 0 || header.EncodedSize > blockSize || header.EncodedSize < columnsOffset + MD_IO_STREAM_CODEC_PADDING ||
+            static_cast<uint64_t>( header.ReportCount ) * m_reportSize > outSize )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: invalid encoded block" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        const uint32_t rowCount = header.ReportCount;
+
+        m_values.resize( static_cast<size_t>( rowCount ) * m_columnCount );
+        m_masks.resize( m_columnCount * IO_STREAM_CODEC_MODE_LAST );
+
+        uint32_t* maskDelta32 = m_masks.data();
+        uint32_t* maskDelta8  = maskDelta32 + m_columnCount;
+        uint32_t* maskXor     = maskDelta8 + m_columnCount;
+
+        // The first report
+        memcpy( m_values.data(), block + sizeof( header ), m_reportSize );
+
+        // Unpack columns
+        uint64_t columnOffset = columnsOffset;
+        for( uint32_t j = 0; j < m_columnCount; ++j )
+        {
+            const uint32_t mode  = descriptors[j] >> MD_IO_STREAM_CODEC_MODE_SHIFT;
+            const uint32_t width = descriptors[j] & MD_IO_STREAM_CODEC_WIDTH_MASK;
+
+            if( mode >= IO_STREAM_CODEC_MODE_LAST || width > ( mode == IO_STREAM_CODEC_MODE_DELTA8 ? MD_BITS_PER_BYTE : 32 ) )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: invalid column encoding" );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+
+            maskDelta32[j] = ( mode == IO_STREAM_CODEC_MODE_DELTA32 ) ? 0xFFFFFFFF : 0;
+            maskDelta8[j]  = ( mode == IO_STREAM_CODEC_MODE_DELTA8 ) ? 0xFFFFFFFF : 0;
+            maskXor[j]     = ( mode == IO_STREAM_CODEC_MODE_XOR ) ? 0xFFFFFFFF : 0;
+
+            const uint8_t* data      = block + columnOffset;
+            const uint64_t valueMask = ( 1ull << width ) - 1;
+
+            columnOffset += GetColumnSize( mode, width, rowCount );
+            if( columnOffset + MD_IO_STREAM_CODEC_PADDING > header.EncodedSize )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: invalid encoded block size" );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+
+            if( mode == IO_STREAM_CODEC_MODE_DELTA8 )
+            {
+                for( uint32_t i = 1; i < rowCount; ++i )
+                {
+                    uint32_t value = 0;
+                    for( uint32_t k = 0; k < MD_IO_STREAM_CODEC_BYTE_LANES; ++k )
+                    {
+                        const uint64_t bitPosition = ( static_cast<uint64_t>( i - 1 ) * MD_IO_STREAM_CODEC_BYTE_LANES + k ) * width;
+                        uint64_t       bits        = 0;
+
+                        memcpy( &bits, data + bitPosition / MD_BITS_PER_BYTE, sizeof( bits ) );
+                        value |= static_cast<uint32_t>( ( bits >> ( bitPosition % MD_BITS_PER_BYTE ) ) & valueMask ) << ( k * MD_BITS_PER_BYTE );
+                    }
+                    m_values[static_cast<size_t>( i ) * m_columnCount + j] = ZigZagDecode8( value );
+                }
+            }
+            else
+            {
+                for( uint32_t i = 1; i < rowCount; ++i )
+                {
+                    const uint64_t bitPosition = static_cast<uint64_t>( i - 1 ) * width;
+                    uint64_t       bits        = 0;
+
+                    memcpy( &bits, data + bitPosition / MD_BITS_PER_BYTE, sizeof( bits ) );
+
+                    const uint32_t value = static_cast<uint32_t>( ( bits >> ( bitPosition % MD_BITS_PER_BYTE ) ) & valueMask );
+
+                    m_values[static_cast<size_t>( i ) * m_columnCount + j] = ( mode == IO_STREAM_CODEC_MODE_XOR ) ? value : ZigZagDecode32( value );
+                }
+            }
+        }
+
+        // Rebuild reports, columns are independent
+        for( uint32_t i = 1; i < rowCount; ++i )
+        {
+            const uint32_t* prev = m_values.data() + static_cast<size_t>( i - 1 ) * m_columnCount;
+            uint32_t*       row  = m_values.data() + static_cast<size_t>( i ) * m_columnCount;
+
+            for( uint32_t j = 0; j < m_columnCount; ++j )
+            {
+                const uint32_t delta = row[j];
+
+                row[j] = ( ( prev[j] + delta ) & maskDelta32[j] ) | ( Add8( prev[j], delta ) & maskDelta8[j] ) | ( ( prev[j] ^ delta ) & maskXor[j] );
+            }
+        }
+
+        memcpy( out, m_values.data(), static_cast<size_t>( rowCount ) * m_reportSize );
+        reportCount = rowCount;
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Method:
+    //     WriteColumn
+    //
+    // Description:
+    //     Bit packs values of a column, prepared in m_values, starting at a byte
+    //     boundary. Values of a byte lane column are packed per lane.
+    //
+    // Input:
+    //     std::vector<uint8_t>& out      - (out) packed values are appended
+    //     const uint32_t        column   - column index
+    //     const uint32_t        mode     - column mode
+    //     const uint32_t        width    - bit width of a single value
+    //     const uint32_t        rowCount - rows in the block, including the first report
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamCodec::WriteColumn( std::vector<uint8_t>& out, const uint32_t column, const uint32_t mode, const uint32_t width, const uint32_t rowCount )
+    {
+        const size_t offset = out.size();
+        const size_t size   = GetColumnSize( mode, width, rowCount );
+
+        MD_ASSERT_A( m_adapterId, column < m_columnCount );
+
+        if( size == 0 )
+        {
+            return;
+        }
+
+        const uint32_t lanes = ( mode == IO_STREAM_CODEC_MODE_DELTA8 ) ? MD_IO_STREAM_CODEC_BYTE_LANES : 1;
+        const uint32_t shift = ( mode == IO_STREAM_CODEC_MODE_DELTA8 ) ? MD_BITS_PER_BYTE : 0;
+        uint64_t       bits  = 0;
+        uint32_t       count = 0;
+        size_t         index = offset;
+
+        out.resize( offset + size, 0 );
+
+        for( uint32_t i = 1; i < rowCount; ++i )
+        {
+            uint32_t value = m_values[i];
+
+            for( uint32_t k = 0; k < lanes; ++k )
+            {
+                const uint32_t laneValue = lanes > 1 ? ( value & 0xFF ) : value;
+
+                bits |= static_cast<uint64_t>( laneValue ) << count;
+                count += width;
+                value = shift ? ( value >> shift ) : 0;
+
+                while( count >= MD_BITS_PER_BYTE )
+                {
+                    out[index++] = static_cast<uint8_t>( bits );
+                    bits >>= MD_BITS_PER_BYTE;
+                    count -= MD_BITS_PER_BYTE;
+                }
+            }
+        }
+
+        if( count )
+        {
+            out[index] = static_cast<uint8_t>( bits );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamCodec
+    //
+    // Method:
+    //     GetColumnSize
+    //
+    // Description:
+    //     Returns size of a packed column in bytes.
+    //
+    // Input:
+    //     const uint32_t mode     - column mode
+    //     const uint32_t width    - bit width of a single value
+    //     const uint32_t rowCount - rows in the block, including the first report
+    //
+    // Output:
+    //     uint32_t                - packed column size
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamCodec::GetColumnSize( const uint32_t mode, const uint32_t width, const uint32_t rowCount ) const
+    {
+        const uint64_t lanes = ( mode == IO_STREAM_CODEC_MODE_DELTA8 ) ? MD_IO_STREAM_CODEC_BYTE_LANES : 1;
+        const uint64_t bits  = static_cast<uint64_t>( rowCount - 1 ) * lanes * width;
+
+        return static_cast<uint32_t>( ( bits + MD_BITS_PER_BYTE - 1 ) / MD_BITS_PER_BYTE );
+    }
+} // namespace MetricsDiscoveryInternal
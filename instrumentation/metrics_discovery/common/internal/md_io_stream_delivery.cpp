@@ -0,0 +1,1077 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_delivery.cpp
+
+//     Abstract:   C++ Metrics Discovery callback driven IoStream delivery implementation
+
+#include "md_io_stream_delivery.h"
+#include "md_oa_concurrent_group.h"
+#include "md_metric_set.h"
+
+#include "md_utils.h"
+
+#include <algorithm>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     CIoStreamDelivery constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     COAConcurrentGroup& concurrentGroup - concurrent group of the delivered stream
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamDelivery::CIoStreamDelivery( COAConcurrentGroup& concurrentGroup )
+        : m_concurrentGroup( concurrentGroup )
+        , m_params{}
+        , m_adapterId( IU_ADAPTER_ID_UNKNOWN )
+        , m_rawReportSize( 0 )
+        , m_sequenceNumber( 0 )
+        , m_buffers()
+        , m_freeBuffers()
+        , m_calculateQueue()
+        , m_exportQueue()
+        , m_mutex()
+        , m_freeCondition()
+        , m_calculateCondition()
+        , m_exportCondition()
+        , m_statistics{}
+        , m_pendingLostReportCount( 0 )
+        , m_readDone( false )
+        , m_calculateDone( false )
+        , m_readThread()
+        , m_calculateThread()
+        , m_exportThread()
+        , m_stop( false )
+        , m_overflowCapture( concurrentGroup.GetMetricsDevice() )
+        , m_transitionReportCount( 0 )
+        , m_lastMetricSet( nullptr )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     ~CIoStreamDelivery
+    //
+    // Description:
+    //     Destructor. The delivery has to be stopped before the concurrent group
+    //     is destroyed, stopping here is a fallback.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamDelivery::~CIoStreamDelivery()
+    {
+        Stop();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     Start
+    //
+    // Description:
+    //     Allocates batch buffers and starts the delivery threads. The stream has
+    //     to be opened and must not be read by the client until Stop. Overflow
+    //     policies apply to the pipelined executor only, the single thread
+    //     executor always blocks.
+    //
+    // Input:
+    //     const TIoStreamDeliveryParams& params        - delivery parameters
+    //     const uint32_t                 adapterId     - adapter id for logging
+    //     const uint32_t                 rawReportSize - raw report size of the opened stream
+    //
+    // Output:
+    //     TCompletionCode                              - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamDelivery::Start( const TIoStreamDeliveryParams& params, const uint32_t adapterId, const uint32_t rawReportSize )
+    {
+        m_adapterId = adapterId;
+
+        if( IsStarted() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: IoStream delivery already started" );
+            return CC_ALREADY_INITIALIZED;
+        }
+        if( params.Callback == nullptr || rawReportSize == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: invalid IoStream delivery parameters" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( params.Mode != IO_STREAM_DELIVERY_MODE_RAW && params.Mode != IO_STREAM_DELIVERY_MODE_CALCULATED )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: unknown IoStream delivery mode: %u", params.Mode );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( params.OverflowPolicy > IO_STREAM_DELIVERY_OVERFLOW_CAPTURE )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: unknown IoStream delivery overflow policy: %u", params.OverflowPolicy );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( params.OverflowPolicy == IO_STREAM_DELIVERY_OVERFLOW_DECIMATE && ( params.DecimationFactor == 1 || params.DecimationFactor > MD_IO_STREAM_DELIVERY_MAX_DECIMATION ) )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: invalid IoStream delivery decimation factor: %u, max: %u", params.DecimationFactor, MD_IO_STREAM_DELIVERY_MAX_DECIMATION );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( params.OverflowPolicy == IO_STREAM_DELIVERY_OVERFLOW_CAPTURE && params.OverflowCaptureFile == nullptr )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: IoStream delivery overflow capture file not set" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        const bool pipelined = params.Executor != IO_STREAM_DELIVERY_EXECUTOR_SINGLE_THREAD;
+
+        m_params                  = params;
+        m_params.BatchReportCount = params.BatchReportCount ? params.BatchReportCount : MD_IO_STREAM_DELIVERY_DEFAULT_BATCH_REPORTS;
+        m_params.MaxLatencyMs     = params.MaxLatencyMs ? params.MaxLatencyMs : MD_IO_STREAM_DELIVERY_DEFAULT_LATENCY_MS;
+        m_params.QueueDepth       = pipelined ? std::max<uint32_t>( params.QueueDepth ? params.QueueDepth : MD_IO_STREAM_DELIVERY_DEFAULT_QUEUE_DEPTH, MD_IO_STREAM_DELIVERY_MIN_QUEUE_DEPTH ) : MD_IO_STREAM_DELIVERY_SINGLE_THREAD_BUFFERS;
+        m_params.OverflowPolicy   = pipelined ? params.OverflowPolicy : IO_STREAM_DELIVERY_OVERFLOW_BLOCK;
+        m_params.DecimationFactor = params.DecimationFactor ? params.DecimationFactor : MD_IO_STREAM_DELIVERY_DEFAULT_DECIMATION;
+        m_rawReportSize           = rawReportSize;
+        m_sequenceNumber          = 0;
+        m_lastMetricSet           = nullptr;
+
+        // Batch buffers are allocated once, reads go directly into them
+        m_buffers.resize( m_params.QueueDepth );
+        m_freeBuffers.clear();
+        m_calculateQueue.clear();
+        m_exportQueue.clear();
+
+        for( uint32_t i = 0; i < m_params.QueueDepth; ++i )
+        {
+            m_buffers[i].RawData.resize( static_cast<size_t>( m_params.BatchReportCount ) * m_rawReportSize );
+            m_freeBuffers.push_back( i );
+        }
+
+        m_statistics             = {};
+        m_statistics.BufferCount = m_params.QueueDepth;
+        m_pendingLostReportCount = 0;
+        m_transitionReportCount  = 0;
+        m_stop                   = false;
+        m_readDone               = false;
+        m_calculateDone          = false;
+
+        m_readThread = std::thread( &CIoStreamDelivery::ReadThread, this );
+        if( pipelined )
+        {
+            m_calculateThread = std::thread( &CIoStreamDelivery::CalculateThread, this );
+            m_exportThread    = std::thread( &CIoStreamDelivery::ExportThread, this );
+        }
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "IoStream delivery started, batch reports: %u, max latency: %u ms, buffers: %u, overflow policy: %u", m_params.BatchReportCount, m_params.MaxLatencyMs, m_params.QueueDepth, m_params.OverflowPolicy );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     Stop
+    //
+    // Description:
+    //     Stops reading and waits until reports already read are delivered.
+    //     Cannot be called from the callback.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamDelivery::Stop()
+    {
+        if( !IsStarted() )
+        {
+            return CC_OK;
+        }
+
+        const auto threadId = std::this_thread::get_id();
+        if( threadId == m_readThread.get_id() || threadId == m_calculateThread.get_id() || threadId == m_exportThread.get_id() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: IoStream delivery cannot be stopped from the callback" );
+            return CC_ERROR_GENERAL;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+        }
+        m_freeCondition.notify_all();
+
+        m_readThread.join();
+
+        if( m_calculateThread.joinable() )
+        {
+            m_calculateThread.join();
+        }
+        if( m_exportThread.joinable() )
+        {
+            m_exportThread.join();
+        }
+        if( m_overflowCapture.IsStarted() )
+        {
+            m_overflowCapture.Stop();
+        }
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "IoStream delivery stopped, batches: %llu, dropped batches: %llu, overflows: %llu", static_cast<unsigned long long>( m_sequenceNumber ), static_cast<unsigned long long>( m_statistics.DroppedBatchCount ), static_cast<unsigned long long>( m_statistics.OverflowCount ) );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     IsStarted
+    //
+    // Description:
+    //     Returns whether the delivery is started.
+    //
+    // Output:
+    //     bool - *true* if started
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoStreamDelivery::IsStarted() const
+    {
+        return m_readThread.joinable();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     IsReadThread
+    //
+    // Description:
+    //     Returns whether called from the delivery read thread, the only thread
+    //     allowed to read the stream while the delivery is started.
+    //
+    // Output:
+    //     bool - *true* if called from the read thread
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoStreamDelivery::IsReadThread() const
+    {
+        return std::this_thread::get_id() == m_readThread.get_id();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     GetStatistics
+    //
+    // Description:
+    //     Returns statistics of the running or the last delivery.
+    //
+    // Output:
+    //     TIoStreamDeliveryStatistics& statistics - delivery statistics
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::GetStatistics( TIoStreamDeliveryStatistics& statistics )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        statistics                         = m_statistics;
+        statistics.CalculateQueueOccupancy = static_cast<uint32_t>( m_calculateQueue.size() );
+        statistics.ExportQueueOccupancy    = static_cast<uint32_t>( m_exportQueue.size() );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     ReadThread
+    //
+    // Description:
+    //     Waits for reports and reads them into the current batch buffer until
+    //     the batch is full or its oldest report reached the latency target.
+    //     Single wait is bounded, so stop requests are noticed. A read error is
+    //     delivered with the last batch and ends the delivery. With decimate and
+    //     capture overflow policies a ready batch is held while no buffer is
+    //     free and reading continues into it, the policy makes room once it is
+    //     full, so the OA buffer is drained even if the callback falls behind.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::ReadThread()
+    {
+        const auto maxLatency = std::chrono::milliseconds( m_params.MaxLatencyMs );
+        const bool holdBatch  = m_params.OverflowPolicy == IO_STREAM_DELIVERY_OVERFLOW_DECIMATE || m_params.OverflowPolicy == IO_STREAM_DELIVERY_OVERFLOW_CAPTURE;
+        auto       firstRead  = std::chrono::steady_clock::now();
+        uint32_t   current    = MD_IO_STREAM_DELIVERY_NO_BUFFER;
+        bool       held       = false;
+
+        while( !m_stop )
+        {
+            if( current == MD_IO_STREAM_DELIVERY_NO_BUFFER )
+            {
+                current = AcquireBuffer();
+                if( current == MD_IO_STREAM_DELIVERY_NO_BUFFER )
+                {
+                    break;
+                }
+            }
+
+            TIoStreamDeliveryBuffer& buffer = m_buffers[current];
+
+            // Wait no longer than the oldest report of the batch may wait for delivery
+            auto wait = maxLatency;
+            if( held )
+            {
+                wait = std::chrono::milliseconds( MD_IO_STREAM_DELIVERY_HOLD_WAIT_MS );
+            }
+            else if( buffer.ReportCount )
+            {
+                wait = std::max( std::chrono::duration_cast<std::chrono::milliseconds>( firstRead + maxLatency - std::chrono::steady_clock::now() ), std::chrono::milliseconds( 0 ) );
+            }
+            wait = std::min( wait, std::chrono::milliseconds( MD_IO_STREAM_DELIVERY_STOP_CHECK_MS ) );
+
+            if( wait.count() > 0 )
+            {
+                m_concurrentGroup.WaitForReports( static_cast<uint32_t>( wait.count() ) );
+            }
+
+            uint32_t              reportCount = m_params.BatchReportCount - buffer.ReportCount;
+            const TCompletionCode ret         = m_concurrentGroup.ReadIoStream( &reportCount, reinterpret_cast<char*>( GetReport( buffer, buffer.ReportCount ) ), 0 );
+
+            if( ret != CC_OK && ret != CC_READ_PENDING )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: IoStream delivery read failed: %u", ret );
+                buffer.Result = ret;
+                SubmitBuffer( current );
+                current = MD_IO_STREAM_DELIVERY_NO_BUFFER;
+                break;
+            }
+
+            if( reportCount )
+            {
+                if( buffer.ReportCount == 0 )
+                {
+                    firstRead = std::chrono::steady_clock::now();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock( m_mutex );
+                    m_statistics.ReadReportCount += reportCount;
+                }
+
+                current = AppendReports( current, reportCount );
+            }
+
+            TIoStreamDeliveryBuffer& batch = m_buffers[current];
+            if( batch.ReportCount >= m_params.BatchReportCount || ( batch.ReportCount && std::chrono::steady_clock::now() - firstRead >= maxLatency ) )
+            {
+                if( holdBatch && !HasFreeBuffer() )
+                {
+                    if( !held )
+                    {
+                        std::lock_guard<std::mutex> lock( m_mutex );
+                        ++m_statistics.OverflowCount;
+                    }
+                    held = true;
+
+                    if( batch.ReportCount >= m_params.BatchReportCount )
+                    {
+                        HandleOverflow( batch );
+                    }
+                    if( batch.ReportCount < m_params.BatchReportCount )
+                    {
+                        continue;
+                    }
+                }
+
+                // Nothing to make room with, blocks on the next buffer
+                SubmitBuffer( current );
+                current = MD_IO_STREAM_DELIVERY_NO_BUFFER;
+                held    = false;
+            }
+        }
+
+        // Reports already read are delivered on stop
+        if( current != MD_IO_STREAM_DELIVERY_NO_BUFFER )
+        {
+            if( m_buffers[current].ReportCount )
+            {
+                SubmitBuffer( current );
+            }
+            else
+            {
+                ReleaseBuffer( current );
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_readDone = true;
+        }
+        m_calculateCondition.notify_all();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     CalculateThread
+    //
+    // Description:
+    //     Pipelined executor thread, calculates submitted batches in order and
+    //     passes them to the export thread until the read thread is done and
+    //     all batches are calculated.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::CalculateThread()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        while( true )
+        {
+            m_calculateCondition.wait( lock, [this] { return !m_calculateQueue.empty() || m_readDone; } );
+
+            if( m_calculateQueue.empty() )
+            {
+                break;
+            }
+
+            const uint32_t index = m_calculateQueue.front();
+            m_calculateQueue.pop_front();
+
+            lock.unlock();
+            Calculate( m_buffers[index] );
+            lock.lock();
+
+            m_exportQueue.push_back( index );
+            m_statistics.ExportQueueMaxOccupancy = std::max( m_statistics.ExportQueueMaxOccupancy, static_cast<uint32_t>( m_exportQueue.size() ) );
+            m_exportCondition.notify_one();
+        }
+
+        m_calculateDone = true;
+        m_exportCondition.notify_all();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     ExportThread
+    //
+    // Description:
+    //     Pipelined executor thread, invokes the callback with calculated batches
+    //     in order and returns their buffers to the free buffers, until
+    //     the calculate thread is done and all batches are delivered.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::ExportThread()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        while( true )
+        {
+            m_exportCondition.wait( lock, [this] { return !m_exportQueue.empty() || m_calculateDone; } );
+
+            if( m_exportQueue.empty() )
+            {
+                break;
+            }
+
+            const uint32_t index = m_exportQueue.front();
+            m_exportQueue.pop_front();
+
+            lock.unlock();
+            Export( m_buffers[index] );
+            lock.lock();
+
+            m_freeBuffers.push_back( index );
+            m_freeCondition.notify_all();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     AcquireBuffer
+    //
+    // Description:
+    //     Returns an empty batch buffer. While all buffers are in use, the drop
+    //     oldest policy frees the oldest queued batch, otherwise reading waits,
+    //     so a slow callback throttles reading instead of queuing reports
+    //     without bound; the OA buffer keeps reports meanwhile.
+    //
+    // Output:
+    //     uint32_t - buffer index, MD_IO_STREAM_DELIVERY_NO_BUFFER if stopped
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamDelivery::AcquireBuffer()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        if( m_freeBuffers.empty() && !m_stop )
+        {
+            const auto begin = std::chrono::steady_clock::now();
+
+            ++m_statistics.OverflowCount;
+
+            while( m_freeBuffers.empty() && !m_stop )
+            {
+                if( m_params.OverflowPolicy != IO_STREAM_DELIVERY_OVERFLOW_DROP_OLDEST || !DropOldestBuffer() )
+                {
+                    m_freeCondition.wait( lock );
+                }
+            }
+
+            m_statistics.BlockedTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - begin ).count();
+        }
+
+        if( m_freeBuffers.empty() )
+        {
+            return MD_IO_STREAM_DELIVERY_NO_BUFFER;
+        }
+
+        const uint32_t index = m_freeBuffers.front();
+        m_freeBuffers.pop_front();
+
+        TIoStreamDeliveryBuffer& buffer = m_buffers[index];
+
+        buffer.ReportCount          = 0;
+        buffer.MetricSet            = nullptr;
+        buffer.Result               = CC_OK;
+        buffer.LostReportCount      = 0;
+        buffer.DecimatedReportCount = 0;
+        buffer.DecimatedPrefixCount = 0;
+        buffer.ValueReportCount     = 0;
+
+        return index;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     DropOldestBuffer
+    //
+    // Description:
+    //     Frees the oldest batch waiting for the callback or for calculation.
+    //     Its reports are added to the lost reports of the next batch, so
+    //     the client sees the gap. Batches being calculated or delivered are
+    //     not dropped. Has to be called with m_mutex locked.
+    //
+    // Output:
+    //     bool - *true* if a batch was dropped
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoStreamDelivery::DropOldestBuffer()
+    {
+        std::deque<uint32_t>& queue = m_exportQueue.empty() ? m_calculateQueue : m_exportQueue;
+        if( queue.empty() )
+        {
+            return false;
+        }
+
+        const uint32_t index = queue.front();
+        queue.pop_front();
+
+        const TIoStreamDeliveryBuffer& dropped = m_buffers[index];
+        const uint64_t                 lost    = dropped.LostReportCount + dropped.ReportCount + dropped.DecimatedReportCount;
+
+        ++m_statistics.DroppedBatchCount;
+        m_statistics.DroppedReportCount += dropped.ReportCount;
+
+        // Export queue batches precede calculate queue batches
+        if( !m_exportQueue.empty() )
+        {
+            m_buffers[m_exportQueue.front()].LostReportCount += lost;
+        }
+        else if( !m_calculateQueue.empty() )
+        {
+            m_buffers[m_calculateQueue.front()].LostReportCount += lost;
+        }
+        else
+        {
+            m_pendingLostReportCount += lost;
+        }
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "IoStream delivery batch dropped: %llu, reports: %u", static_cast<unsigned long long>( dropped.SequenceNumber ), dropped.ReportCount );
+
+        m_freeBuffers.push_back( index );
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     ReleaseBuffer
+    //
+    // Description:
+    //     Returns a buffer to the free buffers without delivery.
+    //
+    // Input:
+    //     const uint32_t index - buffer index
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::ReleaseBuffer( const uint32_t index )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        m_freeBuffers.push_back( index );
+        m_freeCondition.notify_all();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     SubmitBuffer
+    //
+    // Description:
+    //     Numbers a batch, attaches reports lost before it and queues it for
+    //     the calculate thread, or delivers it right away with the single thread
+    //     executor.
+    //
+    // Input:
+    //     const uint32_t index - buffer index
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::SubmitBuffer( const uint32_t index )
+    {
+        TIoStreamDeliveryBuffer& buffer       = m_buffers[index];
+        const bool               singleThread = m_params.Executor == IO_STREAM_DELIVERY_EXECUTOR_SINGLE_THREAD;
+
+        buffer.SequenceNumber = m_sequenceNumber++;
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            buffer.LostReportCount += m_pendingLostReportCount;
+            m_pendingLostReportCount = 0;
+
+            if( !singleThread )
+            {
+                m_calculateQueue.push_back( index );
+                m_statistics.CalculateQueueMaxOccupancy = std::max( m_statistics.CalculateQueueMaxOccupancy, static_cast<uint32_t>( m_calculateQueue.size() ) );
+            }
+        }
+
+        if( singleThread )
+        {
+            Calculate( buffer );
+            Export( buffer );
+            ReleaseBuffer( index );
+            return;
+        }
+
+        m_calculateCondition.notify_one();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     HasFreeBuffer
+    //
+    // Description:
+    //     Returns whether a batch buffer is free.
+    //
+    // Output:
+    //     bool - *true* if a buffer is free
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoStreamDelivery::HasFreeBuffer()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        return !m_freeBuffers.empty();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     AppendReports
+    //
+    // Description:
+    //     Adds reports just read behind the batch reports. A batch holds reports
+    //     of a single metric set, so reports sampled after a metric set switch
+    //     are moved to a new batch and the current one is submitted. Reports
+    //     sampled while the switch was programmed are dropped, the batch after
+    //     them starts after a gap.
+    //
+    // Input:
+    //     uint32_t       index       - buffer the reports were read into
+    //     const uint32_t reportCount - reports read
+    //
+    // Output:
+    //     uint32_t                   - buffer holding the newest reports
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamDelivery::AppendReports( uint32_t index, const uint32_t reportCount )
+    {
+        TIoStreamDeliveryBuffer* buffer = &m_buffers[index];
+        uint32_t                 first  = buffer->ReportCount;
+        uint32_t                 end    = first + reportCount;
+
+        while( first < end )
+        {
+            IMetricSetLatest* metricSet = GetReportMetricSet( *buffer, first );
+            uint32_t          runEnd    = first + 1;
+
+            while( runEnd < end && GetReportMetricSet( *buffer, runEnd ) == metricSet )
+            {
+                ++runEnd;
+            }
+
+            if( metricSet == nullptr )
+            {
+                const uint32_t dropped = runEnd - first;
+
+                for( uint32_t i = runEnd; i < end; ++i )
+                {
+                    iu_memcpy_s( GetReport( *buffer, i - dropped ), m_rawReportSize, GetReport( *buffer, i ), m_rawReportSize );
+                }
+
+                end -= dropped;
+                m_transitionReportCount += dropped;
+
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_statistics.DroppedReportCount += dropped;
+                continue;
+            }
+
+            if( first > 0 && ( metricSet != buffer->MetricSet || m_transitionReportCount ) )
+            {
+                const uint32_t next = AcquireBuffer();
+                if( next == MD_IO_STREAM_DELIVERY_NO_BUFFER )
+                {
+                    // Stopped, reports of the next metric set are dropped
+                    end = first;
+                    break;
+                }
+
+                TIoStreamDeliveryBuffer& nextBuffer = m_buffers[next];
+                iu_memcpy_s( GetReport( nextBuffer, 0 ), nextBuffer.RawData.size(), GetReport( *buffer, first ), static_cast<size_t>( end - first ) * m_rawReportSize );
+
+                buffer->ReportCount = first;
+                SubmitBuffer( index );
+
+                index  = next;
+                buffer = &nextBuffer;
+                end    = end - first;
+                runEnd = runEnd - first;
+                first  = 0;
+            }
+
+            if( first == 0 )
+            {
+                buffer->MetricSet = metricSet;
+                buffer->LostReportCount += m_transitionReportCount;
+                m_transitionReportCount = 0;
+            }
+
+            first = runEnd;
+        }
+
+        buffer->ReportCount = end;
+        return index;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     HandleOverflow
+    //
+    // Description:
+    //     Makes room in a full batch held by the read thread while no buffer is
+    //     free. The decimate policy keeps every DecimationFactor-th report of
+    //     those read since the previous decimation. Once more than half of the
+    //     batch is decimated, or with the capture policy, all batch reports are
+    //     moved to the overflow capture, dropped if there is none, and the next
+    //     batch starts after a gap.
+    //
+    // Input:
+    //     TIoStreamDeliveryBuffer& buffer - held batch buffer
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::HandleOverflow( TIoStreamDeliveryBuffer& buffer )
+    {
+        // Kept reports are not decimated again, their intervals would grow past the counter wrap
+        if( m_params.OverflowPolicy == IO_STREAM_DELIVERY_OVERFLOW_DECIMATE && buffer.DecimatedPrefixCount <= m_params.BatchReportCount / 2 )
+        {
+            Decimate( buffer );
+            return;
+        }
+
+        TCompletionCode ret = CC_ERROR_GENERAL;
+        if( m_params.OverflowCaptureFile == nullptr )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "IoStream delivery batch already decimated, reports dropped: %u", buffer.ReportCount );
+        }
+        else
+        {
+            ret = m_overflowCapture.IsStarted() ? CC_OK : m_overflowCapture.Start( m_params.OverflowCaptureFile, *m_concurrentGroup.GetIoMetricSet(), nullptr );
+            if( ret == CC_OK )
+            {
+                ret = m_overflowCapture.Write( GetReport( buffer, 0 ), buffer.ReportCount );
+            }
+            if( ret != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: IoStream delivery overflow capture failed: %u, reports dropped: %u", ret, buffer.ReportCount );
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            if( ret == CC_OK )
+            {
+                m_statistics.CapturedReportCount += buffer.ReportCount;
+            }
+            else
+            {
+                m_statistics.DroppedReportCount += buffer.ReportCount;
+            }
+
+            m_pendingLostReportCount += buffer.LostReportCount + buffer.ReportCount + buffer.DecimatedReportCount;
+        }
+
+        buffer.ReportCount          = 0;
+        buffer.MetricSet            = nullptr;
+        buffer.LostReportCount      = 0;
+        buffer.DecimatedReportCount = 0;
+        buffer.DecimatedPrefixCount = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     Decimate
+    //
+    // Description:
+    //     Compacts batch reports read since the previous decimation in place to
+    //     every DecimationFactor-th report and the newest one. OA counters are
+    //     cumulative, so deltas between the kept reports still cover the removed
+    //     intervals, which are at most DecimationFactor reports long.
+    //
+    // Input:
+    //     TIoStreamDeliveryBuffer& buffer - batch buffer
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::Decimate( TIoStreamDeliveryBuffer& buffer )
+    {
+        const uint32_t factor = m_params.DecimationFactor;
+        const uint32_t prefix = buffer.DecimatedPrefixCount;
+        uint32_t       kept   = prefix;
+
+        for( uint32_t i = prefix; i < buffer.ReportCount; ++i )
+        {
+            if( ( i + 1 - prefix ) % factor == 0 || i + 1 == buffer.ReportCount )
+            {
+                if( kept != i )
+                {
+                    iu_memcpy_s( GetReport( buffer, kept ), m_rawReportSize, GetReport( buffer, i ), m_rawReportSize );
+                }
+                ++kept;
+            }
+        }
+
+        const uint32_t removed = buffer.ReportCount - kept;
+
+        buffer.ReportCount          = kept;
+        buffer.DecimatedPrefixCount = kept;
+        buffer.DecimatedReportCount += removed;
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_statistics.DecimatedReportCount += removed;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     Calculate
+    //
+    // Description:
+    //     Calculates a batch if requested. The calculator keeps the last report
+    //     of the previous batch, so its interval to the first batch report is
+    //     calculated as well. The kept report is discarded if reports were lost
+    //     in between or the previous batch used another metric set.
+    //
+    // Input:
+    //     TIoStreamDeliveryBuffer& buffer - batch buffer
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::Calculate( TIoStreamDeliveryBuffer& buffer )
+    {
+        buffer.ValueReportCount = 0;
+
+        if( m_params.Mode != IO_STREAM_DELIVERY_MODE_CALCULATED || buffer.ReportCount == 0 || buffer.MetricSet == nullptr )
+        {
+            return;
+        }
+
+        CMetricSet*    metricSet   = static_cast<CMetricSet*>( buffer.MetricSet );
+        const auto     params      = metricSet->GetParams();
+        const uint32_t rawCount    = buffer.ReportCount;
+        const uint32_t valueCount  = params->MetricsCount + params->InformationCount;
+        uint32_t       outputCount = 0;
+
+        if( m_lastMetricSet != buffer.MetricSet || buffer.LostReportCount )
+        {
+            metricSet->DiscardSavedReport();
+        }
+
+        if( buffer.Values.size() < static_cast<size_t>( rawCount ) * valueCount )
+        {
+            buffer.Values.resize( static_cast<size_t>( rawCount ) * valueCount );
+        }
+
+        const TCompletionCode ret = metricSet->CalculateIoStreamMetrics( GetReport( buffer, 0 ), rawCount * m_rawReportSize, buffer.Values.data(), static_cast<uint32_t>( rawCount * valueCount * sizeof( TTypedValue_1_0 ) ), &outputCount );
+        if( ret == CC_OK )
+        {
+            buffer.ValueReportCount = outputCount;
+        }
+        else
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: IoStream delivery calculation failed: %u", ret );
+            buffer.Result = ret;
+        }
+
+        m_lastMetricSet = buffer.MetricSet;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     Export
+    //
+    // Description:
+    //     Invokes the callback with a batch.
+    //
+    // Input:
+    //     TIoStreamDeliveryBuffer& buffer - batch buffer
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamDelivery::Export( TIoStreamDeliveryBuffer& buffer )
+    {
+        TIoStreamDeliveryBatch batch = {};
+
+        batch.MetricSet            = buffer.MetricSet;
+        batch.SequenceNumber       = buffer.SequenceNumber;
+        batch.Result               = buffer.Result;
+        batch.RawData              = GetReport( buffer, 0 );
+        batch.RawReportCount       = buffer.ReportCount;
+        batch.RawReportSize        = m_rawReportSize;
+        batch.Values               = buffer.ValueReportCount ? buffer.Values.data() : nullptr;
+        batch.ValueReportCount     = buffer.ValueReportCount;
+        batch.LostReportCount      = buffer.LostReportCount;
+        batch.DecimatedReportCount = buffer.DecimatedReportCount;
+
+        m_params.Callback( &batch, m_params.UserData );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        ++m_statistics.DeliveredBatchCount;
+        m_statistics.DeliveredReportCount += buffer.ReportCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     GetReportMetricSet
+    //
+    // Description:
+    //     Returns metric set the given batch report was sampled with, nullptr
+    //     if it was sampled while a metric set switch was programmed.
+    //
+    // Input:
+    //     TIoStreamDeliveryBuffer& buffer - batch buffer
+    //     const uint32_t           report - report index in the batch
+    //
+    // Output:
+    //     IMetricSetLatest*               - metric set
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IMetricSetLatest* CIoStreamDelivery::GetReportMetricSet( TIoStreamDeliveryBuffer& buffer, const uint32_t report )
+    {
+        return m_concurrentGroup.GetIoStreamReportMetricSet( GetReport( buffer, report ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamDelivery
+    //
+    // Method:
+    //     GetReport
+    //
+    // Description:
+    //     Returns the given batch report.
+    //
+    // Input:
+    //     TIoStreamDeliveryBuffer& buffer - batch buffer
+    //     const uint32_t           report - report index in the batch
+    //
+    // Output:
+    //     uint8_t*                        - raw report
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint8_t* CIoStreamDelivery::GetReport( TIoStreamDeliveryBuffer& buffer, const uint32_t report )
+    {
+        return buffer.RawData.data() + static_cast<size_t>( report ) * m_rawReportSize;
+    }
+} // namespace MetricsDiscoveryInternal
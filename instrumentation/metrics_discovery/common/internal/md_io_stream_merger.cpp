@@ -0,0 +1,426 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_merger.cpp
+
+//     Abstract:   C++ Metrics Discovery internal IoStream timeline merger implementation
+
+#include "md_io_stream_merger.h"
+#include "md_adapter.h"
+#include "md_metric_set.h"
+#include "md_metrics_device.h"
+#include "md_oa_concurrent_group.h"
+
+#include "md_utils.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Method:
+    //     CIoStreamMerger constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     const uint32_t               adapterId - adapter id for logging
+    //     const TIoStreamMergerParams* params    - merger parameters, nullptr means defaults
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamMerger::CIoStreamMerger( const uint32_t adapterId, const TIoStreamMergerParams* params )
+        : m_adapterId( adapterId )
+        , m_sourceReportCount( ( params && params->SourceReportCount ) ? params->SourceReportCount : MD_IO_STREAM_MERGER_SOURCE_REPORTS )
+        , m_toleranceNs( ( params && params->ToleranceNs ) ? params->ToleranceNs : MD_IO_STREAM_MERGER_TOLERANCE_NS )
+        , m_sources()
+        , m_heap()
+        , m_gpuTimestamps( m_sourceReportCount )
+        , m_cpuTimestamps( m_sourceReportCount )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Method:
+    //     ~CIoStreamMerger
+    //
+    // Description:
+    //     Destructor. Source streams are left opened.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamMerger::~CIoStreamMerger()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Method:
+    //     AddSource
+    //
+    // Description:
+    //     Adds an opened IO stream to the merger. Timestamp correlation of its
+    //     metrics device is updated, so the stream timestamps can be converted.
+    //
+    // Input:
+    //     IConcurrentGroupLatest* concurrentGroup - concurrent group with an opened IO stream
+    //     uint32_t*               outSourceIndex  - (out) source index used in merged reports, may be null
+    //
+    // Output:
+    //     TCompletionCode                         - result of the operation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamMerger::AddSource( IConcurrentGroupLatest* concurrentGroup, uint32_t* outSourceIndex )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, concurrentGroup, CC_ERROR_INVALID_PARAMETER );
+
+        if( ( concurrentGroup->GetParams()->MeasurementTypeMask & MEASUREMENT_TYPE_SNAPSHOT_IO ) == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: concurrent group does not support IO streams" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        auto group     = static_cast<COAConcurrentGroup*>( concurrentGroup );
+        auto metricSet = group->GetIoMetricSet();
+
+        if( metricSet == nullptr )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream not opened" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        for( const auto& source : m_sources )
+        {
+            if( source.ConcurrentGroup == group )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream already added" );
+                return CC_ALREADY_INITIALIZED;
+            }
+        }
+
+        auto ret = group->GetMetricsDevice().UpdateTimestampCorrelation( true, nullptr );
+        if( ret != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream timestamps cannot be correlated" );
+            return ret;
+        }
+
+        TIoStreamMergerSource source = {};
+        source.ConcurrentGroup       = group;
+        source.MetricSet             = metricSet;
+        source.ReportSize            = metricSet->GetParams()->RawReportSize;
+        source.ReportType            = metricSet->GetReportType();
+        source.Reports.resize( static_cast<size_t>( m_sourceReportCount ) * source.ReportSize );
+        source.Timestamps.resize( m_sourceReportCount );
+        source.MetricSets.resize( m_sourceReportCount );
+
+        m_sources.push_back( std::move( source ) );
+
+        if( outSourceIndex )
+        {
+            *outSourceIndex = static_cast<uint32_t>( m_sources.size() - 1 );
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Method:
+    //     GetSourceCount
+    //
+    // Description:
+    //     Returns number of source streams.
+    //
+    // Output:
+    //     uint32_t - source stream count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamMerger::GetSourceCount( void )
+    {
+        return static_cast<uint32_t>( m_sources.size() );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Method:
+    //     ReadReports
+    //
+    // Description:
+    //     Drains all source streams into their rings and returns buffered reports
+    //     in timestamp order, as long as no source can deliver an older report.
+    //     Each source takes part in the merge with its oldest buffered report
+    //     only, so the heap holds at most one report per source. Reports of
+    //     a stream should be calculated in source order, with the metric set
+    //     of the report and the previous report of the same source and metric set.
+    //
+    // Input:
+    //     TIoStreamMergedReport* outReports      - (out) merged reports
+    //     uint32_t               outReportsCount - outReports capacity
+    //     uint32_t*              outReportCount  - (out) returned reports
+    //
+    // Output:
+    //     TCompletionCode                        - *CC_OK* if outReports were filled,
+    //                                              *CC_READ_PENDING* if fewer reports could be merged,
+    //                                              *CC_ERROR_GENERAL* if all sources failed and are drained
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamMerger::ReadReports( TIoStreamMergedReport* outReports, uint32_t outReportsCount, uint32_t* outReportCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, outReports, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, outReportCount, CC_ERROR_INVALID_PARAMETER );
+
+        *outReportCount = 0;
+
+        if( m_sources.empty() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: no source streams" );
+            return CC_ERROR_GENERAL;
+        }
+
+        // Reports newer than the bound may still be preceded by unread reports of an empty source
+        uint64_t boundNs  = UINT64_MAX;
+        bool     readable = false;
+
+        m_heap.clear();
+
+        for( uint32_t i = 0; i < m_sources.size(); ++i )
+        {
+            auto& source = m_sources[i];
+
+            Refill( source );
+
+            if( source.Count )
+            {
+                m_heap.emplace_back( source.Timestamps[source.Head], i );
+            }
+            else if( !source.Finished )
+            {
+                boundNs = std::min( boundNs, source.WatermarkNs );
+            }
+
+            readable = readable || source.Count || !source.Finished;
+        }
+
+        if( !readable )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: all source streams failed" );
+            return CC_ERROR_GENERAL;
+        }
+
+        std::make_heap( m_heap.begin(), m_heap.end(), std::greater<>() );
+
+        while( !m_heap.empty() && *outReportCount < outReportsCount && m_heap.front().first <= boundNs )
+        {
+            std::pop_heap( m_heap.begin(), m_heap.end(), std::greater<>() );
+
+            const uint64_t timestampNs = m_heap.back().first;
+            const uint32_t index       = m_heap.back().second;
+            auto&          source      = m_sources[index];
+
+            m_heap.pop_back();
+
+            outReports[( *outReportCount )++] = { index, timestampNs, source.Reports.data() + static_cast<size_t>( source.Head ) * source.ReportSize, source.ReportSize, source.MetricSets[source.Head] };
+
+            source.Head = ( source.Head + 1 ) % m_sourceReportCount;
+            --source.Count;
+
+            if( source.Count )
+            {
+                m_heap.emplace_back( source.Timestamps[source.Head], index );
+                std::push_heap( m_heap.begin(), m_heap.end(), std::greater<>() );
+            }
+            else if( !source.Finished )
+            {
+                boundNs = std::min( boundNs, source.WatermarkNs );
+            }
+        }
+
+        return ( *outReportCount < outReportsCount ) ? CC_READ_PENDING : CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Method:
+    //     Refill
+    //
+    // Description:
+    //     Reads the source stream into free ring slots and converts report
+    //     timestamps to CPU time. Reports are never placed before the source
+    //     watermark, so the merged sequence stays ordered even if a report
+    //     becomes readable later than the tolerance allows. A drained stream
+    //     moves the watermark to the read time minus the tolerance. Each report
+    //     is tagged with the metric set it was sampled with. A source is removed
+    //     from the merge, with an error logged, only if its stream is closed,
+    //     reopened with another report size, or fails.
+    //
+    // Input:
+    //     TIoStreamMergerSource& source - source to refill
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamMerger::Refill( TIoStreamMergerSource& source )
+    {
+        const uint32_t freeCount = m_sourceReportCount - source.Count;
+
+        if( source.Finished || freeCount == 0 )
+        {
+            return;
+        }
+
+        CMetricSet* metricSet = source.ConcurrentGroup->GetIoMetricSet();
+        if( metricSet == nullptr || metricSet->GetParams()->RawReportSize != source.ReportSize )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: source stream closed or reopened with another report size, removed from merge" );
+            source.Finished = true;
+            return;
+        }
+
+        auto& device = source.ConcurrentGroup->GetMetricsDevice();
+
+        // Rate limited, only samples timestamps once in a while
+        auto ret = device.UpdateTimestampCorrelation( false, nullptr );
+        if( ret != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "warning: cannot update timestamp correlation, source not read" );
+            return;
+        }
+
+        const uint64_t startTimeNs = GetTimeNs();
+        uint32_t       reportCount = freeCount;
+        TIoStreamView  view        = {};
+        TIoStreamSpan  span        = {};
+
+        const TCompletionCode readResult = ReadSource( source, reportCount, view, span );
+        if( readResult != CC_OK && readResult != CC_READ_PENDING )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: source stream read failed, result: %d, removed from merge", readResult );
+            source.Finished = true;
+            return;
+        }
+
+        const uint32_t tail  = source.Head + source.Count;
+        uint32_t       count = 0;
+
+        for( uint32_t i = 0; i < view.SpanCount; ++i )
+        {
+            const TIoStreamSpan& span = view.Spans[i];
+
+            for( uint32_t j = 0; j < span.ReportCount && count < freeCount; ++j )
+            {
+                const uint8_t*    report          = span.Data + static_cast<size_t>( j ) * span.Stride;
+                const uint32_t    slot            = ( tail + count ) % m_sourceReportCount;
+                IMetricSetLatest* reportMetricSet = source.ConcurrentGroup->GetIoStreamReportMetricSet( report );
+
+                // Sampled while a metric set switch was programmed, counters are not consistent
+                if( reportMetricSet == nullptr )
+                {
+                    continue;
+                }
+
+                iu_memcpy_s( source.Reports.data() + static_cast<size_t>( slot ) * source.ReportSize, source.ReportSize, report, source.ReportSize );
+                source.MetricSets[slot] = reportMetricSet;
+                m_gpuTimestamps[count]  = GetRawReportTimestamp( report, source.ReportType );
+                ++count;
+            }
+        }
+
+        if( count )
+        {
+            ret = device.ConvertGpuTimestampsToCpu( m_gpuTimestamps.data(), m_cpuTimestamps.data(), count );
+            if( ret != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: cannot convert report timestamps, result: %d, source removed from merge", ret );
+                source.Finished = true;
+                return;
+            }
+
+            for( uint32_t i = 0; i < count; ++i )
+            {
+                source.WatermarkNs                                    = std::max( source.WatermarkNs, m_cpuTimestamps[i] );
+                source.Timestamps[( tail + i ) % m_sourceReportCount] = source.WatermarkNs;
+            }
+
+            source.Count += count;
+        }
+
+        if( readResult == CC_READ_PENDING && startTimeNs > m_toleranceNs )
+        {
+            source.WatermarkNs = std::max( source.WatermarkNs, startTimeNs - m_toleranceNs );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamMerger
+    //
+    // Method:
+    //     ReadSource
+    //
+    // Description:
+    //     Reads the source stream in place. Streams which cannot be read in place,
+    //     e.g. drained by a background reader, are read with a copying read into
+    //     the source read buffer, presented as a single span view.
+    //
+    // Input:
+    //     TIoStreamMergerSource& source      - source to read
+    //     uint32_t&              reportCount - (in/out) reports to read / read reports
+    //     TIoStreamView&         view        - (out) read reports
+    //     TIoStreamSpan&         span        - (out) span of a copying read, referenced by the view
+    //
+    // Output:
+    //     TCompletionCode                    - result of the read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamMerger::ReadSource( TIoStreamMergerSource& source, uint32_t& reportCount, TIoStreamView& view, TIoStreamSpan& span )
+    {
+        const uint32_t  requestedCount = reportCount;
+        TCompletionCode ret            = source.ConcurrentGroup->ReadIoStreamView( &reportCount, &view, 0 );
+
+        if( ret != CC_ERROR_NOT_SUPPORTED )
+        {
+            return ret;
+        }
+
+        if( source.ReadBuffer.empty() )
+        {
+            source.ReadBuffer.resize( source.Reports.size() );
+        }
+
+        reportCount = requestedCount;
+        ret         = source.ConcurrentGroup->ReadIoStream( &reportCount, reinterpret_cast<char*>( source.ReadBuffer.data() ), 0 );
+
+        if( ret == CC_OK || ret == CC_READ_PENDING )
+        {
+            span = { source.ReadBuffer.data(), source.ReportSize, reportCount };
+            view = { &span, 1, reportCount };
+        }
+
+        return ret;
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,221 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_read_policy.cpp
+
+//     Abstract:   C++ Metrics Discovery internal adaptive IoStream read policy implementation
+
+#include "md_io_stream_read_policy.h"
+
+#include <algorithm>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     CIoStreamReadPolicy constructor
+    //
+    // Description:
+    //     Constructor. Sets default parameters.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamReadPolicy::CIoStreamReadPolicy()
+        : m_params{ MD_IO_STREAM_READ_POLICY_MIN_BATCH_REPORTS, MD_IO_STREAM_READ_POLICY_MAX_LATENCY_MS, MD_IO_STREAM_READ_POLICY_MAX_READ_SIZE }
+        , m_reportRate( 0.0 )
+        , m_lastReadTimeNs( 0 )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     ~CIoStreamReadPolicy
+    //
+    // Description:
+    //     Destructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamReadPolicy::~CIoStreamReadPolicy()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     SetParams
+    //
+    // Description:
+    //     Sets policy parameters. Zero fields and nullptr mean defaults.
+    //
+    // Input:
+    //     const TIoStreamReadPolicyParams* params - policy parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReadPolicy::SetParams( const TIoStreamReadPolicyParams* params )
+    {
+        m_params = { MD_IO_STREAM_READ_POLICY_MIN_BATCH_REPORTS, MD_IO_STREAM_READ_POLICY_MAX_LATENCY_MS, MD_IO_STREAM_READ_POLICY_MAX_READ_SIZE };
+
+        if( params != nullptr )
+        {
+            m_params.MinBatchReportCount = params->MinBatchReportCount ? params->MinBatchReportCount : m_params.MinBatchReportCount;
+            m_params.MaxLatencyMs        = params->MaxLatencyMs ? params->MaxLatencyMs : m_params.MaxLatencyMs;
+            m_params.MaxReadSize         = params->MaxReadSize ? params->MaxReadSize : m_params.MaxReadSize;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     GetParams
+    //
+    // Description:
+    //     Returns effective policy parameters.
+    //
+    // Output:
+    //     const TIoStreamReadPolicyParams& - policy parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TIoStreamReadPolicyParams& CIoStreamReadPolicy::GetParams() const
+    {
+        return m_params;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     Reset
+    //
+    // Description:
+    //     Forgets the observed report rate, e.g. when the stream is reopened with
+    //     a different sampling period.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReadPolicy::Reset()
+    {
+        m_reportRate     = 0.0;
+        m_lastReadTimeNs = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     GetReadReportCount
+    //
+    // Description:
+    //     Returns the number of reports to request with the next read. It is
+    //     the volume expected to be pending since the last read with some
+    //     headroom, at least the minimum batch, capped to the max read size.
+    //     Without a known rate the cap is used.
+    //
+    // Input:
+    //     const uint32_t reportSize     - raw report size in bytes
+    //     const uint32_t maxReportCount - space left in the output buffer, in reports
+    //
+    // Output:
+    //     uint32_t                      - reports to read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamReadPolicy::GetReadReportCount( const uint32_t reportSize, const uint32_t maxReportCount )
+    {
+        const uint32_t capReportCount = std::max<uint32_t>( m_params.MaxReadSize / std::max<uint32_t>( reportSize, 1 ), 1 );
+        uint32_t       reportCount    = capReportCount;
+
+        if( m_reportRate > 0.0 && m_lastReadTimeNs )
+        {
+            const double expected = m_reportRate * static_cast<double>( GetTimeNs() - m_lastReadTimeNs );
+
+            // 25% headroom for rate jitter
+            reportCount = static_cast<uint32_t>( std::min<double>( expected * 1.25 + 1.0, capReportCount ) );
+            reportCount = std::max( reportCount, std::min( m_params.MinBatchReportCount, capReportCount ) );
+        }
+
+        return std::min( reportCount, maxReportCount );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     GetWaitTimeMs
+    //
+    // Description:
+    //     Returns time after which the given number of reports is expected to
+    //     arrive, bounded by the coalescing deadline.
+    //
+    // Input:
+    //     const uint32_t missingReportCount - reports still missing to complete the batch
+    //
+    // Output:
+    //     uint32_t                          - wait time in milliseconds, at least 1
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamReadPolicy::GetWaitTimeMs( const uint32_t missingReportCount )
+    {
+        if( m_reportRate <= 0.0 )
+        {
+            return m_params.MaxLatencyMs;
+        }
+
+        const double waitMs = static_cast<double>( missingReportCount ) / m_reportRate / 1000000.0;
+
+        return static_cast<uint32_t>( std::min<double>( std::max<double>( waitMs, 1.0 ), m_params.MaxLatencyMs ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReadPolicy
+    //
+    // Method:
+    //     Update
+    //
+    // Description:
+    //     Updates the observed report rate with the result of a read. The rate is
+    //     an exponential moving average of reports read per elapsed time.
+    //
+    // Input:
+    //     const uint32_t readReportCount - reports returned by the read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReadPolicy::Update( const uint32_t readReportCount )
+    {
+        const uint64_t timeNs = GetTimeNs();
+
+        if( m_lastReadTimeNs && timeNs > m_lastReadTimeNs )
+        {
+            const double rate = static_cast<double>( readReportCount ) / static_cast<double>( timeNs - m_lastReadTimeNs );
+
+            m_reportRate = ( m_reportRate > 0.0 )
+                ? m_reportRate + MD_IO_STREAM_READ_POLICY_RATE_WEIGHT * ( rate - m_reportRate )
+                : rate;
+        }
+
+        m_lastReadTimeNs = timeNs;
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,240 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_sampling_control.cpp
+
+//     Abstract:   C++ Metrics Discovery internal adaptive IoStream sampling period controller implementation
+
+#include "md_io_stream_sampling_control.h"
+
+#include <algorithm>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     CIoStreamSamplingControl constructor
+    //
+    // Description:
+    //     Constructor. The controller is disabled by default.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamSamplingControl::CIoStreamSamplingControl()
+        : m_params{ false, 0, MD_IO_STREAM_SAMPLING_CONTROL_MAX_PERIOD_NS, MD_IO_STREAM_SAMPLING_CONTROL_TARGET_FILL }
+        , m_nsTimerPeriod( 0 )
+        , m_minNsTimerPeriod( 0 )
+        , m_maxNsTimerPeriod( 0 )
+        , m_bufferReportCount( 0 )
+        , m_backlogReportCount( 0 )
+        , m_lowFillCycleCount( 0 )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     ~CIoStreamSamplingControl
+    //
+    // Description:
+    //     Destructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamSamplingControl::~CIoStreamSamplingControl()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     SetParams
+    //
+    // Description:
+    //     Sets controller parameters. Zero fields mean defaults, nullptr disables
+    //     the controller. Bounds are applied when the stream is opened.
+    //
+    // Input:
+    //     const TIoStreamSamplingControlParams* params - controller parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamSamplingControl::SetParams( const TIoStreamSamplingControlParams* params )
+    {
+        m_params = { false, 0, MD_IO_STREAM_SAMPLING_CONTROL_MAX_PERIOD_NS, MD_IO_STREAM_SAMPLING_CONTROL_TARGET_FILL };
+
+        if( params != nullptr )
+        {
+            m_params.Enabled           = params->Enabled;
+            m_params.MinNsTimerPeriod  = params->MinNsTimerPeriod;
+            m_params.MaxNsTimerPeriod  = params->MaxNsTimerPeriod ? params->MaxNsTimerPeriod : m_params.MaxNsTimerPeriod;
+            m_params.TargetFillPercent = params->TargetFillPercent ? std::min<uint32_t>( params->TargetFillPercent, 100 ) : m_params.TargetFillPercent;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     GetParams
+    //
+    // Description:
+    //     Returns effective controller parameters.
+    //
+    // Output:
+    //     const TIoStreamSamplingControlParams& - controller parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TIoStreamSamplingControlParams& CIoStreamSamplingControl::GetParams() const
+    {
+        return m_params;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     IsEnabled
+    //
+    // Description:
+    //     Returns true if the controller is enabled for the opened stream.
+    //
+    // Output:
+    //     bool - *true* if enabled
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoStreamSamplingControl::IsEnabled() const
+    {
+        return m_params.Enabled && m_nsTimerPeriod && m_bufferReportCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     Start
+    //
+    // Description:
+    //     Starts controlling a stream opened by the user with the given period,
+    //     which is the default lower bound.
+    //
+    // Input:
+    //     const uint32_t nsTimerPeriod - sampling period set by the driver
+    //     const uint32_t bufferSize    - OA buffer size set by the driver
+    //     const uint32_t reportSize    - raw report size
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamSamplingControl::Start( const uint32_t nsTimerPeriod, const uint32_t bufferSize, const uint32_t reportSize )
+    {
+        m_minNsTimerPeriod  = m_params.MinNsTimerPeriod ? m_params.MinNsTimerPeriod : nsTimerPeriod;
+        m_maxNsTimerPeriod  = std::max( m_params.MaxNsTimerPeriod, nsTimerPeriod );
+        m_bufferReportCount = reportSize ? bufferSize / reportSize : 0;
+
+        SetPeriod( nsTimerPeriod );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     SetPeriod
+    //
+    // Description:
+    //     Sets the period the stream was reopened with and forgets the backlog.
+    //
+    // Input:
+    //     const uint32_t nsTimerPeriod - sampling period set by the driver
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamSamplingControl::SetPeriod( const uint32_t nsTimerPeriod )
+    {
+        m_nsTimerPeriod      = nsTimerPeriod;
+        m_backlogReportCount = 0;
+        m_lowFillCycleCount  = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamSamplingControl
+    //
+    // Method:
+    //     Update
+    //
+    // Description:
+    //     Accounts the result of a read and returns the period the stream should
+    //     be reopened with. The fill level is evaluated when the buffer is drained
+    //     empty, or earlier if the backlog already exceeds the target.
+    //
+    // Input:
+    //     const uint32_t readReportCount - reports returned by the read
+    //     const bool     drained         - the read emptied the buffer (*CC_READ_PENDING*)
+    //     const bool     reportsLost     - the read signaled lost reports or buffer overflow
+    //
+    // Output:
+    //     uint32_t                       - new sampling period in nanoseconds, 0 if unchanged
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamSamplingControl::Update( const uint32_t readReportCount, const bool drained, const bool reportsLost )
+    {
+        if( !IsEnabled() )
+        {
+            return 0;
+        }
+
+        m_backlogReportCount += readReportCount;
+
+        const uint64_t fillPercent = m_backlogReportCount * 100 / m_bufferReportCount;
+
+        if( reportsLost || fillPercent > m_params.TargetFillPercent )
+        {
+            m_backlogReportCount = 0;
+            m_lowFillCycleCount  = 0;
+
+            // The driver rounds periods down to a power of two multiple of the timestamp period
+            return ( m_nsTimerPeriod <= m_maxNsTimerPeriod / 2 ) ? m_nsTimerPeriod * 2 : 0;
+        }
+
+        if( !drained )
+        {
+            return 0;
+        }
+
+        m_backlogReportCount = 0;
+
+        if( fillPercent * 4 >= m_params.TargetFillPercent )
+        {
+            m_lowFillCycleCount = 0;
+            return 0;
+        }
+
+        if( ++m_lowFillCycleCount < MD_IO_STREAM_SAMPLING_CONTROL_DECREASE_CYCLES )
+        {
+            return 0;
+        }
+
+        m_lowFillCycleCount = 0;
+
+        return ( m_nsTimerPeriod / 2 >= m_minNsTimerPeriod ) ? m_nsTimerPeriod / 2 : 0;
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,210 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_statistics.cpp
+
+//     Abstract:   C++ Metrics Discovery internal IoStream health statistics implementation
+
+#include "md_io_stream_statistics.h"
+
+#include "md_utils.h"
+
+#include <algorithm>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Method:
+    //     CIoStreamStatistics constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamStatistics::CIoStreamStatistics()
+        : m_statistics{}
+        , m_lastDrainTimeNs( 0 )
+        , m_reportType( OA_REPORT_TYPE_256B_A45_NOA16 )
+        , m_timestampFrequency( 0 )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Method:
+    //     ~CIoStreamStatistics
+    //
+    // Description:
+    //     Destructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamStatistics::~CIoStreamStatistics()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Method:
+    //     SetReportLayout
+    //
+    // Description:
+    //     Sets layout of the read reports, used to find report timestamps.
+    //
+    // Input:
+    //     const TReportType reportType         - raw report layout
+    //     const uint64_t    timestampFrequency - report timestamp frequency, 0 disables backlog estimation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamStatistics::SetReportLayout( const TReportType reportType, const uint64_t timestampFrequency )
+    {
+        m_reportType         = reportType;
+        m_timestampFrequency = timestampFrequency;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Method:
+    //     Reset
+    //
+    // Description:
+    //     Clears all counters.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamStatistics::Reset()
+    {
+        m_statistics      = {};
+        m_lastDrainTimeNs = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Method:
+    //     Get
+    //
+    // Description:
+    //     Returns cumulative counters.
+    //
+    // Output:
+    //     const TIoStreamStatistics& - counters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TIoStreamStatistics& CIoStreamStatistics::Get() const
+    {
+        return m_statistics;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Method:
+    //     AddRead
+    //
+    // Description:
+    //     Accounts a successful driver read.
+    //
+    // Input:
+    //     const uint64_t                         startTimeNs - GetTimeNs taken before the read
+    //     const TIoStreamView&                   view        - read reports
+    //     const uint32_t                         reportSize  - raw report size
+    //     const GTDIReadCounterStreamExceptions& exceptions  - exceptions returned by the read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamStatistics::AddRead( const uint64_t startTimeNs, const TIoStreamView& view, const uint32_t reportSize, const GTDIReadCounterStreamExceptions& exceptions )
+    {
+        const uint64_t timeNs    = GetTimeNs();
+        const uint64_t latencyNs = timeNs - startTimeNs;
+
+        ++m_statistics.ReadCount;
+        m_statistics.ReadLatencyTotalNs += latencyNs;
+        m_statistics.ReadLatencyMaxNs = std::max( m_statistics.ReadLatencyMaxNs, latencyNs );
+
+        m_statistics.ReportLostCount += exceptions.ReportLost ? 1 : 0;
+        m_statistics.BufferLostCount += ( exceptions.BufferOverflow || exceptions.BufferOverrun ) ? 1 : 0;
+
+        if( view.ReportCount == 0 || view.SpanCount == 0 )
+        {
+            return;
+        }
+
+        m_statistics.ReportCount += view.ReportCount;
+        m_statistics.ByteCount += static_cast<uint64_t>( view.ReportCount ) * reportSize;
+
+        // Time between drains
+        if( m_lastDrainTimeNs )
+        {
+            const uint64_t intervalUs = ( timeNs - m_lastDrainTimeNs ) / MD_NSEC_PER_USEC;
+            uint32_t       bucket     = 0;
+
+            for( uint64_t value = intervalUs >> 1; value && bucket < MD_IO_STREAM_DRAIN_HISTOGRAM_SIZE - 1; value >>= 1 )
+            {
+                ++bucket;
+            }
+
+            ++m_statistics.DrainIntervalHistogram[bucket];
+        }
+        m_lastDrainTimeNs = timeNs;
+
+        // Backlog, time span of the drained reports
+        const TIoStreamSpan& firstSpan = view.Spans[0];
+        const TIoStreamSpan& lastSpan  = view.Spans[view.SpanCount - 1];
+
+        if( m_timestampFrequency && firstSpan.ReportCount && lastSpan.ReportCount )
+        {
+            const uint64_t first = GetRawReportTimestamp( firstSpan.Data, m_reportType );
+            const uint64_t last  = GetRawReportTimestamp( lastSpan.Data + static_cast<size_t>( lastSpan.ReportCount - 1 ) * lastSpan.Stride, m_reportType );
+            const uint64_t ticks = IsOamReportType( m_reportType ) ? last - first : ( last - first ) & MD_GPU_TIMESTAMP_MASK_32;
+
+            m_statistics.MaxBacklogNs = std::max<uint64_t>( m_statistics.MaxBacklogNs, ticks * MD_SECOND_IN_NS / m_timestampFrequency );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamStatistics
+    //
+    // Method:
+    //     AddRead
+    //
+    // Description:
+    //     Accounts a successful driver read into a contiguous report buffer.
+    //
+    // Input:
+    //     const uint64_t                         startTimeNs - GetTimeNs taken before the read
+    //     const uint8_t*                         reportData  - read reports
+    //     const uint32_t                         reportCount - read report count
+    //     const uint32_t                         reportSize  - raw report size
+    //     const GTDIReadCounterStreamExceptions& exceptions  - exceptions returned by the read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamStatistics::AddRead( const uint64_t startTimeNs, const uint8_t* reportData, const uint32_t reportCount, const uint32_t reportSize, const GTDIReadCounterStreamExceptions& exceptions )
+    {
+        const TIoStreamSpan span = { reportData, reportSize, reportCount };
+        const TIoStreamView view = { &span, 1, reportCount };
+
+        AddRead( startTimeNs, view, reportSize, exceptions );
+    }
+} // namespace MetricsDiscoveryInternal
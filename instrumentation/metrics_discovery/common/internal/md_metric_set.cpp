@@ -17,8 +17,10 @@ SPDX-License-Identifier: MIT
 #include "md_equation.h"
 #include "md_information.h"
 #include "md_metric.h"
+#include "md_metrics_aggregator.h"
 #include "md_metrics_device.h"
 #include "md_register_set.h"
+#include "md_time_series.h"
 
 #include "md_calculation.h"
 #include "md_driver_ifc.h"
@@ -81,6 +83,7 @@ namespace MetricsDiscoveryInternal
         , m_isCustom( isCustom )
         , m_isReadRegsCfgSet( false )
         , m_metricsCalculator( new( std::nothrow ) CMetricsCalculator( m_device ) )
+        , m_timeSeriesVector()
     {
         const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
 
@@ -161,6 +164,7 @@ namespace MetricsDiscoveryInternal
         ClearVector( m_otherMetricsVector );
         ClearVector( m_otherInformationVector );
         MD_SAFE_DELETE( m_metricsCalculator );
+        ClearVector( m_timeSeriesVector );
 
         MD_SAFE_DELETE( m_availabilityEquation );
 
@@ -2127,6 +2131,584 @@ namespace MetricsDiscoveryInternal
     //
     //////////////////////////////////////////////////////////////////////////////
     TCompletionCode CMetricSet::CalculateMetrics( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TTypedValue_1_0* outMaxValues, uint32_t outMaxValuesSize )
+    {
+        return CalculateMetricsInternal( rawData, rawDataSize, out, outSize, outReportCount, outMaxValues, outMaxValuesSize, false, nullptr, 0, false );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CalculateMetricsCollapsed
+    //
+    // Description:
+    //     Calculates IoStream metrics like CalculateMetrics, but collapses each run of raw reports
+    //     without any activity (all the counters unchanged, only timestamp differs) into a single
+    //     output report. Metric deltas of such a report are zero except GpuTime, which covers
+    //     the whole run. Information is read from the last report in the run.
+    //     Run length and time span of each output report is returned in outIdleRunInfo.
+    //
+    // Input:
+    //     const uint8_t*   rawData             - raw report data
+    //     uint32_t         rawDataSize         - size of raw report data in bytes
+    //     TTypedValue_1_0* out                 - (OUT) buffer for calculated reports
+    //     uint32_t         outSize             - size of the provided output buffer in bytes
+    //     uint32_t*        outReportCount      - (OUT - optional) how much reports were calculated and are stored in the out buffer
+    //     TIdleRunInfo*    outIdleRunInfo      - (OUT - optional) idle run information for each calculated report, can be nullptr
+    //     uint32_t         outIdleRunInfoCount - count of entries in outIdleRunInfo, should be at least raw report count
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::CalculateMetricsCollapsed( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount )
+    {
+        return CalculateMetricsInternal( rawData, rawDataSize, out, outSize, outReportCount, nullptr, 0, true, outIdleRunInfo, outIdleRunInfoCount, false );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CalculateIoStreamMetrics
+    //
+    // Description:
+    //     Calculates reports read from the opened IoStream like CalculateMetrics,
+    //     but only reports sampled with this metric set, which may differ from
+    //     the one read reports start with after SwitchIoStreamMetricSet. Reports
+    //     of other metric sets and those sampled during a switch are skipped.
+    //     Reports have to be calculated before the stream is closed.
+    //
+    // Input:
+    //     const uint8_t*   rawData        - raw report data read from the stream
+    //     uint32_t         rawDataSize    - size of raw report data in bytes
+    //     TTypedValue_1_0* out            - (OUT) buffer for calculated reports
+    //     uint32_t         outSize        - size of the provided output buffer in bytes
+    //     uint32_t*        outReportCount - (OUT - optional) how much reports were calculated and are stored in the out buffer
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::CalculateIoStreamMetrics( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        return CalculateMetricsInternal( rawData, rawDataSize, out, outSize, outReportCount, nullptr, 0, false, nullptr, 0, true );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CreateTimeSeries
+    //
+    // Description:
+    //     Creates compressed time series for reports calculated with CalculateMetricsEncoded.
+    //     Its columns are metrics and information of the current (API filtered) metric set.
+    //     The time series is owned by the metric set.
+    //
+    // Input:
+    //     uint32_t blockRowCount - rows in a single independently decodable block, 0 means default
+    //
+    // Output:
+    //     IInternalTimeSeries* - created time series, nullptr if error
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IInternalTimeSeries* CMetricSet::CreateTimeSeries( uint32_t blockRowCount )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        if( !m_isFiltered )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: API filtering must be enabled first" );
+            return nullptr;
+        }
+
+        auto timeSeries = new( std::nothrow ) CTimeSeries( adapterId, m_currentParams->MetricsCount + m_currentParams->InformationCount, blockRowCount );
+        MD_CHECK_PTR_RET_A( adapterId, timeSeries, nullptr );
+
+        m_timeSeriesVector.push_back( timeSeries );
+
+        return timeSeries;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     DeleteTimeSeries
+    //
+    // Description:
+    //     Deletes time series created with CreateTimeSeries.
+    //
+    // Input:
+    //     IInternalTimeSeries* timeSeries - time series to delete
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::DeleteTimeSeries( IInternalTimeSeries* timeSeries )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        auto it = std::find( m_timeSeriesVector.begin(), m_timeSeriesVector.end(), timeSeries );
+        if( timeSeries == nullptr || it == m_timeSeriesVector.end() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: time series not created by this metric set" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        MD_SAFE_DELETE( *it );
+        m_timeSeriesVector.erase( it );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CalculateMetricsEncoded
+    //
+    // Description:
+    //     Calculates IoStream metrics and appends calculated reports directly to the
+    //     compressed time series. Only a single uncompressed report is kept in memory
+    //     during calculation. Report timestamp is taken from QueryBeginTime information.
+    //
+    // Input:
+    //     const uint8_t*       rawData        - raw report data
+    //     uint32_t             rawDataSize    - size of raw report data in bytes
+    //     IInternalTimeSeries* timeSeries     - (OUT) time series created with CreateTimeSeries
+    //     uint32_t*            outReportCount - (OUT - optional) how much reports were calculated and encoded
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::CalculateMetricsEncoded( const uint8_t* rawData, uint32_t rawDataSize, IInternalTimeSeries* timeSeries, uint32_t* outReportCount )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        MD_LOG_ENTER_A( adapterId );
+
+        MD_CHECK_PTR_RET_A( adapterId, rawData, CC_ERROR_INVALID_PARAMETER );
+
+        auto it = std::find( m_timeSeriesVector.begin(), m_timeSeriesVector.end(), timeSeries );
+        if( timeSeries == nullptr || it == m_timeSeriesVector.end() )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: time series not created by this metric set" );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( !m_isFiltered || !( m_currentParams->ApiMask & API_TYPE_IOSTREAM ) )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: IoStream API filtering must be enabled first" );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_GENERAL;
+        }
+
+        const uint32_t metricsAndInformationCount = m_currentParams->MetricsCount + m_currentParams->InformationCount;
+        const uint32_t rawReportSize              = m_currentParams->RawReportSize;
+        const uint32_t rawReportCount             = rawReportSize ? rawDataSize / rawReportSize : 0;
+
+        if( timeSeries->GetColumnCount() != metricsAndInformationCount )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: time series created for different API filtering" );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( rawDataSize == 0 || metricsAndInformationCount == 0 )
+        {
+            MD_LOG_A( adapterId, LOG_DEBUG, "nothing to calculate" );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_OK;
+        }
+        if( rawReportSize == 0 || rawDataSize % rawReportSize != 0 )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: input buffer has incorrect size" );
+            MD_LOG_A( adapterId, LOG_DEBUG, "rawDataSize: %u, rawReportSize: %u", rawDataSize, rawReportSize );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        // Single calculated report, reused for every raw report
+        TTypedValue_1_0* out = new( std::nothrow ) TTypedValue_1_0[metricsAndInformationCount];
+        MD_CHECK_PTR_RET_A( adapterId, out, CC_ERROR_NO_MEMORY );
+
+        // Initialize manager and context
+        TCalculationContext  calculationContext = {};
+        CCalculationManager* calculationManager = nullptr;
+
+        InitializeCalculationManager( MEASUREMENT_TYPE_SNAPSHOT_IO, &calculationManager, true );
+        if( calculationManager == nullptr )
+        {
+            MD_SAFE_DELETE_ARRAY( out );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_NO_MEMORY;
+        }
+
+        auto ret = InitializeCalculationContext( calculationContext, calculationManager, MEASUREMENT_TYPE_SNAPSHOT_IO, out, nullptr, rawData, rawReportCount, true );
+        if( ret == CC_OK )
+        {
+            calculationContext.StreamCalculationContext.OutTimeSeries = static_cast<CTimeSeries*>( timeSeries );
+
+            MD_LOG_A( adapterId, LOG_DEBUG, "about to calculate and encode %u raw reports", rawReportCount );
+
+            // CALCULATE METRICS
+            while( calculationManager->CalculateNextReport( calculationContext ) )
+            { // void
+            }
+
+            MD_LOG_A( adapterId, LOG_DEBUG, "encoded %u out reports, encoded size: %llu", calculationContext.CommonCalculationContext.OutReportCount, static_cast<unsigned long long>( timeSeries->GetEncodedSize() ) );
+
+            ret = calculationContext.StreamCalculationContext.OutTimeSeriesResult;
+
+            if( outReportCount )
+            {
+                *outReportCount = calculationContext.CommonCalculationContext.OutReportCount;
+            }
+
+            InitializeCalculationContext( calculationContext, nullptr, MEASUREMENT_TYPE_SNAPSHOT_IO, nullptr, nullptr, nullptr, 0, false );
+        }
+
+        InitializeCalculationManager( MEASUREMENT_TYPE_SNAPSHOT_IO, &calculationManager, false );
+        MD_SAFE_DELETE_ARRAY( out );
+
+        MD_LOG_EXIT_A( adapterId );
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CalculateMetricsAggregated
+    //
+    // Description:
+    //     Calculates IoStream metrics of the same metric set gathered on several
+    //     sub devices and combines reports aligned by GPU timestamp into device
+    //     level reports. Output layout is the same as for CalculateMetrics.
+    //
+    // Input:
+    //     const TSubDeviceRawData* subDeviceData  - metric set and raw data of each sub device
+    //     uint32_t                 subDeviceCount - sub device count
+    //     uint64_t                 toleranceNs    - max timestamp distance of aligned reports in ns,
+    //                                               0 means half of the report period
+    //     TTypedValue_1_0*         out            - (OUT) buffer for aggregated reports
+    //     uint32_t                 outSize        - size of the output buffer in bytes
+    //     uint32_t*                outReportCount - (OUT - optional) aggregated report count
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::CalculateMetricsAggregated( const TSubDeviceRawData* subDeviceData, uint32_t subDeviceCount, uint64_t toleranceNs, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        MD_LOG_ENTER_A( adapterId );
+
+        if( !m_isFiltered || !( m_currentParams->ApiMask & API_TYPE_IOSTREAM ) )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: IoStream API filtering must be enabled first" );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_GENERAL;
+        }
+
+        CMetricsAggregator aggregator( *this );
+
+        const auto ret = aggregator.Calculate( subDeviceData, subDeviceCount, toleranceNs, out, outSize, outReportCount );
+
+        MD_LOG_EXIT_A( adapterId );
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CalculateMetricsView
+    //
+    // Description:
+    //     Calculates IoStream metrics directly from reports read with ReadIoStreamView.
+    //     Spans are calculated one by one, the last report of a span is kept by the
+    //     calculator and used as a previous report for the first report of the next span.
+    //
+    // Input:
+    //     const TIoStreamView* view           - view of raw reports
+    //     TTypedValue_1_0*     out            - (OUT) buffer for calculated reports
+    //     uint32_t             outSize        - size of the output buffer in bytes
+    //     uint32_t*            outReportCount - (OUT - optional) how much reports were calculated
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::CalculateMetricsView( const TIoStreamView* view, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount )
+    {
+        const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
+
+        MD_LOG_ENTER_A( adapterId );
+
+        MD_CHECK_PTR_RET_A( adapterId, view, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, out, CC_ERROR_INVALID_PARAMETER );
+
+        if( !m_isFiltered || !( m_currentParams->ApiMask & API_TYPE_IOSTREAM ) )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: IoStream API filtering must be enabled first" );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_GENERAL;
+        }
+
+        const uint32_t metricsAndInformationCount = m_currentParams->MetricsCount + m_currentParams->InformationCount;
+        const uint32_t rawReportSize              = m_currentParams->RawReportSize;
+
+        if( view->ReportCount == 0 || metricsAndInformationCount == 0 )
+        {
+            MD_LOG_A( adapterId, LOG_DEBUG, "nothing to calculate" );
+            if( outReportCount )
+            {
+                *outReportCount = 0;
+            }
+            MD_LOG_EXIT_A( adapterId );
+            return CC_OK;
+        }
+        if( view->Spans == nullptr || view->SpanCount == 0 )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: view without spans" );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( outSize / ( metricsAndInformationCount * sizeof( TTypedValue_1_0 ) ) < view->ReportCount )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: output buffer has incorrect size" );
+            MD_LOG_A( adapterId, LOG_DEBUG, "outSize: %u, reportCount: %u", outSize, view->ReportCount );
+            MD_LOG_EXIT_A( adapterId );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        // Initialize manager
+        CCalculationManager* calculationManager = nullptr;
+
+        InitializeCalculationManager( MEASUREMENT_TYPE_SNAPSHOT_IO, &calculationManager, true );
+        MD_CHECK_PTR_RET_A( adapterId, calculationManager, CC_ERROR_NO_MEMORY );
+
+        TCompletionCode ret         = CC_OK;
+        uint32_t        reportCount = 0;
+
+        for( uint32_t i = 0; i < view->SpanCount && ret == CC_OK; ++i )
+        {
+            const TIoStreamSpan& span = view->Spans[i];
+
+            if( span.ReportCount == 0 )
+            {
+                continue;
+            }
+            if( span.Data == nullptr || span.Stride < rawReportSize )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: invalid span %u, stride: %u", i, span.Stride );
+                ret = CC_ERROR_INVALID_PARAMETER;
+                break;
+            }
+
+            TCalculationContext calculationContext = {};
+
+            ret = InitializeCalculationContext( calculationContext, calculationManager, MEASUREMENT_TYPE_SNAPSHOT_IO, out + reportCount * metricsAndInformationCount, nullptr, span.Data, span.ReportCount, true );
+            if( ret == CC_OK )
+            {
+                calculationContext.StreamCalculationContext.RawReportStride = span.Stride;
+
+                // CALCULATE METRICS
+                while( calculationManager->CalculateNextReport( calculationContext ) )
+                { // void
+                }
+
+                reportCount += calculationContext.CommonCalculationContext.OutReportCount;
+
+                InitializeCalculationContext( calculationContext, nullptr, MEASUREMENT_TYPE_SNAPSHOT_IO, nullptr, nullptr, nullptr, 0, false );
+            }
+        }
+
+        MD_LOG_A( adapterId, LOG_DEBUG, "calculated %u out reports from %u spans", reportCount, view->SpanCount );
+
+        if( outReportCount )
+        {
+            *outReportCount = reportCount;
+        }
+
+        InitializeCalculationManager( MEASUREMENT_TYPE_SNAPSHOT_IO, &calculationManager, false );
+
+        MD_LOG_EXIT_A( adapterId );
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CalculateIoStreamRuns
+    //
+    // Description:
+    //     Calculates IoStream reports of a stream switched between metric sets.
+    //     Runs of reports sampled with this metric set are calculated one by one,
+    //     reports of other metric sets are skipped. A delta is never calculated
+    //     across a switch, the saved report is discarded at each skipped run.
+    //
+    // Input:
+    //     const uint8_t*   rawData             - raw report data
+    //     uint32_t         rawReportSize       - raw report size in bytes
+    //     uint32_t         rawReportCount      - raw report count
+    //     TTypedValue_1_0* out                 - (OUT) buffer for calculated reports
+    //     uint32_t         outSize             - size of the provided output buffer in bytes
+    //     uint32_t*        outReportCount      - (OUT - optional) how much reports were calculated and are stored in the out buffer
+    //     TTypedValue_1_0* outMaxValues        - (OUT - optional) buffer for calculated max values, can be nullptr
+    //     uint32_t         outMaxValuesSize    - size of the provided buffer for max values in bytes
+    //     bool             doIdleCollapsing    - if true collapse runs of IoStream reports without activity
+    //     TIdleRunInfo*    outIdleRunInfo      - (OUT - optional) idle run information for each calculated report, can be nullptr
+    //     uint32_t         outIdleRunInfoCount - count of entries in outIdleRunInfo
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::CalculateIoStreamRuns( const uint8_t* rawData, uint32_t rawReportSize, uint32_t rawReportCount, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TTypedValue_1_0* outMaxValues, uint32_t outMaxValuesSize, bool doIdleCollapsing, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount )
+    {
+        const uint32_t  valueCount    = m_currentParams->MetricsCount + m_currentParams->InformationCount;
+        const uint32_t  maxValueCount = m_currentParams->MetricsCount;
+        uint32_t        calculated    = 0;
+        uint32_t        first         = 0;
+        TCompletionCode ret           = CC_OK;
+
+        while( first < rawReportCount && ret == CC_OK )
+        {
+            const bool other = IsIoStreamReportOfOtherMetricSet( rawData + static_cast<size_t>( first ) * rawReportSize );
+            uint32_t   end   = first + 1;
+
+            while( end < rawReportCount && IsIoStreamReportOfOtherMetricSet( rawData + static_cast<size_t>( end ) * rawReportSize ) == other )
+            {
+                ++end;
+            }
+
+            if( other )
+            {
+                if( m_metricsCalculator )
+                {
+                    m_metricsCalculator->DiscardSavedReport();
+                }
+            }
+            else
+            {
+                uint32_t runReportCount = 0;
+
+                ret = CalculateMetricsInternal(
+                    rawData + static_cast<size_t>( first ) * rawReportSize,
+                    ( end - first ) * rawReportSize,
+                    out + static_cast<size_t>( calculated ) * valueCount,
+                    outSize - calculated * valueCount * sizeof( TTypedValue_1_0 ),
+                    &runReportCount,
+                    outMaxValues ? outMaxValues + static_cast<size_t>( calculated ) * maxValueCount : nullptr,
+                    outMaxValues ? outMaxValuesSize - calculated * maxValueCount * static_cast<uint32_t>( sizeof( TTypedValue_1_0 ) ) : 0,
+                    doIdleCollapsing,
+                    outIdleRunInfo ? outIdleRunInfo + calculated : nullptr,
+                    outIdleRunInfo ? outIdleRunInfoCount - calculated : 0,
+                    false );
+
+                calculated += runReportCount;
+            }
+
+            first = end;
+        }
+
+        if( outReportCount )
+        {
+            *outReportCount = calculated;
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     IsIoStreamReportOfOtherMetricSet
+    //
+    // Description:
+    //     Checks whether an IoStream report of the opened stream was sampled
+    //     with another metric set, after or before a metric set switch, or
+    //     while a switch was programmed.
+    //
+    // Input:
+    //     const uint8_t* rawReport - raw report
+    //
+    // Output:
+    //     bool                     - *true* if sampled with another metric set
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CMetricSet::IsIoStreamReportOfOtherMetricSet( const uint8_t* rawReport )
+    {
+        IMetricSetLatest* metricSet   = m_concurrentGroup->GetIoStreamReportMetricSet( rawReport );
+        uint32_t          switchCount = 0;
+
+        if( metricSet == nullptr )
+        {
+            // No metric set while switching, otherwise the stream is not opened
+            return m_concurrentGroup->GetIoStreamMetricSetSwitches( nullptr, &switchCount ) == CC_OK && switchCount > 1;
+        }
+
+        return metricSet != static_cast<IMetricSetLatest*>( this );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     CalculateMetricsInternal
+    //
+    // Description:
+    //     Common implementation of CalculateMetrics, CalculateMetricsCollapsed
+    //     and CalculateIoStreamMetrics. With splitAtSwitches IoStream reports
+    //     sampled with another metric set of a switched stream are not
+    //     calculated, see CalculateIoStreamRuns.
+    //
+    // Input:
+    //     const uint8_t*   rawData             - raw report data
+    //     uint32_t         rawDataSize         - size of raw report data in bytes
+    //     TTypedValue_1_0* out                 - (OUT) buffer for calculated reports
+    //     uint32_t         outSize             - size of the provided output buffer in bytes
+    //     uint32_t*        outReportCount      - (OUT - optional) how much reports were calculated and are stored in the out buffer
+    //     TTypedValue_1_0* outMaxValues        - (OUT - optional) buffer for calculated max values, can be nullptr
+    //     uint32_t         outMaxValuesSize    - size of the provided buffer for max values in bytes
+    //     bool             doIdleCollapsing    - if true collapse runs of IoStream reports without activity
+    //     TIdleRunInfo*    outIdleRunInfo      - (OUT - optional) idle run information for each calculated report, can be nullptr
+    //     uint32_t         outIdleRunInfoCount - count of entries in outIdleRunInfo
+    //     bool             splitAtSwitches     - if true IoStream reports are split at metric set switches
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricSet::CalculateMetricsInternal( const uint8_t* rawData, uint32_t rawDataSize, TTypedValue_1_0* out, uint32_t outSize, uint32_t* outReportCount, TTypedValue_1_0* outMaxValues, uint32_t outMaxValuesSize, bool doIdleCollapsing, TIdleRunInfo* outIdleRunInfo, uint32_t outIdleRunInfoCount, bool splitAtSwitches )
     {
         const uint32_t adapterId = m_device.GetAdapter().GetAdapterId();
 
@@ -2176,6 +2758,34 @@ namespace MetricsDiscoveryInternal
         auto ret = ValidateCalculateMetricsParams( rawDataSize, rawReportSize, outSize, rawReportCount, outMaxValuesSize );
         MD_CHECK_CC_RET_A( adapterId, ret );
 
+        if( doIdleCollapsing )
+        {
+            if( measurementType != MEASUREMENT_TYPE_SNAPSHOT_IO )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: idle collapsing supported only for IoStream" );
+                MD_LOG_EXIT_A( adapterId );
+                return CC_ERROR_NOT_SUPPORTED;
+            }
+            if( outIdleRunInfo && outIdleRunInfoCount < rawReportCount )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: idle run info buffer to small" );
+                MD_LOG_A( adapterId, LOG_DEBUG, "rawReportCount: %u, outIdleRunInfoCount: %u", rawReportCount, outIdleRunInfoCount );
+                MD_LOG_EXIT_A( adapterId );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+        }
+
+        if( splitAtSwitches && measurementType == MEASUREMENT_TYPE_SNAPSHOT_IO )
+        {
+            uint32_t switchCount = 0;
+            if( m_concurrentGroup->GetIoStreamMetricSetSwitches( nullptr, &switchCount ) == CC_OK && switchCount > 1 )
+            {
+                ret = CalculateIoStreamRuns( rawData, rawReportSize, rawReportCount, out, outSize, outReportCount, outMaxValues, outMaxValuesSize, doIdleCollapsing, outIdleRunInfo, outIdleRunInfoCount );
+                MD_LOG_EXIT_A( adapterId );
+                return ret;
+            }
+        }
+
         // Initialize manager and context
         TCalculationContext  calculationContext = {};
         CCalculationManager* calculationManager = nullptr;
@@ -2189,6 +2799,12 @@ namespace MetricsDiscoveryInternal
             goto deinitialize_manager;
         }
 
+        if( doIdleCollapsing )
+        {
+            calculationContext.StreamCalculationContext.DoIdleCollapsing = true;
+            calculationContext.StreamCalculationContext.OutIdleRunInfo   = outIdleRunInfo;
+        }
+
         MD_LOG_A( adapterId, LOG_DEBUG, "about to calculate %u raw reports", rawReportCount );
 
         // CALCULATE METRICS
@@ -2614,6 +3230,27 @@ namespace MetricsDiscoveryInternal
         return m_metricsCalculator;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricSet
+    //
+    // Method:
+    //     DiscardSavedReport
+    //
+    // Description:
+    //     Discards the last report saved by the previous stream calculation, so
+    //     the next calculation does not compute a delta across a gap in reports.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CMetricSet::DiscardSavedReport()
+    {
+        if( m_metricsCalculator != nullptr )
+        {
+            m_metricsCalculator->DiscardSavedReport();
+        }
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -0,0 +1,525 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_metrics_aggregator.cpp
+
+//     Abstract:   C++ Metrics Discovery internal sub device metrics aggregation implementation
+
+#include "md_metrics_aggregator.h"
+#include "md_adapter.h"
+#include "md_information.h"
+#include "md_metric.h"
+#include "md_metric_set.h"
+#include "md_metrics_calculator.h"
+#include "md_metrics_device.h"
+
+#include "md_utils.h"
+
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     CMetricsAggregator constructor
+    //
+    // Description:
+    //     Constructor. Determines how each metric of the given metric set is aggregated.
+    //
+    // Input:
+    //     CMetricSet& metricSet - metric set defining output report layout
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CMetricsAggregator::CMetricsAggregator( CMetricSet& metricSet )
+        : m_metricSet( metricSet )
+        , m_adapterId( metricSet.GetMetricsDevice().GetAdapter().GetAdapterId() )
+        , m_metricsCount( metricSet.GetParams()->MetricsCount )
+        , m_metricsAndInformationCount( metricSet.GetParams()->MetricsCount + metricSet.GetParams()->InformationCount )
+        , m_timestampIndex( -1 )
+        , m_gpuTimeIndex( -1 )
+        , m_aggregationTypes()
+        , m_subDevices()
+    {
+        for( uint32_t i = 0; i < metricSet.GetParams()->InformationCount; ++i )
+        {
+            auto information = metricSet.GetInformation( i );
+            if( information && information->GetParams()->SymbolName && std::string_view( information->GetParams()->SymbolName ) == "QueryBeginTime" )
+            {
+                m_timestampIndex = m_metricsCount + i;
+                break;
+            }
+        }
+
+        m_aggregationTypes.reserve( m_metricsCount );
+        for( uint32_t i = 0; i < m_metricsCount; ++i )
+        {
+            auto metric = metricSet.GetMetricExplicit( i );
+            if( metric && metric->GetParams()->SymbolName && std::string_view( metric->GetParams()->SymbolName ) == "GpuTime" )
+            {
+                m_gpuTimeIndex = i;
+            }
+
+            m_aggregationTypes.push_back( GetAggregationType( i ) );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     ~CMetricsAggregator
+    //
+    // Description:
+    //     Destructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CMetricsAggregator::~CMetricsAggregator()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     Calculate
+    //
+    // Description:
+    //     Calculates raw IoStream data of each sub device in a separate thread,
+    //     then walks reports of the first sub device and for each of them looks
+    //     for reports of all other sub devices with the nearest GPU timestamp.
+    //     Only reports present on all the sub devices are aggregated.
+    //
+    // Input:
+    //     const TSubDeviceRawData* subDeviceData  - raw data of each sub device
+    //     const uint32_t           subDeviceCount - sub device count
+    //     const uint64_t           toleranceNs    - max timestamp distance of aligned reports,
+    //                                               0 means half of the first sub device report period
+    //     TTypedValue_1_0*         out            - (OUT) buffer for aggregated reports
+    //     const uint32_t           outSize        - size of the output buffer in bytes
+    //     uint32_t*                outReportCount - (OUT - optional) aggregated report count
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsAggregator::Calculate( const TSubDeviceRawData* subDeviceData, const uint32_t subDeviceCount, const uint64_t toleranceNs, TTypedValue_1_0* out, const uint32_t outSize, uint32_t* outReportCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, subDeviceData, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, out, CC_ERROR_INVALID_PARAMETER );
+
+        if( subDeviceCount == 0 || m_metricsAndInformationCount == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: nothing to aggregate, subDeviceCount: %u", subDeviceCount );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( m_timestampIndex < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: QueryBeginTime information required to align reports" );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        m_subDevices.clear();
+        m_subDevices.reserve( subDeviceCount );
+
+        for( uint32_t i = 0; i < subDeviceCount; ++i )
+        {
+            MD_CHECK_CC_RET_A( m_adapterId, AddSubDevice( subDeviceData[i] ) );
+        }
+
+        // Calculate each sub device in parallel, sub devices use separate calculators.
+        std::vector<std::thread> threads;
+        threads.reserve( subDeviceCount - 1 );
+
+        auto calculate = []( TSubDeviceReports& subDevice )
+        {
+            subDevice.Result = subDevice.MetricSet->CalculateMetrics( subDevice.RawData, subDevice.RawDataSize, subDevice.Reports.data(), static_cast<uint32_t>( subDevice.Reports.size() * sizeof( TTypedValue_1_0 ) ), &subDevice.ReportCount, nullptr, 0 );
+        };
+
+        for( uint32_t i = 1; i < subDeviceCount; ++i )
+        {
+            threads.emplace_back( calculate, std::ref( m_subDevices[i] ) );
+        }
+
+        calculate( m_subDevices[0] );
+
+        for( auto& thread : threads )
+        {
+            thread.join();
+        }
+
+        for( uint32_t i = 0; i < subDeviceCount; ++i )
+        {
+            if( m_subDevices[i].Result != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: sub device %u calculation failed: %u", i, m_subDevices[i].Result );
+                return m_subDevices[i].Result;
+            }
+        }
+
+        // Align and combine
+        const uint64_t                      tolerance      = toleranceNs ? toleranceNs : GetDefaultTolerance();
+        const uint32_t                      outReportMax   = outSize / ( m_metricsAndInformationCount * sizeof( TTypedValue_1_0 ) );
+        const TSubDeviceReports&            reference      = m_subDevices[0];
+        std::vector<uint32_t>               positions( subDeviceCount, 0 );
+        std::vector<const TTypedValue_1_0*> aligned( subDeviceCount, nullptr );
+        uint32_t                            outReportIndex = 0;
+
+        for( uint32_t report = 0; report < reference.ReportCount; ++report )
+        {
+            aligned[0] = &reference.Reports[report * m_metricsAndInformationCount];
+
+            const uint64_t timestamp = aligned[0][m_timestampIndex].ValueUInt64;
+            bool           complete  = true;
+
+            for( uint32_t i = 1; i < subDeviceCount && complete; ++i )
+            {
+                aligned[i] = FindReport( m_subDevices[i], positions[i], timestamp, tolerance );
+                complete   = aligned[i] != nullptr;
+            }
+
+            if( !complete )
+            {
+                MD_LOG_A( m_adapterId, LOG_DEBUG, "report %u not present on all sub devices, skipped", report );
+                continue;
+            }
+
+            if( outReportIndex >= outReportMax )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: output buffer too small" );
+                MD_LOG_A( m_adapterId, LOG_DEBUG, "outSize: %u, reports: %u", outSize, reference.ReportCount );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+
+            CombineReports( aligned, &out[outReportIndex * m_metricsAndInformationCount] );
+            ++outReportIndex;
+        }
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "aggregated %u of %u reports from %u sub devices", outReportIndex, reference.ReportCount, subDeviceCount );
+
+        if( outReportCount )
+        {
+            *outReportCount = outReportIndex;
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     AddSubDevice
+    //
+    // Description:
+    //     Validates sub device data and allocates memory for its calculated reports.
+    //
+    // Input:
+    //     const TSubDeviceRawData& subDeviceData - raw data of a single sub device
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsAggregator::AddSubDevice( const TSubDeviceRawData& subDeviceData )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, subDeviceData.MetricSet, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, subDeviceData.RawData, CC_ERROR_INVALID_PARAMETER );
+
+        CMetricSet* metricSet = static_cast<CMetricSet*>( subDeviceData.MetricSet );
+        auto        params    = metricSet->GetParams();
+
+        for( auto& subDevice : m_subDevices )
+        {
+            if( subDevice.MetricSet == metricSet )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: the same metric set passed twice" );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+        }
+
+        if( strcmp( params->SymbolName, m_metricSet.GetParams()->SymbolName ) != 0 ||
+            params->MetricsCount + params->InformationCount != m_metricsAndInformationCount ||
+            params->RawReportSize == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: incompatible sub device metric set: %s", params->SymbolName );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        TSubDeviceReports subDevice = {};
+        subDevice.MetricSet         = metricSet;
+        subDevice.RawData           = subDeviceData.RawData;
+        subDevice.RawDataSize       = subDeviceData.RawDataSize;
+        subDevice.Result            = CC_ERROR_GENERAL;
+        subDevice.Reports.resize( static_cast<size_t>( subDeviceData.RawDataSize / params->RawReportSize ) * m_metricsAndInformationCount );
+
+        m_subDevices.push_back( std::move( subDevice ) );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     GetAggregationType
+    //
+    // Description:
+    //     Returns aggregation type of the metric. Values relative to time or to
+    //     the sub device size (percentages, ratios, frequencies, durations) are
+    //     averaged, absolute ones (events, throughputs) are summed up.
+    //
+    // Input:
+    //     const uint32_t metricIndex - metric index in the metric set
+    //
+    // Output:
+    //     TAggregationType - aggregation type
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TAggregationType CMetricsAggregator::GetAggregationType( const uint32_t metricIndex )
+    {
+        auto metric = m_metricSet.GetMetricExplicit( metricIndex );
+        MD_CHECK_PTR_RET_A( m_adapterId, metric, AGGREGATION_TYPE_FIRST );
+
+        auto             params = metric->GetParams();
+        std::string_view units  = params->MetricResultUnits ? params->MetricResultUnits : "";
+
+        if( params->ResultType == RESULT_BOOL || params->MetricType == METRIC_TYPE_FLAG )
+        {
+            return AGGREGATION_TYPE_OR;
+        }
+
+        switch( params->MetricType )
+        {
+            case METRIC_TYPE_TIMESTAMP:
+                return AGGREGATION_TYPE_FIRST;
+
+            case METRIC_TYPE_DURATION:
+            case METRIC_TYPE_RATIO:
+                return AGGREGATION_TYPE_WEIGHTED_AVERAGE;
+
+            default:
+                return ( units == "percent" || units == "MHz" || units == "ns" || units == "us" )
+                    ? AGGREGATION_TYPE_WEIGHTED_AVERAGE
+                    : AGGREGATION_TYPE_SUM;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     FindReport
+    //
+    // Description:
+    //     Finds the sub device report nearest to the given timestamp. Reports are
+    //     sorted by timestamp, so the search continues from the previous position.
+    //
+    // Input:
+    //     const TSubDeviceReports& subDevice   - calculated sub device reports
+    //     uint32_t&                position    - (IN/OUT) search start position
+    //     const uint64_t           timestamp   - reference timestamp in ns
+    //     const uint64_t           toleranceNs - max allowed timestamp distance
+    //
+    // Output:
+    //     const TTypedValue_1_0* - found report, nullptr if none within the tolerance
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TTypedValue_1_0* CMetricsAggregator::FindReport( const TSubDeviceReports& subDevice, uint32_t& position, const uint64_t timestamp, const uint64_t toleranceNs )
+    {
+        auto getTimestamp = [&]( const uint32_t index )
+        {
+            return subDevice.Reports[index * m_metricsAndInformationCount + m_timestampIndex].ValueUInt64;
+        };
+        auto getDistance = [&]( const uint32_t index )
+        {
+            const uint64_t reportTimestamp = getTimestamp( index );
+            return ( reportTimestamp > timestamp ) ? reportTimestamp - timestamp : timestamp - reportTimestamp;
+        };
+
+        // Skip reports older than the nearest one
+        while( position + 1 < subDevice.ReportCount && getDistance( position + 1 ) <= getDistance( position ) )
+        {
+            ++position;
+        }
+
+        if( position >= subDevice.ReportCount || getDistance( position ) > toleranceNs )
+        {
+            return nullptr;
+        }
+
+        return &subDevice.Reports[position * m_metricsAndInformationCount];
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     GetDefaultTolerance
+    //
+    // Description:
+    //     Returns half of the average report period of the first sub device.
+    //
+    // Output:
+    //     uint64_t - tolerance in ns
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CMetricsAggregator::GetDefaultTolerance()
+    {
+        const TSubDeviceReports& reference = m_subDevices[0];
+
+        if( reference.ReportCount < 2 )
+        {
+            return UINT64_MAX;
+        }
+
+        const uint64_t first = reference.Reports[m_timestampIndex].ValueUInt64;
+        const uint64_t last  = reference.Reports[( reference.ReportCount - 1 ) * m_metricsAndInformationCount + m_timestampIndex].ValueUInt64;
+
+        return ( last - first ) / ( reference.ReportCount - 1 ) / 2;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsAggregator
+    //
+    // Method:
+    //     CombineReports
+    //
+    // Description:
+    //     Combines aligned reports of all sub devices into a single report.
+    //     Information is taken from the first sub device.
+    //
+    // Input:
+    //     const std::vector<const TTypedValue_1_0*>& reports - aligned report of each sub device
+    //     TTypedValue_1_0*                           out     - (OUT) aggregated report
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CMetricsAggregator::CombineReports( const std::vector<const TTypedValue_1_0*>& reports, TTypedValue_1_0* out )
+    {
+        CMetricsCalculator* calculator = m_metricSet.GetMetricsCalculator();
+
+        iu_memcpy_s( out, m_metricsAndInformationCount * sizeof( TTypedValue_1_0 ), reports[0], m_metricsAndInformationCount * sizeof( TTypedValue_1_0 ) );
+
+        if( calculator == nullptr )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: missing metrics calculator" );
+            return;
+        }
+
+        // Weights for averages
+        double              weightSum = 0.0;
+        std::vector<double> weights( reports.size(), 1.0 );
+
+        for( size_t i = 0; i < reports.size(); ++i )
+        {
+            if( m_gpuTimeIndex >= 0 )
+            {
+                weights[i] = static_cast<double>( calculator->CastToUInt64( reports[i][m_gpuTimeIndex] ) );
+            }
+            weightSum += weights[i];
+        }
+
+        for( uint32_t metric = 0; metric < m_metricsCount; ++metric )
+        {
+            TTypedValue_1_0& value = out[metric];
+
+            switch( m_aggregationTypes[metric] )
+            {
+                case AGGREGATION_TYPE_SUM:
+                {
+                    if( value.ValueType == VALUE_TYPE_UINT64 || value.ValueType == VALUE_TYPE_UINT32 )
+                    {
+                        // Integer sums are exact, float would lose precision above 2^24
+                        uint64_t sum = 0;
+                        for( auto report : reports )
+                        {
+                            sum += calculator->CastToUInt64( report[metric] );
+                        }
+
+                        if( value.ValueType == VALUE_TYPE_UINT64 )
+                        {
+                            value.ValueUInt64 = sum;
+                        }
+                        else
+                        {
+                            value.ValueUInt32 = static_cast<uint32_t>( sum );
+                        }
+                    }
+                    else
+                    {
+                        double sum = 0.0;
+                        for( auto report : reports )
+                        {
+                            sum += static_cast<double>( calculator->CastToFloat( report[metric] ) );
+                        }
+                        value.ValueFloat = static_cast<float>( sum );
+                    }
+                    break;
+                }
+
+                case AGGREGATION_TYPE_WEIGHTED_AVERAGE:
+                {
+                    double average = 0.0;
+                    for( size_t i = 0; i < reports.size(); ++i )
+                    {
+                        const double weight = ( weightSum > 0.0 ) ? weights[i] / weightSum : 1.0 / reports.size();
+                        const double sample = ( reports[i][metric].ValueType == VALUE_TYPE_FLOAT )
+                            ? static_cast<double>( reports[i][metric].ValueFloat )
+                            : static_cast<double>( calculator->CastToUInt64( reports[i][metric] ) );
+
+                        average += weight * sample;
+                    }
+
+                    if( value.ValueType == VALUE_TYPE_UINT64 )
+                    {
+                        value.ValueUInt64 = static_cast<uint64_t>( average + 0.5 );
+                    }
+                    else if( value.ValueType == VALUE_TYPE_UINT32 )
+                    {
+                        value.ValueUInt32 = static_cast<uint32_t>( average + 0.5 );
+                    }
+                    else
+                    {
+                        value.ValueFloat = static_cast<float>( average );
+                    }
+                    break;
+                }
+
+                case AGGREGATION_TYPE_OR:
+                    for( auto report : reports )
+                    {
+                        value.ValueBool = value.ValueBool || calculator->CastToBoolean( report[metric] );
+                    }
+                    break;
+
+                case AGGREGATION_TYPE_FIRST:
+                default:
+                    break;
+            }
+        }
+    }
+} // namespace MetricsDiscoveryInternal
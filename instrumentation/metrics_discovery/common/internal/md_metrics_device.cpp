@@ -13,6 +13,7 @@ SPDX-License-Identifier: MIT
 #include "md_metrics_device.h"
 #include "md_adapter.h"
 #include "md_concurrent_group.h"
+#include "md_io_stream_capture.h"
 #include "md_oa_concurrent_group.h"
 #include "md_oam_concurrent_group.h"
 #include "md_equation.h"
@@ -23,6 +24,7 @@ SPDX-License-Identifier: MIT
 
 #include "md_driver_ifc.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 
@@ -45,11 +47,15 @@ namespace MetricsDiscoveryInternal
         : m_params{}
         , m_groupsVector()
         , m_overridesVector()
+        , m_sideBandSamplersVector()
         , m_adapter( adapter )
         , m_driverInterface( driverInterface )
         , m_symbolSet( *this, driverInterface )
+        , m_timestampCorrelation()
         , m_streamId( -1 )
         , m_streamConfigId( -1 )
+        , m_streamGeneration( 0 )
+        , m_streamPaused( false )
         , m_subDeviceIndex( subDeviceIndex )
         , m_platformIndex( 0 )
         , m_gtType( GT_TYPE_UNKNOWN )
@@ -106,6 +112,8 @@ namespace MetricsDiscoveryInternal
     {
         MD_SAFE_DELETE_ARRAY( m_params.DeviceName );
 
+        ClearVector( m_sideBandSamplersVector );
+        ClearVector( m_ioStreamCapturesVector );
         ClearVector( m_groupsVector );
         ClearVector( m_overridesVector );
     }
@@ -308,6 +316,270 @@ namespace MetricsDiscoveryInternal
         return GetGpuCpuTimestamps( gpuTimestampNs, cpuTimestampNs, cpuId, nullptr );
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     OpenIoStreamCapture
+    //
+    // Description:
+    //     Opens a raw IoStream capture file for offline calculation. The capture
+    //     is calculated with the metric set and global symbols stored in the file,
+    //     this device only hosts the calculation. The capture is owned by
+    //     the metrics device.
+    //
+    // Input:
+    //     const char*                fileName   - capture file path
+    //     IInternalIoStreamCapture** outCapture - (out) opened capture
+    //
+    // Output:
+    //     TCompletionCode                       - result of the operation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::OpenIoStreamCapture( const char* fileName, IInternalIoStreamCapture** outCapture )
+    {
+        const uint32_t adapterId = m_adapter.GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, fileName, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, outCapture, CC_ERROR_INVALID_PARAMETER );
+
+        *outCapture = nullptr;
+
+        auto capture = new( std::nothrow ) CIoStreamCaptureFile( *this );
+        MD_CHECK_PTR_RET_A( adapterId, capture, CC_ERROR_NO_MEMORY );
+
+        const TCompletionCode ret = capture->Open( fileName );
+        if( ret != CC_OK )
+        {
+            MD_SAFE_DELETE( capture );
+            return ret;
+        }
+
+        m_ioStreamCapturesVector.push_back( capture );
+        *outCapture = capture;
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     CloseIoStreamCapture
+    //
+    // Description:
+    //     Closes capture opened with OpenIoStreamCapture.
+    //
+    // Input:
+    //     IInternalIoStreamCapture* capture - capture to close
+    //
+    // Output:
+    //     TCompletionCode                   - result of the operation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::CloseIoStreamCapture( IInternalIoStreamCapture* capture )
+    {
+        auto it = std::find( m_ioStreamCapturesVector.begin(), m_ioStreamCapturesVector.end(), capture );
+        if( capture == nullptr || it == m_ioStreamCapturesVector.end() )
+        {
+            MD_LOG_A( m_adapter.GetAdapterId(), LOG_ERROR, "error: capture not opened by this metrics device" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        MD_SAFE_DELETE( *it );
+        m_ioStreamCapturesVector.erase( it );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     UpdateTimestampCorrelation
+    //
+    // Description:
+    //     Takes a paired GPU / CPU timestamp sample and refits the GPU to CPU
+    //     timestamp model. Samples are rate limited, so the function may be called
+    //     periodically, e.g. before each stream read, without an ioctl each time.
+    //
+    // Input:
+    //     bool                       force   - take a sample regardless of the rate limit
+    //     TTimestampCorrelationInfo* outInfo - (out) model state, may be null
+    //
+    // Output:
+    //     TCompletionCode                    - result of the operation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::UpdateTimestampCorrelation( bool force, TTimestampCorrelationInfo* outInfo )
+    {
+        const uint32_t     adapterId          = m_adapter.GetAdapterId();
+        TTypedValueLatest* timestampFrequency = GetGlobalSymbolValueByName( "GpuTimestampFrequency" );
+        MD_CHECK_PTR_RET_A( adapterId, timestampFrequency, CC_ERROR_GENERAL );
+
+        const uint64_t frequency = timestampFrequency->ValueUInt32;
+        if( frequency == 0 )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: unknown gpu timestamp frequency" );
+            return CC_ERROR_GENERAL;
+        }
+
+        m_timestampCorrelation.SetFrequency( frequency );
+
+        const uint64_t timeNs = GetTimeNs();
+
+        if( force || m_timestampCorrelation.IsSampleNeeded( timeNs ) )
+        {
+            uint64_t gpuTimestampNs       = 0;
+            uint64_t cpuTimestampNs       = 0;
+            uint64_t correlationIndicator = 0;
+            uint32_t cpuId                = 0;
+
+            auto ret = m_driverInterface.GetGpuCpuTimestamps( *this, &gpuTimestampNs, &cpuTimestampNs, &cpuId, &correlationIndicator );
+            MD_CHECK_CC_RET_A( adapterId, ret );
+
+            // The driver scales 32 bit ticks down to ns, so rounding up restores them exactly
+            const uint64_t gpuTimestampTicks = ( gpuTimestampNs * frequency + MD_SECOND_IN_NS - 1 ) / MD_SECOND_IN_NS;
+
+            m_timestampCorrelation.AddSample( gpuTimestampTicks, cpuTimestampNs, timeNs );
+        }
+
+        if( outInfo )
+        {
+            m_timestampCorrelation.GetInfo( *outInfo );
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     ConvertGpuTimestampsToCpu
+    //
+    // Description:
+    //     Converts GPU report timestamps to CPU time with the model fitted by
+    //     UpdateTimestampCorrelation, without any ioctl. Only the low 32 bits of
+    //     GPU timestamps are used, so timestamps have to be within 2^31 ticks
+    //     of the newest sample. May be called from any thread.
+    //
+    // Input:
+    //     const uint64_t* gpuTimestamps   - GPU timestamps in ticks
+    //     uint64_t*       cpuTimestampsNs - (out) CPU timestamps in ns
+    //     uint32_t        count           - timestamp count
+    //
+    // Output:
+    //     TCompletionCode                 - result of the operation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::ConvertGpuTimestampsToCpu( const uint64_t* gpuTimestamps, uint64_t* cpuTimestampsNs, uint32_t count )
+    {
+        const uint32_t adapterId = m_adapter.GetAdapterId();
+        MD_CHECK_PTR_RET_A( adapterId, gpuTimestamps, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( adapterId, cpuTimestampsNs, CC_ERROR_INVALID_PARAMETER );
+
+        TTimestampCorrelationModel model = {};
+        if( !m_timestampCorrelation.GetModel( model ) )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: timestamp correlation not updated" );
+            return CC_ERROR_GENERAL;
+        }
+
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            cpuTimestampsNs[i] = CTimestampCorrelation::GpuTicksToCpuNs( model, gpuTimestamps[i] );
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     CreateSideBandSampler
+    //
+    // Description:
+    //     Creates a sampler of GPU state not present in OA reports, e.g. actual
+    //     frequency, RC6 residency, throttle reasons and energy. Samples are
+    //     timestamped with CPU time, so they are matched with report intervals
+    //     converted by ConvertGpuTimestampsToCpu. The sampler is created stopped
+    //     and is owned by the metrics device.
+    //
+    // Input:
+    //     const TSideBandSamplerParams* params     - sampler parameters, null means defaults
+    //     IInternalSideBandSampler**    outSampler - (out) created sampler
+    //
+    // Output:
+    //     TCompletionCode                          - result of the operation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::CreateSideBandSampler( const TSideBandSamplerParams* params, IInternalSideBandSampler** outSampler )
+    {
+        const uint32_t adapterId = m_adapter.GetAdapterId();
+        MD_CHECK_PTR_RET_A( adapterId, outSampler, CC_ERROR_INVALID_PARAMETER );
+
+        *outSampler = nullptr;
+
+        const TSideBandSamplerParams defaultParams = {};
+
+        auto sampler = m_driverInterface.CreateSideBandSampler( params ? *params : defaultParams );
+        if( sampler == nullptr )
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "error: cannot create side-band sampler" );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        m_sideBandSamplersVector.push_back( sampler );
+        *outSampler = sampler;
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     DeleteSideBandSampler
+    //
+    // Description:
+    //     Stops and deletes sampler created with CreateSideBandSampler.
+    //
+    // Input:
+    //     IInternalSideBandSampler* sampler - sampler to delete
+    //
+    // Output:
+    //     TCompletionCode                   - result of the operation
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::DeleteSideBandSampler( IInternalSideBandSampler* sampler )
+    {
+        auto it = std::find( m_sideBandSamplersVector.begin(), m_sideBandSamplersVector.end(), sampler );
+        if( sampler == nullptr || it == m_sideBandSamplersVector.end() )
+        {
+            MD_LOG_A( m_adapter.GetAdapterId(), LOG_ERROR, "error: sampler not created by this metrics device" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        MD_SAFE_DELETE( *it );
+        m_sideBandSamplersVector.erase( it );
+
+        return CC_OK;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -604,13 +876,48 @@ namespace MetricsDiscoveryInternal
     //////////////////////////////////////////////////////////////////////////////
     TCompletionCode CMetricsDevice::SaveToFile( const char* fileName, const uint32_t minMajorApiVersion /* =0*/, const uint32_t minMinorApiVersion /* =0*/ )
     {
-        TCompletionCode retVal     = CC_OK;
-        FILE*           metricFile = nullptr;
-        const uint32_t  adapterId  = m_adapter.GetAdapterId();
+        FILE*          metricFile = nullptr;
+        const uint32_t adapterId  = m_adapter.GetAdapterId();
 
         iu_fopen_s( &metricFile, fileName, "wb" );
         MD_CHECK_PTR_RET_A( adapterId, metricFile, CC_ERROR_FILE_NOT_FOUND );
 
+        TCompletionCode retVal = WriteToFile( metricFile, minMajorApiVersion, minMinorApiVersion );
+
+        fclose( metricFile );
+
+        return retVal;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     WriteToFile
+    //
+    // Description:
+    //     Writes a custom part of MetricsDevice to the opened file. If a metric set
+    //     is given, only the metric set is written instead, e.g. to describe
+    //     a capture of its reports.
+    //
+    // Input:
+    //     FILE*           metricFile      - opened file
+    //     const uint32_t  minMajorVersion - required major MDAPI version to save to file
+    //     const uint32_t  minMinorVersion - required minor MDAPI version to save to file
+    //     CMetricSet*     metricSet       - (optional) the only metric set to write
+    //
+    // Output:
+    //     TCompletionCode             - result
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::WriteToFile( FILE* metricFile, const uint32_t minMajorApiVersion, const uint32_t minMinorApiVersion, CMetricSet* metricSet /* = nullptr */ )
+    {
+        TCompletionCode retVal = CC_OK;
+
+        MD_CHECK_PTR_RET_A( m_adapter.GetAdapterId(), metricFile, CC_ERROR_INVALID_PARAMETER );
+
         // Specific key indicating plain text MDAPI file
         fwrite( MD_METRICS_FILE_KEY_3_0, sizeof( char ), sizeof( MD_METRICS_FILE_KEY_3_0 ), metricFile );
 
@@ -628,6 +935,14 @@ namespace MetricsDiscoveryInternal
         m_symbolSet.WriteSymbolSetToFile( metricFile );
 
         // m_groupsVector
+        if( metricSet != nullptr )
+        {
+            const uint32_t groupsCount = 1;
+            fwrite( &groupsCount, sizeof( groupsCount ), 1, metricFile );
+
+            return metricSet->GetConcurrentGroup()->WriteCConcurrentGroupToFile( metricFile, metricSet );
+        }
+
         uint32_t groupsCount = m_groupsVector.size();
         fwrite( &groupsCount, sizeof( groupsCount ), 1, metricFile );
         for( auto& group : m_groupsVector )
@@ -639,8 +954,6 @@ namespace MetricsDiscoveryInternal
             }
         }
 
-        fclose( metricFile );
-
         return retVal;
     }
 
@@ -1402,7 +1715,6 @@ namespace MetricsDiscoveryInternal
         TCompletionCode retVal           = CC_OK;
         FILE*           metricFile       = nullptr;
         uint8_t*        metricFileBuffer = nullptr;
-        uint8_t*        bufferPtr        = nullptr;
         uint32_t        fileVersion      = CUSTOM_METRICS_FILE_VERSION_0;
         const uint32_t  adapterId        = m_adapter.GetAdapterId();
 
@@ -1434,20 +1746,6 @@ namespace MetricsDiscoveryInternal
                 fclose( metricFile );
                 return CC_ERROR_INVALID_PARAMETER;
             }
-            bufferPtr = metricFileBuffer;
-
-            if( fileVersion == CUSTOM_METRICS_FILE_VERSION_1 )
-            {
-                bufferPtr += sizeof( MD_METRICS_FILE_KEY );
-            }
-            else if( fileVersion == CUSTOM_METRICS_FILE_VERSION_2 )
-            {
-                bufferPtr += sizeof( MD_METRICS_FILE_KEY_2_0 );
-            }
-            else if( fileVersion == CUSTOM_METRICS_FILE_VERSION_3 )
-            {
-                bufferPtr += sizeof( MD_METRICS_FILE_KEY_3_0 );
-            }
         }
         else
         {
@@ -1458,83 +1756,137 @@ namespace MetricsDiscoveryInternal
 
         if( retVal == CC_OK )
         {
-            if( fileVersion > CUSTOM_METRICS_FILE_VERSION_1 )
+            retVal = OpenFromFileBuffer( metricFileBuffer, fileSize, fileVersion );
+        }
+
+        MD_SAFE_DELETE_ARRAY( metricFileBuffer );
+        return retVal;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     OpenFromFileBuffer
+    //
+    // Description:
+    //     Loads saved metrics device from a buffer with the whole file content,
+    //     e.g. read from a file or embedded in another file.
+    //
+    // Input:
+    //     uint8_t*       metricFileBuffer - buffer starting with the file key
+    //     const uint32_t fileSize         - buffer size
+    //     const uint32_t fileVersion      - file version matching the file key
+    //
+    // Output:
+    //     TCompletionCode                 - result
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CMetricsDevice::OpenFromFileBuffer( uint8_t* metricFileBuffer, const uint32_t fileSize, const uint32_t fileVersion )
+    {
+        TCompletionCode retVal     = CC_OK;
+        uint8_t*        bufferPtr  = metricFileBuffer;
+        TApiVersion_1_0 apiVersion = {};
+        const uint32_t  adapterId  = m_adapter.GetAdapterId();
+
+        MD_CHECK_PTR_RET_A( adapterId, metricFileBuffer, CC_ERROR_INVALID_PARAMETER );
+
+        if( fileVersion == CUSTOM_METRICS_FILE_VERSION_1 )
+        {
+            bufferPtr += sizeof( MD_METRICS_FILE_KEY );
+        }
+        else if( fileVersion == CUSTOM_METRICS_FILE_VERSION_2 )
+        {
+            bufferPtr += sizeof( MD_METRICS_FILE_KEY_2_0 );
+        }
+        else if( fileVersion == CUSTOM_METRICS_FILE_VERSION_3 )
+        {
+            bufferPtr += sizeof( MD_METRICS_FILE_KEY_3_0 );
+        }
+        else
+        {
+            MD_LOG_A( adapterId, LOG_ERROR, "Metrics device file is not valid" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        if( fileVersion > CUSTOM_METRICS_FILE_VERSION_1 )
+        {
+            uint32_t majorApiVersion = 0;
+            uint32_t minorApiVersion = 0;
+
+            retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, majorApiVersion, adapterId );
+            MD_CHECK_CC( retVal );
+
+            retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, minorApiVersion, adapterId );
+            MD_CHECK_CC( retVal );
+
+            if( ( majorApiVersion == MD_API_MAJOR_NUMBER_CURRENT && minorApiVersion > MD_API_MINOR_NUMBER_CURRENT ) || majorApiVersion > MD_API_MAJOR_NUMBER_CURRENT )
             {
-                uint32_t majorApiVersion = 0;
-                uint32_t minorApiVersion = 0;
+                MD_LOG_A( adapterId, LOG_ERROR, "Requered MDAPI version %d.%d, current version %d.%d", majorApiVersion, minorApiVersion, MD_API_MAJOR_NUMBER_CURRENT, MD_API_MINOR_NUMBER_CURRENT );
+                m_isOpenedFromFile = false;
+                return CC_ERROR_NOT_SUPPORTED;
+            }
+        }
 
-                retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, majorApiVersion, adapterId );
-                MD_CHECK_CC( retVal );
+        if( fileVersion >= CUSTOM_METRICS_FILE_VERSION_3 )
+        {
+            uint32_t savedPlatformIndex = 0;
 
-                retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, minorApiVersion, adapterId );
-                MD_CHECK_CC( retVal );
+            retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, savedPlatformIndex, adapterId );
+            MD_CHECK_CC( retVal );
 
-                if( ( majorApiVersion == MD_API_MAJOR_NUMBER_CURRENT && minorApiVersion > MD_API_MINOR_NUMBER_CURRENT ) || majorApiVersion > MD_API_MAJOR_NUMBER_CURRENT )
+            MD_LOG_A( adapterId, LOG_DEBUG, "Metrics device file saved on platform index: %u, current: %u", savedPlatformIndex, m_platformIndex );
+        }
+        else
+        {
+            uint32_t       platFormIndex = UINT32_MAX;
+            const uint32_t platformMask  = *( (TPlatformType*) bufferPtr );
+            for( uint32_t i = 0; i < sizeof( platformMask ) * MD_BYTE; ++i )
+            {
+                if( platformMask & ( 1 << i ) )
                 {
-                    MD_LOG_A( adapterId, LOG_ERROR, "Requered MDAPI version %d.%d, current version %d.%d", majorApiVersion, minorApiVersion, MD_API_MAJOR_NUMBER_CURRENT, MD_API_MINOR_NUMBER_CURRENT );
-                    m_isOpenedFromFile = false;
-                    MD_SAFE_DELETE_ARRAY( metricFileBuffer );
-                    return CC_ERROR_NOT_SUPPORTED;
+                    platFormIndex = i;
+                    break;
                 }
             }
 
-            if( fileVersion >= CUSTOM_METRICS_FILE_VERSION_3 )
+            if( platFormIndex == UINT32_MAX )
             {
-                MD_LOG_A( adapterId, LOG_DEBUG, "Metrics device file saved on platform index: %u, current: %u", *( (uint32_t*) bufferPtr ), m_platformIndex );
-                bufferPtr += sizeof( uint32_t );
+                MD_LOG_A( adapterId, LOG_DEBUG, "WARNING: read platform mask of metrics device is empty." );
             }
             else
             {
-                uint32_t       platFormIndex = UINT32_MAX;
-                const uint32_t platformMask  = *( (TPlatformType*) bufferPtr );
-                for( uint32_t i = 0; i < sizeof( platformMask ) * MD_BYTE; ++i )
-                {
-                    if( platformMask & ( 1 << i ) )
-                    {
-                        platFormIndex = i;
-                        break;
-                    }
-                }
-
-                if( platFormIndex == UINT32_MAX )
-                {
-                    MD_LOG_A( adapterId, LOG_DEBUG, "WARNING: read platform mask of metrics device is empty." );
-                }
-                else
-                {
-                    MD_LOG_A( adapterId, LOG_DEBUG, "Metrics device file saved on platform: %u, current: %u", platFormIndex, m_platformIndex );
-                }
-
-                bufferPtr += sizeof( TPlatformType );
+                MD_LOG_A( adapterId, LOG_DEBUG, "Metrics device file saved on platform: %u, current: %u", platFormIndex, m_platformIndex );
             }
 
-            // MetricsDeviceParams
-            TApiVersion_1_0 apiVersion = {};
+            bufferPtr += sizeof( TPlatformType );
+        }
 
-            retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, apiVersion.MajorNumber, adapterId );
-            MD_CHECK_CC( retVal );
-            retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, apiVersion.MinorNumber, adapterId );
-            MD_CHECK_CC( retVal );
-            retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, apiVersion.BuildNumber, adapterId );
-            MD_CHECK_CC( retVal );
+        // MetricsDeviceParams
+        retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, apiVersion.MajorNumber, adapterId );
+        MD_CHECK_CC( retVal );
+        retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, apiVersion.MinorNumber, adapterId );
+        MD_CHECK_CC( retVal );
+        retVal = ReadUInt32FromFileBuffer( bufferPtr, metricFileBuffer, fileSize, apiVersion.BuildNumber, adapterId );
+        MD_CHECK_CC( retVal );
 
-            MD_LOG_A( adapterId, LOG_DEBUG, "Metrics device file saved with MDAPI v. %d.%d.%d, current v: %d.%d.%d", apiVersion.MajorNumber, apiVersion.MinorNumber, apiVersion.BuildNumber, MD_API_MAJOR_NUMBER_CURRENT, MD_API_MINOR_NUMBER_CURRENT, MD_API_BUILD_NUMBER_CURRENT );
+        MD_LOG_A( adapterId, LOG_DEBUG, "Metrics device file saved with MDAPI v. %d.%d.%d, current v: %d.%d.%d", apiVersion.MajorNumber, apiVersion.MinorNumber, apiVersion.BuildNumber, MD_API_MAJOR_NUMBER_CURRENT, MD_API_MINOR_NUMBER_CURRENT, MD_API_BUILD_NUMBER_CURRENT );
 
-            // GlobalSymbols
-            retVal = ReadGlobalSymbolsFromFileBuffer( bufferPtr, metricFileBuffer, fileSize );
-            MD_CHECK_CC( retVal );
+        // GlobalSymbols
+        retVal = ReadGlobalSymbolsFromFileBuffer( bufferPtr, metricFileBuffer, fileSize );
+        MD_CHECK_CC( retVal );
 
-            // ConcurrentGroup tree
-            if( retVal == CC_OK )
-            {
-                retVal = ReadConcurrentGroupsFromFileBuffer( bufferPtr, metricFileBuffer, fileSize, &apiVersion, fileVersion );
-                MD_CHECK_CC( retVal );
-            }
+        // ConcurrentGroup tree
+        if( retVal == CC_OK )
+        {
+            retVal = ReadConcurrentGroupsFromFileBuffer( bufferPtr, metricFileBuffer, fileSize, &apiVersion, fileVersion );
+            MD_CHECK_CC( retVal );
         }
         m_isOpenedFromFile = ( retVal == CC_OK );
 
     exception:
-        MD_SAFE_DELETE_ARRAY( metricFileBuffer );
         return retVal;
     }
 
@@ -1672,6 +2024,52 @@ namespace MetricsDiscoveryInternal
         return m_platformIndex;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     GetGtType
+    //
+    // Description:
+    //     Returns GT type.
+    //
+    // Output:
+    //     TGTType - GT type.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TGTType CMetricsDevice::GetGtType()
+    {
+        return m_gtType;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     SetPlatform
+    //
+    // Description:
+    //     Overrides platform index and GT type, so metric sets read from a file
+    //     are matched against the platform they were saved on. Must be called
+    //     before any concurrent group is added.
+    //
+    // Input:
+    //     const uint32_t platformIndex - platform index
+    //     const TGTType  gtType        - GT type
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CMetricsDevice::SetPlatform( const uint32_t platformIndex, const TGTType gtType )
+    {
+        MD_ASSERT_A( m_adapter.GetAdapterId(), m_groupsVector.empty() );
+
+        m_platformIndex = platformIndex;
+        m_gtType        = gtType;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -1838,6 +2236,27 @@ namespace MetricsDiscoveryInternal
         return m_streamId;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     GetStreamGeneration
+    //
+    // Description:
+    //     Returns number of streams opened so far. A reopened stream may get
+    //     the same stream id, but it always gets a new generation.
+    //
+    // Output:
+    //     uint32_t - stream generation.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CMetricsDevice::GetStreamGeneration()
+    {
+        return m_streamGeneration;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -1847,7 +2266,7 @@ namespace MetricsDiscoveryInternal
     //     SetStreamId
     //
     // Description:
-    //     Sets stream id.
+    //     Sets stream id. A valid id starts a new stream generation.
     //
     // Input:
     //     const int32_t id - stream id.
@@ -1856,6 +2275,11 @@ namespace MetricsDiscoveryInternal
     void CMetricsDevice::SetStreamId( const int32_t id )
     {
         m_streamId = id;
+
+        if( id >= 0 )
+        {
+            ++m_streamGeneration;
+        }
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -1878,6 +2302,46 @@ namespace MetricsDiscoveryInternal
         m_streamConfigId = id;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     IsStreamPaused
+    //
+    // Description:
+    //     Returns whether the stream is paused (opened or set disabled).
+    //
+    // Output:
+    //     bool - *true* if paused.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CMetricsDevice::IsStreamPaused()
+    {
+        return m_streamPaused;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     SetStreamPaused
+    //
+    // Description:
+    //     Sets whether the stream is paused. Reads of a paused stream return no reports.
+    //
+    // Input:
+    //     const bool paused - *true* if paused.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CMetricsDevice::SetStreamPaused( const bool paused )
+    {
+        m_streamPaused = paused;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -1890,14 +2354,34 @@ namespace MetricsDiscoveryInternal
     //     Returns preallocated buffer for reading data from tbs stream to avoid new allocations on every read.
     //
     // Output:
-    //     std::vector<uint8_t> - tbs stream buffer.
+    //     CStreamBuffer& - tbs stream buffer.
     //
     //////////////////////////////////////////////////////////////////////////////
-    std::vector<uint8_t>& CMetricsDevice::GetStreamBuffer()
+    CStreamBuffer& CMetricsDevice::GetStreamBuffer()
     {
         return m_streamBuffer;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsDevice
+    //
+    // Method:
+    //     GetStreamSpans
+    //
+    // Description:
+    //     Returns spans of raw reports placed in the stream buffer by the last read.
+    //
+    // Output:
+    //     std::vector<TIoStreamSpan> - raw report spans.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    std::vector<TIoStreamSpan>& CMetricsDevice::GetStreamSpans()
+    {
+        return m_streamSpans;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
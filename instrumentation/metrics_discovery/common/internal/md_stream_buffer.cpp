@@ -0,0 +1,335 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_stream_buffer.cpp
+
+//     Abstract:   C++ Metrics Discovery internal stream buffer implementation
+
+#include "md_stream_buffer.h"
+
+#include "md_utils.h"
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProvider
+    //
+    // Method:
+    //     Allocate
+    //
+    // Description:
+    //     Allocates a heap buffer.
+    //
+    // Input:
+    //     const size_t size          - requested size in bytes
+    //     size_t&      allocatedSize - (out) allocated size in bytes
+    //
+    // Output:
+    //     uint8_t*                   - allocated buffer, nullptr on failure
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint8_t* CBufferProvider::Allocate( const size_t size, size_t& allocatedSize )
+    {
+        uint8_t* data = new( std::nothrow ) uint8_t[size];
+
+        allocatedSize = data ? size : 0;
+        return data;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProvider
+    //
+    // Method:
+    //     Free
+    //
+    // Description:
+    //     Frees a buffer allocated with Allocate.
+    //
+    // Input:
+    //     uint8_t*     data          - allocated buffer
+    //     const size_t allocatedSize - size returned by Allocate
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CBufferProvider::Free( uint8_t* data, const size_t /*allocatedSize*/ )
+    {
+        delete[] data;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProvider
+    //
+    // Method:
+    //     GetDefault
+    //
+    // Description:
+    //     Returns the heap buffer provider.
+    //
+    // Output:
+    //     CBufferProvider& - heap buffer provider
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CBufferProvider& CBufferProvider::GetDefault()
+    {
+        static CBufferProvider provider;
+        return provider;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     CStreamBuffer constructor
+    //
+    // Description:
+    //     Constructor. Nothing is allocated until the first Reserve or Resize.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CStreamBuffer::CStreamBuffer()
+        : m_provider( &CBufferProvider::GetDefault() )
+        , m_data( nullptr )
+        , m_size( 0 )
+        , m_capacity( 0 )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     ~CStreamBuffer
+    //
+    // Description:
+    //     Destructor. The provider has to outlive the buffer.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CStreamBuffer::~CStreamBuffer()
+    {
+        Release();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     SetProvider
+    //
+    // Description:
+    //     Sets the provider of the next allocations. The current allocation is
+    //     released if the provider changes.
+    //
+    // Input:
+    //     CBufferProvider* provider - buffer provider, nullptr means heap
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CStreamBuffer::SetProvider( CBufferProvider* provider )
+    {
+        if( provider == nullptr )
+        {
+            provider = &CBufferProvider::GetDefault();
+        }
+
+        if( provider != m_provider )
+        {
+            Release();
+            m_provider = provider;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     Reserve
+    //
+    // Description:
+    //     Makes sure at least the given size is allocated. Content is kept.
+    //
+    // Input:
+    //     const size_t size - required capacity in bytes
+    //
+    // Output:
+    //     TCompletionCode   - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CStreamBuffer::Reserve( const size_t size )
+    {
+        if( size <= m_capacity )
+        {
+            return CC_OK;
+        }
+
+        size_t   capacity = 0;
+        uint8_t* data     = m_provider->Allocate( size, capacity );
+        if( data == nullptr )
+        {
+            return CC_ERROR_NO_MEMORY;
+        }
+
+        if( m_size )
+        {
+            iu_memcpy_s( data, capacity, m_data, m_size );
+        }
+
+        if( m_data )
+        {
+            m_provider->Free( m_data, m_capacity );
+        }
+
+        m_data     = data;
+        m_capacity = capacity;
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     Resize
+    //
+    // Description:
+    //     Changes the buffer size. Content is kept, added bytes are not initialized.
+    //
+    // Input:
+    //     const size_t size - new size in bytes
+    //
+    // Output:
+    //     TCompletionCode   - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CStreamBuffer::Resize( const size_t size )
+    {
+        TCompletionCode ret = Reserve( size );
+        if( ret == CC_OK )
+        {
+            m_size = size;
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     Release
+    //
+    // Description:
+    //     Frees the allocation.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CStreamBuffer::Release()
+    {
+        if( m_data )
+        {
+            m_provider->Free( m_data, m_capacity );
+        }
+
+        m_data     = nullptr;
+        m_size     = 0;
+        m_capacity = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     GetData
+    //
+    // Description:
+    //     Returns the buffer, nullptr if nothing is allocated.
+    //
+    // Output:
+    //     uint8_t* - buffer
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint8_t* CStreamBuffer::GetData()
+    {
+        return m_data;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     GetSize
+    //
+    // Description:
+    //     Returns the buffer size.
+    //
+    // Output:
+    //     size_t - size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    size_t CStreamBuffer::GetSize() const
+    {
+        return m_size;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     GetCapacity
+    //
+    // Description:
+    //     Returns the allocated size.
+    //
+    // Output:
+    //     size_t - allocated size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    size_t CStreamBuffer::GetCapacity() const
+    {
+        return m_capacity;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CStreamBuffer
+    //
+    // Method:
+    //     IsEmpty
+    //
+    // Description:
+    //     Returns whether the buffer size is zero.
+    //
+    // Output:
+    //     bool - *true* if empty
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CStreamBuffer::IsEmpty() const
+    {
+        return m_size == 0;
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,824 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_time_series.cpp
+
+//     Abstract:   C++ Metrics Discovery internal compressed time series implementation
+
+#include "md_time_series.h"
+
+#include "md_utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define MD_TIME_SERIES_FLOAT_BITS         32
+#define MD_TIME_SERIES_LEADING_NONE       0xFFFFFFFF
+#define MD_TIME_SERIES_DEFAULT_BLOCK_ROWS 1024
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery Time Series
+    //
+    // Function:
+    //     ZigZagEncode / ZigZagDecode
+    //
+    // Description:
+    //     Maps signed deltas to unsigned values, so small negative deltas are
+    //     encoded with a few bits as well.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint64_t ZigZagEncode( const int64_t value )
+    {
+        return ( static_cast<uint64_t>( value ) << 1 ) ^ static_cast<uint64_t>( value >> 63 );
+    }
+
+    static inline int64_t ZigZagDecode( const uint64_t value )
+    {
+        return static_cast<int64_t>( value >> 1 ) ^ -static_cast<int64_t>( value & 1 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery Time Series
+    //
+    // Function:
+    //     CountLeadingZeros / CountTrailingZeros
+    //
+    // Description:
+    //     Leading / trailing zero bits of a non zero 32 bit value.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint32_t CountLeadingZeros( const uint32_t value )
+    {
+        uint32_t count = 0;
+        for( uint32_t mask = 0x80000000; mask && !( value & mask ); mask >>= 1 )
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    static inline uint32_t CountTrailingZeros( const uint32_t value )
+    {
+        uint32_t count = 0;
+        for( uint32_t mask = 1; mask && !( value & mask ); mask <<= 1 )
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     CTimeSeries constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     const uint32_t adapterId     - adapter id
+    //     const uint32_t columnCount   - values in each row (metrics and information count)
+    //     const uint32_t blockRowCount - rows in a single block, 0 means default
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CTimeSeries::CTimeSeries( const uint32_t adapterId, const uint32_t columnCount, const uint32_t blockRowCount )
+        : m_adapterId( adapterId )
+        , m_columnCount( columnCount )
+        , m_blockRowCount( blockRowCount ? blockRowCount : MD_TIME_SERIES_DEFAULT_BLOCK_ROWS )
+        , m_data()
+        , m_bitCount( 0 )
+        , m_blocks()
+        , m_columns( columnCount )
+        , m_rowCount( 0 )
+        , m_prevTimestamp( 0 )
+        , m_prevTimestampDelta( 0 )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     ~CTimeSeries
+    //
+    // Description:
+    //     Destructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CTimeSeries::~CTimeSeries()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     GetColumnCount
+    //
+    // Description:
+    //     Returns number of values in each row.
+    //
+    // Output:
+    //     uint32_t - column count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CTimeSeries::GetColumnCount( void )
+    {
+        return m_columnCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     GetRowCount
+    //
+    // Description:
+    //     Returns number of rows encoded in all the blocks.
+    //
+    // Output:
+    //     uint32_t - row count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CTimeSeries::GetRowCount( void )
+    {
+        return m_rowCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     GetBlockCount
+    //
+    // Description:
+    //     Returns number of blocks, including the one currently being filled.
+    //
+    // Output:
+    //     uint32_t - block count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CTimeSeries::GetBlockCount( void )
+    {
+        return static_cast<uint32_t>( m_blocks.size() );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     GetEncodedSize
+    //
+    // Description:
+    //     Returns size of the encoded data in bytes.
+    //
+    // Output:
+    //     uint64_t - encoded data size
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CTimeSeries::GetEncodedSize( void )
+    {
+        return m_data.size();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     GetBlockInfo
+    //
+    // Description:
+    //     Returns block index entry.
+    //
+    // Input:
+    //     uint32_t index - block index
+    //
+    // Output:
+    //     const TTimeSeriesBlockInfo* - block information, nullptr if index is out of range
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const TTimeSeriesBlockInfo* CTimeSeries::GetBlockInfo( uint32_t index )
+    {
+        return ( index < m_blocks.size() ) ? &m_blocks[index] : nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     FindBlock
+    //
+    // Description:
+    //     Finds the block which contains rows for the given timestamp, i.e. the last
+    //     block starting not later than the timestamp.
+    //
+    // Input:
+    //     uint64_t  timestamp - timestamp in ns
+    //     uint32_t* outIndex  - (OUT) block index
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CTimeSeries::FindBlock( uint64_t timestamp, uint32_t* outIndex )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, outIndex, CC_ERROR_INVALID_PARAMETER );
+
+        auto block = std::upper_bound( m_blocks.begin(), m_blocks.end(), timestamp, []( const uint64_t value, const TTimeSeriesBlockInfo& block )
+            { return value < block.FirstTimestamp; } );
+
+        if( block == m_blocks.begin() )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "no block for timestamp: %llu", static_cast<unsigned long long>( timestamp ) );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        *outIndex = static_cast<uint32_t>( std::distance( m_blocks.begin(), block ) - 1 );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     DecodeBlock
+    //
+    // Description:
+    //     Decodes all the rows stored in a single block.
+    //
+    // Input:
+    //     uint32_t         index              - block index
+    //     TTypedValue_1_0* out                - (OUT) decoded rows, RowCount * ColumnCount values
+    //     uint32_t         outSize            - size of the out buffer in bytes
+    //     uint64_t*        outTimestamps      - (OUT - optional) decoded row timestamps
+    //     uint32_t         outTimestampsCount - count of entries in outTimestamps
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CTimeSeries::DecodeBlock( uint32_t index, TTypedValue_1_0* out, uint32_t outSize, uint64_t* outTimestamps, uint32_t outTimestampsCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, out, CC_ERROR_INVALID_PARAMETER );
+
+        if( index >= m_blocks.size() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: invalid block index: %u", index );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        const TTimeSeriesBlockInfo& block = m_blocks[index];
+
+        if( outSize < static_cast<uint64_t>( block.RowCount ) * m_columnCount * sizeof( TTypedValue_1_0 ) )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: output buffer to small" );
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "rowCount: %u, columnCount: %u, outSize: %u", block.RowCount, m_columnCount, outSize );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+        if( outTimestamps && outTimestampsCount < block.RowCount )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: timestamps buffer to small" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        const uint8_t*                      data        = m_data.data() + block.Offset;
+        uint64_t                            bitPosition = 0;
+        uint64_t                            timestamp   = 0;
+        int64_t                             delta       = 0;
+        std::vector<TTimeSeriesColumnState> columns( m_columns );
+
+        for( uint32_t row = 0; row < block.RowCount; ++row )
+        {
+            // Timestamp
+            if( row == 0 )
+            {
+                timestamp = ReadBits( data, bitPosition, 64 );
+            }
+            else
+            {
+                delta = ( row == 1 )
+                    ? ZigZagDecode( ReadVarInt( data, bitPosition ) )
+                    : delta + ZigZagDecode( ReadVarInt( data, bitPosition ) );
+                timestamp += delta;
+            }
+
+            if( outTimestamps )
+            {
+                outTimestamps[row] = timestamp;
+            }
+
+            // Values
+            for( uint32_t i = 0; i < m_columnCount; ++i )
+            {
+                TTimeSeriesColumnState& state = columns[i];
+                TTypedValue_1_0&        value = out[row * m_columnCount + i];
+
+                value.ValueType = state.ValueType;
+
+                switch( state.ValueType )
+                {
+                    case VALUE_TYPE_BOOL:
+                        value.ValueBool = ReadBits( data, bitPosition, 1 ) != 0;
+                        break;
+
+                    case VALUE_TYPE_FLOAT:
+                    {
+                        const uint32_t bits = ( row == 0 )
+                            ? static_cast<uint32_t>( ReadBits( data, bitPosition, MD_TIME_SERIES_FLOAT_BITS ) )
+                            : DecodeFloat( data, bitPosition, state );
+
+                        if( row == 0 )
+                        {
+                            state.PrevLeading = MD_TIME_SERIES_LEADING_NONE;
+                        }
+                        state.PrevValue = bits;
+                        iu_memcpy_s( &value.ValueFloat, sizeof( value.ValueFloat ), &bits, sizeof( bits ) );
+                        break;
+                    }
+
+                    case VALUE_TYPE_UINT32:
+                    case VALUE_TYPE_UINT64:
+                    default:
+                        state.PrevValue = ( row == 0 )
+                            ? ReadBits( data, bitPosition, 64 )
+                            : state.PrevValue + static_cast<uint64_t>( ZigZagDecode( ReadVarInt( data, bitPosition ) ) );
+
+                        if( state.ValueType == VALUE_TYPE_UINT32 )
+                        {
+                            value.ValueUInt32 = static_cast<uint32_t>( state.PrevValue );
+                        }
+                        else
+                        {
+                            value.ValueUInt64 = state.PrevValue;
+                        }
+                        break;
+                }
+            }
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     Clear
+    //
+    // Description:
+    //     Removes all the encoded rows and releases the memory.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CTimeSeries::Clear( void )
+    {
+        std::vector<uint8_t>().swap( m_data );
+        std::vector<TTimeSeriesBlockInfo>().swap( m_blocks );
+
+        m_bitCount           = 0;
+        m_rowCount           = 0;
+        m_prevTimestamp      = 0;
+        m_prevTimestampDelta = 0;
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     AppendRow
+    //
+    // Description:
+    //     Encodes a single calculated report. Value types of the first row determine
+    //     column types of the whole series.
+    //
+    // Input:
+    //     const TTypedValue_1_0* row       - ColumnCount values
+    //     const uint64_t         timestamp - row timestamp in ns
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CTimeSeries::AppendRow( const TTypedValue_1_0* row, const uint64_t timestamp )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, row, CC_ERROR_INVALID_PARAMETER );
+
+        for( uint32_t i = 0; i < m_columnCount; ++i )
+        {
+            const bool isTypeSupported = row[i].ValueType == VALUE_TYPE_UINT32 ||
+                row[i].ValueType == VALUE_TYPE_UINT64 ||
+                row[i].ValueType == VALUE_TYPE_FLOAT ||
+                row[i].ValueType == VALUE_TYPE_BOOL;
+
+            if( !isTypeSupported || ( m_rowCount && row[i].ValueType != m_columns[i].ValueType ) )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: unexpected value type: %u, column: %u", row[i].ValueType, i );
+                return CC_ERROR_INVALID_PARAMETER;
+            }
+        }
+
+        if( m_blocks.empty() || m_blocks.back().RowCount == m_blockRowCount )
+        {
+            StartBlock( row, timestamp );
+        }
+        else
+        {
+            // Timestamp
+            const int64_t delta = static_cast<int64_t>( timestamp - m_prevTimestamp );
+
+            WriteVarInt( ZigZagEncode( ( m_blocks.back().RowCount == 1 ) ? delta : delta - m_prevTimestampDelta ) );
+
+            m_prevTimestamp      = timestamp;
+            m_prevTimestampDelta = delta;
+
+            // Values
+            for( uint32_t i = 0; i < m_columnCount; ++i )
+            {
+                TTimeSeriesColumnState& state = m_columns[i];
+
+                switch( state.ValueType )
+                {
+                    case VALUE_TYPE_BOOL:
+                        WriteBits( row[i].ValueBool ? 1 : 0, 1 );
+                        break;
+
+                    case VALUE_TYPE_FLOAT:
+                    {
+                        uint32_t bits = 0;
+                        iu_memcpy_s( &bits, sizeof( bits ), &row[i].ValueFloat, sizeof( row[i].ValueFloat ) );
+                        EncodeFloat( state, bits );
+                        break;
+                    }
+
+                    case VALUE_TYPE_UINT32:
+                    case VALUE_TYPE_UINT64:
+                    default:
+                    {
+                        const uint64_t value = ( state.ValueType == VALUE_TYPE_UINT32 ) ? row[i].ValueUInt32 : row[i].ValueUInt64;
+
+                        WriteVarInt( ZigZagEncode( static_cast<int64_t>( value - state.PrevValue ) ) );
+                        state.PrevValue = value;
+                        break;
+                    }
+                }
+            }
+        }
+
+        TTimeSeriesBlockInfo& block = m_blocks.back();
+
+        block.RowCount++;
+        block.LastTimestamp = timestamp;
+        block.Size          = static_cast<uint64_t>( m_data.size() ) - block.Offset;
+
+        m_rowCount++;
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     StartBlock
+    //
+    // Description:
+    //     Starts a new byte aligned block and stores the given row uncompressed,
+    //     as a base for the following rows.
+    //
+    // Input:
+    //     const TTypedValue_1_0* row       - first row in the block
+    //     const uint64_t         timestamp - first row timestamp in ns
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimeSeries::StartBlock( const TTypedValue_1_0* row, const uint64_t timestamp )
+    {
+        TTimeSeriesBlockInfo block = {};
+
+        m_bitCount = static_cast<uint64_t>( m_data.size() ) * MD_BITS_PER_BYTE;
+
+        block.FirstTimestamp = timestamp;
+        block.LastTimestamp  = timestamp;
+        block.Offset         = static_cast<uint64_t>( m_data.size() );
+        m_blocks.push_back( block );
+
+        WriteBits( timestamp, 64 );
+
+        m_prevTimestamp      = timestamp;
+        m_prevTimestampDelta = 0;
+
+        for( uint32_t i = 0; i < m_columnCount; ++i )
+        {
+            TTimeSeriesColumnState& state = m_columns[i];
+
+            state.ValueType = static_cast<TValueType>( row[i].ValueType );
+
+            switch( state.ValueType )
+            {
+                case VALUE_TYPE_BOOL:
+                    WriteBits( row[i].ValueBool ? 1 : 0, 1 );
+                    break;
+
+                case VALUE_TYPE_FLOAT:
+                {
+                    uint32_t bits = 0;
+                    iu_memcpy_s( &bits, sizeof( bits ), &row[i].ValueFloat, sizeof( row[i].ValueFloat ) );
+                    WriteBits( bits, MD_TIME_SERIES_FLOAT_BITS );
+
+                    state.PrevValue   = bits;
+                    state.PrevLeading = MD_TIME_SERIES_LEADING_NONE;
+                    break;
+                }
+
+                case VALUE_TYPE_UINT32:
+                case VALUE_TYPE_UINT64:
+                default:
+                    state.PrevValue = ( state.ValueType == VALUE_TYPE_UINT32 ) ? row[i].ValueUInt32 : row[i].ValueUInt64;
+                    WriteBits( state.PrevValue, 64 );
+                    break;
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     EncodeFloat
+    //
+    // Description:
+    //     Encodes xor of the float with the previous one in the column:
+    //         '0'                                      - the same value
+    //         '10' + meaningful bits                   - fits into the previous leading / trailing zeros window
+    //         '11' + leading(5) + length-1(5) + bits   - new window
+    //
+    // Input:
+    //     TTimeSeriesColumnState& state - (IN/OUT) column state
+    //     const uint32_t          bits  - float value bits
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimeSeries::EncodeFloat( TTimeSeriesColumnState& state, const uint32_t bits )
+    {
+        const uint32_t xorValue = bits ^ static_cast<uint32_t>( state.PrevValue );
+
+        state.PrevValue = bits;
+
+        if( xorValue == 0 )
+        {
+            WriteBits( 0, 1 );
+            return;
+        }
+
+        const uint32_t leading  = std::min<uint32_t>( CountLeadingZeros( xorValue ), 31 );
+        const uint32_t trailing = CountTrailingZeros( xorValue );
+
+        if( state.PrevLeading != MD_TIME_SERIES_LEADING_NONE && leading >= state.PrevLeading && trailing >= state.PrevTrailing )
+        {
+            WriteBits( 0x2, 2 );
+            WriteBits( xorValue >> state.PrevTrailing, MD_TIME_SERIES_FLOAT_BITS - state.PrevLeading - state.PrevTrailing );
+            return;
+        }
+
+        const uint32_t length = MD_TIME_SERIES_FLOAT_BITS - leading - trailing;
+
+        WriteBits( 0x3, 2 );
+        WriteBits( leading, 5 );
+        WriteBits( length - 1, 5 );
+        WriteBits( xorValue >> trailing, length );
+
+        state.PrevLeading  = leading;
+        state.PrevTrailing = trailing;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     DecodeFloat
+    //
+    // Description:
+    //     Decodes float bits encoded with EncodeFloat.
+    //
+    // Input:
+    //     const uint8_t*          data        - block data
+    //     uint64_t&               bitPosition - (IN/OUT) read position in bits
+    //     TTimeSeriesColumnState& state       - (IN/OUT) column state
+    //
+    // Output:
+    //     uint32_t - float value bits
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CTimeSeries::DecodeFloat( const uint8_t* data, uint64_t& bitPosition, TTimeSeriesColumnState& state )
+    {
+        const uint32_t prev = static_cast<uint32_t>( state.PrevValue );
+
+        if( ReadBits( data, bitPosition, 1 ) == 0 )
+        {
+            return prev;
+        }
+
+        if( ReadBits( data, bitPosition, 1 ) == 1 )
+        {
+            const uint32_t leading = static_cast<uint32_t>( ReadBits( data, bitPosition, 5 ) );
+            const uint32_t length  = static_cast<uint32_t>( ReadBits( data, bitPosition, 5 ) ) + 1;
+
+            state.PrevLeading  = leading;
+            state.PrevTrailing = MD_TIME_SERIES_FLOAT_BITS - leading - length;
+        }
+
+        const uint32_t length   = MD_TIME_SERIES_FLOAT_BITS - state.PrevLeading - state.PrevTrailing;
+        const uint32_t xorValue = static_cast<uint32_t>( ReadBits( data, bitPosition, length ) << state.PrevTrailing );
+
+        return prev ^ xorValue;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     WriteBits
+    //
+    // Description:
+    //     Appends the lowest bitCount bits of the value, most significant bit first.
+    //
+    // Input:
+    //     const uint64_t value    - value to write
+    //     const uint32_t bitCount - number of bits to write, up to 64
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimeSeries::WriteBits( const uint64_t value, const uint32_t bitCount )
+    {
+        uint32_t remaining = bitCount;
+
+        while( remaining )
+        {
+            const uint32_t usedBits = static_cast<uint32_t>( m_bitCount % MD_BITS_PER_BYTE );
+            const uint32_t freeBits = MD_BITS_PER_BYTE - usedBits;
+            const uint32_t count    = std::min( freeBits, remaining );
+            const uint64_t bits     = ( value >> ( remaining - count ) ) & MD_BITMASK( count );
+
+            if( usedBits == 0 )
+            {
+                m_data.push_back( 0 );
+            }
+
+            m_data.back() |= static_cast<uint8_t>( bits << ( freeBits - count ) );
+
+            m_bitCount += count;
+            remaining -= count;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     WriteVarInt
+    //
+    // Description:
+    //     Appends value as varint, 7 bits per byte with the highest bit set
+    //     if more bytes follow.
+    //
+    // Input:
+    //     const uint64_t value - value to write
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimeSeries::WriteVarInt( const uint64_t value )
+    {
+        uint64_t remaining = value;
+
+        while( remaining >= 0x80 )
+        {
+            WriteBits( ( remaining & 0x7F ) | 0x80, MD_BITS_PER_BYTE );
+            remaining >>= 7;
+        }
+
+        WriteBits( remaining, MD_BITS_PER_BYTE );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     ReadBits
+    //
+    // Description:
+    //     Reads bitCount bits written with WriteBits.
+    //
+    // Input:
+    //     const uint8_t* data        - block data
+    //     uint64_t&      bitPosition - (IN/OUT) read position in bits
+    //     const uint32_t bitCount    - number of bits to read, up to 64
+    //
+    // Output:
+    //     uint64_t - read value
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CTimeSeries::ReadBits( const uint8_t* data, uint64_t& bitPosition, const uint32_t bitCount )
+    {
+        uint64_t value     = 0;
+        uint32_t remaining = bitCount;
+
+        while( remaining )
+        {
+            const uint32_t usedBits  = static_cast<uint32_t>( bitPosition % MD_BITS_PER_BYTE );
+            const uint32_t availBits = MD_BITS_PER_BYTE - usedBits;
+            const uint32_t count     = std::min( availBits, remaining );
+            const uint8_t  byte      = data[bitPosition / MD_BITS_PER_BYTE];
+
+            value = ( value << count ) | ( ( byte >> ( availBits - count ) ) & MD_BITMASK( count ) );
+
+            bitPosition += count;
+            remaining -= count;
+        }
+
+        return value;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimeSeries
+    //
+    // Method:
+    //     ReadVarInt
+    //
+    // Description:
+    //     Reads value written with WriteVarInt.
+    //
+    // Input:
+    //     const uint8_t* data        - block data
+    //     uint64_t&      bitPosition - (IN/OUT) read position in bits
+    //
+    // Output:
+    //     uint64_t - read value
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CTimeSeries::ReadVarInt( const uint8_t* data, uint64_t& bitPosition )
+    {
+        uint64_t value = 0;
+
+        for( uint32_t shift = 0; shift < 64; shift += 7 )
+        {
+            const uint64_t byte = ReadBits( data, bitPosition, MD_BITS_PER_BYTE );
+
+            value |= ( byte & 0x7F ) << shift;
+
+            if( ( byte & 0x80 ) == 0 )
+            {
+                break;
+            }
+        }
+
+        return value;
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,431 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_timestamp_correlation.cpp
+
+//     Abstract:   C++ Metrics Discovery internal GPU to CPU timestamp correlation implementation
+
+#include "md_timestamp_correlation.h"
+
+#include "md_utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     CTimestampCorrelation constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CTimestampCorrelation::CTimestampCorrelation()
+        : m_gpuTimestampFrequency( 0 )
+        , m_nominalNsPerTick( 0.0 )
+        , m_samples{}
+        , m_sampleCount( 0 )
+        , m_sampleIndex( 0 )
+        , m_lastSampleTime( 0 )
+        , m_nsPerTick( 0.0 )
+        , m_errorBoundNs( 0 )
+        , m_mutex()
+        , m_sequence( 0 )
+        , m_modelBaseTicks( 0 )
+        , m_modelBaseCpuNs( 0 )
+        , m_modelNsPerTick( 0.0 )
+        , m_modelErrorBoundNs( 0 )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     ~CTimestampCorrelation
+    //
+    // Description:
+    //     Destructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CTimestampCorrelation::~CTimestampCorrelation()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     SetFrequency
+    //
+    // Description:
+    //     Sets nominal GPU timestamp frequency. Drops samples and the model
+    //     if the frequency changes.
+    //
+    // Input:
+    //     const uint64_t gpuTimestampFrequency - GPU timestamp frequency in Hz
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimestampCorrelation::SetFrequency( const uint64_t gpuTimestampFrequency )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        if( gpuTimestampFrequency == m_gpuTimestampFrequency )
+        {
+            return;
+        }
+
+        m_gpuTimestampFrequency = gpuTimestampFrequency;
+        m_nominalNsPerTick      = gpuTimestampFrequency ? static_cast<double>( MD_SECOND_IN_NS ) / gpuTimestampFrequency : 0.0;
+        m_nsPerTick             = m_nominalNsPerTick;
+        m_sampleCount           = 0;
+        m_sampleIndex           = 0;
+        m_lastSampleTime        = 0;
+        m_errorBoundNs          = 0;
+
+        Publish( {} );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     GetFrequency
+    //
+    // Description:
+    //     Returns nominal GPU timestamp frequency.
+    //
+    // Output:
+    //     uint64_t - GPU timestamp frequency in Hz, 0 if not set
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CTimestampCorrelation::GetFrequency() const
+    {
+        return m_gpuTimestampFrequency;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     IsSampleNeeded
+    //
+    // Description:
+    //     Rate limits samples: returns true if there is no model yet or
+    //     the newest sample is older than the minimal interval.
+    //
+    // Input:
+    //     const uint64_t timeNs - current monotonic time
+    //
+    // Output:
+    //     bool                  - *true* if a new sample should be taken
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CTimestampCorrelation::IsSampleNeeded( const uint64_t timeNs ) const
+    {
+        return m_sampleCount == 0 || ( timeNs - m_lastSampleTime ) >= MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     AddSample
+    //
+    // Description:
+    //     Adds paired GPU / CPU timestamps and refits the model. GPU timestamp is
+    //     unwrapped against the GPU time predicted from the CPU time elapsed since
+    //     the newest sample. Samples older than the newest one are ignored.
+    //
+    // Input:
+    //     const uint64_t gpuTicks - GPU timestamp in ticks, only low 32 bits are used
+    //     const uint64_t cpuNs    - CPU timestamp in ns taken together with gpuTicks
+    //     const uint64_t timeNs   - current monotonic time, for rate limiting
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimestampCorrelation::AddSample( const uint64_t gpuTicks, const uint64_t cpuNs, const uint64_t timeNs )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        if( m_nominalNsPerTick == 0.0 )
+        {
+            return;
+        }
+
+        uint64_t unwrappedTicks = gpuTicks & MD_GPU_TIMESTAMP_MASK_32;
+
+        if( m_sampleCount )
+        {
+            const TTimestampCorrelationSample& newest = m_samples[( m_sampleIndex + MD_TIMESTAMP_CORRELATION_SAMPLES - 1 ) % MD_TIMESTAMP_CORRELATION_SAMPLES];
+
+            if( cpuNs <= newest.CpuNs )
+            {
+                return;
+            }
+
+            const uint64_t predictedTicks = newest.GpuTicks + static_cast<uint64_t>( std::llround( ( cpuNs - newest.CpuNs ) / m_nsPerTick ) );
+            const int32_t  correction     = static_cast<int32_t>( static_cast<uint32_t>( gpuTicks ) - static_cast<uint32_t>( predictedTicks ) );
+
+            unwrappedTicks = predictedTicks + correction;
+        }
+        else
+        {
+            // Keep unwrapped timestamps far from zero, so corrections never underflow
+            unwrappedTicks += 1ULL << 32;
+        }
+
+        m_samples[m_sampleIndex] = { unwrappedTicks, cpuNs };
+        m_sampleIndex            = ( m_sampleIndex + 1 ) % MD_TIMESTAMP_CORRELATION_SAMPLES;
+        m_sampleCount            = std::min<uint32_t>( m_sampleCount + 1, MD_TIMESTAMP_CORRELATION_SAMPLES );
+        m_lastSampleTime         = timeNs;
+
+        Fit();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     GetInfo
+    //
+    // Description:
+    //     Returns state of the model.
+    //
+    // Input:
+    //     TTimestampCorrelationInfo& info - (out) model state
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimestampCorrelation::GetInfo( TTimestampCorrelationInfo& info )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        info                 = {};
+        info.SampleCount     = m_sampleCount;
+        info.LastSampleCpuNs = m_sampleCount ? m_samples[( m_sampleIndex + MD_TIMESTAMP_CORRELATION_SAMPLES - 1 ) % MD_TIMESTAMP_CORRELATION_SAMPLES].CpuNs : 0;
+        info.NsPerGpuTick    = m_sampleCount ? m_nsPerTick : 0.0;
+        info.ErrorBoundNs    = m_errorBoundNs;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     GetModel
+    //
+    // Description:
+    //     Returns a consistent copy of the published model without locking.
+    //     Bulk conversions should get the model once and convert with it.
+    //
+    // Input:
+    //     TTimestampCorrelationModel& model - (out) model
+    //
+    // Output:
+    //     bool                              - *false* if there is no model yet
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CTimestampCorrelation::GetModel( TTimestampCorrelationModel& model ) const
+    {
+        uint32_t sequence = 0;
+
+        do
+        {
+            sequence = m_sequence.load( std::memory_order_acquire );
+            if( sequence & 1 )
+            {
+                continue;
+            }
+
+            model.BaseTicks    = m_modelBaseTicks.load( std::memory_order_relaxed );
+            model.BaseCpuNs    = m_modelBaseCpuNs.load( std::memory_order_relaxed );
+            model.NsPerTick    = m_modelNsPerTick.load( std::memory_order_relaxed );
+            model.ErrorBoundNs = m_modelErrorBoundNs.load( std::memory_order_relaxed );
+
+            std::atomic_thread_fence( std::memory_order_acquire );
+        } while( ( sequence & 1 ) || sequence != m_sequence.load( std::memory_order_relaxed ) );
+
+        return model.NsPerTick > 0.0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     GpuTicksToCpuNs
+    //
+    // Description:
+    //     Converts a GPU timestamp to CPU time with the published model.
+    //
+    // Input:
+    //     const uint64_t gpuTicks - GPU timestamp in ticks, only low 32 bits are used
+    //
+    // Output:
+    //     uint64_t                - CPU timestamp in ns, 0 if there is no model yet
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CTimestampCorrelation::GpuTicksToCpuNs( const uint64_t gpuTicks ) const
+    {
+        TTimestampCorrelationModel model = {};
+
+        return GetModel( model ) ? GpuTicksToCpuNs( model, gpuTicks ) : 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     GpuTicksToCpuNs
+    //
+    // Description:
+    //     Converts a GPU timestamp to CPU time with the given model. Timestamps
+    //     are taken as the nearest ones to the model base, so they may precede it.
+    //
+    // Input:
+    //     const TTimestampCorrelationModel& model    - model from GetModel
+    //     const uint64_t                    gpuTicks - GPU timestamp in ticks, only low 32 bits are used
+    //
+    // Output:
+    //     uint64_t                                   - CPU timestamp in ns
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CTimestampCorrelation::GpuTicksToCpuNs( const TTimestampCorrelationModel& model, const uint64_t gpuTicks )
+    {
+        const int32_t deltaTicks = static_cast<int32_t>( static_cast<uint32_t>( gpuTicks ) - model.BaseTicks );
+
+        return model.BaseCpuNs + static_cast<int64_t>( std::llround( deltaTicks * model.NsPerTick ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     Fit
+    //
+    // Description:
+    //     Fits CPU time as a linear function of unwrapped GPU ticks to the samples
+    //     with least squares, relative to the newest sample to keep precision.
+    //     Fitted periods further than the allowed drift from the nominal one,
+    //     e.g. from samples too close to each other, fall back to the nominal
+    //     period. Error bound is the largest sample residual.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimestampCorrelation::Fit()
+    {
+        const TTimestampCorrelationSample& newest = m_samples[( m_sampleIndex + MD_TIMESTAMP_CORRELATION_SAMPLES - 1 ) % MD_TIMESTAMP_CORRELATION_SAMPLES];
+
+        double meanX = 0.0;
+        double meanY = 0.0;
+
+        for( uint32_t i = 0; i < m_sampleCount; ++i )
+        {
+            meanX += static_cast<double>( static_cast<int64_t>( m_samples[i].GpuTicks - newest.GpuTicks ) );
+            meanY += static_cast<double>( static_cast<int64_t>( m_samples[i].CpuNs - newest.CpuNs ) );
+        }
+        meanX /= m_sampleCount;
+        meanY /= m_sampleCount;
+
+        double covariance = 0.0;
+        double variance   = 0.0;
+
+        for( uint32_t i = 0; i < m_sampleCount; ++i )
+        {
+            const double x = static_cast<double>( static_cast<int64_t>( m_samples[i].GpuTicks - newest.GpuTicks ) ) - meanX;
+            const double y = static_cast<double>( static_cast<int64_t>( m_samples[i].CpuNs - newest.CpuNs ) ) - meanY;
+
+            covariance += x * y;
+            variance += x * x;
+        }
+
+        const double maxDrift  = m_nominalNsPerTick * MD_TIMESTAMP_CORRELATION_MAX_DRIFT_PPM / 1000000.0;
+        double       nsPerTick = ( variance > 0.0 ) ? covariance / variance : m_nominalNsPerTick;
+
+        if( std::fabs( nsPerTick - m_nominalNsPerTick ) > maxDrift )
+        {
+            nsPerTick = m_nominalNsPerTick;
+        }
+
+        // Model value at the newest sample, relative to its CPU time
+        const double intercept = meanY - nsPerTick * meanX;
+        double       maxError  = 0.0;
+
+        for( uint32_t i = 0; i < m_sampleCount; ++i )
+        {
+            const double x = static_cast<double>( static_cast<int64_t>( m_samples[i].GpuTicks - newest.GpuTicks ) );
+            const double y = static_cast<double>( static_cast<int64_t>( m_samples[i].CpuNs - newest.CpuNs ) );
+
+            maxError = std::max( maxError, std::fabs( y - ( intercept + nsPerTick * x ) ) );
+        }
+
+        m_nsPerTick    = nsPerTick;
+        m_errorBoundNs = static_cast<uint64_t>( std::ceil( maxError ) );
+
+        TTimestampCorrelationModel model = {};
+        model.BaseTicks                  = static_cast<uint32_t>( newest.GpuTicks );
+        model.BaseCpuNs                  = newest.CpuNs + static_cast<int64_t>( std::llround( intercept ) );
+        model.NsPerTick                  = nsPerTick;
+        model.ErrorBoundNs               = m_errorBoundNs;
+
+        Publish( model );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTimestampCorrelation
+    //
+    // Method:
+    //     Publish
+    //
+    // Description:
+    //     Publishes the model for lock free readers. Must be called with
+    //     the mutex held, so there is a single writer.
+    //
+    // Input:
+    //     const TTimestampCorrelationModel& model - model to publish, zero period means no model
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CTimestampCorrelation::Publish( const TTimestampCorrelationModel& model )
+    {
+        const uint32_t sequence = m_sequence.load( std::memory_order_relaxed );
+
+        m_sequence.store( sequence + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        m_modelBaseTicks.store( model.BaseTicks, std::memory_order_relaxed );
+        m_modelBaseCpuNs.store( model.BaseCpuNs, std::memory_order_relaxed );
+        m_modelNsPerTick.store( model.NsPerTick, std::memory_order_relaxed );
+        m_modelErrorBoundNs.store( model.ErrorBoundNs, std::memory_order_relaxed );
+
+        m_sequence.store( sequence + 2, std::memory_order_release );
+    }
+} // namespace MetricsDiscoveryInternal
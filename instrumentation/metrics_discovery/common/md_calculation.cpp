@@ -17,6 +17,7 @@ SPDX-License-Identifier: MIT
 #include "md_metric.h"
 #include "md_metric_set.h"
 #include "md_metrics_device.h"
+#include "md_time_series.h"
 #include "md_types.h"
 #include <algorithm>
 #include <cstring>
@@ -26,6 +27,8 @@ namespace MetricsDiscoveryInternal
     // Forward declarations //
     template <>
     int32_t CMetricsCalculationManager<MEASUREMENT_TYPE_SNAPSHOT_IO>::GetInformationIndex( const char* symbolName, CMetricSet* metricSet );
+    template <>
+    void CMetricsCalculationManager<MEASUREMENT_TYPE_SNAPSHOT_IO>::CollapseIdleReports( TStreamCalculationContext& context );
 
     //////////////////////////////////////////////////////////////////////////////
     //
@@ -45,8 +48,9 @@ namespace MetricsDiscoveryInternal
     template <>
     void CMetricsCalculationManager<MEASUREMENT_TYPE_SNAPSHOT_IO>::ResetContext( TCalculationContext& context )
     {
-        context.StreamCalculationContext              = {};
-        context.StreamCalculationContext.ContextIdIdx = -1;
+        context.StreamCalculationContext                   = {};
+        context.StreamCalculationContext.ContextIdIdx      = -1;
+        context.StreamCalculationContext.QueryBeginTimeIdx = -1;
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -102,9 +106,11 @@ namespace MetricsDiscoveryInternal
         MD_CHECK_PTR_RET_A( adapterId, sc->Out, CC_ERROR_INVALID_PARAMETER );
         MD_CHECK_PTR_RET_A( adapterId, sc->DeltaValues, CC_ERROR_INVALID_PARAMETER );
 
-        // Find required indices for context filtering, report filtering and PreviousContextId information
-        sc->ContextIdIdx    = GetInformationIndex( "ContextId", sc->MetricSet );
-        sc->ReportReasonIdx = GetInformationIndex( "ReportReason", sc->MetricSet );
+        // Find required indices for context filtering, report filtering, PreviousContextId information
+        // and idle run time span
+        sc->ContextIdIdx      = GetInformationIndex( "ContextId", sc->MetricSet );
+        sc->ReportReasonIdx   = GetInformationIndex( "ReportReason", sc->MetricSet );
+        sc->QueryBeginTimeIdx = GetInformationIndex( "QueryBeginTime", sc->MetricSet );
 
         if( sc->DoContextFiltering )
         {
@@ -118,8 +124,11 @@ namespace MetricsDiscoveryInternal
 
         sc->MetricsAndInformationCount = sc->MetricSet->GetParams()->MetricsCount + sc->MetricSet->GetParams()->InformationCount;
         sc->RawReportSize              = sc->MetricSet->GetParams()->RawReportSize;
+        sc->RawReportStride            = sc->RawReportSize;
+        sc->ReportType                 = sc->MetricSet->GetReportType();
 
         sc->OutReportCount      = 0;
+        sc->OutTimeSeriesResult = CC_OK;
         sc->OutPtr              = sc->Out;
         sc->OutMaxValuesPtr     = sc->OutMaxValues;
         sc->PrevRawDataPtr      = sc->RawData;
@@ -236,10 +245,16 @@ namespace MetricsDiscoveryInternal
         // If not using saved report
         if( sc->PrevRawReportNumber != MD_SAVED_REPORT_NUMBER )
         {
-            sc->LastRawDataPtr      = sc->PrevRawDataPtr + sc->RawReportSize;
+            sc->LastRawDataPtr      = sc->PrevRawDataPtr + sc->RawReportStride;
             sc->LastRawReportNumber = sc->PrevRawReportNumber + 1;
         }
 
+        // IDLE COLLAPSING
+        if( sc->DoIdleCollapsing )
+        {
+            CollapseIdleReports( *sc );
+        }
+
         // METRICS
         sc->Calculator->ReadMetricsFromIoReport( sc->LastRawDataPtr, sc->PrevRawDataPtr, sc->DeltaValues, *sc->MetricSet );
         // NORMALIZATION
@@ -253,7 +268,24 @@ namespace MetricsDiscoveryInternal
             sc->OutMaxValuesPtr += sc->MetricSet->GetParams()->MetricsCount;
         }
 
-        sc->OutPtr += sc->MetricsAndInformationCount;
+        if( sc->OutTimeSeries )
+        {
+            // Out holds a single report which is encoded right away
+            const uint64_t timestamp = ( sc->QueryBeginTimeIdx >= 0 )
+                ? sc->OutPtr[sc->MetricSet->GetParams()->MetricsCount + sc->QueryBeginTimeIdx].ValueUInt64
+                : 0;
+
+            sc->OutTimeSeriesResult = sc->OutTimeSeries->AppendRow( sc->OutPtr, timestamp );
+            if( sc->OutTimeSeriesResult != CC_OK )
+            {
+                MD_LOG_A( adapterId, LOG_ERROR, "error: unable to encode calculated report" );
+                return false;
+            }
+        }
+        else
+        {
+            sc->OutPtr += sc->MetricsAndInformationCount;
+        }
         sc->OutReportCount++;
 
         // Prev is now Last
@@ -378,4 +410,50 @@ namespace MetricsDiscoveryInternal
         MD_LOG_A( adapterId, LOG_DEBUG, "can't find information index: %s", symbolName );
         return -1;
     }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CMetricsCalculationManager<MEASUREMENT_TYPE_SNAPSHOT_IO>
+    //
+    // Method:
+    //     CollapseIdleReports
+    //
+    // Description:
+    //     Moves 'Last' raw report forward over a run of reports without any activity
+    //     since 'Prev' report, so the whole run is calculated as a single output report.
+    //     All its metric deltas are zero except GpuTime, which covers the whole run.
+    //     Fills idle run information for the output report if requested.
+    //
+    // Input:
+    //     TStreamCalculationContext& context - (IN/OUT) stream calculation context
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    template <>
+    void CMetricsCalculationManager<MEASUREMENT_TYPE_SNAPSHOT_IO>::CollapseIdleReports( TStreamCalculationContext& context )
+    {
+        auto calculator = context.Calculator;
+
+        if( calculator->IsIdleReport( context.LastRawDataPtr, context.PrevRawDataPtr, context.RawReportSize, context.ReportType ) )
+        {
+            // All reports in the run are equal, so each next one may be compared with 'Prev'
+            while( context.LastRawReportNumber + 1 < context.RawReportCount &&
+                   calculator->IsIdleReport( context.LastRawDataPtr + context.RawReportStride, context.PrevRawDataPtr, context.RawReportSize, context.ReportType ) )
+            {
+                context.LastRawDataPtr += context.RawReportStride;
+                context.LastRawReportNumber++;
+            }
+        }
+
+        if( context.OutIdleRunInfo )
+        {
+            TIdleRunInfo& idleRunInfo = context.OutIdleRunInfo[context.OutReportCount];
+
+            idleRunInfo.RawReportCount = ( context.PrevRawReportNumber == MD_SAVED_REPORT_NUMBER )
+                ? context.LastRawReportNumber + 1
+                : context.LastRawReportNumber - context.PrevRawReportNumber;
+            idleRunInfo.BeginTimestamp = calculator->ReadInformationByIndex( context.PrevRawDataPtr, *context.MetricSet, context.QueryBeginTimeIdx );
+            idleRunInfo.EndTimestamp   = calculator->ReadInformationByIndex( context.LastRawDataPtr, *context.MetricSet, context.QueryBeginTimeIdx );
+        }
+    }
 } // namespace MetricsDiscoveryInternal
@@ -16,10 +16,13 @@ SPDX-License-Identifier: MIT
 #include "md_driver_ifc.h"
 #include "md_equation.h"
 #include "md_information.h"
+#include "md_io_stream_capture.h"
 #include "md_metric.h"
 #include "md_metric_set.h"
 #include "md_register_set.h"
+#include "md_time_series.h"
 
+#include <chrono>
 #include <cmath>
 #include <cstring>
 #include <cstdlib>
@@ -319,6 +322,27 @@ namespace MetricsDiscoveryInternal
         return lSize;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Metrics Discovery Utils
+    //
+    // Function:
+    //     GetTimeNs
+    //
+    // Description:
+    //     Returns monotonic time in nanoseconds (CLOCK_MONOTONIC on Linux), the clock
+    //     of the CPU timestamps GPU timestamps are correlated with.
+    //
+    // Output:
+    //     uint64_t - time in nanoseconds
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t GetTimeNs()
+    {
+        return static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Group:
@@ -1350,6 +1374,11 @@ namespace MetricsDiscoveryInternal
     template void ClearVector( std::vector<CEquationElementInternal>& );
     template void ClearVector( std::vector<SGlobalSymbol*>& );
     template void ClearVector( std::vector<IOverride_1_2*>& );
+    template void ClearVector( std::vector<CTimeSeries*>& );
+    template void ClearVector( std::vector<IInternalIoStreamGroup*>& );
+    template void ClearVector( std::vector<CIoStreamCaptureFile*>& );
+    template void ClearVector( std::vector<IInternalIoStreamMerger*>& );
+    template void ClearVector( std::vector<IInternalSideBandSampler*>& );
     template void ClearList( std::list<uint64_t>& );
     template void ClearList( std::list<CRegisterSet*>& );
     template void ClearList( std::list<CMetricSet*>& );
@@ -0,0 +1,79 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_buffer_provider_linux.h
+//
+//     Abstract:   C++ huge page and NUMA aware stream buffer provider for Linux
+
+#pragma once
+
+#include "md_stream_buffer.h"
+
+#include <sched.h> // cpu_set_t
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defines used by the stream buffer provider.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_HUGE_PAGE_SIZE             ( 2 * MD_MBYTE )  // Huge page size on x86-64
+#define MD_HUGE_PAGE_MIN_BUFFER_SIZE  MD_MBYTE          // Smaller buffers use regular pages
+#define MD_NUMA_NODE_MASK_SIZE        16                // Node mask words, up to 1024 NUMA nodes
+#define MD_STREAM_BUFFER_PREALLOCATED MD_HUGE_PAGE_SIZE // Stream buffer allocated and prefaulted on stream open
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Description:
+    //     Allocates stream buffers with mmap. Buffers of at least 1 MB are rounded
+    //     up to 2 MB and backed by hugetlbfs pages if the pool has free pages,
+    //     otherwise by 2 MB aligned memory advised for transparent huge pages.
+    //     Memory is bound (preferred policy) to the NUMA node of the device PCI
+    //     bus, read from SysFs, and prefaulted, so stream reads do not page
+    //     fault. CPUs local to the device are kept for reader thread affinity.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CBufferProviderLinux : public CBufferProvider
+    {
+    public:
+        // Constructor & Destructor:
+        CBufferProviderLinux();
+        virtual ~CBufferProviderLinux();
+
+        CBufferProviderLinux( const CBufferProviderLinux& )            = delete; // Delete copy-constructor
+        CBufferProviderLinux& operator=( const CBufferProviderLinux& ) = delete; // Delete assignment operator
+
+        // CBufferProvider:
+        virtual uint8_t* Allocate( const size_t size, size_t& allocatedSize );
+        virtual void     Free( uint8_t* data, const size_t allocatedSize );
+
+        // Non-API:
+        void    Initialize( const uint32_t adapterId, const int32_t drmCardNumber );
+        int32_t GetNumaNode() const;
+        bool    GetLocalCpus( cpu_set_t& cpuSet ) const;
+
+    private:
+        uint8_t* MapHugePages( const size_t size );
+        void     BindToNumaNode( uint8_t* data, const size_t size );
+        void     Prefault( uint8_t* data, const size_t size );
+        bool     ReadCpuList( const char* filePath );
+
+    private:
+        // Variables:
+        uint32_t  m_adapterId;
+        int32_t   m_numaNode; // -1 if unknown or the platform is not NUMA
+        cpu_set_t m_localCpus;
+        bool      m_localCpusValid;
+        size_t    m_pageSize;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -13,9 +13,13 @@ SPDX-License-Identifier: MIT
 #pragma once
 
 #include "md_driver_ifc.h"
+#include "md_buffer_provider_linux.h"
+#include "md_oa_config_cache_linux.h"
+#include "md_sysfs_cache_linux.h"
 
 #include <mutex>
 #include <chrono>
+#include <map>
 #include <vector> // for Query
 #include <condition_variable>
 
@@ -95,13 +99,45 @@ SPDX-License-Identifier: MIT
 //     Oa buffer min/max size value
 //
 //////////////////////////////////////////////////////////////////////////////
-// Oa buffer min/max size is equal to 16 MB
-#define MD_OA_BUFFER_SIZE_MAX ( 16 * MD_MBYTE )
+// Oa buffer min/max size is equal to 16 MB, unless the kernel supports setting the size
+#define MD_OA_BUFFER_SIZE_MAX      ( 16 * MD_MBYTE )
+#define MD_OA_BUFFER_SIZE_MIN      ( 128 * MD_KBYTE ) // Smallest size supported by PRELIM_DRM_I915_PERF_PROP_OA_BUFFER_SIZE
+#define MD_OA_BUFFER_SIZE_MAX_XEHP ( 128 * MD_MBYTE ) // Largest size supported since XeHP SDV
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Automatic oa buffer size parameters
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_OA_BUFFER_DRAIN_INTERVAL_DEFAULT_MS 100 // Expected time between reads if not given
+#define MD_OA_BUFFER_DRAIN_INTERVALS           2   // Drain intervals of reports the oa buffer holds
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Oa buffer poll period limits
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_OA_POLL_PERIOD_MIN_NS          100000 // 100 us, kernel rejects shorter poll periods
+#define MD_OA_POLL_MAX_LATENCY_DEFAULT_MS 100    // Automatic poll period latency target, 20x the kernel default period
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Oa buffer drain before the stream is paused
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_OA_PAUSE_DRAIN_REPORTS  1024                       // Reports read at once
+#define MD_OA_PAUSE_DRAIN_SIZE_MAX MD_OA_BUFFER_SIZE_MAX_XEHP // Stops a drain not keeping up with sampling
 
 using namespace MetricsDiscovery;
 
 namespace MetricsDiscoveryInternal
 {
+    // Forward declarations //
+    class CIoStreamReader;
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Enum:
@@ -186,6 +222,38 @@ namespace MetricsDiscoveryInternal
         uint32_t            ThreadsPerEu;
     } TGfxDeviceInfo;
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Struct:
+    //     TCompletedOaStreamRead
+    //
+    // Description:
+    //     Oa stream read completed by a stream group into its own buffer.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    typedef struct SCompletedOaStreamRead
+    {
+        int32_t        Result; // Read bytes or negative errno
+        const uint8_t* Data;   // Read data, valid until the next read of the stream group
+    } TCompletedOaStreamRead;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Struct:
+    //     TDrainedOaStreamReports
+    //
+    // Description:
+    //     Reports read from the oa buffer before the stream was paused,
+    //     returned by the following stream reads.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    typedef struct SDrainedOaStreamReports
+    {
+        std::vector<uint8_t>            Reports;
+        size_t                          Offset;     // In bytes, reports already returned
+        GTDIReadCounterStreamExceptions Exceptions; // Exceptions of the drain reads, returned with the first reports
+    } TDrainedOaStreamReports;
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -291,12 +359,24 @@ namespace MetricsDiscoveryInternal
         // Stream
         virtual TCompletionCode OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize );
         virtual TCompletionCode ReadIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, char* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode PauseIoStream( COAConcurrentGroup& oaConcurrentGroup, const bool pause );
+        virtual TCompletionCode SwitchIoStream( COAConcurrentGroup& oaConcurrentGroup, CMetricSet& metricSet );
         virtual TCompletionCode CloseIoStream( COAConcurrentGroup& oaConcurrentGroup );
         virtual TCompletionCode HandleIoStreamExceptions( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& reportCount, const GTDIReadCounterStreamExceptions exceptions );
         virtual TCompletionCode WaitForIoStreamReports( COAConcurrentGroup& oaConcurrentGroup, const uint32_t milliseconds );
         virtual bool            IsIoMeasurementInfoAvailable( const TIoMeasurementInfoType ioMeasurementInfoType );
         virtual bool            IsStreamTypeSupported( const TStreamType streamType );
 
+        // Stream group
+        virtual IInternalIoStreamGroup* CreateIoStreamGroup();
+        virtual size_t                  GetOaStreamBufferSize( const uint32_t reportSize, const uint32_t reportsToRead ) = 0;
+        void                            SetCompletedOaStreamRead( CMetricsDevice& metricsDevice, const int32_t result, const uint8_t* data );
+        bool                            HasIoStreamReader( CMetricsDevice& metricsDevice );
+
+        // Side-band
+        virtual IInternalSideBandSampler* CreateSideBandSampler( const TSideBandSamplerParams& params );
+
         // Overrides
         virtual TCompletionCode SetFrequencyOverride( const TSetFrequencyOverrideParams_1_2* params );
         virtual TCompletionCode SetQueryOverride( TOverrideType overrideType, uint32_t oaBufferSize, const TSetQueryOverrideParams_1_2* params );
@@ -311,21 +391,40 @@ namespace MetricsDiscoveryInternal
 
     protected:
         // OA
-        virtual TCompletionCode OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType ) = 0;
-        virtual TCompletionCode ReadOaStream( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, char* reportData, uint32_t& readBytes, GTDIReadCounterStreamExceptions& exceptions )          = 0;
+        virtual TCompletionCode OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t& bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType, const uint32_t pollPeriodNs, const bool disabled ) = 0;
+        virtual TCompletionCode ReadOaStream( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, char* reportData, uint32_t& readBytes, GTDIReadCounterStreamExceptions& exceptions )                                                             = 0;
+        virtual TCompletionCode ReadOaStreamView( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, uint32_t& readReports, GTDIReadCounterStreamExceptions& exceptions )                                                                         = 0;
+        virtual TCompletionCode EnableOaStream( CMetricsDevice& metricsDevice, const bool enable )                                                                                                                                                                         = 0;
+        virtual TCompletionCode ChangeOaStreamConfig( CMetricsDevice& metricsDevice, const int32_t oaMetricSetId )                                                                                                                                                         = 0;
         TCompletionCode         CloseOaStream( CMetricsDevice& metricsDevice );
         TCompletionCode         WaitForOaStreamReports( CMetricsDevice& metricsDevice, uint32_t timeoutMs );
         std::string             GenerateQueryGuid( const uint32_t subDeviceIndex );
-        virtual TCompletionCode AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId ) = 0;
+        virtual TCompletionCode AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId, bool* added = nullptr ) = 0;
         virtual TCompletionCode RemoveOaConfig( int32_t oaConfigId )                                                                                                            = 0;
         TCompletionCode         RemoveOaConfigQuery( const char* guid );
         TCompletionCode         GetOaMetricSetId( const char* guid, int32_t& oaMetricSetId );
+        TCompletionCode         AcquireOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, int32_t& oaConfigId );
+        void                    ReleaseOaConfig( const int32_t oaConfigId );
         bool                    OaMetricSetExists( const char* guid );
         virtual uint32_t        GetOaReportType( const TReportType reportType ) = 0;
         virtual TCompletionCode GetOaTimestampFrequency( uint64_t& frequency )  = 0;
         virtual TCompletionCode GetCsTimestampFrequency( uint64_t& frequency )  = 0;
         bool                    IsOamSupported();
 
+        // Background IoStream reader
+        CIoStreamReader* GetIoStreamReader( CMetricsDevice& metricsDevice );
+        TCompletionCode  StartIoStreamReader( COAConcurrentGroup& oaConcurrentGroup );
+        void             StopIoStreamReader( CMetricsDevice& metricsDevice );
+        void             RunIoStreamReader( CIoStreamReader& reader, CMetricsDevice& metricsDevice, const uint32_t reportSize );
+        void             GetIoStreamFrequency( uint32_t& frequency );
+
+        // Stream group
+        bool TakeCompletedOaStreamRead( CMetricsDevice& metricsDevice, TCompletedOaStreamRead& completedRead );
+
+        // Pause
+        TCompletionCode DrainOaStream( CMetricsDevice& metricsDevice, const uint32_t reportSize );
+        uint32_t        TakeDrainedOaStreamReports( CMetricsDevice& metricsDevice, const uint32_t reportSize, const uint32_t reportsToRead, const uint8_t*& reportData, GTDIReadCounterStreamExceptions& exceptions );
+
         // DRM
         bool            InitializeIntelDrm();
         void            DeinitializeIntelDrm();
@@ -333,9 +432,9 @@ namespace MetricsDiscoveryInternal
         TCompletionCode AcquireAdapterId();
 
         // SysFs
-        TCompletionCode ReadSysFsFile( const char* fileName, uint64_t* readValue );
+        TCompletionCode ReadSysFsFile( const char* fileName, uint64_t* readValue, const bool rateLimited = false );
         TCompletionCode WriteSysFsFile( const char* fileName, uint64_t value );
-        TCompletionCode ReadUInt64FromFile( const char* filePath, uint64_t* readValue );
+        TCompletionCode ReadUInt64FromFile( const char* filePath, uint64_t* readValue, const bool rateLimited = false );
         TCompletionCode WriteUInt64ToFile( const char* filePath, uint64_t value );
 
         // IOCTL
@@ -363,6 +462,8 @@ namespace MetricsDiscoveryInternal
         uint32_t GetTimerPeriodExponent( uint32_t nsTimerPeriod );
         uint32_t GetNsTimerPeriod( uint32_t timerPeriodExponent );
         uint32_t CalculateOaBufferSize( const uint32_t requestedBufferSize );
+        uint32_t GetOaPollPeriod( const TIoStreamPollParams& pollParams, const uint32_t nsTimerPeriod, const uint32_t bufferSize, const uint32_t reportSize );
+        uint32_t GetOaBufferSize( const TIoStreamOaBufferParams& oaBufferParams, const uint32_t requestedBufferSize, const uint32_t nsTimerPeriod, const uint32_t reportSize );
 
     protected:
         // Variables
@@ -371,9 +472,20 @@ namespace MetricsDiscoveryInternal
         int32_t     m_DrmCardNumber;            // Used for SysFs reads / writes
         TDrmVersion m_DrmVersion;
 
+        // SysFs
+        CSysFsCache m_SysFsCache; // Opened SysFs files, read with a single pread
+
         // Query
         std::vector<int32_t> m_AddedOaConfigs; // IDs of configurations added to i915 Perf or XE OA for the need of query, needed for later config removal
 
+        // Stream
+        COaConfigCache                                     m_OaConfigCache;          // Stream configurations added to the kernel, reused by later streams
+        CBufferProviderLinux                               m_BufferProvider;         // Stream and reader ring buffers, near the device
+        std::map<CMetricsDevice*, CIoStreamReader*>        m_IoStreamReaders;        // Background readers of opened streams, if enabled, guarded by m_IoStreamReadersMutex
+        std::mutex                                         m_IoStreamReadersMutex;
+        std::map<CMetricsDevice*, TCompletedOaStreamRead>  m_CompletedOaStreamReads; // Stream reads completed by a stream group, consumed by the next read
+        std::map<CMetricsDevice*, TDrainedOaStreamReports> m_DrainedOaStreamReports; // Reports read before a pause, returned by the next reads
+
         // Cached values
         uint64_t       m_CachedBoostFrequency;
         uint64_t       m_CachedMinFrequency;
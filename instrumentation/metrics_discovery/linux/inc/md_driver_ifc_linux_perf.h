@@ -37,8 +37,11 @@ namespace MetricsDiscoveryInternal
     typedef struct SPerfCapabilities
     {
         bool IsOaInterruptSupported;     // Available since i915 Perf revision '2'
+        bool IsOaConfigChangeSupported;  // Available since i915 Perf revision '2'
+        bool IsPollOaPeriodSupported;    // Available since i915 Perf revision '5'
         bool IsSubDeviceSupported;       // Available since i915 Perf revision '10'
         bool IsGpuCpuTimestampSupported; // Available since i915 Perf revision '11'
+        bool IsOaBufferSizeSupported;    // Available since i915 Perf revision '1001' (prelim)
     } TPerfCapabilities;
 
     //////////////////////////////////////////////////////////////////////////////
@@ -74,6 +77,9 @@ namespace MetricsDiscoveryInternal
         virtual TCompletionCode GetGpuCpuTimestamps( CMetricsDevice& device, uint64_t* gpuTimestamp, uint64_t* cpuTimestamp, uint32_t* cpuId, uint64_t* correlationIndicator );
         virtual bool            IsTbsEngineValid( const TEngineParams_1_9& engineParams, const uint32_t requestedInstance = -1, const bool isOam = false ) const;
 
+        // Stream group
+        virtual size_t GetOaStreamBufferSize( const uint32_t reportSize, const uint32_t reportsToRead );
+
         // Overrides
         virtual bool            IsSubDeviceSupported();
         virtual TCompletionCode EnumerateSubDevices( CSubDevices& subDevices );
@@ -92,15 +98,19 @@ namespace MetricsDiscoveryInternal
         void PrintPerfCapabilities();
 
         // OA Stream
-        virtual TCompletionCode OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType );
+        virtual TCompletionCode OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t& bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType, const uint32_t pollPeriodNs, const bool disabled );
         virtual TCompletionCode ReadOaStream( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, char* reportData, uint32_t& readBytes, GTDIReadCounterStreamExceptions& exceptions );
-        virtual TCompletionCode AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId );
+        virtual TCompletionCode ReadOaStreamView( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, uint32_t& readReports, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode EnableOaStream( CMetricsDevice& metricsDevice, const bool enable );
+        virtual TCompletionCode ChangeOaStreamConfig( CMetricsDevice& metricsDevice, const int32_t oaMetricSetId );
+        virtual TCompletionCode AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId, bool* added = nullptr );
         virtual TCompletionCode RemoveOaConfig( int32_t oaConfigId );
         virtual uint32_t        GetOaReportType( const TReportType reportType );
         virtual TCompletionCode GetOaTimestampFrequency( uint64_t& frequency );
         virtual TCompletionCode GetCsTimestampFrequency( uint64_t& frequency );
         TCompletionCode         UpdateTbsEngineParams( CMetricsDevice& metricsDevice, std::vector<uint64_t>& properties );
         bool                    IsOamRequested( const uint32_t reportType );
+        TCompletionCode         QueryOaBufferSize( const int32_t streamId, uint32_t& bufferSize );
 
         // Read global symbols per tile.
         TCompletionCode GetQueryGeometrySlices( std::vector<uint8_t>& buffer, CMetricsDevice* metricsDevice );
@@ -0,0 +1,222 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_driver_ifc_linux_recorder.h
+//
+//     Abstract:   C++ driver interface recorder for Linux with Perf
+
+#pragma once
+
+#include "md_driver_ifc_linux_perf.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Environment variables selecting driver recording and replay.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_DRIVER_RECORD        "MD_DRIVER_RECORD"        // Record file written by the first opened adapter
+#define MD_DRIVER_REPLAY        "MD_DRIVER_REPLAY"        // Record file replayed instead of the system adapters
+#define MD_DRIVER_REPLAY_PACED  "MD_DRIVER_REPLAY_PACED"  // Non-zero replays stream reports at the recorded pace
+#define MD_DRIVER_RECORD_MAGIC  0x5244444D                // "MDDR"
+#define MD_DRIVER_RECORD_VERSION 1
+#define MD_DRIVER_RECORD_NO_SUB_DEVICE UINT32_MAX         // Device params read without a metrics device
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Enum:
+    //     TDriverRecordType
+    //
+    // Description:
+    //     Driver record types. Each record is a TDriverRecordHeader followed by
+    //     the record structure and an optional variable length payload.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    typedef enum EDriverRecordType
+    {
+        DRIVER_RECORD_ADAPTER = 0,  // TAdapterParams_1_9, short name as payload
+        DRIVER_RECORD_DEVICE_PARAM, // TDriverRecordDeviceParam
+        DRIVER_RECORD_TIMESTAMPS,   // TDriverRecordTimestamps
+        DRIVER_RECORD_QUERY,        // TDriverRecordQuery
+        DRIVER_RECORD_SUB_DEVICE,   // TDriverRecordSubDevice, engine class / instance pairs as payload
+        DRIVER_RECORD_STREAM_OPEN,  // TDriverRecordStreamOpen
+        DRIVER_RECORD_STREAM_READ,  // TDriverRecordStreamRead, raw reports as payload
+        DRIVER_RECORD_STREAM_CLOSE, // TDriverRecordStream
+        // ...
+        DRIVER_RECORD_LAST
+    } TDriverRecordType;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Enum:
+    //     TDriverRecordQueryType
+    //
+    // Description:
+    //     Recorded boolean driver queries.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    typedef enum EDriverRecordQueryType
+    {
+        DRIVER_RECORD_QUERY_SUB_DEVICE_SUPPORTED = 0, // No arguments
+        DRIVER_RECORD_QUERY_TBS_ENGINE_VALID,         // Engine class, engine instance, requested instance, is oam
+    } TDriverRecordQueryType;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Record file layout, native byte order and alignment:                      //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SDriverRecordFileHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t AdapterId; // Adapter id of the recorded driver interface
+        uint32_t Reserved;
+    } TDriverRecordFileHeader;
+
+    typedef struct SDriverRecordHeader
+    {
+        uint32_t Type;
+        uint32_t Size; // In bytes, without the header
+    } TDriverRecordHeader;
+
+    typedef struct SDriverRecordDeviceParam
+    {
+        uint32_t                  Param;
+        uint32_t                  SubDeviceIndex;
+        uint32_t                  Result;
+        GTDIDeviceInfoParamExtOut Out;
+    } TDriverRecordDeviceParam;
+
+    typedef struct SDriverRecordTimestamps
+    {
+        uint32_t SubDeviceIndex;
+        uint32_t Result;
+        uint64_t GpuTimestamp;
+        uint64_t CpuTimestamp;
+        uint64_t CorrelationIndicator;
+        uint32_t CpuId;
+        uint32_t Reserved;
+    } TDriverRecordTimestamps;
+
+    typedef struct SDriverRecordQuery
+    {
+        uint32_t Query;
+        uint32_t Arguments[4];
+        uint32_t Result;
+    } TDriverRecordQuery;
+
+    typedef struct SDriverRecordSubDevice
+    {
+        uint32_t SubDeviceIndex;
+        uint32_t EngineCount;
+    } TDriverRecordSubDevice;
+
+    typedef struct SDriverRecordStream
+    {
+        uint32_t SubDeviceIndex;
+        uint32_t OaBufferType;
+    } TDriverRecordStream;
+
+    typedef struct SDriverRecordStreamOpen
+    {
+        TDriverRecordStream Stream;
+        uint32_t            Result;
+        uint32_t            NsTimerPeriod;
+        uint32_t            BufferSize;
+        uint32_t            Reserved;
+    } TDriverRecordStreamOpen;
+
+    typedef struct SDriverRecordStreamRead
+    {
+        TDriverRecordStream             Stream;
+        uint32_t                        Result;
+        uint32_t                        Frequency;
+        GTDIReadCounterStreamExceptions Exceptions;
+        uint32_t                        ReportSize;
+        uint32_t                        ReportCount;
+        uint32_t                        Reserved;
+        uint64_t                        TimeNs; // Read completion since the stream was opened
+    } TDriverRecordStreamRead;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Description:
+    //     i915 Perf driver interface which records results of device params,
+    //     topology and timestamp queries and IO Stream reads to a file, so
+    //     the open device to calculate path can be replayed without the GPU
+    //     by CDriverInterfaceLinuxReplay. Records are written as the calls
+    //     complete, from any thread. Only one driver interface records at
+    //     a time, others run unrecorded.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CDriverInterfaceLinuxRecorder : public CDriverInterfaceLinuxPerf
+    {
+    public: // Constructor & Destructor
+        CDriverInterfaceLinuxRecorder( CAdapterHandle& adapterHandle, const TAdapterParams_1_9& adapterParams, const char* fileName );
+        virtual ~CDriverInterfaceLinuxRecorder();
+
+        CDriverInterfaceLinuxRecorder( const CDriverInterfaceLinuxRecorder& )            = delete; // Delete copy-constructor
+        CDriverInterfaceLinuxRecorder& operator=( const CDriverInterfaceLinuxRecorder& ) = delete; // Delete assignment operator
+
+    public: // Methods
+        // General
+        virtual TCompletionCode SendDeviceInfoParamEscape( GTDI_DEVICE_PARAM param, GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice = nullptr );
+        virtual TCompletionCode GetGpuCpuTimestamps( CMetricsDevice& device, uint64_t* gpuTimestamp, uint64_t* cpuTimestamp, uint32_t* cpuId, uint64_t* correlationIndicator );
+        virtual bool            IsTbsEngineValid( const TEngineParams_1_9& engineParams, const uint32_t requestedInstance = -1, const bool isOam = false ) const;
+
+        // Stream
+        virtual TCompletionCode OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize );
+        virtual TCompletionCode ReadIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, char* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode CloseIoStream( COAConcurrentGroup& oaConcurrentGroup );
+
+        // Overrides
+        virtual bool            IsSubDeviceSupported();
+        virtual TCompletionCode EnumerateSubDevices( CSubDevices& subDevices );
+
+        // Record file
+        static uint64_t GetStreamKey( const TDriverRecordStream& stream );
+
+    protected:
+        virtual bool CreateContext();
+
+    private:
+        void     WriteRecord( const TDriverRecordType type, const void* record, const uint32_t recordSize, const void* payload = nullptr, const uint32_t payloadSize = 0 ) const;
+        void     WriteQuery( const TDriverRecordQueryType query, const uint32_t argument0, const uint32_t argument1, const uint32_t argument2, const uint32_t argument3, const bool result ) const;
+        void     WriteStreamRead( COAConcurrentGroup& oaConcurrentGroup, const TCompletionCode result, const char* reportData, const uint32_t reportCount, const uint32_t frequency, const GTDIReadCounterStreamExceptions& exceptions );
+        uint64_t GetStreamTimeNs( const TDriverRecordStream& stream );
+
+        static TDriverRecordStream GetRecordStream( COAConcurrentGroup& oaConcurrentGroup );
+
+    private:
+        // Variables
+        TAdapterParams_1_9 m_adapterParams;
+        std::string        m_fileName;
+        FILE*              m_file; // nullptr if not recording
+        mutable std::mutex m_fileMutex;
+
+        std::map<uint64_t, std::chrono::steady_clock::time_point> m_streamOpenTimes; // Guarded by m_fileMutex
+
+        static std::atomic<bool> m_recording; // A driver interface is recording
+    };
+
+} // namespace MetricsDiscoveryInternal
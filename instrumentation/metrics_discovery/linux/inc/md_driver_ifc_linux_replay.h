@@ -0,0 +1,165 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_driver_ifc_linux_replay.h
+//
+//     Abstract:   C++ driver interface replaying a driver record file on Linux
+
+#pragma once
+
+#include "md_driver_ifc_linux_recorder.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Replayed IO Stream:                                                       //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SReplayStreamRead
+    {
+        TDriverRecordStreamRead Read;
+        std::vector<uint8_t>    Reports;
+        uint32_t                ReportOffset; // Reports already returned
+    } TReplayStreamRead;
+
+    typedef struct SReplayStream
+    {
+        TDriverRecordStreamOpen               Open;
+        std::deque<TReplayStreamRead>         Reads;
+        std::chrono::steady_clock::time_point OpenTime;
+        uint32_t                              Frequency; // Frequency of the last returned reports
+    } TReplayStream;
+
+    typedef struct SReplayTimestamps
+    {
+        std::deque<TDriverRecordTimestamps> Timestamps;
+        TDriverRecordTimestamps             Last;
+        uint64_t                            GpuDelta; // Last recorded deltas, extrapolated once timestamps run out
+        uint64_t                            CpuDelta;
+    } TReplayTimestamps;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Description:
+    //     Driver interface serving device params, topology and timestamp queries
+    //     and IO Stream reads from a file written by CDriverInterfaceLinuxRecorder,
+    //     without a GPU or DRM device. Device params and timestamps are returned
+    //     in the recorded order, the last recorded value is repeated afterwards.
+    //     Each opened stream replays the next recorded stream of the same sub
+    //     device and OA buffer. Reports are returned as fast as possible, or, if
+    //     paced, not before the time they were read at since the stream opened.
+    //     Configurations are not sent anywhere, so replayed reports do not depend
+    //     on the metric set the stream is opened with.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CDriverInterfaceLinuxReplay : public CDriverInterfaceLinuxCommon
+    {
+    public: // Constructor & Destructor
+        CDriverInterfaceLinuxReplay( CAdapterHandle& adapterHandle, const char* fileName, const bool paced );
+        virtual ~CDriverInterfaceLinuxReplay();
+
+        CDriverInterfaceLinuxReplay( const CDriverInterfaceLinuxReplay& )            = delete; // Delete copy-constructor
+        CDriverInterfaceLinuxReplay& operator=( const CDriverInterfaceLinuxReplay& ) = delete; // Delete assignment operator
+
+    public: // Methods
+        // Static
+        static TCompletionCode GetReplayAdapters( const char* fileName, std::vector<TAdapterData>& adapters );
+
+        // Read global symbols per tile.
+        virtual TCompletionCode GetEuCoresTotalCount( GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice );
+        virtual TCompletionCode GetEuCoresPerSubsliceCount( GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice );
+        virtual TCompletionCode GetSliceMask( int32_t* sliceMask, CMetricsDevice* metricsDevice );
+        virtual TCompletionCode GetSubsliceMask( int64_t* subsliceMask, CMetricsDevice* metricsDevice );
+
+        // General
+        virtual TCompletionCode SendDeviceInfoParamEscape( GTDI_DEVICE_PARAM param, GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice = nullptr );
+        virtual TCompletionCode SendPmRegsConfig( TRegister** regVector, const uint32_t regCount, const uint32_t apiMask, const uint32_t subDeviceIndex, const GTDI_OA_BUFFER_TYPE oaBufferType );
+        virtual TCompletionCode GetGpuCpuTimestamps( CMetricsDevice& device, uint64_t* gpuTimestamp, uint64_t* cpuTimestamp, uint32_t* cpuId, uint64_t* correlationIndicator );
+        virtual bool            IsTbsEngineValid( const TEngineParams_1_9& engineParams, const uint32_t requestedInstance = -1, const bool isOam = false ) const;
+
+        // Stream
+        virtual TCompletionCode OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize );
+        virtual TCompletionCode ReadIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, char* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode SwitchIoStream( COAConcurrentGroup& oaConcurrentGroup, CMetricSet& metricSet );
+        virtual TCompletionCode CloseIoStream( COAConcurrentGroup& oaConcurrentGroup );
+        virtual TCompletionCode WaitForIoStreamReports( COAConcurrentGroup& oaConcurrentGroup, const uint32_t milliseconds );
+
+        // Stream group
+        virtual IInternalIoStreamGroup* CreateIoStreamGroup();
+        virtual size_t                  GetOaStreamBufferSize( const uint32_t reportSize, const uint32_t reportsToRead );
+
+        // Overrides
+        virtual TCompletionCode SetFrequencyOverride( const TSetFrequencyOverrideParams_1_2* params );
+        virtual TCompletionCode SetQueryOverride( TOverrideType overrideType, uint32_t oaBufferSize, const TSetQueryOverrideParams_1_2* params );
+        virtual TCompletionCode SetFreqChangeReportsOverride( bool enable );
+        virtual bool            IsOverrideAvailable( TOverrideType overrideType );
+        virtual bool            IsSubDeviceSupported();
+        virtual TCompletionCode EnumerateSubDevices( CSubDevices& subDevices );
+
+    protected:
+        virtual bool CreateContext();
+
+    private:
+        // OA Stream
+        virtual TCompletionCode OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t& bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType, const uint32_t pollPeriodNs, const bool disabled );
+        virtual TCompletionCode ReadOaStream( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, char* reportData, uint32_t& readBytes, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode ReadOaStreamView( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, uint32_t& readReports, GTDIReadCounterStreamExceptions& exceptions );
+        virtual TCompletionCode EnableOaStream( CMetricsDevice& metricsDevice, const bool enable );
+        virtual TCompletionCode ChangeOaStreamConfig( CMetricsDevice& metricsDevice, const int32_t oaMetricSetId );
+        virtual TCompletionCode AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId, bool* added = nullptr );
+        virtual TCompletionCode RemoveOaConfig( int32_t oaConfigId );
+        virtual uint32_t        GetOaReportType( const TReportType reportType );
+        virtual TCompletionCode GetOaTimestampFrequency( uint64_t& frequency );
+        virtual TCompletionCode GetCsTimestampFrequency( uint64_t& frequency );
+
+        // Device info params
+        virtual TCompletionCode GetDeviceId( int32_t& deviceId );
+        virtual TCompletionCode GetRevisionId( int32_t& revisionId );
+        virtual TCompletionCode GetOaBufferSupportedSizes( const uint32_t platformId, uint32_t& minSize, uint32_t& maxSize );
+        virtual TCompletionCode GetOaBufferCount( CMetricsDevice& metricsDevice, uint32_t& oaBufferCount );
+
+        // Replay
+        TCompletionCode ParseRecords( const std::vector<uint8_t>& file );
+        TCompletionCode TakeReports( TReplayStream& stream, const uint32_t reportSize, uint8_t* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions );
+        bool            IsReadAvailable( const TReplayStream& stream, const TReplayStreamRead& read ) const;
+
+        static TCompletionCode LoadFile( const char* fileName, std::vector<uint8_t>& file );
+
+    private:
+        // Variables
+        std::string m_fileName;
+        const bool  m_paced; // Reports are returned at the recorded pace
+
+        // Guarded by m_mutex
+        std::map<uint64_t, std::deque<TDriverRecordDeviceParam>> m_deviceParams; // Key is param and sub device index
+        std::map<uint32_t, TReplayTimestamps>                    m_timestamps;   // Key is sub device index
+        std::map<std::array<uint32_t, 5>, bool>                  m_queries;      // Key is query type and arguments
+        std::map<uint64_t, std::deque<TReplayStream>>            m_streams;      // Recorded streams not opened yet, key is GetStreamKey
+        std::map<uint64_t, TReplayStream>                        m_openedStreams;
+        int32_t                                                  m_nextStreamConfigId;
+        mutable std::mutex                                       m_mutex;
+        std::condition_variable                                  m_readCondition; // Notified on a closed stream
+
+        std::vector<std::vector<TEngineIdClassInstance_1_9>> m_subDeviceEngines;
+    };
+
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,138 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_group_linux.h
+//
+//     Abstract:   C++ epoll and io_uring based IoStream group for Linux
+
+#pragma once
+
+#include "md_types.h"
+#include "md_stream_buffer.h"
+
+#include <vector>
+
+#include <linux/io_uring.h>
+
+#include <sys/epoll.h>
+#include <sys/uio.h>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     io_uring read backend of the stream group. User data of submitted entries
+//     holds the stream entry id shifted left by 2 and the operation type.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_GROUP_IO_URING_ENTRIES 256 // Submission queue size, two entries per stream read
+#define MD_IO_STREAM_GROUP_OP_POLL          0
+#define MD_IO_STREAM_GROUP_OP_READ          1
+#define MD_IO_STREAM_GROUP_OP_CANCEL        2
+#define MD_IO_STREAM_GROUP_OP_MASK          3
+#define MD_IO_STREAM_GROUP_CANCEL_WAIT_MS   100 // Single wait for cancelled reads
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    // Forward declarations //
+    class CConcurrentGroup;
+    class CDriverInterfaceLinuxCommon;
+    class CIoUringLinux;
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Single stream registered in the stream group:                             //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SIoStreamGroupEntry
+    {
+        CConcurrentGroup* ConcurrentGroup;
+        int32_t           StreamId;         // Stream fd at the time of registration
+        uint32_t          StreamGeneration; // Metrics device stream generation at the time of registration
+        uint64_t          Id;               // Unique id, used in io_uring user data
+        uint32_t          PendingCqeCount;  // io_uring completions still expected
+        bool              Completed;        // io_uring read completed, not delivered yet
+        int32_t           ReadResult;       // io_uring read result, read bytes or negative errno
+        uint32_t          ReportCount;      // Reports requested by the submitted read
+        size_t            ReadSize;         // Bytes requested by the submitted read
+        int32_t           BufferIndex;      // Registered buffer index, -1 if not registered
+        CStreamBuffer*    Buffer;           // io_uring read target, owned by the group
+    } TIoStreamGroupEntry;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Description:
+    //     Registers opened IO streams of several concurrent groups, possibly from
+    //     different metrics devices, in a single epoll set, so one thread can wait
+    //     for all of them with a single syscall and drain only the ready ones.
+    //     With the io_uring read backend a linked poll and read of every stream
+    //     is submitted at once, so reads of all ready streams complete with
+    //     a single io_uring_enter. Reads target buffers owned by the group, not
+    //     metrics device stream buffers, so a stream read or buffer resize
+    //     elsewhere cannot free memory the kernel writes into. Completed data is
+    //     copied to the stream buffer by the following ReadIoStreamView. Streams
+    //     read with io_uring should still be read only with ReadReports.
+    //     Streams reopened by their concurrent group are registered again and
+    //     closed streams are dropped before every wait.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamGroupLinux : public IInternalIoStreamGroup
+    {
+    public:
+        // Internal API (IInternalIoStreamGroup):
+        virtual TCompletionCode AddStream( IConcurrentGroupLatest* concurrentGroup );
+        virtual TCompletionCode RemoveStream( IConcurrentGroupLatest* concurrentGroup );
+        virtual uint32_t        GetStreamCount( void );
+        virtual TCompletionCode WaitForReports( uint32_t milliseconds, IConcurrentGroupLatest** outReadyGroups, uint32_t outReadyGroupsCount, uint32_t* outReadyCount );
+        virtual TCompletionCode SetReadBackend( TIoStreamGroupBackend backend );
+        virtual TCompletionCode ReadReports( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount );
+
+    public:
+        // Constructor & Destructor:
+        CIoStreamGroupLinux( const uint32_t adapterId, CDriverInterfaceLinuxCommon& driverInterface );
+        virtual ~CIoStreamGroupLinux();
+
+        CIoStreamGroupLinux( const CIoStreamGroupLinux& )            = delete; // Delete copy-constructor
+        CIoStreamGroupLinux& operator=( const CIoStreamGroupLinux& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Initialize();
+
+    private:
+        TCompletionCode ReadReportsPoll( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount );
+        TCompletionCode ReadReportsIoUring( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount );
+
+        void                 UpdateStreams();
+        void                 PrepareRead( TIoStreamGroupEntry& entry, const uint32_t maxReportCount );
+        TCompletionCode      SubmitRead( TIoStreamGroupEntry& entry );
+        void                 RegisterBuffers();
+        int32_t              FindBuffer( const TIoStreamGroupEntry& entry );
+        void                 HandleCompletion( const io_uring_cqe& cqe );
+        void                 CancelRead( TIoStreamGroupEntry& entry );
+        void                 CancelReads();
+        void                 DeleteBuffer( TIoStreamGroupEntry& entry );
+        TIoStreamGroupEntry* FindEntry( const uint64_t id );
+
+    private:
+        // Variables:
+        const uint32_t                       m_adapterId;
+        CDriverInterfaceLinuxCommon&         m_driverInterface;
+        int32_t                              m_epollFd;
+        std::vector<TIoStreamGroupEntry>     m_entries;
+        std::vector<epoll_event>             m_events;      // Reused for every wait
+        std::vector<IConcurrentGroupLatest*> m_readyGroups; // Reused for every poll backend read
+        uint64_t                             m_nextEntryId;
+
+        CIoUringLinux*              m_ioUring;         // nullptr means poll backend
+        std::vector<iovec>          m_buffers;         // Entry buffers registered in io_uring
+        bool                        m_useFixedBuffers; // Cleared if buffers cannot be registered, e.g. due to RLIMIT_MEMLOCK
+        std::vector<CStreamBuffer*> m_orphanedBuffers; // Buffers of removed entries with reads not cancelled, deleted with the ring
+    };
+} // namespace MetricsDiscoveryInternal
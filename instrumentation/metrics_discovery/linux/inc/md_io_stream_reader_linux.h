@@ -0,0 +1,116 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_reader_linux.h
+//
+//     Abstract:   C++ background IoStream reader for Linux
+
+#pragma once
+
+#include "md_driver_ifc.h"
+#include "md_buffer_provider_linux.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defines used by the background IoStream reader.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_IO_STREAM_READER_RING_REPORT_COUNT 65536 // Default ring capacity, 16 MB for 256B reports
+#define MD_IO_STREAM_READER_BATCH_REPORTS     1024  // Max reports drained with a single read
+#define MD_IO_STREAM_READER_POLL_TIMEOUT_MS   100   // Stop request check period
+#define MD_IO_STREAM_READER_DRAIN_TIMEOUT_MS  1000  // Max wait for the reader thread to drain the stream
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Description:
+    //     Background IoStream reader. Reader thread drains the stream into
+    //     a single-producer / single-consumer ring of raw reports, the client
+    //     thread pops reports in ReadIoStream. Ring positions are lock-free,
+    //     the mutex and condition variable are used only to wake up waiters.
+    //     Stream exceptions and reports dropped on a full ring are accumulated
+    //     until the next pop. The ring is allocated by the driver interface
+    //     buffer provider, near the device. If the reader thread exits on
+    //     an error, the error is returned once the ring is drained. The client
+    //     thread may request a drain, completed by the first reader thread read
+    //     started after the request that leaves the stream empty.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoStreamReader
+    {
+    public:
+        // Constructor & Destructor:
+        CIoStreamReader( const uint32_t adapterId, const uint32_t reportSize, const TIoStreamReaderParams& params, CBufferProviderLinux& bufferProvider );
+        virtual ~CIoStreamReader();
+
+        CIoStreamReader( const CIoStreamReader& )            = delete; // Delete copy-constructor
+        CIoStreamReader& operator=( const CIoStreamReader& ) = delete; // Delete assignment operator
+
+        // Control:
+        TCompletionCode Start( std::function<void( CIoStreamReader& )> threadFunction );
+        void            Stop();
+        bool            IsStopRequested() const;
+
+        // Producer (reader thread):
+        uint32_t GetBatchReportCount() const;
+        void     Push( const uint8_t* report );
+        void     AddExceptions( const GTDIReadCounterStreamExceptions& exceptions );
+        void     NotifyReports();
+        void     SetThreadResult( const TCompletionCode result );
+        uint64_t GetDrainRequest() const;
+        void     CompleteDrain( const uint64_t drainRequest );
+
+        // Consumer (client thread):
+        uint32_t        Pop( char* reportData, const uint32_t reportsCount, GTDIReadCounterStreamExceptions& exceptions );
+        TCompletionCode WaitForReports( const uint32_t milliseconds );
+        TCompletionCode GetThreadResult() const;
+        TCompletionCode Drain( const uint32_t milliseconds );
+
+    private:
+        void ApplyThreadParams();
+
+    private:
+        // Variables:
+        const uint32_t              m_adapterId;
+        const uint32_t              m_reportSize;
+        const TIoStreamReaderParams m_params;
+        const uint32_t              m_capacity; // In reports
+        CBufferProviderLinux&       m_bufferProvider;
+
+        CStreamBuffer         m_ring;
+        std::atomic<uint64_t> m_head; // Reports pushed, written by the reader thread only
+        std::atomic<uint64_t> m_tail; // Reports popped, written by the client thread only
+
+        std::atomic<bool>     m_reportLost;
+        std::atomic<bool>     m_bufferOverflow;
+        std::atomic<bool>     m_bufferOverrun;
+        std::atomic<uint64_t> m_droppedReportCount;
+
+        std::atomic<TCompletionCode> m_threadResult; // Error the reader thread exited with, CC_OK while running
+
+        std::atomic<uint64_t> m_drainRequest;   // Drains requested, written by the client thread only
+        std::atomic<uint64_t> m_drainCompleted; // Last drain request completed, written by the reader thread only
+
+        std::thread             m_thread;
+        std::atomic<bool>       m_stop;
+        std::mutex              m_waitMutex;
+        std::condition_variable m_waitCondition;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,83 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_uring_linux.h
+//
+//     Abstract:   C++ minimal io_uring wrapper for Linux
+
+#pragma once
+
+#include "md_types.h"
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Description:
+    //     Minimal io_uring wrapper based directly on io_uring syscalls, so no
+    //     liburing dependency is needed. Supports submission of prepared entries,
+    //     waiting for completions with a timeout and fixed buffers.
+    //     Requires IORING_FEAT_SINGLE_MMAP and IORING_FEAT_EXT_ARG (kernel 5.11+).
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CIoUringLinux
+    {
+    public:
+        // Constructor & Destructor:
+        CIoUringLinux( const uint32_t adapterId );
+        virtual ~CIoUringLinux();
+
+        CIoUringLinux( const CIoUringLinux& )            = delete; // Delete copy-constructor
+        CIoUringLinux& operator=( const CIoUringLinux& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Initialize( const uint32_t entryCount );
+
+        TCompletionCode RegisterBuffers( const iovec* buffers, const uint32_t bufferCount );
+        void            UnregisterBuffers();
+
+        io_uring_sqe*   GetSqe();
+        uint32_t        GetSqeSpace();
+        TCompletionCode Submit( const uint32_t waitCount, const uint32_t milliseconds );
+        bool            PopCqe( io_uring_cqe& cqe );
+
+    private:
+        void Deinitialize();
+
+    private:
+        // Variables:
+        const uint32_t m_adapterId;
+        int32_t        m_ringFd;
+        bool           m_buffersRegistered;
+
+        void*  m_ringMemory; // Shared SQ and CQ rings
+        size_t m_ringMemorySize;
+        void*  m_sqeMemory;
+        size_t m_sqeMemorySize;
+
+        uint32_t*     m_sqHead;
+        uint32_t*     m_sqTail;
+        uint32_t*     m_sqMask;
+        uint32_t*     m_sqArray;
+        io_uring_sqe* m_sqes;
+        uint32_t      m_sqPendingTail; // Local tail, published by Submit
+
+        uint32_t*     m_cqHead;
+        uint32_t*     m_cqTail;
+        uint32_t*     m_cqMask;
+        io_uring_cqe* m_cqes;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,92 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_oa_config_cache_linux.h
+//
+//     Abstract:   C++ content addressed OA configuration cache for Linux
+
+#pragma once
+
+#include "md_types.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defines used by the OA configuration cache.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_OA_CONFIG_CACHE_MAX_IDLE 16 // Unused configurations kept in the kernel before the least recently used one is removed
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Single cached OA configuration:                                           //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SOaConfigCacheEntry
+    {
+        int32_t  ConfigId;
+        uint32_t RefCount;
+        bool     Owned;       // Added to the kernel by this process, removed when evicted
+        uint64_t LastUseTime; // Release sequence number, for idle entry eviction
+    } TOaConfigCacheEntry;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Description:
+    //     Reference counted table of OA configurations added to the kernel, keyed
+    //     by a GUID derived from a 128 bit hash of the exact register tuples.
+    //     Identical configurations map to the same kernel GUID in every process,
+    //     so a configuration added by another process is found and reused.
+    //     Configurations stay added after the last stream using them is closed,
+    //     so repeated stream open / close cycles do not add and remove them again.
+    //     Only the least recently used idle configurations above the limit are
+    //     evicted, configurations in use never are. A configuration of another
+    //     process may be removed by it at any time, a discarded entry is kept
+    //     apart until its references are released.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class COaConfigCache
+    {
+    public:
+        // Constructor & Destructor:
+        COaConfigCache();
+        virtual ~COaConfigCache();
+
+        COaConfigCache( const COaConfigCache& )            = delete; // Delete copy-constructor
+        COaConfigCache& operator=( const COaConfigCache& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        static void GetGuid( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, char* guid, const uint32_t guidSize );
+
+        bool Acquire( const char* guid, int32_t& configId, bool& owned );
+        void Insert( const char* guid, const int32_t configId, const bool owned );
+        void Discard( const char* guid );
+        bool Release( const int32_t configId, std::vector<int32_t>& evictedConfigIds );
+        void Clear( std::vector<int32_t>& ownedConfigIds );
+
+    private:
+        void Evict( std::vector<int32_t>& evictedConfigIds );
+
+    private:
+        // Variables:
+        std::map<std::string, TOaConfigCacheEntry> m_entries;
+        std::vector<TOaConfigCacheEntry>           m_discardedEntries; // Not owned, no longer valid, still referenced
+        uint64_t                                   m_useCounter;
+        std::mutex                                 m_mutex; // Streams of sub devices may be opened from different threads
+    };
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,100 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_side_band_sampler_linux.h
+//
+//     Abstract:   C++ SysFs / hwmon side-band sampler for Linux
+
+#pragma once
+
+#include "md_types.h"
+#include "md_sysfs_cache_linux.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defines used by the side-band sampler.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_SIDE_BAND_DEFAULT_PERIOD_US       1000  // 1 ms, well below the usual OA report aggregation interval
+#define MD_SIDE_BAND_MIN_PERIOD_US           100   // SysFs reads take several us each, faster sampling only burns CPU
+#define MD_SIDE_BAND_DEFAULT_SAMPLE_COUNT    16384 // ~16 s of history with the default period
+#define MD_SIDE_BAND_DEFAULT_ATTRIBUTE_COUNT 4
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Description:
+    //     Samples SysFs / hwmon attributes of a DRM card on a background thread
+    //     with a fixed period. Attribute files are kept open by a SysFs cache of
+    //     the sampler and read with a single pread per sample, unreadable ones
+    //     are dropped on initialization. Missing attributes keep their index and are
+    //     reported as invalid in every sample. Samples are kept in a ring, the
+    //     oldest ones are overwritten, and are timestamped with CLOCK_MONOTONIC,
+    //     the clock GPU timestamps are converted to by the timestamp correlation.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CSideBandSamplerLinux : public IInternalSideBandSampler
+    {
+    public:
+        // Internal API (IInternalSideBandSampler):
+        virtual uint32_t        GetAttributeCount( void );
+        virtual const char*     GetAttributeName( uint32_t index );
+        virtual TCompletionCode Start( void );
+        virtual TCompletionCode Stop( void );
+        virtual TCompletionCode GetSamples( uint64_t beginCpuNs, uint64_t endCpuNs, TSideBandSample* outSamples, uint32_t* sampleCount );
+        virtual TCompletionCode GetSampleAt( uint64_t cpuTimestampNs, TSideBandSample* outSample );
+
+    public:
+        // Constructor & Destructor:
+        CSideBandSamplerLinux( const uint32_t adapterId, const TSideBandSamplerParams& params );
+        virtual ~CSideBandSamplerLinux();
+
+        CSideBandSamplerLinux( const CSideBandSamplerLinux& )            = delete; // Delete copy-constructor
+        CSideBandSamplerLinux& operator=( const CSideBandSamplerLinux& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Initialize( const char* directory );
+
+    private:
+        std::string ResolveAttribute( const std::string& directory, const char* attribute );
+        void        ThreadFunction();
+        void        TakeSample();
+        uint64_t    FindSample( const uint64_t cpuTimestampNs );
+
+    private:
+        // Variables:
+        const uint32_t           m_adapterId;
+        const uint32_t           m_periodUs;
+        const uint32_t           m_capacity; // In samples
+        std::vector<std::string> m_attributeNames;
+        std::vector<std::string> m_attributeFiles; // Resolved paths, empty if the attribute is not available
+        CSysFsCache              m_sysFsCache;     // Attribute files, used by the sampling thread only after initialization
+
+        std::vector<TSideBandSample> m_samples;
+        uint64_t                     m_sampleIndex; // Samples taken, the next sample position in the ring
+        std::mutex                   m_samplesMutex;
+
+        std::thread             m_thread;
+        bool                    m_stop;
+        std::mutex              m_stopMutex;
+        std::condition_variable m_stopCondition;
+    };
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,94 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_sysfs_cache_linux.h
+//
+//     Abstract:   C++ persistent SysFs file handle cache for Linux
+
+#pragma once
+
+#include "md_types.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Defines used by the SysFs file handle cache.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_SYSFS_REFRESH_INTERVAL                  "MD_SYSFS_REFRESH_INTERVAL_US" // Environment variable overriding the refresh interval
+#define MD_SYSFS_CACHE_DEFAULT_REFRESH_INTERVAL_US 1000                           // Minimal interval between reads of rate limited files
+#define MD_SYSFS_CACHE_MAX_VALUE_LENGTH            32                             // Max length of a read value, in characters
+
+using namespace MetricsDiscovery;
+
+namespace MetricsDiscoveryInternal
+{
+    ///////////////////////////////////////////////////////////////////////////////
+    // Single cached SysFs file:                                                 //
+    ///////////////////////////////////////////////////////////////////////////////
+    typedef struct SSysFsCacheEntry
+    {
+        int32_t  Fd;
+        uint64_t Value;
+        uint64_t ReadTimeNs; // CLOCK_MONOTONIC time of the last read
+    } TSysFsCacheEntry;
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Description:
+    //     Keeps SysFs files open for the driver interface lifetime and reads them
+    //     with a single pread() instead of open / read / close. Relative file names
+    //     are opened against the DRM card SysFs directory, or the directory given
+    //     on initialization, absolute paths as is.
+    //     Rate limited reads return the last value if it is younger than
+    //     the refresh interval, without any syscall. Files which come and go,
+    //     like per GUID oa config ids, should be read uncached.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CSysFsCache
+    {
+    public:
+        // Constructor & Destructor:
+        CSysFsCache();
+        virtual ~CSysFsCache();
+
+        CSysFsCache( const CSysFsCache& )            = delete; // Delete copy-constructor
+        CSysFsCache& operator=( const CSysFsCache& ) = delete; // Delete assignment operator
+
+        // Non-API:
+        TCompletionCode Initialize( const uint32_t adapterId, const int32_t drmCardNumber );
+        TCompletionCode Initialize( const uint32_t adapterId, const char* directory );
+        void            Clear();
+        void            SetRefreshInterval( const uint64_t refreshIntervalNs );
+
+        TCompletionCode Read( const char* fileName, uint64_t* readValue, const bool rateLimited = false );
+        TCompletionCode ReadUncached( const char* fileName, uint64_t* readValue );
+        void            Invalidate( const char* fileName );
+
+    private:
+        TSysFsCacheEntry* GetEntry( const char* fileName );
+        void              RemoveEntry( const char* fileName );
+        TCompletionCode   ReadEntry( const char* fileName, TSysFsCacheEntry& entry );
+        void              CloseEntry( TSysFsCacheEntry& entry );
+
+    private:
+        // Variables:
+        uint32_t                                             m_adapterId;
+        int32_t                                              m_directoryFd; // DRM card SysFs directory
+        uint64_t                                             m_refreshIntervalNs;
+        std::map<std::string, TSysFsCacheEntry, std::less<>> m_entries;
+        std::mutex                                           m_mutex; // Reads may come from the background IoStream reader too
+    };
+} // namespace MetricsDiscoveryInternal
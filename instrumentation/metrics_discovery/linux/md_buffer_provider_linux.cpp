@@ -0,0 +1,421 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_buffer_provider_linux.cpp
+//
+//     Abstract:   C++ huge page and NUMA aware stream buffer provider for Linux
+
+#include "md_buffer_provider_linux.h"
+#include "md_driver_ifc_linux_common.h"
+#include "md_utils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+
+#include <linux/mempolicy.h> // MPOL_PREFERRED
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     CBufferProviderLinux constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CBufferProviderLinux::CBufferProviderLinux()
+        : m_adapterId( IU_ADAPTER_ID_UNKNOWN )
+        , m_numaNode( -1 )
+        , m_localCpus()
+        , m_localCpusValid( false )
+        , m_pageSize( static_cast<size_t>( sysconf( _SC_PAGESIZE ) ) )
+    {
+        CPU_ZERO( &m_localCpus );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     ~CBufferProviderLinux
+    //
+    // Description:
+    //     Destructor. Buffers have to be freed by their owners.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CBufferProviderLinux::~CBufferProviderLinux()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     Initialize
+    //
+    // Description:
+    //     Reads NUMA node and local CPUs of the given DRM card PCI device.
+    //     Missing files are not an error, buffers are just not bound then.
+    //
+    // Input:
+    //     const uint32_t adapterId     - adapter id for logging
+    //     const int32_t  drmCardNumber - DRM card number
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CBufferProviderLinux::Initialize( const uint32_t adapterId, const int32_t drmCardNumber )
+    {
+        char filePath[MD_MAX_PATH_LENGTH] = { 0 };
+
+        m_adapterId      = adapterId;
+        m_numaNode       = -1;
+        m_localCpusValid = false;
+
+        snprintf( filePath, sizeof( filePath ), "/sys/class/drm/card%d/device/numa_node", drmCardNumber );
+
+        FILE* file = fopen( filePath, "r" );
+        if( file )
+        {
+            if( fscanf( file, "%d", &m_numaNode ) != 1 )
+            {
+                m_numaNode = -1;
+            }
+            fclose( file );
+        }
+
+        snprintf( filePath, sizeof( filePath ), "/sys/class/drm/card%d/device/local_cpulist", drmCardNumber );
+        m_localCpusValid = ReadCpuList( filePath );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Device numa node: %d, local cpus: %d", m_numaNode, m_localCpusValid ? CPU_COUNT( &m_localCpus ) : 0 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     GetNumaNode
+    //
+    // Description:
+    //     Returns NUMA node of the device.
+    //
+    // Output:
+    //     int32_t - NUMA node, -1 if unknown
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    int32_t CBufferProviderLinux::GetNumaNode() const
+    {
+        return m_numaNode;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     GetLocalCpus
+    //
+    // Description:
+    //     Returns CPUs local to the device.
+    //
+    // Input:
+    //     cpu_set_t& cpuSet - (out) local CPUs
+    //
+    // Output:
+    //     bool              - *true* if local CPUs are known
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CBufferProviderLinux::GetLocalCpus( cpu_set_t& cpuSet ) const
+    {
+        if( m_localCpusValid )
+        {
+            cpuSet = m_localCpus;
+        }
+
+        return m_localCpusValid;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     Allocate
+    //
+    // Description:
+    //     Maps a buffer, huge page backed if large enough, binds it to the device
+    //     NUMA node and prefaults it.
+    //
+    // Input:
+    //     const size_t size          - requested size in bytes
+    //     size_t&      allocatedSize - (out) mapped size in bytes
+    //
+    // Output:
+    //     uint8_t*                   - allocated buffer, nullptr on failure
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint8_t* CBufferProviderLinux::Allocate( const size_t size, size_t& allocatedSize )
+    {
+        allocatedSize = 0;
+
+        if( size == 0 )
+        {
+            return nullptr;
+        }
+
+        const bool   useHugePages = size >= MD_HUGE_PAGE_MIN_BUFFER_SIZE;
+        const size_t alignment    = useHugePages ? MD_HUGE_PAGE_SIZE : m_pageSize;
+        const size_t mappedSize   = ( size + alignment - 1 ) / alignment * alignment;
+        uint8_t*     data         = nullptr;
+
+        if( useHugePages )
+        {
+            data = MapHugePages( mappedSize );
+        }
+        else
+        {
+            void* memory = mmap( nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+            data         = ( memory != MAP_FAILED ) ? static_cast<uint8_t*>( memory ) : nullptr;
+        }
+
+        if( data == nullptr )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Cannot map stream buffer, size: %zu, errno: %d (%s)", mappedSize, errno, strerror( errno ) );
+            return nullptr;
+        }
+
+        // Binding has to precede the first touch
+        BindToNumaNode( data, mappedSize );
+        Prefault( data, mappedSize );
+
+        allocatedSize = mappedSize;
+        return data;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     Free
+    //
+    // Description:
+    //     Unmaps a buffer allocated with Allocate.
+    //
+    // Input:
+    //     uint8_t*     data          - allocated buffer
+    //     const size_t allocatedSize - size returned by Allocate
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CBufferProviderLinux::Free( uint8_t* data, const size_t allocatedSize )
+    {
+        if( data && munmap( data, allocatedSize ) != 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Cannot unmap stream buffer, errno: %d (%s)", errno, strerror( errno ) );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     MapHugePages
+    //
+    // Description:
+    //     Maps hugetlbfs pages. If the huge page pool is empty, maps 2 MB aligned
+    //     regular memory and advises it for transparent huge pages instead.
+    //
+    // Input:
+    //     const size_t size - size in bytes, multiple of the huge page size
+    //
+    // Output:
+    //     uint8_t*          - mapped buffer, nullptr on failure
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint8_t* CBufferProviderLinux::MapHugePages( const size_t size )
+    {
+        void* memory = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+        if( memory != MAP_FAILED )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Stream buffer mapped with huge pages, size: %zu", size );
+            return static_cast<uint8_t*>( memory );
+        }
+
+        // Over-map to trim the mapping to huge page alignment
+        memory = mmap( nullptr, size + MD_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if( memory == MAP_FAILED )
+        {
+            return nullptr;
+        }
+
+        const uintptr_t address = reinterpret_cast<uintptr_t>( memory );
+        const uintptr_t aligned = ( address + MD_HUGE_PAGE_SIZE - 1 ) & ~static_cast<uintptr_t>( MD_HUGE_PAGE_SIZE - 1 );
+        const size_t    head    = aligned - address;
+        const size_t    tail    = MD_HUGE_PAGE_SIZE - head;
+
+        if( head )
+        {
+            munmap( memory, head );
+        }
+        if( tail )
+        {
+            munmap( reinterpret_cast<void*>( aligned + size ), tail );
+        }
+
+        if( madvise( reinterpret_cast<void*>( aligned ), size, MADV_HUGEPAGE ) != 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Transparent huge pages not available, errno: %d (%s)", errno, strerror( errno ) );
+        }
+
+        return reinterpret_cast<uint8_t*>( aligned );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     BindToNumaNode
+    //
+    // Description:
+    //     Sets preferred memory policy of the buffer to the device NUMA node.
+    //     Failures are logged only, the buffer is usable without binding.
+    //
+    // Input:
+    //     uint8_t*     data - buffer
+    //     const size_t size - buffer size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CBufferProviderLinux::BindToNumaNode( uint8_t* data, const size_t size )
+    {
+        constexpr uint32_t nodeMaskBits = MD_NUMA_NODE_MASK_SIZE * sizeof( unsigned long ) * 8;
+
+        if( m_numaNode < 0 || static_cast<uint32_t>( m_numaNode ) >= nodeMaskBits )
+        {
+            return;
+        }
+
+        unsigned long nodeMask[MD_NUMA_NODE_MASK_SIZE] = { 0 };
+        nodeMask[m_numaNode / ( sizeof( unsigned long ) * 8 )] |= 1UL << ( m_numaNode % ( sizeof( unsigned long ) * 8 ) );
+
+        // Kernel ignores the last bit of maxnode
+        if( syscall( SYS_mbind, data, size, MPOL_PREFERRED, nodeMask, nodeMaskBits + 1, 0 ) != 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Cannot bind stream buffer to numa node %d, errno: %d (%s)", m_numaNode, errno, strerror( errno ) );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     Prefault
+    //
+    // Description:
+    //     Touches every page of the buffer, so reads do not fault on it.
+    //
+    // Input:
+    //     uint8_t*     data - buffer
+    //     const size_t size - buffer size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CBufferProviderLinux::Prefault( uint8_t* data, const size_t size )
+    {
+        volatile uint8_t* page = data;
+
+        for( size_t offset = 0; offset < size; offset += m_pageSize )
+        {
+            page[offset] = 0;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CBufferProviderLinux
+    //
+    // Method:
+    //     ReadCpuList
+    //
+    // Description:
+    //     Reads SysFs CPU list, like "0-7,16-23", into the local CPU set.
+    //
+    // Input:
+    //     const char* filePath - CPU list file path
+    //
+    // Output:
+    //     bool                 - *true* if at least one CPU was read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CBufferProviderLinux::ReadCpuList( const char* filePath )
+    {
+        char  cpuList[4096] = { 0 };
+        FILE* file          = fopen( filePath, "r" );
+
+        if( file == nullptr )
+        {
+            return false;
+        }
+
+        const bool read = fgets( cpuList, sizeof( cpuList ), file ) != nullptr;
+        fclose( file );
+
+        if( !read )
+        {
+            return false;
+        }
+
+        CPU_ZERO( &m_localCpus );
+
+        char* position = cpuList;
+        while( *position >= '0' && *position <= '9' )
+        {
+            const uint32_t first = static_cast<uint32_t>( strtoul( position, &position, 10 ) );
+            uint32_t       last  = first;
+
+            if( *position == '-' )
+            {
+                last = static_cast<uint32_t>( strtoul( position + 1, &position, 10 ) );
+            }
+
+            for( uint32_t cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu )
+            {
+                CPU_SET( cpu, &m_localCpus );
+            }
+
+            if( *position == ',' )
+            {
+                ++position;
+            }
+        }
+
+        return CPU_COUNT( &m_localCpus ) > 0;
+    }
+} // namespace MetricsDiscoveryInternal
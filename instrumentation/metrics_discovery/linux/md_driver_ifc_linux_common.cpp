@@ -11,6 +11,10 @@ SPDX-License-Identifier: MIT
 //     Abstract:   C++ common implementation for Linux
 
 #include "md_driver_ifc_linux_perf.h"
+#include "md_driver_ifc_linux_replay.h"
+#include "md_io_stream_group_linux.h"
+#include "md_io_stream_reader_linux.h"
+#include "md_side_band_sampler_linux.h"
 #include "md_adapter.h"
 #include "md_metrics_device.h"
 #include "md_metric_set.h"
@@ -25,7 +29,7 @@ SPDX-License-Identifier: MIT
 #include <vector>
 #include <string>
 #include <functional> // for std::hash
-#include <algorithm>  // for std::find, std::remove
+#include <algorithm>  // for std::find, std::remove, std::min
 #include <iomanip>
 #include <sstream>
 #include <regex>
@@ -230,26 +234,52 @@ namespace MetricsDiscoveryInternal
     //
     // Description:
     //     Returns instance of CDriverInterface for Linux supporting Perf.
+    //     If MD_DRIVER_REPLAY is set, the driver record file is replayed instead
+    //     of the DRM device. If MD_DRIVER_RECORD is set, driver calls are recorded.
+    //
+    // Input:
+    //     CAdapterHandle&           adapterHandle - adapter handle
+    //     const TAdapterParams_1_9& adapterParams - adapter params
     //
     // Output:
     //     CDriverInterface* - Pointer to new allocated object of CDriverInterfaceLinuxCommon
     //
     //////////////////////////////////////////////////////////////////////////////
-    CDriverInterface* CDriverInterface::CreateInstance( CAdapterHandle& adapterHandle )
+    CDriverInterface* CDriverInterface::CreateInstance( CAdapterHandle& adapterHandle, const TAdapterParams_1_9& adapterParams )
     {
-        // Initialize DRM.
         CDriverInterface* driverInterface = nullptr;
+        const char*       replayFile      = iu_dupenv_s( MD_DRIVER_REPLAY );
+        const char*       recordFile      = iu_dupenv_s( MD_DRIVER_RECORD );
 
-        switch( CDriverInterfaceLinuxCommon::GetDrmVersion( static_cast<CAdapterHandleLinux&>( adapterHandle ) ) )
+        if( replayFile != nullptr )
         {
-            case DRM_VERSION_I915:
-                MD_LOG( LOG_INFO, "Initializing i915..." );
-                driverInterface = new( std::nothrow ) CDriverInterfaceLinuxPerf( adapterHandle );
-                break;
+            const char* paced   = iu_dupenv_s( MD_DRIVER_REPLAY_PACED );
+            const bool  isPaced = ( paced != nullptr ) && ( strtoul( paced, nullptr, 0 ) != 0 );
 
-            default:
-                MD_LOG( LOG_ERROR, "ERROR: Wrong DRM version!" );
-                break;
+            MD_LOG( LOG_INFO, "Initializing replay..." );
+            driverInterface = new( std::nothrow ) CDriverInterfaceLinuxReplay( adapterHandle, replayFile, isPaced );
+
+            if( paced != nullptr )
+            {
+                free( (void*) paced );
+            }
+        }
+        else
+        {
+            // Initialize DRM.
+            switch( CDriverInterfaceLinuxCommon::GetDrmVersion( static_cast<CAdapterHandleLinux&>( adapterHandle ) ) )
+            {
+                case DRM_VERSION_I915:
+                    MD_LOG( LOG_INFO, "Initializing i915..." );
+                    driverInterface = ( recordFile != nullptr )
+                        ? new( std::nothrow ) CDriverInterfaceLinuxRecorder( adapterHandle, adapterParams, recordFile )
+                        : new( std::nothrow ) CDriverInterfaceLinuxPerf( adapterHandle );
+                    break;
+
+                default:
+                    MD_LOG( LOG_ERROR, "ERROR: Wrong DRM version!" );
+                    break;
+            }
         }
 
         if( ( driverInterface != nullptr ) && ( driverInterface->CreateContext() == false ) )
@@ -257,6 +287,15 @@ namespace MetricsDiscoveryInternal
             MD_SAFE_DELETE( driverInterface );
         }
 
+        if( replayFile != nullptr )
+        {
+            free( (void*) replayFile );
+        }
+        if( recordFile != nullptr )
+        {
+            free( (void*) recordFile );
+        }
+
         return driverInterface;
     }
 
@@ -287,6 +326,7 @@ namespace MetricsDiscoveryInternal
     // Description:
     //     Linux implementation of static function GetAvailableAdapters.
     //     Enumerates all available adapters in the system and return Intel ones.
+    //     If MD_DRIVER_REPLAY is set, only the recorded adapter is returned.
     //
     // Input:
     //     std::vector<TAdapterData>& adapters  - [out] available Intel adapters
@@ -297,6 +337,15 @@ namespace MetricsDiscoveryInternal
     //////////////////////////////////////////////////////////////////////////////
     TCompletionCode CDriverInterface::GetAvailableAdapters( std::vector<TAdapterData>& adapters )
     {
+        const char* replayFile = iu_dupenv_s( MD_DRIVER_REPLAY );
+        if( replayFile != nullptr )
+        {
+            TCompletionCode ret = CDriverInterfaceLinuxReplay::GetReplayAdapters( replayFile, adapters );
+
+            free( (void*) replayFile );
+            return ret;
+        }
+
         // The maximum number of drm devices is 64, see:
         // https://git.kernel.org/pub/scm/linux/kernel/git/stable/linux.git/tree/drivers/gpu/drm/drm_drv.c#n110
         const uint32_t DRM_MAX_DEVICES = 64;
@@ -496,12 +545,17 @@ namespace MetricsDiscoveryInternal
         : m_DrmDeviceHandle( static_cast<CAdapterHandleLinux&>( adapterHandle ) )
         , m_DrmCardNumber( -1 )
         , m_DrmVersion( drmVersion )
+        , m_SysFsCache()
         , m_CachedBoostFrequency( 0 )
         , m_CachedMinFrequency( 0 )
         , m_CachedMaxFrequency( 0 )
         , m_CachedGfxDeviceInfo{ GTDI_PLATFORM_MAX, GFX_GTTYPE_UNDEFINED, 0 }
         , m_CachedDeviceId( -1 )
         , m_CachedRevisionId( -1 )
+        , m_IoStreamReaders()
+        , m_IoStreamReadersMutex()
+        , m_CompletedOaStreamReads()
+        , m_DrainedOaStreamReports()
     {
     }
 
@@ -520,6 +574,13 @@ namespace MetricsDiscoveryInternal
     CDriverInterfaceLinuxCommon::~CDriverInterfaceLinuxCommon()
     {
         MD_LOG_ENTER_A( m_adapterId );
+
+        for( auto& reader : m_IoStreamReaders )
+        {
+            MD_SAFE_DELETE( reader.second );
+        }
+        m_IoStreamReaders.clear();
+
         DeleteContext();
         MD_LOG_EXIT_A( m_adapterId );
     }
@@ -1463,7 +1524,7 @@ namespace MetricsDiscoveryInternal
     //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
     //     uint32_t            processId         - PID of the measured app (0 is global context)
     //     uint32_t&           nsTimerPeriod     - (in/out) requested/set sampling period time in nanoseconds
-    //     uint32_t&           bufferSize        - (in/out) requested/set OA Buffer/buffer size in bytes
+    //     uint32_t&           bufferSize        - (in/out) requested/set OA Buffer/buffer size in bytes, 0 means default
     //
     // Output:
     //     TCompletionCode                       - *CC_OK* means succeess
@@ -1492,7 +1553,10 @@ namespace MetricsDiscoveryInternal
         // 2. SET PARAMS
         const uint32_t timerPeriodExponent = GetTimerPeriodExponent( nsTimerPeriod );
         const uint32_t oaReportType        = GetOaReportType( metricSet->GetReportType() );
+        const uint32_t reportSize          = metricSet->GetParams()->RawReportSize;
         int32_t        oaMetricSetId       = -1;
+        uint32_t       oaBufferSize        = 0;
+        uint32_t       pollPeriodNs        = 0;
         uint32_t       regCount            = 0;
         TRegister**    regVector           = metricSet->GetStartConfiguration( regCount );
 
@@ -1503,7 +1567,7 @@ namespace MetricsDiscoveryInternal
         }
 
         // 3. ADD HW CONFIG
-        ret = AddOaConfig( regVector, regCount, metricsDevice.GetSubDeviceIndex(), nullptr, oaMetricSetId );
+        ret = AcquireOaConfig( regVector, regCount, metricsDevice.GetSubDeviceIndex(), oaMetricSetId );
         if( ret != CC_OK )
         {
             goto deactivate;
@@ -1511,23 +1575,45 @@ namespace MetricsDiscoveryInternal
         MD_ASSERT_A( m_adapterId, oaMetricSetId != -1 );
 
         // 4. OPEN STREAM
-        ret = OpenOaStream( metricsDevice, oaMetricSetId, oaReportType, timerPeriodExponent, bufferSize, oaConcurrentGroup.GetOaBufferType() );
+        oaBufferSize = GetOaBufferSize( oaConcurrentGroup.GetIoStreamOaBufferParams(), bufferSize, GetNsTimerPeriod( timerPeriodExponent ), reportSize );
+        pollPeriodNs = GetOaPollPeriod( oaConcurrentGroup.GetIoStreamPollParams(), GetNsTimerPeriod( timerPeriodExponent ), oaBufferSize, reportSize );
+
+        ret = OpenOaStream( metricsDevice, oaMetricSetId, oaReportType, timerPeriodExponent, oaBufferSize, oaConcurrentGroup.GetOaBufferType(), pollPeriodNs, oaConcurrentGroup.IsIoStreamPaused() );
         if( ret != CC_OK )
         {
             goto remove_config;
         }
+        metricsDevice.SetStreamPaused( oaConcurrentGroup.IsIoStreamPaused() );
+
+        // Stream buffer is allocated near the device and faulted in before the first read
+        metricsDevice.GetStreamBuffer().SetProvider( &m_BufferProvider );
+        if( metricsDevice.GetStreamBuffer().Reserve( MD_STREAM_BUFFER_PREALLOCATED ) != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Stream buffer not preallocated" );
+        }
+
+        // 5. START BACKGROUND READER
+        if( oaConcurrentGroup.GetIoStreamReaderParams().Enabled )
+        {
+            ret = StartIoStreamReader( oaConcurrentGroup );
+            if( ret != CC_OK )
+            {
+                CloseOaStream( metricsDevice );
+                goto remove_config;
+            }
+        }
 
-        // 5. RETURN PARAMETERS
+        // 6. RETURN PARAMETERS
         nsTimerPeriod = GetNsTimerPeriod( timerPeriodExponent );
-        bufferSize    = MD_OA_BUFFER_SIZE_MAX;
+        bufferSize    = oaBufferSize;
 
         metricsDevice.SetStreamConfigId( oaMetricSetId ); // Remember oa config id so it could be removed from the kernel on CloseIoStream
 
-        MD_LOG_A( m_adapterId, LOG_DEBUG, "Oa stream opened with metricSetId: %d, periodNs: %u, exponent: %u, bufferSize: %u", oaMetricSetId, nsTimerPeriod, timerPeriodExponent, bufferSize );
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Oa stream opened with metricSetId: %d, periodNs: %u, exponent: %u, bufferSize: %u, pollPeriodNs: %u, paused: %u", oaMetricSetId, nsTimerPeriod, timerPeriodExponent, bufferSize, pollPeriodNs, metricsDevice.IsStreamPaused() );
         return CC_OK;
 
     remove_config:
-        RemoveOaConfig( oaMetricSetId );
+        ReleaseOaConfig( oaMetricSetId );
     deactivate:
         metricSet->Deactivate();
         return ret;
@@ -1572,6 +1658,39 @@ namespace MetricsDiscoveryInternal
         const uint32_t bytesToRead = reportsCount * reportSize;
         uint32_t       readBytes   = 0;
 
+        // Background reader drains the stream, only copy from its ring
+        CIoStreamReader* reader = GetIoStreamReader( oaConcurrentGroup.GetMetricsDevice() );
+        if( reader )
+        {
+            const uint32_t        reportsToRead = reportsCount;
+            const TCompletionCode readerResult  = reader->GetThreadResult(); // Loaded before the pop, so it sees all reports pushed before the exit
+
+            reportsCount = reader->Pop( reportData, reportsToRead, exceptions );
+            GetIoStreamFrequency( frequency );
+
+            // Reader thread error is returned once all reports it read are consumed
+            if( reportsCount == 0 && readerResult != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: IoStream reader exited" );
+                return readerResult;
+            }
+
+            return ( reportsCount < reportsToRead ) ? CC_READ_PENDING : CC_OK;
+        }
+
+        // Reports drained before a pause are returned first
+        const uint8_t* drainedData    = nullptr;
+        const uint32_t reportsToRead  = reportsCount;
+        const uint32_t drainedReports = TakeDrainedOaStreamReports( oaConcurrentGroup.GetMetricsDevice(), reportSize, reportsToRead, drainedData, exceptions );
+        if( drainedReports )
+        {
+            iu_memcpy_s( reportData, bytesToRead, drainedData, static_cast<size_t>( drainedReports ) * reportSize );
+            reportsCount = drainedReports;
+            GetIoStreamFrequency( frequency );
+
+            return ( drainedReports < reportsToRead ) ? CC_READ_PENDING : CC_OK;
+        }
+
         // Read flags are ignored for Linux
         TCompletionCode ret = ReadOaStream( oaConcurrentGroup.GetMetricsDevice(), reportSize, reportsCount, reportData, readBytes, exceptions );
         if( ret == CC_OK )
@@ -1584,17 +1703,230 @@ namespace MetricsDiscoveryInternal
                 ret = CC_READ_PENDING;
             }
 
-            // Read gpu frequency
-            uint64_t currentFrequency = 0;
-            if( GetGpuFrequencyInfo( nullptr, nullptr, &currentFrequency, nullptr ) == CC_OK )
+            GetIoStreamFrequency( frequency );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     ReadIoStreamView
+    //
+    // Description:
+    //     Reads data from previously opened OA/Sys IO Stream without copying reports
+    //     out of the metrics device stream buffer. Read reports are described by
+    //     metrics device stream spans, valid until the next read.
+    //
+    // Input:
+    //     COAConcurrentGroup&              oaConcurrentGroup - oa concurrent group
+    //     uint32_t                         readFlags         - read flags
+    //     uint32_t&                        reportsCount      - (in/out) reports read/to read from the stream
+    //     uint32_t&                        frequency         - (out) frequency from GTDIReadCounterStreamExtOut
+    //     GTDIReadCounterStreamExceptions& exceptions        - (out) exceptions from GTDIReadCounterStreamExtOut
+    //
+    // Output:
+    //     TCompletionCode                                    - *CC_OK* means succeess
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxCommon::ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        if( !IsStreamTypeSupported( oaConcurrentGroup.GetStreamType() ) )
+        {
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        auto metricSet = oaConcurrentGroup.GetIoMetricSet();
+
+        MD_CHECK_PTR_RET_A( m_adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
+
+        const uint32_t reportSize    = metricSet->GetParams()->RawReportSize;
+        const uint32_t reportsToRead = reportsCount;
+
+        if( GetIoStreamReader( oaConcurrentGroup.GetMetricsDevice() ) )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream buffer is owned by the background reader" );
+            reportsCount = 0;
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        // Reports drained before a pause are returned first
+        const uint8_t* drainedData    = nullptr;
+        const uint32_t drainedReports = TakeDrainedOaStreamReports( oaConcurrentGroup.GetMetricsDevice(), reportSize, reportsToRead, drainedData, exceptions );
+        if( drainedReports )
+        {
+            auto& streamSpans = oaConcurrentGroup.GetMetricsDevice().GetStreamSpans();
+
+            streamSpans.clear();
+            streamSpans.push_back( { drainedData, reportSize, drainedReports } );
+
+            reportsCount = drainedReports;
+            GetIoStreamFrequency( frequency );
+
+            return ( drainedReports < reportsToRead ) ? CC_READ_PENDING : CC_OK;
+        }
+
+        // Read flags are ignored for Linux
+        TCompletionCode ret = ReadOaStreamView( oaConcurrentGroup.GetMetricsDevice(), reportSize, reportsToRead, reportsCount, exceptions );
+        if( ret == CC_OK )
+        {
+            if( reportsCount < reportsToRead )
             {
-                frequency = static_cast<uint32_t>( currentFrequency / MD_MHERTZ );
+                ret = CC_READ_PENDING;
             }
+
+            GetIoStreamFrequency( frequency );
         }
 
         return ret;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     PauseIoStream
+    //
+    // Description:
+    //     Stops or restarts sampling of the opened OA stream without closing it.
+    //     The stream keeps its configuration and OA buffer. The kernel fails reads
+    //     of a disabled stream and resets the OA buffer when it is enabled again,
+    //     so reports sampled before the pause are drained first, into the background
+    //     reader ring or, without a reader, into a buffer returned by the following
+    //     reads. Reads of a paused stream return no other reports.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group with an opened stream
+    //     const bool          pause             - *true* to pause, *false* to resume
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means succeess
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxCommon::PauseIoStream( COAConcurrentGroup& oaConcurrentGroup, const bool pause )
+    {
+        if( !IsStreamTypeSupported( oaConcurrentGroup.GetStreamType() ) )
+        {
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        auto& metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+
+        if( metricsDevice.GetStreamConfigId() == -1 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Oa stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+
+        if( metricsDevice.IsStreamPaused() == pause )
+        {
+            return CC_OK;
+        }
+
+        if( pause )
+        {
+            auto metricSet = oaConcurrentGroup.GetIoMetricSet();
+
+            MD_CHECK_PTR_RET_A( m_adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
+
+            CIoStreamReader*      reader      = GetIoStreamReader( metricsDevice );
+            const TCompletionCode drainResult = reader
+                ? reader->Drain( MD_IO_STREAM_READER_DRAIN_TIMEOUT_MS )
+                : DrainOaStream( metricsDevice, metricSet->GetParams()->RawReportSize );
+
+            // A reader drain not finished in time loses only the reports sampled meanwhile
+            if( drainResult != CC_OK && drainResult != CC_WAIT_TIMEOUT )
+            {
+                return drainResult;
+            }
+        }
+
+        // Paused state is set before disabling, so a concurrent read failing on
+        // the disabled stream is not treated as an error
+        if( pause )
+        {
+            metricsDevice.SetStreamPaused( true );
+        }
+
+        TCompletionCode ret = EnableOaStream( metricsDevice, !pause );
+        if( ret != CC_OK )
+        {
+            metricsDevice.SetStreamPaused( !pause );
+            return ret;
+        }
+
+        metricsDevice.SetStreamPaused( pause );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Oa stream %s", pause ? "paused" : "resumed" );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     SwitchIoStream
+    //
+    // Description:
+    //     Changes configuration of the opened OA stream to the given metric set
+    //     of the same concurrent group, without closing the stream. The concurrent
+    //     group stays locked by the stream, the previous configuration is released.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group with an opened stream
+    //     CMetricSet&         metricSet         - metric set to switch to
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means succeess
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxCommon::SwitchIoStream( COAConcurrentGroup& oaConcurrentGroup, CMetricSet& metricSet )
+    {
+        if( !IsStreamTypeSupported( oaConcurrentGroup.GetStreamType() ) )
+        {
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        auto&         metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+        const int32_t previousId    = metricsDevice.GetStreamConfigId();
+        int32_t       oaMetricSetId = -1;
+        uint32_t      regCount      = 0;
+        TRegister**   regVector     = metricSet.GetStartConfiguration( regCount );
+
+        if( previousId == -1 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Oa stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+
+        // 1. ADD HW CONFIG
+        TCompletionCode ret = AcquireOaConfig( regVector, regCount, metricsDevice.GetSubDeviceIndex(), oaMetricSetId );
+        MD_CHECK_CC_RET_A( m_adapterId, ret );
+
+        // 2. CHANGE STREAM CONFIG
+        ret = ChangeOaStreamConfig( metricsDevice, oaMetricSetId );
+        if( ret != CC_OK )
+        {
+            ReleaseOaConfig( oaMetricSetId );
+            return ret;
+        }
+
+        // 3. RELEASE PREVIOUS HW CONFIG
+        ReleaseOaConfig( previousId );
+        metricsDevice.SetStreamConfigId( oaMetricSetId );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Oa stream switched to metricSetId: %d, previous: %d", oaMetricSetId, previousId );
+        return CC_OK;
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -1626,13 +1958,15 @@ namespace MetricsDiscoveryInternal
         MD_CHECK_PTR_RET_A( m_adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
 
         // 1. CLOSE STREAM
+        StopIoStreamReader( metricsDevice );
         CloseOaStream( metricsDevice );
+        m_CompletedOaStreamReads.erase( &metricsDevice );
+        m_DrainedOaStreamReports.erase( &metricsDevice );
+        metricsDevice.SetStreamPaused( false );
 
-        // 2. REMOVE HW CONFIG
-        if( RemoveOaConfig( metricsDevice.GetStreamConfigId() ) == CC_OK )
-        {
-            metricsDevice.SetStreamConfigId( -1 );
-        }
+        // 2. RELEASE HW CONFIG
+        ReleaseOaConfig( metricsDevice.GetStreamConfigId() );
+        metricsDevice.SetStreamConfigId( -1 );
 
         // 3. DEACTIVATE
         TCompletionCode ret = metricSet->Deactivate();
@@ -1699,6 +2033,12 @@ namespace MetricsDiscoveryInternal
             return CC_ERROR_NOT_SUPPORTED;
         }
 
+        CIoStreamReader* reader = GetIoStreamReader( oaConcurrentGroup.GetMetricsDevice() );
+        if( reader )
+        {
+            return reader->WaitForReports( milliseconds );
+        }
+
         return WaitForOaStreamReports( oaConcurrentGroup.GetMetricsDevice(), milliseconds );
     }
 
@@ -1722,10 +2062,15 @@ namespace MetricsDiscoveryInternal
     //////////////////////////////////////////////////////////////////////////////
     bool CDriverInterfaceLinuxCommon::IsIoMeasurementInfoAvailable( const TIoMeasurementInfoType ioMeasurementInfoType )
     {
-        // Only ReportLost, BufferOverflow and Frequency during read available with Perf
+        // Only ReportLost, BufferOverflow and Frequency during read available with Perf.
+        // BufferOverrun is reported when the background reader ring is full.
+        // Sampling period is tracked by the concurrent group.
         return ioMeasurementInfoType == IO_MEASUREMENT_INFO_REPORT_LOST ||
             ioMeasurementInfoType == IO_MEASUREMENT_INFO_BUFFER_OVERFLOW ||
-            ioMeasurementInfoType == IO_MEASUREMENT_INFO_CORE_FREQUENCY_MHZ;
+            ioMeasurementInfoType == IO_MEASUREMENT_INFO_BUFFER_OVERRUN ||
+            ioMeasurementInfoType == IO_MEASUREMENT_INFO_CORE_FREQUENCY_MHZ ||
+            ioMeasurementInfoType == IO_MEASUREMENT_INFO_SAMPLING_PERIOD_NS ||
+            ioMeasurementInfoType == IO_MEASUREMENT_INFO_SAMPLING_PERIOD_CHANGED;
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -1765,42 +2110,318 @@ namespace MetricsDiscoveryInternal
     //     CDriverInterfaceLinuxCommon
     //
     // Method:
-    //     SetFrequencyOverride
+    //     CreateIoStreamGroup
     //
     // Description:
-    //     Enables / disables frequency override using CoreU function.
+    //     Creates an epoll based stream group. The caller takes ownership.
+    //
+    // Output:
+    //     IInternalIoStreamGroup* - created stream group, nullptr on error
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IInternalIoStreamGroup* CDriverInterfaceLinuxCommon::CreateIoStreamGroup()
+    {
+        CIoStreamGroupLinux* streamGroup = new( std::nothrow ) CIoStreamGroupLinux( m_adapterId, *this );
+        MD_CHECK_PTR_RET_A( m_adapterId, streamGroup, nullptr );
+
+        if( streamGroup->Initialize() != CC_OK )
+        {
+            MD_SAFE_DELETE( streamGroup );
+        }
+
+        return streamGroup;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     CreateSideBandSampler
+    //
+    // Description:
+    //     Creates a SysFs / hwmon sampler. Relative attributes are opened in
+    //     the DRM card SysFs directory unless another directory is given,
+    //     e.g. a copy of the SysFs tree. The caller takes ownership.
     //
     // Input:
-    //     const TSetFrequencyOverrideParams_1_2* params - frequency override params
+    //     const TSideBandSamplerParams& params - sampler parameters
     //
     // Output:
-    //     TCompletionCode                               - *CC_OK* means succeess
+    //     IInternalSideBandSampler*            - created sampler, nullptr on error
     //
     //////////////////////////////////////////////////////////////////////////////
-    TCompletionCode CDriverInterfaceLinuxCommon::SetFrequencyOverride( const TSetFrequencyOverrideParams_1_2* params )
+    IInternalSideBandSampler* CDriverInterfaceLinuxCommon::CreateSideBandSampler( const TSideBandSamplerParams& params )
     {
-        MD_CHECK_PTR_RET_A( m_adapterId, params, CC_ERROR_INVALID_PARAMETER );
-        if( params->Pid != 0 )
+        char directory[MD_MAX_PATH_LENGTH] = { 0 };
+        if( params.Directory != nullptr )
         {
-            MD_LOG_A( m_adapterId, LOG_WARNING, "Pid ignored, frequency override supported only in global mode (Pid = 0)" );
+            snprintf( directory, sizeof( directory ), "%s", params.Directory );
+        }
+        else
+        {
+            snprintf( directory, sizeof( directory ), "/sys/class/drm/card%d", m_DrmCardNumber );
         }
 
-        uint64_t minFrequency        = 0;
-        uint64_t maxFrequency        = 0;
-        uint64_t minFrequencyToSet   = 0;
-        uint64_t maxFrequencyToSet   = 0;
-        uint64_t boostFrequencyToSet = 0;
+        CSideBandSamplerLinux* sampler = new( std::nothrow ) CSideBandSamplerLinux( m_adapterId, params );
+        MD_CHECK_PTR_RET_A( m_adapterId, sampler, nullptr );
 
-        // Boost frequency needs to be remembered at the beginning for disable
-        uint64_t* boostFrequencyPtr = ( m_CachedBoostFrequency ) ? nullptr : &m_CachedBoostFrequency;
+        if( sampler->Initialize( directory ) != CC_OK )
+        {
+            MD_SAFE_DELETE( sampler );
+        }
 
-        // 1. Read Min/Max and optional Boost frequency
-        TCompletionCode ret = GetGpuFrequencyInfo( &minFrequency, &maxFrequency, nullptr, boostFrequencyPtr );
-        MD_CHECK_CC_RET_A( m_adapterId, ret );
+        return sampler;
+    }
 
-        MD_LOG_A( m_adapterId, LOG_DEBUG, "MinFreq: %llu, MaxFreq: %llu, BoostFreq: %llu MHz", minFrequency, maxFrequency, m_CachedBoostFrequency );
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     SetCompletedOaStreamRead
+    //
+    // Description:
+    //     Stores result of an oa stream read completed asynchronously into a stream
+    //     group buffer. The next ReadOaStreamView copies the completed data to
+    //     the metrics device stream buffer and parses it instead of reading the stream.
+    //
+    // Input:
+    //     CMetricsDevice& metricsDevice - metrics device
+    //     const int32_t   result        - read bytes or negative errno
+    //     const uint8_t*  data          - read data
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxCommon::SetCompletedOaStreamRead( CMetricsDevice& metricsDevice, const int32_t result, const uint8_t* data )
+    {
+        m_CompletedOaStreamReads[&metricsDevice] = { result, data };
+    }
 
-        // 2. Decide frequency values to be set (e.g. check range)
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     HasIoStreamReader
+    //
+    // Description:
+    //     Checks whether the stream is drained by a background reader, so it must
+    //     not be read by anyone else.
+    //
+    // Input:
+    //     CMetricsDevice& metricsDevice - metrics device
+    //
+    // Output:
+    //     bool                          - *true* if a background reader is running
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxCommon::HasIoStreamReader( CMetricsDevice& metricsDevice )
+    {
+        return GetIoStreamReader( metricsDevice ) != nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     TakeCompletedOaStreamRead
+    //
+    // Description:
+    //     Returns and forgets result of an oa stream read completed by a stream group.
+    //
+    // Input:
+    //     CMetricsDevice&         metricsDevice - metrics device
+    //     TCompletedOaStreamRead& completedRead - (OUT) completed read
+    //
+    // Output:
+    //     bool                                  - *true* if a completed read was available
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxCommon::TakeCompletedOaStreamRead( CMetricsDevice& metricsDevice, TCompletedOaStreamRead& completedRead )
+    {
+        auto it = m_CompletedOaStreamReads.find( &metricsDevice );
+        if( it == m_CompletedOaStreamReads.end() )
+        {
+            return false;
+        }
+
+        completedRead = it->second;
+        m_CompletedOaStreamReads.erase( it );
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     DrainOaStream
+    //
+    // Description:
+    //     Reads all reports available in the oa buffer of the enabled stream and
+    //     keeps them for the following stream reads. Called before the stream is
+    //     disabled, as the kernel fails reads of a disabled stream and resets
+    //     the oa buffer when the stream is enabled again.
+    //
+    // Input:
+    //     CMetricsDevice& metricsDevice - metrics device with an opened stream
+    //     const uint32_t  reportSize    - raw report size
+    //
+    // Output:
+    //     TCompletionCode               - *CC_OK* means succeess
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxCommon::DrainOaStream( CMetricsDevice& metricsDevice, const uint32_t reportSize )
+    {
+        auto&          drained     = m_DrainedOaStreamReports[&metricsDevice];
+        const uint32_t bytesToRead = MD_OA_PAUSE_DRAIN_REPORTS * reportSize;
+        uint32_t       readBytes   = bytesToRead;
+
+        // Reports returned already are dropped, those not read yet stay before the new ones
+        drained.Reports.erase( drained.Reports.begin(), drained.Reports.begin() + drained.Offset );
+        drained.Offset = 0;
+
+        while( readBytes == bytesToRead )
+        {
+            if( drained.Reports.size() >= MD_OA_PAUSE_DRAIN_SIZE_MAX )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Oa buffer drain stopped, reports are sampled faster than read" );
+                break;
+            }
+
+            const size_t                    drainedBytes = drained.Reports.size();
+            GTDIReadCounterStreamExceptions exceptions   = {};
+
+            drained.Reports.resize( drainedBytes + bytesToRead );
+            readBytes = 0;
+
+            const TCompletionCode ret = ReadOaStream( metricsDevice, reportSize, MD_OA_PAUSE_DRAIN_REPORTS, reinterpret_cast<char*>( drained.Reports.data() + drainedBytes ), readBytes, exceptions );
+
+            drained.Reports.resize( drainedBytes + readBytes );
+
+            if( ret == CC_ERROR_NOT_SUPPORTED )
+            {
+                // Copying reads not supported by the driver interface, nothing to drain
+                break;
+            }
+            if( ret != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Cannot drain oa buffer before pause" );
+                return ret;
+            }
+
+            drained.Exceptions.ReportLost     |= exceptions.ReportLost;
+            drained.Exceptions.BufferOverflow |= exceptions.BufferOverflow;
+            drained.Exceptions.BufferOverrun  |= exceptions.BufferOverrun;
+        }
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Oa buffer drained, reports: %zu", drained.Reports.size() / reportSize );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     TakeDrainedOaStreamReports
+    //
+    // Description:
+    //     Returns reports drained before the stream was paused and not read yet.
+    //     Returned reports are valid until the next read or pause of the stream.
+    //     A read completed by a stream group before the pause holds older reports,
+    //     so drained reports are returned only after it is consumed.
+    //
+    // Input:
+    //     CMetricsDevice&                  metricsDevice - metrics device
+    //     const uint32_t                   reportSize    - raw report size
+    //     const uint32_t                   reportsToRead - max reports to return
+    //     const uint8_t*&                  reportData    - (OUT) first returned report
+    //     GTDIReadCounterStreamExceptions& exceptions    - (OUT) exceptions of the drain reads
+    //
+    // Output:
+    //     uint32_t                                       - returned reports, 0 if none
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CDriverInterfaceLinuxCommon::TakeDrainedOaStreamReports( CMetricsDevice& metricsDevice, const uint32_t reportSize, const uint32_t reportsToRead, const uint8_t*& reportData, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        auto it = m_DrainedOaStreamReports.find( &metricsDevice );
+        if( it == m_DrainedOaStreamReports.end() || m_CompletedOaStreamReads.count( &metricsDevice ) )
+        {
+            return 0;
+        }
+
+        auto&        drained          = it->second;
+        const size_t availableReports = ( drained.Reports.size() - drained.Offset ) / reportSize;
+
+        // Freed on the read following the last returned reports, they are valid until then
+        if( availableReports == 0 )
+        {
+            m_DrainedOaStreamReports.erase( it );
+            return 0;
+        }
+
+        const uint32_t reportCount = static_cast<uint32_t>( std::min<size_t>( availableReports, reportsToRead ) );
+
+        reportData         = drained.Reports.data() + drained.Offset;
+        exceptions         = drained.Exceptions;
+        drained.Exceptions = {};
+
+        drained.Offset += static_cast<size_t>( reportCount ) * reportSize;
+
+        return reportCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     SetFrequencyOverride
+    //
+    // Description:
+    //     Enables / disables frequency override using CoreU function.
+    //
+    // Input:
+    //     const TSetFrequencyOverrideParams_1_2* params - frequency override params
+    //
+    // Output:
+    //     TCompletionCode                               - *CC_OK* means succeess
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxCommon::SetFrequencyOverride( const TSetFrequencyOverrideParams_1_2* params )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, params, CC_ERROR_INVALID_PARAMETER );
+        if( params->Pid != 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "Pid ignored, frequency override supported only in global mode (Pid = 0)" );
+        }
+
+        uint64_t minFrequency        = 0;
+        uint64_t maxFrequency        = 0;
+        uint64_t minFrequencyToSet   = 0;
+        uint64_t maxFrequencyToSet   = 0;
+        uint64_t boostFrequencyToSet = 0;
+
+        // Boost frequency needs to be remembered at the beginning for disable
+        uint64_t* boostFrequencyPtr = ( m_CachedBoostFrequency ) ? nullptr : &m_CachedBoostFrequency;
+
+        // 1. Read Min/Max and optional Boost frequency
+        TCompletionCode ret = GetGpuFrequencyInfo( &minFrequency, &maxFrequency, nullptr, boostFrequencyPtr );
+        MD_CHECK_CC_RET_A( m_adapterId, ret );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "MinFreq: %llu, MaxFreq: %llu, BoostFreq: %llu MHz", minFrequency, maxFrequency, m_CachedBoostFrequency );
+
+        // 2. Decide frequency values to be set (e.g. check range)
         if( params->Enable )
         {
             if( params->FrequencyMhz == 0 )
@@ -2036,6 +2657,214 @@ namespace MetricsDiscoveryInternal
         return retVal;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     GetIoStreamReader
+    //
+    // Description:
+    //     Returns background reader of the stream opened on the given metrics device.
+    //
+    // Input:
+    //     CMetricsDevice& metricsDevice - metrics device
+    //
+    // Output:
+    //     CIoStreamReader* - reader, nullptr if the stream is read directly
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamReader* CDriverInterfaceLinuxCommon::GetIoStreamReader( CMetricsDevice& metricsDevice )
+    {
+        std::lock_guard<std::mutex> lock( m_IoStreamReadersMutex );
+
+        auto it = m_IoStreamReaders.find( &metricsDevice );
+
+        return ( it != m_IoStreamReaders.end() ) ? it->second : nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     StartIoStreamReader
+    //
+    // Description:
+    //     Creates and starts background reader of the opened oa stream.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxCommon::StartIoStreamReader( COAConcurrentGroup& oaConcurrentGroup )
+    {
+        auto&          metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+        const uint32_t reportSize    = oaConcurrentGroup.GetIoMetricSet()->GetParams()->RawReportSize;
+
+        MD_ASSERT_A( m_adapterId, GetIoStreamReader( metricsDevice ) == nullptr );
+
+        CIoStreamReader* reader = new( std::nothrow ) CIoStreamReader( m_adapterId, reportSize, oaConcurrentGroup.GetIoStreamReaderParams(), m_BufferProvider );
+        MD_CHECK_PTR_RET_A( m_adapterId, reader, CC_ERROR_NO_MEMORY );
+
+        auto ret = reader->Start(
+            [this, &metricsDevice, reportSize]( CIoStreamReader& threadReader )
+            {
+                RunIoStreamReader( threadReader, metricsDevice, reportSize );
+            } );
+
+        if( ret != CC_OK )
+        {
+            MD_SAFE_DELETE( reader );
+            return ret;
+        }
+
+        std::lock_guard<std::mutex> lock( m_IoStreamReadersMutex );
+
+        m_IoStreamReaders[&metricsDevice] = reader;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     StopIoStreamReader
+    //
+    // Description:
+    //     Stops and deletes background reader of the stream, if any. Must be called
+    //     before the stream is closed.
+    //
+    // Input:
+    //     CMetricsDevice& metricsDevice - metrics device
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxCommon::StopIoStreamReader( CMetricsDevice& metricsDevice )
+    {
+        CIoStreamReader* reader = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock( m_IoStreamReadersMutex );
+
+            auto it = m_IoStreamReaders.find( &metricsDevice );
+            if( it != m_IoStreamReaders.end() )
+            {
+                reader = it->second;
+                m_IoStreamReaders.erase( it );
+            }
+        }
+
+        // Joins the reader thread, so outside of the lock
+        MD_SAFE_DELETE( reader );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     RunIoStreamReader
+    //
+    // Description:
+    //     Background reader thread body. Waits for the stream data and drains it
+    //     into the reader ring until stop is requested. The metrics device stream
+    //     buffer is used by this thread only while the reader is running. A drain
+    //     request is completed once a wait times out or a read returns less than
+    //     a batch, both meaning the stream is empty.
+    //
+    // Input:
+    //     CIoStreamReader& reader        - reader
+    //     CMetricsDevice&  metricsDevice - metrics device with opened stream
+    //     const uint32_t   reportSize    - raw report size
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxCommon::RunIoStreamReader( CIoStreamReader& reader, CMetricsDevice& metricsDevice, const uint32_t reportSize )
+    {
+        while( !reader.IsStopRequested() )
+        {
+            const uint64_t drainRequest = reader.GetDrainRequest();
+
+            auto ret = WaitForOaStreamReports( metricsDevice, MD_IO_STREAM_READER_POLL_TIMEOUT_MS );
+            if( ret == CC_WAIT_TIMEOUT )
+            {
+                reader.CompleteDrain( drainRequest );
+                continue;
+            }
+            if( ret == CC_INTERRUPTED )
+            {
+                continue;
+            }
+            if( ret != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: IoStream reader wait failed, reader exits" );
+                reader.SetThreadResult( ret );
+                break;
+            }
+
+            uint32_t                        readReports = 0;
+            GTDIReadCounterStreamExceptions exceptions  = {};
+
+            ret = ReadOaStreamView( metricsDevice, reportSize, reader.GetBatchReportCount(), readReports, exceptions );
+            if( ret != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: IoStream reader read failed, reader exits" );
+                reader.SetThreadResult( ret );
+                break;
+            }
+
+            reader.AddExceptions( exceptions );
+
+            for( const auto& span : metricsDevice.GetStreamSpans() )
+            {
+                for( uint32_t i = 0; i < span.ReportCount; ++i )
+                {
+                    reader.Push( span.Data + static_cast<size_t>( i ) * span.Stride );
+                }
+            }
+
+            if( readReports )
+            {
+                reader.NotifyReports();
+            }
+            if( readReports < reader.GetBatchReportCount() )
+            {
+                reader.CompleteDrain( drainRequest );
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     GetIoStreamFrequency
+    //
+    // Description:
+    //     Reads current gpu frequency reported with every IoStream read.
+    //
+    // Input:
+    //     uint32_t& frequency - (OUT) frequency in MHz, unchanged on failure
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxCommon::GetIoStreamFrequency( uint32_t& frequency )
+    {
+        uint64_t currentFrequency = 0;
+        if( GetGpuFrequencyInfo( nullptr, nullptr, &currentFrequency, nullptr ) == CC_OK )
+        {
+            frequency = static_cast<uint32_t>( currentFrequency / MD_MHERTZ );
+        }
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -2152,17 +2981,17 @@ namespace MetricsDiscoveryInternal
     {
         MD_ASSERT_A( m_adapterId, m_DrmCardNumber >= 0 );
 
-        char     filePath[MD_MAX_PATH_LENGTH];
+        char     fileName[MD_MAX_PATH_LENGTH];
         uint64_t metricSetId = -1;
 
-        // Read oa metric set ID based on GUID
-        snprintf( filePath, sizeof( filePath ), "/sys/class/drm/card%d/metrics/%s/id", m_DrmCardNumber, guid );
+        // Read oa metric set ID based on GUID, the file is removed with the configuration so it is not kept open
+        snprintf( fileName, sizeof( fileName ), "metrics/%s/id", guid );
 
-        TCompletionCode ret = ReadUInt64FromFile( filePath, &metricSetId );
+        TCompletionCode ret = m_SysFsCache.ReadUncached( fileName, &metricSetId );
         MD_CHECK_CC_RET_A( m_adapterId, ret );
         if( !metricSetId )
         {
-            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Invalid oa config id read from %s", filePath );
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Invalid oa config id read from %s", fileName );
             return CC_ERROR_GENERAL;
         }
 
@@ -2170,6 +2999,114 @@ namespace MetricsDiscoveryInternal
         return CC_OK;
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     AcquireOaConfig
+    //
+    // Description:
+    //     Returns kernel id of the OA configuration with the given registers,
+    //     adding it only if it is neither cached nor already added by another
+    //     process. A cached configuration of another process is checked to be
+    //     still added under the same id, as its owner may remove it. Only
+    //     configurations added by this call are owned and later removed. Has to
+    //     be released with ReleaseOaConfig.
+    //
+    // Input:
+    //     TRegister**    regVector      - array of pointers to configuration registers
+    //     const uint32_t regCount       - register count
+    //     const uint32_t subDeviceIndex - sub device index
+    //     int32_t&       oaConfigId     - (out) oa configuration id, -1 if error
+    //
+    // Output:
+    //     TCompletionCode               - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxCommon::AcquireOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, int32_t& oaConfigId )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, regVector, CC_ERROR_INVALID_PARAMETER );
+
+        char guid[MD_PERF_GUID_LENGTH];
+        COaConfigCache::GetGuid( regVector, regCount, subDeviceIndex, guid, sizeof( guid ) );
+
+        bool owned = false;
+        if( m_OaConfigCache.Acquire( guid, oaConfigId, owned ) )
+        {
+            int32_t currentConfigId = -1;
+            if( owned || ( GetOaMetricSetId( guid, currentConfigId ) == CC_OK && currentConfigId == oaConfigId ) )
+            {
+                MD_LOG_A( m_adapterId, LOG_DEBUG, "Reusing cached oa configuration %s, id: %d", guid, oaConfigId );
+                return CC_OK;
+            }
+
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Cached oa configuration %s, id: %d, removed by its owner", guid, oaConfigId );
+            m_OaConfigCache.Discard( guid );
+        }
+
+        // Configuration added by another process is reused, but not removed by this one
+        TCompletionCode ret = CC_ERROR_GENERAL;
+        if( OaMetricSetExists( guid ) )
+        {
+            ret = GetOaMetricSetId( guid, oaConfigId );
+        }
+
+        // Also if removed by its owner meanwhile. An add racing with another process reuses its configuration.
+        bool added = false;
+        if( ret != CC_OK )
+        {
+            ret = AddOaConfig( regVector, regCount, subDeviceIndex, guid, oaConfigId, &added );
+        }
+
+        if( ret != CC_OK )
+        {
+            oaConfigId = -1;
+            return ret;
+        }
+
+        m_OaConfigCache.Insert( guid, oaConfigId, added );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     ReleaseOaConfig
+    //
+    // Description:
+    //     Releases OA configuration acquired with AcquireOaConfig. The configuration
+    //     stays added to the kernel for next streams, unless it is evicted from
+    //     the cache.
+    //
+    // Input:
+    //     const int32_t oaConfigId - oa configuration id, -1 is ignored
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxCommon::ReleaseOaConfig( const int32_t oaConfigId )
+    {
+        if( oaConfigId == -1 )
+        {
+            return;
+        }
+
+        std::vector<int32_t> evictedConfigIds;
+        if( !m_OaConfigCache.Release( oaConfigId, evictedConfigIds ) )
+        {
+            RemoveOaConfig( oaConfigId );
+            return;
+        }
+
+        for( int32_t evictedConfigId : evictedConfigIds )
+        {
+            RemoveOaConfig( evictedConfigId );
+        }
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
@@ -2232,6 +3169,17 @@ namespace MetricsDiscoveryInternal
             return false;
         }
 
+        // Adapter id is needed for logging of the caches below
+        AcquireAdapterId();
+
+        if( m_SysFsCache.Initialize( m_adapterId, m_DrmCardNumber ) != CC_OK )
+        {
+            // Not fatal, SysFs reads will fail separately
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Failed to initialize SysFs cache" );
+        }
+
+        m_BufferProvider.Initialize( m_adapterId, m_DrmCardNumber );
+
         MD_LOG_A( m_DrmCardNumber, LOG_DEBUG, "DRM initalized successfully" ); // should NOT use m_DrmCardNumber as adapter id if
                                                                                // we ever stop using drm card number as adapter id.
         return true;
@@ -2251,6 +3199,7 @@ namespace MetricsDiscoveryInternal
     //////////////////////////////////////////////////////////////////////////////
     void CDriverInterfaceLinuxCommon::DeinitializeIntelDrm()
     {
+        m_SysFsCache.Clear();
         m_DrmCardNumber = -1;
         MD_LOG_A( m_adapterId, LOG_DEBUG, "DRM deinitialized" );
     }
@@ -2346,25 +3295,23 @@ namespace MetricsDiscoveryInternal
     //
     // Description:
     //     Reads a 64-bit unsigned value from the given SysFs file. SysFs path is
-    //     based on DRM card number.
+    //     based on DRM card number. The file is kept open by the SysFs cache.
     //
     // Input:
-    //     const char* fileName  - name of SysFs file to read
-    //     uint64_t*   readValue - (OUT) read value (content of the file)
+    //     const char* fileName    - name of SysFs file to read
+    //     uint64_t*   readValue   - (OUT) read value (content of the file)
+    //     const bool  rateLimited - if true, a value read within the refresh interval is reused
     //
     // Output:
-    //     TCompletionCode       - *CC_OK* means success
+    //     TCompletionCode         - *CC_OK* means success
     //
     //////////////////////////////////////////////////////////////////////////////
-    TCompletionCode CDriverInterfaceLinuxCommon::ReadSysFsFile( const char* fileName, uint64_t* readValue )
+    TCompletionCode CDriverInterfaceLinuxCommon::ReadSysFsFile( const char* fileName, uint64_t* readValue, const bool rateLimited /* = false */ )
     {
         MD_CHECK_PTR_RET_A( m_adapterId, fileName, CC_ERROR_INVALID_PARAMETER );
         MD_ASSERT_A( m_adapterId, m_DrmCardNumber >= 0 );
 
-        char filePath[MD_MAX_PATH_LENGTH] = { 0 };
-        snprintf( filePath, sizeof( filePath ), "/sys/class/drm/card%d/%s", m_DrmCardNumber, fileName );
-
-        return ReadUInt64FromFile( filePath, readValue );
+        return m_SysFsCache.Read( fileName, readValue, rateLimited );
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -2395,6 +3342,9 @@ namespace MetricsDiscoveryInternal
         char filePath[MD_MAX_PATH_LENGTH] = { 0 };
         snprintf( filePath, sizeof( filePath ), "/sys/class/drm/card%d/%s", m_DrmCardNumber, fileName );
 
+        // Written file may be read later, drop its cached value
+        m_SysFsCache.Invalidate( fileName );
+
         return WriteUInt64ToFile( filePath, value );
     }
 
@@ -2407,44 +3357,24 @@ namespace MetricsDiscoveryInternal
     //     ReadUInt64FromFile
     //
     // Description:
-    //     Reads 64-bit unsigned value from the given file.
-    //     Based on GpuTop read_file_uint64().
+    //     Reads 64-bit unsigned value from the given file. The file is kept open
+    //     by the SysFs cache and read with a single pread.
     //
     // Input:
-    //     const char* filePath  - file to read the value from
-    //     uint64_t*   readValue - (OUT) read value, not changed in case of error.
+    //     const char* filePath    - file to read the value from
+    //     uint64_t*   readValue   - (OUT) read value, not changed in case of error.
+    //     const bool  rateLimited - if true, a value read within the refresh interval is reused
     //
     // Output:
-    //     TCompletionCode       - *CC_OK* means success
+    //     TCompletionCode         - *CC_OK* means success
     //
     //////////////////////////////////////////////////////////////////////////////
-    TCompletionCode CDriverInterfaceLinuxCommon::ReadUInt64FromFile( const char* filePath, uint64_t* readValue )
+    TCompletionCode CDriverInterfaceLinuxCommon::ReadUInt64FromFile( const char* filePath, uint64_t* readValue, const bool rateLimited /* = false */ )
     {
         MD_CHECK_PTR_RET_A( m_adapterId, filePath, CC_ERROR_INVALID_PARAMETER );
         MD_CHECK_PTR_RET_A( m_adapterId, readValue, CC_ERROR_INVALID_PARAMETER );
 
-        char buffer[32] = { 0 };
-
-        int32_t fd = open( filePath, O_RDONLY );
-        if( fd < 0 )
-        {
-            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Failed to open %s, error: %d (%s)", filePath, errno, strerror( errno ) );
-            return CC_ERROR_FILE_NOT_FOUND;
-        }
-
-        int32_t readBytes = read( fd, buffer, sizeof( buffer ) - 1 );
-        close( fd );
-
-        if( readBytes < 0 )
-        {
-            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Read negative number of bytes, error: %d (%s)", errno, strerror( errno ) );
-            return CC_ERROR_GENERAL;
-        }
-
-        buffer[readBytes] = '\0';
-        *readValue        = strtoull( buffer, 0, 0 );
-
-        return CC_OK;
+        return m_SysFsCache.Read( filePath, readValue, rateLimited );
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -2764,7 +3694,8 @@ namespace MetricsDiscoveryInternal
 
             // Using act ('actual') frequency file, curr ('current') freq file may show
             // frequency requested by the driver not the actual GPU frequency.
-            ret = ReadSysFsFile( actFreqFileName, &actFrequencyMhz );
+            // Read on every IoStream read, so rate limited.
+            ret = ReadSysFsFile( actFreqFileName, &actFrequencyMhz, true );
             MD_CHECK_CC_RET_A( m_adapterId, ret );
 
             // Convert reading to Hz (for compatibility with the other MDAPI driver interfaces)
@@ -3393,6 +4324,115 @@ namespace MetricsDiscoveryInternal
         return std::pow( 2, std::floor( log2( requestedBufferSize ) ) );
     }
 
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     GetOaPollPeriod
+    //
+    // Description:
+    //     Returns the period the kernel should check the OA buffer for reports with.
+    //     The automatic period is the latency target, shortened so the OA buffer
+    //     cannot get more than half full between checks. Checking more often than
+    //     reports are written is useless, so it is never shorter than the sampling
+    //     period.
+    //
+    // Input:
+    //     const TIoStreamPollParams& pollParams    - poll parameters
+    //     const uint32_t             nsTimerPeriod - sampling period in nanoseconds
+    //     const uint32_t             bufferSize    - oa buffer size in bytes
+    //     const uint32_t             reportSize    - raw report size in bytes
+    //
+    // Output:
+    //     uint32_t                                 - poll period in nanoseconds, 0 means kernel default
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CDriverInterfaceLinuxCommon::GetOaPollPeriod( const TIoStreamPollParams& pollParams, const uint32_t nsTimerPeriod, const uint32_t bufferSize, const uint32_t reportSize )
+    {
+        uint64_t pollPeriodNs = pollParams.PollPeriodNs;
+
+        if( pollParams.Automatic )
+        {
+            const uint64_t maxLatencyMs = pollParams.MaxLatencyMs ? pollParams.MaxLatencyMs : MD_OA_POLL_MAX_LATENCY_DEFAULT_MS;
+            const uint64_t halfFillNs   = reportSize ? static_cast<uint64_t>( bufferSize / reportSize ) * nsTimerPeriod / 2 : 0;
+
+            pollPeriodNs = maxLatencyMs * MD_NSEC_PER_MSEC;
+            if( halfFillNs )
+            {
+                pollPeriodNs = std::min( pollPeriodNs, halfFillNs );
+            }
+            pollPeriodNs = std::max<uint64_t>( pollPeriodNs, nsTimerPeriod );
+        }
+
+        if( pollPeriodNs == 0 )
+        {
+            return 0;
+        }
+
+        if( pollPeriodNs < MD_OA_POLL_PERIOD_MIN_NS )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Poll period %" PRIu64 " ns raised to the minimum %u ns", pollPeriodNs, MD_OA_POLL_PERIOD_MIN_NS );
+            pollPeriodNs = MD_OA_POLL_PERIOD_MIN_NS;
+        }
+
+        return static_cast<uint32_t>( std::min<uint64_t>( pollPeriodNs, UINT32_MAX ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxCommon
+    //
+    // Method:
+    //     GetOaBufferSize
+    //
+    // Description:
+    //     Returns the OA buffer size to open the stream with. The automatic size
+    //     holds reports sampled during MD_OA_BUFFER_DRAIN_INTERVALS drain
+    //     intervals, rounded up to a power of 2. Sizes are limited to the range
+    //     supported by the kernel, see CalculateOaBufferSize.
+    //
+    // Input:
+    //     const TIoStreamOaBufferParams& oaBufferParams      - oa buffer parameters
+    //     const uint32_t                 requestedBufferSize - size requested on open in bytes, 0 means default
+    //     const uint32_t                 nsTimerPeriod       - sampling period in nanoseconds
+    //     const uint32_t                 reportSize          - raw report size in bytes
+    //
+    // Output:
+    //     uint32_t                                           - oa buffer size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CDriverInterfaceLinuxCommon::GetOaBufferSize( const TIoStreamOaBufferParams& oaBufferParams, const uint32_t requestedBufferSize, const uint32_t nsTimerPeriod, const uint32_t reportSize )
+    {
+        uint64_t bufferSize = requestedBufferSize ? requestedBufferSize : MD_OA_BUFFER_SIZE_MAX;
+
+        if( oaBufferParams.Automatic && nsTimerPeriod )
+        {
+            const uint64_t drainIntervalMs = oaBufferParams.DrainIntervalMs ? oaBufferParams.DrainIntervalMs : MD_OA_BUFFER_DRAIN_INTERVAL_DEFAULT_MS;
+            const uint64_t reportCount     = ( drainIntervalMs * MD_NSEC_PER_MSEC + nsTimerPeriod - 1 ) / nsTimerPeriod;
+            const uint64_t requiredSize    = std::min<uint64_t>( reportCount * reportSize * MD_OA_BUFFER_DRAIN_INTERVALS, UINT32_MAX );
+
+            bufferSize = MD_OA_BUFFER_SIZE_MIN;
+            while( bufferSize < requiredSize )
+            {
+                bufferSize <<= 1;
+            }
+
+            const uint32_t supportedSize = CalculateOaBufferSize( static_cast<uint32_t>( std::min<uint64_t>( bufferSize, UINT32_MAX ) ) );
+            if( supportedSize < requiredSize )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "Oa buffer may overflow, required size: %" PRIu64 " bytes, supported: %u bytes", requiredSize, supportedSize );
+            }
+
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Automatic oa buffer size: %u bytes, drain interval: %" PRIu64 " ms", supportedSize, drainIntervalMs );
+            return supportedSize;
+        }
+
+        return CalculateOaBufferSize( static_cast<uint32_t>( bufferSize ) );
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     //
     // Class:
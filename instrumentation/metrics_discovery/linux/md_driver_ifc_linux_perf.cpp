@@ -115,6 +115,13 @@ namespace MetricsDiscoveryInternal
         }
         m_AddedOaConfigs.clear();
 
+        std::vector<int32_t> cachedOaConfigs;
+        m_OaConfigCache.Clear( cachedOaConfigs );
+        for( int32_t oaConfigId : cachedOaConfigs )
+        {
+            RemoveOaConfig( oaConfigId );
+        }
+
         ResetPerfCapabilities();
 
         MD_LOG_EXIT_A( m_adapterId );
@@ -699,8 +706,11 @@ namespace MetricsDiscoveryInternal
         // Check capabilities. Update when OA interrupt will be merged.
 
         m_perfCapabilities.IsOaInterruptSupported     = false;
+        m_perfCapabilities.IsOaConfigChangeSupported  = requirePerfRevision( 2 );
+        m_perfCapabilities.IsPollOaPeriodSupported    = requirePerfRevision( 5 );
         m_perfCapabilities.IsSubDeviceSupported       = requirePerfRevision( 10 );
         m_perfCapabilities.IsGpuCpuTimestampSupported = requirePerfRevision( 11 );
+        m_perfCapabilities.IsOaBufferSizeSupported    = requirePerfRevision( PRELIM_PERF_VERSION + 1 );
 
         PrintPerfCapabilities();
     }
@@ -743,8 +753,11 @@ namespace MetricsDiscoveryInternal
         };
 
         MD_LOG_A( m_adapterId, LOG_INFO, "Oa interrupt: %s", getSupportedString( m_perfCapabilities.IsOaInterruptSupported ) );
+        MD_LOG_A( m_adapterId, LOG_INFO, "Oa config change: %s", getSupportedString( m_perfCapabilities.IsOaConfigChangeSupported ) );
+        MD_LOG_A( m_adapterId, LOG_INFO, "Oa poll period: %s", getSupportedString( m_perfCapabilities.IsPollOaPeriodSupported ) );
         MD_LOG_A( m_adapterId, LOG_INFO, "Sub devices: %s", getSupportedString( m_perfCapabilities.IsSubDeviceSupported ) );
         MD_LOG_A( m_adapterId, LOG_INFO, "Cpu gpu timestamps: %s", getSupportedString( m_perfCapabilities.IsGpuCpuTimestampSupported ) );
+        MD_LOG_A( m_adapterId, LOG_INFO, "Oa buffer size: %s", getSupportedString( m_perfCapabilities.IsOaBufferSizeSupported ) );
     }
 
     //////////////////////////////////////////////////////////////////////////////
@@ -765,14 +778,16 @@ namespace MetricsDiscoveryInternal
     //     uint32_t                  oaMetricSetId       - oa configuration ID (previously added)
     //     uint32_t                  oaReportType        - oa report type
     //     uint32_t                  timerPeriodExponent - timer period exponent
-    //     uint32_t                  bufferSize          - oa buffer size
+    //     uint32_t&                 bufferSize          - (in/out) requested/set oa buffer size
     //     const GTDI_OA_BUFFER_TYPE oaBufferType        - oa buffer type
+    //     const uint32_t            pollPeriodNs        - oa buffer poll period in nanoseconds, 0 means kernel default
+    //     const bool                disabled            - open the stream disabled, see EnableOaStream
     //
     // Output:
     //     TCompletionCode                               - *CC_OK* means success
     //
     //////////////////////////////////////////////////////////////////////////////
-    TCompletionCode CDriverInterfaceLinuxPerf::OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType )
+    TCompletionCode CDriverInterfaceLinuxPerf::OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t& bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType, const uint32_t pollPeriodNs, const bool disabled )
     {
         TCompletionCode       ret                    = CC_ERROR_GENERAL;
         int32_t               oaRevision             = -1;
@@ -804,6 +819,10 @@ namespace MetricsDiscoveryInternal
         param.flags = 0;
         param.flags |= I915_PERF_FLAG_FD_CLOEXEC;
         param.flags |= I915_PERF_FLAG_FD_NONBLOCK; // We want a non-blocking read
+        if( disabled )
+        {
+            param.flags |= I915_PERF_FLAG_DISABLED; // Sampling starts with I915_PERF_IOCTL_ENABLE
+        }
 
         // Standard tbs properties.
         addProperty( DRM_I915_PERF_PROP_SAMPLE_OA, true );
@@ -811,6 +830,28 @@ namespace MetricsDiscoveryInternal
         addProperty( DRM_I915_PERF_PROP_OA_FORMAT, oaReportType );
         addProperty( DRM_I915_PERF_PROP_OA_EXPONENT, timerPeriodExponent );
 
+        if( pollPeriodNs )
+        {
+            if( m_perfCapabilities.IsPollOaPeriodSupported )
+            {
+                addProperty( DRM_I915_PERF_PROP_POLL_OA_PERIOD, pollPeriodNs );
+            }
+            else
+            {
+                MD_LOG_A( m_adapterId, LOG_DEBUG, "Oa poll period is not supported, using kernel default" );
+            }
+        }
+
+        if( m_perfCapabilities.IsOaBufferSizeSupported && !isOamRequested )
+        {
+            addProperty( PRELIM_DRM_I915_PERF_PROP_OA_BUFFER_SIZE, bufferSize );
+        }
+        else
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Oa buffer size cannot be set, using kernel default" );
+            bufferSize = MD_OA_BUFFER_SIZE_MAX;
+        }
+
         if( IsSubDeviceSupported() )
         {
             if( isOamRequested )
@@ -861,7 +902,7 @@ namespace MetricsDiscoveryInternal
         {
             MD_LOG_A( m_adapterId, LOG_DEBUG, "Using engine %d:%d ", engine.EngineId.ClassInstance.Class, engine.EngineId.ClassInstance.Instance );
 
-            MD_LOG_A( m_adapterId, LOG_DEBUG, "Opening i915 Perf stream with params: oaMetricSetId: %u, oaReportType: %u, timerPeriodExponent: %u, bufferSize: %u", oaMetricSetId, oaReportType, timerPeriodExponent, bufferSize );
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Opening i915 Perf stream with params: oaMetricSetId: %u, oaReportType: %u, timerPeriodExponent: %u, bufferSize: %u, pollPeriodNs: %u, disabled: %u", oaMetricSetId, oaReportType, timerPeriodExponent, bufferSize, pollPeriodNs, disabled );
 
             oaEventFd = SendIoctl( m_DrmDeviceHandle, DRM_IOCTL_I915_PERF_OPEN, &param );
         }
@@ -875,7 +916,52 @@ namespace MetricsDiscoveryInternal
 
         metricsDevice.SetStreamId( oaEventFd );
 
-        MD_LOG_A( m_adapterId, LOG_DEBUG, "i915 Perf stream opened successfully, fd: %d", oaEventFd );
+        // Report the size actually allocated if the kernel tells it
+        QueryOaBufferSize( oaEventFd, bufferSize );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "i915 Perf stream opened successfully, fd: %d, oa buffer size: %u", oaEventFd, bufferSize );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxPerf
+    //
+    // Method:
+    //     QueryOaBufferSize
+    //
+    // Description:
+    //     Reads the size of the OA buffer allocated for the opened stream with
+    //     PRELIM_I915_PERF_IOCTL_GET_OA_BUFFER_INFO. Output is left unchanged
+    //     if the kernel does not support the query.
+    //
+    // Input:
+    //     const int32_t streamId   - opened stream fd
+    //     uint32_t&     bufferSize - (out) oa buffer size in bytes
+    //
+    // Output:
+    //     TCompletionCode          - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxPerf::QueryOaBufferSize( const int32_t streamId, uint32_t& bufferSize )
+    {
+        int32_t perfRevision = -1;
+
+        if( GetPerfRevision( perfRevision ) != CC_OK || perfRevision < PRELIM_PERF_VERSION )
+        {
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        auto oaBufferInfo = prelim_drm_i915_perf_oa_buffer_info{};
+
+        if( SendIoctl( streamId, PRELIM_I915_PERF_IOCTL_GET_OA_BUFFER_INFO, &oaBufferInfo ) != 0 || oaBufferInfo.size == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Cannot query oa buffer size, errno: %d (%s)", errno, strerror( errno ) );
+            return CC_ERROR_GENERAL;
+        }
+
+        bufferSize = static_cast<uint32_t>( std::min<uint64_t>( oaBufferInfo.size, UINT32_MAX ) );
         return CC_OK;
     }
 
@@ -906,9 +992,72 @@ namespace MetricsDiscoveryInternal
     //
     //////////////////////////////////////////////////////////////////////////////
     TCompletionCode CDriverInterfaceLinuxPerf::ReadOaStream( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, char* reportData, uint32_t& readBytes, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        uint32_t readReports = 0;
+
+        readBytes = 0;
+
+        // 1. READ DATA
+        TCompletionCode ret = ReadOaStreamView( metricsDevice, reportSize, reportsToRead, readReports, exceptions );
+        if( ret != CC_OK )
+        {
+            return ret;
+        }
+
+        // 2. COPY DATA
+        const size_t outBufferSize = reportSize * reportsToRead;
+        size_t       bytesCopied   = 0;
+
+        for( const auto& span : metricsDevice.GetStreamSpans() )
+        {
+            for( uint32_t i = 0; i < span.ReportCount; ++i )
+            {
+                // In MDAPI usage model 'perfRecord->data' contains only raw OA report
+                iu_memcpy_s( reportData + bytesCopied, outBufferSize - bytesCopied, span.Data + static_cast<size_t>( i ) * span.Stride, reportSize );
+                bytesCopied += reportSize;
+            }
+        }
+
+        readBytes = bytesCopied;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxPerf
+    //
+    // Method:
+    //     ReadOaStreamView
+    //
+    // Description:
+    //     Reads data from the previously opened oa stream into the metrics device stream
+    //     buffer. OA reports are not copied, instead runs of consecutive sample records
+    //     are stored as metrics device stream spans pointing directly to the OA reports.
+    //     Report lost and buffer lost records split spans and set exception flags.
+    //
+    // Input:
+    //     CMetricsDevice&                  metricsDevice - metrics device
+    //     uint32_t                         reportSize    - size of a single OA report, currently always 256 bytes
+    //     uint32_t                         reportsToRead - number of reports to read
+    //     uint32_t&                        readReports   - (OUT) number of OA reports read
+    //     GTDIReadCounterStreamExceptions& exceptions    - (OUT) exception flags reported by i915 Perf
+    //
+    // Output:
+    //     TCompletionCode                   - *CC_OK* means success, BUT IT DOESN'T MEAN ALL REQUESTED DATA WAS READ !!
+    //                                         (check readReports for that).
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxPerf::ReadOaStreamView( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, uint32_t& readReports, GTDIReadCounterStreamExceptions& exceptions )
     {
         const int32_t streamId = metricsDevice.GetStreamId();
 
+        auto& streamBuffer = metricsDevice.GetStreamBuffer();
+        auto& streamSpans  = metricsDevice.GetStreamSpans();
+
+        readReports = 0;
+        streamSpans.clear();
+
         if( streamId < 0 )
         {
             MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Perf stream not opened" );
@@ -916,47 +1065,71 @@ namespace MetricsDiscoveryInternal
         }
 
         constexpr size_t oaHeaderSize    = sizeof( drm_i915_perf_record_header );
-        const size_t     outBufferSize   = reportSize * reportsToRead;
-        const size_t     perfReportSize  = oaHeaderSize + reportSize;                     // i915 Perf report size is bigger (additional header)
-        const size_t     perfBytesToRead = reportsToRead * perfReportSize + oaHeaderSize; // Adding header for flag only reports, e.g. for situations where user
-                                                                                          // requests 1 report, but first report from i915 Perf is REPORT_LOST flag.
-
-        auto& streamBuffer = metricsDevice.GetStreamBuffer();
+        const size_t     perfReportSize  = oaHeaderSize + reportSize; // i915 Perf report size is bigger (additional header)
+        const size_t     perfBytesToRead = GetOaStreamBufferSize( reportSize, reportsToRead );
 
         // Resize report buffer if needed
-        if( streamBuffer.size() < perfBytesToRead )
+        if( streamBuffer.GetSize() < perfBytesToRead && streamBuffer.Resize( perfBytesToRead ) != CC_OK )
         {
-            streamBuffer.resize( perfBytesToRead );
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Cannot allocate stream buffer, size: %zu", perfBytesToRead );
+            return CC_ERROR_NO_MEMORY;
         }
 
         MD_LOG_A( m_adapterId, LOG_DEBUG, "Trying to read %u reports from i915 Perf stream, fd: %d", reportsToRead, streamId );
 
         // #Note May read 1 sample less than requested if ReportLost is returned from kernel
 
-        // 1. READ DATA
-        int32_t perfReadBytes = read( streamId, streamBuffer.data(), perfBytesToRead );
+        // 1. READ DATA, unless already read by an io_uring stream group into its buffer
+        int32_t                perfReadBytes = 0;
+        TCompletedOaStreamRead completedRead = {};
+        if( !TakeCompletedOaStreamRead( metricsDevice, completedRead ) )
+        {
+            perfReadBytes = read( streamId, streamBuffer.GetData(), perfBytesToRead );
+        }
+        else if( completedRead.Result < 0 )
+        {
+            errno         = -completedRead.Result;
+            perfReadBytes = -1;
+        }
+        else
+        {
+            perfReadBytes = completedRead.Result;
+            if( streamBuffer.GetSize() < static_cast<size_t>( perfReadBytes ) && streamBuffer.Resize( perfReadBytes ) != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Cannot allocate stream buffer, size: %d", perfReadBytes );
+                return CC_ERROR_NO_MEMORY;
+            }
+            iu_memcpy_s( streamBuffer.GetData(), streamBuffer.GetSize(), completedRead.Data, perfReadBytes );
+        }
+
         if( perfReadBytes < 0 )
         {
-            readBytes = 0;
             if( errno == EAGAIN )
             {
                 MD_LOG_A( m_adapterId, LOG_DEBUG, "i915 Perf stream data not available yet" );
                 return CC_OK;
             }
+            if( errno == EIO && metricsDevice.IsStreamPaused() )
+            {
+                MD_LOG_A( m_adapterId, LOG_DEBUG, "i915 Perf stream paused" );
+                return CC_OK;
+            }
             MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Reading i915 Perf stream failed, errno: %d (%s)", errno, strerror( errno ) );
             return CC_ERROR_GENERAL;
         }
         MD_LOG_A( m_adapterId, LOG_DEBUG, "Read %u Perf bytes (= %lu reports), perfReportSize: %lu", perfReadBytes, perfReadBytes / perfReportSize, perfReportSize );
 
-        // 2. PROCESS AND COPY DATA
-        size_t bytesCopied    = 0;
-        size_t perfDataOffset = 0;
+        // 2. PROCESS DATA
+        TIoStreamSpan span           = {};
+        size_t        perfDataOffset = 0;
         while( perfDataOffset < static_cast<size_t>( perfReadBytes ) )
         {
-            const iu_i915_perf_record* perfRecord = reinterpret_cast<const iu_i915_perf_record*>( streamBuffer.data() + perfDataOffset );
+            const iu_i915_perf_record* perfRecord = reinterpret_cast<const iu_i915_perf_record*>( streamBuffer.GetData() + perfDataOffset );
             if( !perfRecord->header.size )
             {
                 MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: 0 header size" );
+                streamSpans.clear();
+                readReports = 0;
                 return CC_ERROR_GENERAL;
             }
             perfDataOffset += perfRecord->header.size;
@@ -968,12 +1141,19 @@ namespace MetricsDiscoveryInternal
                     if( perfRecord->header.size != perfReportSize )
                     {
                         MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Invalid record size" );
+                        streamSpans.clear();
+                        readReports = 0;
                         return CC_ERROR_GENERAL;
                     }
 
                     // In MDAPI usage model 'perfRecord->data' contains only raw OA report
-                    iu_memcpy_s( reportData + bytesCopied, outBufferSize - bytesCopied, perfRecord->data, reportSize );
-                    bytesCopied += reportSize;
+                    if( span.ReportCount == 0 )
+                    {
+                        span.Data   = perfRecord->data;
+                        span.Stride = static_cast<uint32_t>( perfReportSize );
+                    }
+                    ++span.ReportCount;
+                    ++readReports;
                     break;
                 }
 
@@ -990,9 +1170,138 @@ namespace MetricsDiscoveryInternal
                 default:
                     MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Unknown header type = %d", perfRecord->header.type );
             }
+
+            // Non sample record breaks the stride
+            if( perfRecord->header.type != DRM_I915_PERF_RECORD_SAMPLE && span.ReportCount )
+            {
+                streamSpans.push_back( span );
+                span = {};
+            }
+        }
+
+        if( span.ReportCount )
+        {
+            streamSpans.push_back( span );
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxPerf
+    //
+    // Method:
+    //     GetOaStreamBufferSize
+    //
+    // Description:
+    //     Returns size of the stream buffer needed to read the given number of OA
+    //     reports from i915 Perf, including record headers.
+    //
+    // Input:
+    //     const uint32_t reportSize    - size of a single OA report
+    //     const uint32_t reportsToRead - number of reports to read
+    //
+    // Output:
+    //     size_t                       - buffer size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    size_t CDriverInterfaceLinuxPerf::GetOaStreamBufferSize( const uint32_t reportSize, const uint32_t reportsToRead )
+    {
+        constexpr size_t oaHeaderSize = sizeof( drm_i915_perf_record_header );
+
+        // Adding header for flag only reports, e.g. for situations where user
+        // requests 1 report, but first report from i915 Perf is REPORT_LOST flag.
+        return reportsToRead * ( oaHeaderSize + reportSize ) + oaHeaderSize;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxPerf
+    //
+    // Method:
+    //     EnableOaStream
+    //
+    // Description:
+    //     Enables or disables sampling of the opened i915 Perf stream with
+    //     I915_PERF_IOCTL_ENABLE / I915_PERF_IOCTL_DISABLE. Reads of a disabled
+    //     stream fail with EIO, enabling resets the OA buffer.
+    //
+    // Input:
+    //     CMetricsDevice& metricsDevice - metrics device with an opened stream
+    //     const bool      enable        - *true* to enable, *false* to disable
+    //
+    // Output:
+    //     TCompletionCode               - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxPerf::EnableOaStream( CMetricsDevice& metricsDevice, const bool enable )
+    {
+        const int32_t streamId = metricsDevice.GetStreamId();
+
+        if( streamId < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Perf stream not opened" );
+            return CC_ERROR_FILE_NOT_FOUND;
+        }
+
+        const int32_t ioctlResult = SendIoctl( streamId, enable ? I915_PERF_IOCTL_ENABLE : I915_PERF_IOCTL_DISABLE, nullptr );
+        if( ioctlResult < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Failed to %s stream, errno: %d (%s)", enable ? "enable" : "disable", errno, strerror( errno ) );
+            return CC_ERROR_GENERAL;
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxPerf
+    //
+    // Method:
+    //     ChangeOaStreamConfig
+    //
+    // Description:
+    //     Changes OA configuration of the opened i915 Perf stream with
+    //     I915_PERF_IOCTL_CONFIG. The stream keeps its OA buffer and reports
+    //     already sampled with the previous configuration.
+    //
+    // Input:
+    //     CMetricsDevice& metricsDevice - metrics device with an opened stream
+    //     const int32_t   oaMetricSetId - configuration id added to the kernel
+    //
+    // Output:
+    //     TCompletionCode               - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxPerf::ChangeOaStreamConfig( CMetricsDevice& metricsDevice, const int32_t oaMetricSetId )
+    {
+        const int32_t streamId = metricsDevice.GetStreamId();
+
+        if( streamId < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Perf stream not opened" );
+            return CC_ERROR_FILE_NOT_FOUND;
+        }
+
+        if( !m_perfCapabilities.IsOaConfigChangeSupported )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Changing configuration of opened stream not supported" );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        // Returns the previous configuration id
+        const int32_t ioctlResult = SendIoctl( streamId, I915_PERF_IOCTL_CONFIG, reinterpret_cast<void*>( static_cast<uintptr_t>( oaMetricSetId ) ) );
+        if( ioctlResult < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Failed to change stream configuration to %d, errno: %d (%s)", oaMetricSetId, errno, strerror( errno ) );
+            return CC_ERROR_GENERAL;
         }
 
-        readBytes = bytesCopied;
         return CC_OK;
     }
 
@@ -1006,8 +1315,8 @@ namespace MetricsDiscoveryInternal
     //
     // Description:
     //     Adds OA configuration to the kernel through i915 Perf interface. If no GUID passed
-    //     in parameter, GUID of the added configuration is calculated based on concatenated
-    //     register offsets and values string.
+    //     in parameter, GUID of the added configuration is a 128 bit hash of the registers,
+    //     see COaConfigCache::GetGuid.
     //     When the same configuration is already added, its ID is reused (configuration isn't
     //     send for the second time).
     //
@@ -1017,12 +1326,13 @@ namespace MetricsDiscoveryInternal
     //     const uint32_t subDeviceIndex - sub device index
     //     const char*    requestedGuid  - [optional] GUID under which configuration will be added, if nullptr GUID will be generated
     //     int32_t&       addedConfigId  - (OUT) added oa configuration ID, -1 if error
+    //     bool*          added          - (OUT) [optional] *true* if added by this call, *false* if reused
     //
     // Output:
     //     TCompletionCode               - *CC_OK* means success
     //
     //////////////////////////////////////////////////////////////////////////////
-    TCompletionCode CDriverInterfaceLinuxPerf::AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId )
+    TCompletionCode CDriverInterfaceLinuxPerf::AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId, bool* added )
     {
         MD_LOG_ENTER_A( m_adapterId );
         MD_CHECK_PTR_RET_A( m_adapterId, regVector, CC_ERROR_INVALID_PARAMETER );
@@ -1037,7 +1347,6 @@ namespace MetricsDiscoveryInternal
         std::vector<iu_i915_perf_config_register> noaRegisters;
         std::vector<iu_i915_perf_config_register> flexRegisters;
         std::vector<iu_i915_perf_config_register> oaRegisters;
-        std::string                               regsString; // For hash (guid)
 
         // 1. TRANSFORM CONFIG TO I915 PERF FORMAT
         MD_LOG_A( m_adapterId, LOG_DEBUG, "AddOaConfig regCount: %u", regCount );
@@ -1049,11 +1358,6 @@ namespace MetricsDiscoveryInternal
                                                                            : ( regVector[i]->type == REGISTER_TYPE_OA ? oaRegisters
                                                                                                                       : noaRegisters );
                 registers.push_back( { regVector[i]->offset, regVector[i]->value } );
-                if( !guid )
-                {
-                    regsString += regVector[i]->offset;
-                    regsString += regVector[i]->value;
-                }
                 MD_LOG_A( m_adapterId, LOG_DEBUG, "regOffset: %#x, regValue: %#x", regVector[i]->offset, regVector[i]->value );
             }
         }
@@ -1062,10 +1366,7 @@ namespace MetricsDiscoveryInternal
         char generatedGuid[MD_PERF_GUID_LENGTH];
         if( !guid )
         {
-            std::hash<std::string> stringHash;
-
-            // Use std::hash for GUID generation
-            snprintf( generatedGuid, sizeof( generatedGuid ), "%08x-%04x-%04x-%04x-%012x", 0, 0, subDeviceIndex, 0, static_cast<uint32_t>( stringHash( regsString ) ) );
+            COaConfigCache::GetGuid( regVector, regCount, subDeviceIndex, generatedGuid, sizeof( generatedGuid ) );
             guid = generatedGuid;
         }
 
@@ -1089,6 +1390,10 @@ namespace MetricsDiscoveryInternal
 
         // 4. ADD CONFIG TO I915 PERF
         addedConfigId = SendIoctl( m_DrmDeviceHandle, DRM_IOCTL_I915_PERF_ADD_CONFIG, &param );
+        if( added )
+        {
+            *added = addedConfigId != -1;
+        }
         if( addedConfigId == -1 )
         {
             if( errno != EADDRINUSE ) // errno == 98 (EADDRINUSE) means set with the given GUID is already added
@@ -2225,10 +2530,20 @@ namespace MetricsDiscoveryInternal
     //////////////////////////////////////////////////////////////////////////////
     TCompletionCode CDriverInterfaceLinuxPerf::GetOaBufferSupportedSizes( const uint32_t platformId, uint32_t& minSize, uint32_t& maxSize )
     {
-        // Buffer size in Perf is constant
+        // Buffer size in Perf is constant, unless the kernel supports setting it
         minSize = MD_OA_BUFFER_SIZE_MAX;
         maxSize = MD_OA_BUFFER_SIZE_MAX;
 
+        if( m_perfCapabilities.IsOaBufferSizeSupported )
+        {
+            minSize = MD_OA_BUFFER_SIZE_MIN;
+
+            if( IsPlatformMatch( platformId, GENERATION_XEHP_SDV, GENERATION_PVC ) )
+            {
+                maxSize = MD_OA_BUFFER_SIZE_MAX_XEHP;
+            }
+        }
+
         return CC_OK;
     }
 
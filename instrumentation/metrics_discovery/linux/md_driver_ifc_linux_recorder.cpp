@@ -0,0 +1,689 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_driver_ifc_linux_recorder.cpp
+//
+//     Abstract:   C++ driver interface recorder for Linux with Perf
+
+#include "md_driver_ifc_linux_recorder.h"
+#include "md_sub_devices_linux.h"
+#include "md_adapter.h"
+#include "md_metrics_device.h"
+#include "md_utils.h"
+
+#include <cstring>
+
+namespace MetricsDiscoveryInternal
+{
+    std::atomic<bool> CDriverInterfaceLinuxRecorder::m_recording( false );
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     CDriverInterfaceLinuxRecorder constructor
+    //
+    // Input:
+    //     CAdapterHandle&           adapterHandle - handle to the DRM device
+    //     const TAdapterParams_1_9& adapterParams - adapter params, written to the record file
+    //     const char*               fileName      - record file
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CDriverInterfaceLinuxRecorder::CDriverInterfaceLinuxRecorder( CAdapterHandle& adapterHandle, const TAdapterParams_1_9& adapterParams, const char* fileName )
+        : CDriverInterfaceLinuxPerf( adapterHandle )
+        , m_adapterParams( adapterParams )
+        , m_fileName( fileName ? fileName : "" )
+        , m_file( nullptr )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     CDriverInterfaceLinuxRecorder destructor
+    //
+    // Description:
+    //     Closes the record file.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CDriverInterfaceLinuxRecorder::~CDriverInterfaceLinuxRecorder()
+    {
+        if( m_file )
+        {
+            fclose( m_file );
+            m_file      = nullptr;
+            m_recording = false;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     CreateContext
+    //
+    // Description:
+    //     Creates the i915 Perf driver context and opens the record file. Failing
+    //     to open the record file is not fatal, the driver interface works
+    //     without recording.
+    //
+    // Output:
+    //     bool - *true* if the driver context was created
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxRecorder::CreateContext()
+    {
+        if( !CDriverInterfaceLinuxPerf::CreateContext() )
+        {
+            return false;
+        }
+
+        bool recording = false;
+        if( !m_recording.compare_exchange_strong( recording, true ) )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Other adapter is recorded, adapter will not be recorded" );
+            return true;
+        }
+
+        iu_fopen_s( &m_file, m_fileName.c_str(), "wb" );
+        if( m_file == nullptr )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Cannot create record file %s", m_fileName.c_str() );
+            m_recording = false;
+            return true;
+        }
+
+        TDriverRecordFileHeader header = {};
+        header.Magic                   = MD_DRIVER_RECORD_MAGIC;
+        header.Version                 = MD_DRIVER_RECORD_VERSION;
+        header.AdapterId               = m_adapterId;
+
+        fwrite( &header, sizeof( header ), 1, m_file );
+
+        // Short name is owned by the adapter, it is written as the payload
+        const char*    shortName     = m_adapterParams.ShortName ? m_adapterParams.ShortName : "";
+        const uint32_t shortNameSize = static_cast<uint32_t>( strlen( shortName ) + 1 );
+
+        m_adapterParams.ShortName = nullptr;
+        WriteRecord( DRIVER_RECORD_ADAPTER, &m_adapterParams, sizeof( m_adapterParams ), shortName, shortNameSize );
+
+        MD_LOG_A( m_adapterId, LOG_INFO, "Recording driver interface to %s", m_fileName.c_str() );
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     SendDeviceInfoParamEscape
+    //
+    // Description:
+    //     Reads a device param and records the result.
+    //
+    // Input:
+    //     GTDI_DEVICE_PARAM          param         - param to read
+    //     GTDIDeviceInfoParamExtOut* out           - (out) param value
+    //     CMetricsDevice*            metricsDevice - metrics device, may be nullptr
+    //
+    // Output:
+    //     TCompletionCode                          - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxRecorder::SendDeviceInfoParamEscape( GTDI_DEVICE_PARAM param, GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice /* = nullptr */ )
+    {
+        const TCompletionCode ret = CDriverInterfaceLinuxPerf::SendDeviceInfoParamEscape( param, out, metricsDevice );
+
+        if( m_file && out )
+        {
+            TDriverRecordDeviceParam record = {};
+            record.Param                    = static_cast<uint32_t>( param );
+            record.SubDeviceIndex           = metricsDevice ? metricsDevice->GetSubDeviceIndex() : MD_DRIVER_RECORD_NO_SUB_DEVICE;
+            record.Result                   = static_cast<uint32_t>( ret );
+            record.Out                      = *out;
+
+            WriteRecord( DRIVER_RECORD_DEVICE_PARAM, &record, sizeof( record ) );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     GetGpuCpuTimestamps
+    //
+    // Description:
+    //     Reads correlated GPU and CPU timestamps and records them.
+    //
+    // Input:
+    //     CMetricsDevice& device               - metrics device
+    //     uint64_t*       gpuTimestamp         - (out) gpu timestamp in ns
+    //     uint64_t*       cpuTimestamp         - (out) cpu timestamp in ns
+    //     uint32_t*       cpuId                - (out) cpu id
+    //     uint64_t*       correlationIndicator - (out) correlation indicator
+    //
+    // Output:
+    //     TCompletionCode                      - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxRecorder::GetGpuCpuTimestamps( CMetricsDevice& device, uint64_t* gpuTimestamp, uint64_t* cpuTimestamp, uint32_t* cpuId, uint64_t* correlationIndicator )
+    {
+        const TCompletionCode ret = CDriverInterfaceLinuxPerf::GetGpuCpuTimestamps( device, gpuTimestamp, cpuTimestamp, cpuId, correlationIndicator );
+
+        if( m_file )
+        {
+            TDriverRecordTimestamps record = {};
+            record.SubDeviceIndex          = device.GetSubDeviceIndex();
+            record.Result                  = static_cast<uint32_t>( ret );
+            record.GpuTimestamp            = gpuTimestamp ? *gpuTimestamp : 0;
+            record.CpuTimestamp            = cpuTimestamp ? *cpuTimestamp : 0;
+            record.CorrelationIndicator    = correlationIndicator ? *correlationIndicator : 0;
+            record.CpuId                   = cpuId ? *cpuId : 0;
+
+            WriteRecord( DRIVER_RECORD_TIMESTAMPS, &record, sizeof( record ) );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     IsTbsEngineValid
+    //
+    // Description:
+    //     Checks the engine and records the result.
+    //
+    // Input:
+    //     const TEngineParams_1_9& engineParams      - engine params
+    //     const uint32_t           requestedInstance - requested engine instance
+    //     const bool               isOam             - *true* if an oam engine is required
+    //
+    // Output:
+    //     bool                                       - *true* if the engine is valid
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxRecorder::IsTbsEngineValid( const TEngineParams_1_9& engineParams, const uint32_t requestedInstance /* = -1 */, const bool isOam /* = false */ ) const
+    {
+        const bool valid = CDriverInterfaceLinuxPerf::IsTbsEngineValid( engineParams, requestedInstance, isOam );
+
+        WriteQuery( DRIVER_RECORD_QUERY_TBS_ENGINE_VALID, engineParams.EngineId.ClassInstance.Class, engineParams.EngineId.ClassInstance.Instance, requestedInstance, isOam, valid );
+
+        return valid;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     OpenIoStream
+    //
+    // Description:
+    //     Opens the IO Stream and records returned params. Time of the following
+    //     reads is recorded relative to this call.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
+    //     uint32_t            processId         - PID of the measured app (0 is global context)
+    //     uint32_t&           nsTimerPeriod     - (in/out) requested/set sampling period time in nanoseconds
+    //     uint32_t&           bufferSize        - (in/out) requested/set OA Buffer/buffer size in bytes, 0 means default
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxRecorder::OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize )
+    {
+        const TCompletionCode ret = CDriverInterfaceLinuxPerf::OpenIoStream( oaConcurrentGroup, processId, nsTimerPeriod, bufferSize );
+
+        if( m_file )
+        {
+            TDriverRecordStreamOpen record = {};
+            record.Stream                  = GetRecordStream( oaConcurrentGroup );
+            record.Result                  = static_cast<uint32_t>( ret );
+            record.NsTimerPeriod           = nsTimerPeriod;
+            record.BufferSize              = bufferSize;
+
+            if( ret == CC_OK )
+            {
+                std::lock_guard<std::mutex> lock( m_fileMutex );
+                m_streamOpenTimes[GetStreamKey( record.Stream )] = std::chrono::steady_clock::now();
+            }
+
+            WriteRecord( DRIVER_RECORD_STREAM_OPEN, &record, sizeof( record ) );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     ReadIoStream
+    //
+    // Description:
+    //     Reads data from the opened IO Stream and records read reports.
+    //
+    // Input:
+    //     COAConcurrentGroup&              oaConcurrentGroup - oa concurrent group
+    //     uint32_t                         readFlags         - read flags
+    //     char*                            reportData        - (out) pointer to the read data
+    //     uint32_t&                        reportsCount      - (in/out) reports read/to read from the stream
+    //     uint32_t&                        frequency         - (out) frequency from GTDIReadCounterStreamExtOut
+    //     GTDIReadCounterStreamExceptions& exceptions        - (out) exceptions from GTDIReadCounterStreamExtOut
+    //
+    // Output:
+    //     TCompletionCode                                    - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxRecorder::ReadIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, char* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        const TCompletionCode ret = CDriverInterfaceLinuxPerf::ReadIoStream( oaConcurrentGroup, readFlags, reportData, reportsCount, frequency, exceptions );
+
+        if( m_file )
+        {
+            const bool read = ( ret == CC_OK ) || ( ret == CC_READ_PENDING );
+
+            WriteStreamRead( oaConcurrentGroup, ret, reportData, read ? reportsCount : 0, frequency, exceptions );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     ReadIoStreamView
+    //
+    // Description:
+    //     Reads data from the opened IO Stream into the metrics device stream
+    //     buffer and records reports described by the stream spans.
+    //
+    // Input:
+    //     COAConcurrentGroup&              oaConcurrentGroup - oa concurrent group
+    //     uint32_t                         readFlags         - read flags
+    //     uint32_t&                        reportsCount      - (in/out) reports read/to read from the stream
+    //     uint32_t&                        frequency         - (out) frequency from GTDIReadCounterStreamExtOut
+    //     GTDIReadCounterStreamExceptions& exceptions        - (out) exceptions from GTDIReadCounterStreamExtOut
+    //
+    // Output:
+    //     TCompletionCode                                    - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxRecorder::ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        const TCompletionCode ret = CDriverInterfaceLinuxPerf::ReadIoStreamView( oaConcurrentGroup, readFlags, reportsCount, frequency, exceptions );
+
+        if( m_file )
+        {
+            std::vector<uint8_t> reports;
+
+            auto metricSet = oaConcurrentGroup.GetIoMetricSet();
+            if( metricSet && ( ( ret == CC_OK ) || ( ret == CC_READ_PENDING ) ) )
+            {
+                const uint32_t reportSize = metricSet->GetParams()->RawReportSize;
+
+                reports.reserve( static_cast<size_t>( reportsCount ) * reportSize );
+
+                // Spans may be strided, only raw reports are recorded
+                for( const auto& span : oaConcurrentGroup.GetMetricsDevice().GetStreamSpans() )
+                {
+                    for( uint32_t i = 0; i < span.ReportCount; ++i )
+                    {
+                        const uint8_t* report = span.Data + static_cast<size_t>( i ) * span.Stride;
+                        reports.insert( reports.end(), report, report + reportSize );
+                    }
+                }
+            }
+
+            const uint32_t reportSize = metricSet ? metricSet->GetParams()->RawReportSize : 0;
+            const uint32_t count      = reportSize ? static_cast<uint32_t>( reports.size() / reportSize ) : 0;
+
+            WriteStreamRead( oaConcurrentGroup, ret, reinterpret_cast<const char*>( reports.data() ), count, frequency, exceptions );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     CloseIoStream
+    //
+    // Description:
+    //     Closes the IO Stream and records the end of its reads.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxRecorder::CloseIoStream( COAConcurrentGroup& oaConcurrentGroup )
+    {
+        if( m_file )
+        {
+            const TDriverRecordStream record = GetRecordStream( oaConcurrentGroup );
+            bool                      opened = false;
+
+            {
+                std::lock_guard<std::mutex> lock( m_fileMutex );
+                opened = m_streamOpenTimes.erase( GetStreamKey( record ) ) != 0;
+            }
+
+            if( opened )
+            {
+                WriteRecord( DRIVER_RECORD_STREAM_CLOSE, &record, sizeof( record ) );
+            }
+        }
+
+        return CDriverInterfaceLinuxPerf::CloseIoStream( oaConcurrentGroup );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     IsSubDeviceSupported
+    //
+    // Description:
+    //     Checks sub device support and records the result.
+    //
+    // Output:
+    //     bool - *true* if sub devices are supported
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxRecorder::IsSubDeviceSupported()
+    {
+        const bool supported = CDriverInterfaceLinuxPerf::IsSubDeviceSupported();
+
+        WriteQuery( DRIVER_RECORD_QUERY_SUB_DEVICE_SUPPORTED, 0, 0, 0, 0, supported );
+
+        return supported;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     EnumerateSubDevices
+    //
+    // Description:
+    //     Detects available sub devices and records engines of each of them.
+    //
+    // Input:
+    //     CSubDevices& subDevices - sub devices
+    //
+    // Output:
+    //     TCompletionCode         - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxRecorder::EnumerateSubDevices( CSubDevices& subDevices )
+    {
+        const TCompletionCode ret = CDriverInterfaceLinuxPerf::EnumerateSubDevices( subDevices );
+
+        if( m_file && ( ret == CC_OK ) )
+        {
+            const uint32_t subDeviceCount = subDevices.GetAllEnginesCount();
+
+            for( uint32_t i = 0; i < subDeviceCount; ++i )
+            {
+                TSubDeviceParams_1_9 subDeviceParams = {};
+                if( subDevices.GetSubDeviceParams( i, subDeviceParams ) != CC_OK )
+                {
+                    break;
+                }
+
+                std::vector<TEngineIdClassInstance_1_9> engines( subDeviceParams.EnginesCount );
+                for( uint32_t j = 0; j < subDeviceParams.EnginesCount; ++j )
+                {
+                    TEngineParams_1_9 engineParams = {};
+                    subDevices.GetEngineParams( i, j, engineParams );
+
+                    engines[j] = engineParams.EngineId.ClassInstance;
+                }
+
+                TDriverRecordSubDevice record = {};
+                record.SubDeviceIndex         = i;
+                record.EngineCount            = subDeviceParams.EnginesCount;
+
+                WriteRecord( DRIVER_RECORD_SUB_DEVICE, &record, sizeof( record ), engines.data(), static_cast<uint32_t>( engines.size() * sizeof( engines[0] ) ) );
+            }
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     GetStreamKey
+    //
+    // Description:
+    //     Returns a key identifying the recorded stream of a metrics device and
+    //     an OA buffer.
+    //
+    // Input:
+    //     const TDriverRecordStream& stream - recorded stream
+    //
+    // Output:
+    //     uint64_t                          - stream key
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CDriverInterfaceLinuxRecorder::GetStreamKey( const TDriverRecordStream& stream )
+    {
+        return ( static_cast<uint64_t>( stream.SubDeviceIndex ) << 32 ) | stream.OaBufferType;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     WriteRecord
+    //
+    // Description:
+    //     Writes a single record. Records of concurrent calls are serialized.
+    //
+    // Input:
+    //     const TDriverRecordType type        - record type
+    //     const void*             record      - record structure
+    //     const uint32_t          recordSize  - record structure size in bytes
+    //     const void*             payload     - record payload, may be nullptr
+    //     const uint32_t          payloadSize - payload size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxRecorder::WriteRecord( const TDriverRecordType type, const void* record, const uint32_t recordSize, const void* payload /* = nullptr */, const uint32_t payloadSize /* = 0 */ ) const
+    {
+        TDriverRecordHeader header = {};
+        header.Type                = static_cast<uint32_t>( type );
+        header.Size                = recordSize + ( payload ? payloadSize : 0 );
+
+        std::lock_guard<std::mutex> lock( m_fileMutex );
+
+        fwrite( &header, sizeof( header ), 1, m_file );
+        fwrite( record, recordSize, 1, m_file );
+
+        if( payload && payloadSize )
+        {
+            fwrite( payload, payloadSize, 1, m_file );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     WriteQuery
+    //
+    // Description:
+    //     Writes a boolean query record.
+    //
+    // Input:
+    //     const TDriverRecordQueryType query     - query type
+    //     const uint32_t               argument* - query arguments
+    //     const bool                   result    - query result
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxRecorder::WriteQuery( const TDriverRecordQueryType query, const uint32_t argument0, const uint32_t argument1, const uint32_t argument2, const uint32_t argument3, const bool result ) const
+    {
+        if( m_file == nullptr )
+        {
+            return;
+        }
+
+        TDriverRecordQuery record = {};
+        record.Query              = static_cast<uint32_t>( query );
+        record.Arguments[0]       = argument0;
+        record.Arguments[1]       = argument1;
+        record.Arguments[2]       = argument2;
+        record.Arguments[3]       = argument3;
+        record.Result             = result;
+
+        WriteRecord( DRIVER_RECORD_QUERY, &record, sizeof( record ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     WriteStreamRead
+    //
+    // Description:
+    //     Writes a stream read record with read reports. Empty successful reads
+    //     are not recorded, the replay waits for the next recorded read instead.
+    //
+    // Input:
+    //     COAConcurrentGroup&                    oaConcurrentGroup - oa concurrent group
+    //     const TCompletionCode                  result            - read result
+    //     const char*                            reportData        - read reports
+    //     const uint32_t                         reportCount       - read reports count
+    //     const uint32_t                         frequency         - read frequency
+    //     const GTDIReadCounterStreamExceptions& exceptions        - read exceptions
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CDriverInterfaceLinuxRecorder::WriteStreamRead( COAConcurrentGroup& oaConcurrentGroup, const TCompletionCode result, const char* reportData, const uint32_t reportCount, const uint32_t frequency, const GTDIReadCounterStreamExceptions& exceptions )
+    {
+        const GTDIReadCounterStreamExceptions noExceptions = {};
+        const bool                            read         = ( result == CC_OK ) || ( result == CC_READ_PENDING );
+        auto                                  metricSet    = oaConcurrentGroup.GetIoMetricSet();
+
+        if( read && ( reportCount == 0 ) && ( memcmp( &exceptions, &noExceptions, sizeof( exceptions ) ) == 0 ) )
+        {
+            return;
+        }
+
+        TDriverRecordStreamRead record = {};
+        record.Stream                  = GetRecordStream( oaConcurrentGroup );
+        record.Result                  = static_cast<uint32_t>( result );
+        record.Frequency               = frequency;
+        record.Exceptions              = exceptions;
+        record.ReportSize              = metricSet ? metricSet->GetParams()->RawReportSize : 0;
+        record.ReportCount             = ( reportData && record.ReportSize ) ? reportCount : 0;
+        record.TimeNs                  = GetStreamTimeNs( record.Stream );
+
+        WriteRecord( DRIVER_RECORD_STREAM_READ, &record, sizeof( record ), reportData, record.ReportCount * record.ReportSize );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     GetStreamTimeNs
+    //
+    // Description:
+    //     Returns time elapsed since the stream was opened.
+    //
+    // Input:
+    //     const TDriverRecordStream& stream - recorded stream
+    //
+    // Output:
+    //     uint64_t                          - time in ns, 0 if the stream is not opened
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CDriverInterfaceLinuxRecorder::GetStreamTimeNs( const TDriverRecordStream& stream )
+    {
+        std::lock_guard<std::mutex> lock( m_fileMutex );
+
+        auto openTime = m_streamOpenTimes.find( GetStreamKey( stream ) );
+        if( openTime == m_streamOpenTimes.end() )
+        {
+            return 0;
+        }
+
+        return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - openTime->second ).count();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxRecorder
+    //
+    // Method:
+    //     GetRecordStream
+    //
+    // Description:
+    //     Returns the recorded stream of the concurrent group.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
+    //
+    // Output:
+    //     TDriverRecordStream                   - recorded stream
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TDriverRecordStream CDriverInterfaceLinuxRecorder::GetRecordStream( COAConcurrentGroup& oaConcurrentGroup )
+    {
+        TDriverRecordStream stream = {};
+        stream.SubDeviceIndex      = oaConcurrentGroup.GetMetricsDevice().GetSubDeviceIndex();
+        stream.OaBufferType        = static_cast<uint32_t>( oaConcurrentGroup.GetOaBufferType() );
+
+        return stream;
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,1565 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_driver_ifc_linux_replay.cpp
+//
+//     Abstract:   C++ driver interface replaying a driver record file on Linux
+
+#include "md_driver_ifc_linux_replay.h"
+#include "md_sub_devices_linux.h"
+#include "md_adapter.h"
+#include "md_metrics_device.h"
+#include "md_utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     CDriverInterfaceLinuxReplay constructor
+    //
+    // Input:
+    //     CAdapterHandle& adapterHandle - invalid adapter handle of the replayed adapter
+    //     const char*     fileName      - driver record file
+    //     const bool      paced         - *true* to return reports at the recorded pace
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CDriverInterfaceLinuxReplay::CDriverInterfaceLinuxReplay( CAdapterHandle& adapterHandle, const char* fileName, const bool paced )
+        : CDriverInterfaceLinuxCommon( adapterHandle, DRM_VERSION_I915 )
+        , m_fileName( fileName ? fileName : "" )
+        , m_paced( paced )
+        , m_nextStreamConfigId( 0 )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     CDriverInterfaceLinuxReplay destructor
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CDriverInterfaceLinuxReplay::~CDriverInterfaceLinuxReplay()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetReplayAdapters
+    //
+    // Description:
+    //     Returns the adapter recorded in the driver record file.
+    //
+    // Input:
+    //     const char*                fileName - driver record file
+    //     std::vector<TAdapterData>& adapters - [out] replayed adapter
+    //
+    // Output:
+    //     TCompletionCode                     - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetReplayAdapters( const char* fileName, std::vector<TAdapterData>& adapters )
+    {
+        std::vector<uint8_t> file;
+
+        TCompletionCode ret = LoadFile( fileName, file );
+        MD_CHECK_CC_RET( ret );
+
+        size_t offset = sizeof( TDriverRecordFileHeader );
+
+        while( offset + sizeof( TDriverRecordHeader ) <= file.size() )
+        {
+            TDriverRecordHeader recordHeader = {};
+            memcpy( &recordHeader, file.data() + offset, sizeof( recordHeader ) );
+            offset += sizeof( recordHeader );
+
+            if( offset + recordHeader.Size > file.size() )
+            {
+                break;
+            }
+
+            if( recordHeader.Type == DRIVER_RECORD_ADAPTER && recordHeader.Size >= sizeof( TAdapterParams_1_9 ) )
+            {
+                const char*       payload = reinterpret_cast<const char*>( file.data() + offset + sizeof( TAdapterParams_1_9 ) );
+                const std::string shortName( payload, strnlen( payload, recordHeader.Size - sizeof( TAdapterParams_1_9 ) ) );
+
+                TAdapterData adapter = {};
+                memcpy( &adapter.Params, file.data() + offset, sizeof( adapter.Params ) );
+
+                adapter.Params.ShortName = GetCopiedCString( shortName.c_str(), IU_ADAPTER_ID_UNKNOWN );
+
+                adapter.Handle = new( std::nothrow ) CAdapterHandleLinux( -1 ); // No DRM device is opened for the replay
+                if( adapter.Handle == nullptr )
+                {
+                    MD_LOG( LOG_ERROR, "ERROR: Cannot create adapter handle" );
+                    MD_SAFE_DELETE_ARRAY( adapter.Params.ShortName );
+                    return CC_ERROR_NO_MEMORY;
+                }
+
+                MD_LOG( LOG_INFO, "Replaying adapter %s from %s", adapter.Params.ShortName, fileName );
+
+                adapters.push_back( std::move( adapter ) );
+                return CC_OK;
+            }
+
+            offset += recordHeader.Size;
+        }
+
+        MD_LOG( LOG_ERROR, "ERROR: No adapter recorded in %s", fileName );
+        return CC_ERROR_FILE_NOT_FOUND;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     CreateContext
+    //
+    // Description:
+    //     Loads the driver record file.
+    //
+    // Output:
+    //     bool - *true* if the record file was loaded
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxReplay::CreateContext()
+    {
+        std::vector<uint8_t> file;
+
+        if( LoadFile( m_fileName.c_str(), file ) != CC_OK )
+        {
+            return false;
+        }
+
+        TDriverRecordFileHeader header = {};
+        memcpy( &header, file.data(), sizeof( header ) );
+
+        m_adapterId = header.AdapterId;
+
+        if( ParseRecords( file ) != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Cannot replay %s", m_fileName.c_str() );
+            return false;
+        }
+
+        MD_LOG_A( m_adapterId, LOG_INFO, "Replaying driver interface from %s, paced: %u", m_fileName.c_str(), m_paced );
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     SendDeviceInfoParamEscape
+    //
+    // Description:
+    //     Returns the next recorded value of the device param. Once recorded
+    //     values run out, the last one is returned.
+    //
+    // Input:
+    //     GTDI_DEVICE_PARAM          param         - param to read
+    //     GTDIDeviceInfoParamExtOut* out           - (out) param value
+    //     CMetricsDevice*            metricsDevice - metrics device, may be nullptr
+    //
+    // Output:
+    //     TCompletionCode                          - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::SendDeviceInfoParamEscape( GTDI_DEVICE_PARAM param, GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice /* = nullptr */ )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, out, CC_ERROR_INVALID_PARAMETER );
+
+        const uint32_t subDeviceIndex = metricsDevice ? metricsDevice->GetSubDeviceIndex() : MD_DRIVER_RECORD_NO_SUB_DEVICE;
+        const uint64_t key            = ( static_cast<uint64_t>( param ) << 32 ) | subDeviceIndex;
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto values = m_deviceParams.find( key );
+        if( values == m_deviceParams.end() || values->second.empty() )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Device param %u not recorded", static_cast<uint32_t>( param ) );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        const TDriverRecordDeviceParam record = values->second.front();
+        if( values->second.size() > 1 )
+        {
+            values->second.pop_front();
+        }
+
+        *out = record.Out;
+        return static_cast<TCompletionCode>( record.Result );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     SendPmRegsConfig
+    //
+    // Description:
+    //     Configurations are not replayed, query configurations are ignored.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::SendPmRegsConfig( TRegister** regVector, const uint32_t regCount, const uint32_t apiMask, const uint32_t subDeviceIndex, const GTDI_OA_BUFFER_TYPE oaBufferType )
+    {
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetGpuCpuTimestamps
+    //
+    // Description:
+    //     Returns the next recorded GPU and CPU timestamps. Once recorded
+    //     timestamps run out, both are advanced by their last recorded delta.
+    //
+    // Input:
+    //     CMetricsDevice& device               - metrics device
+    //     uint64_t*       gpuTimestamp         - (out) gpu timestamp in ns
+    //     uint64_t*       cpuTimestamp         - (out) cpu timestamp in ns
+    //     uint32_t*       cpuId                - (out) cpu id
+    //     uint64_t*       correlationIndicator - (out) correlation indicator
+    //
+    // Output:
+    //     TCompletionCode                      - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetGpuCpuTimestamps( CMetricsDevice& device, uint64_t* gpuTimestamp, uint64_t* cpuTimestamp, uint32_t* cpuId, uint64_t* correlationIndicator )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto timestamps = m_timestamps.find( device.GetSubDeviceIndex() );
+        if( timestamps == m_timestamps.end() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Timestamps not recorded" );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        auto& replay = timestamps->second;
+
+        if( replay.Timestamps.empty() )
+        {
+            replay.Last.GpuTimestamp += replay.GpuDelta;
+            replay.Last.CpuTimestamp += replay.CpuDelta;
+        }
+        else
+        {
+            replay.Last = replay.Timestamps.front();
+            replay.Timestamps.pop_front();
+        }
+
+        if( gpuTimestamp )
+        {
+            *gpuTimestamp = replay.Last.GpuTimestamp;
+        }
+        if( cpuTimestamp )
+        {
+            *cpuTimestamp = replay.Last.CpuTimestamp;
+        }
+        if( cpuId )
+        {
+            *cpuId = replay.Last.CpuId;
+        }
+        if( correlationIndicator )
+        {
+            *correlationIndicator = replay.Last.CorrelationIndicator;
+        }
+
+        return static_cast<TCompletionCode>( replay.Last.Result );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     IsTbsEngineValid
+    //
+    // Description:
+    //     Returns the recorded result of the engine check.
+    //
+    // Input:
+    //     const TEngineParams_1_9& engineParams      - engine params
+    //     const uint32_t           requestedInstance - requested engine instance
+    //     const bool               isOam             - *true* if an oam engine is required
+    //
+    // Output:
+    //     bool                                       - *true* if the engine is valid
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxReplay::IsTbsEngineValid( const TEngineParams_1_9& engineParams, const uint32_t requestedInstance /* = -1 */, const bool isOam /* = false */ ) const
+    {
+        const std::array<uint32_t, 5> key = { DRIVER_RECORD_QUERY_TBS_ENGINE_VALID, engineParams.EngineId.ClassInstance.Class, engineParams.EngineId.ClassInstance.Instance, requestedInstance, isOam };
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto query = m_queries.find( key );
+        return ( query != m_queries.end() ) && query->second;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     OpenIoStream
+    //
+    // Description:
+    //     Opens the next recorded stream of the metrics device and the OA buffer
+    //     and returns its recorded params.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
+    //     uint32_t            processId         - PID of the measured app (0 is global context)
+    //     uint32_t&           nsTimerPeriod     - (in/out) requested/set sampling period time in nanoseconds
+    //     uint32_t&           bufferSize        - (in/out) requested/set OA Buffer/buffer size in bytes, 0 means default
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize )
+    {
+        auto& metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+        auto  metricSet     = oaConcurrentGroup.GetIoMetricSet();
+
+        MD_CHECK_PTR_RET_A( m_adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
+
+        if( !IsStreamTypeSupported( oaConcurrentGroup.GetStreamType() ) )
+        {
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        auto ret = metricSet->ActivateInternal( false, false );
+        MD_CHECK_CC_RET_A( m_adapterId, ret );
+
+        const TDriverRecordStream recordStream = { metricsDevice.GetSubDeviceIndex(), static_cast<uint32_t>( oaConcurrentGroup.GetOaBufferType() ) };
+        const uint64_t            key          = CDriverInterfaceLinuxRecorder::GetStreamKey( recordStream );
+
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        auto streams = m_streams.find( key );
+        if( streams == m_streams.end() || streams->second.empty() )
+        {
+            lock.unlock();
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: No more recorded streams, sub device: %u, oa buffer: %u", recordStream.SubDeviceIndex, recordStream.OaBufferType );
+            metricSet->Deactivate();
+            return CC_ERROR_GENERAL;
+        }
+
+        TReplayStream stream = std::move( streams->second.front() );
+        streams->second.pop_front();
+
+        ret = static_cast<TCompletionCode>( stream.Open.Result );
+        if( ret != CC_OK )
+        {
+            lock.unlock();
+            metricSet->Deactivate();
+            return ret;
+        }
+
+        nsTimerPeriod   = stream.Open.NsTimerPeriod;
+        bufferSize      = stream.Open.BufferSize;
+        stream.OpenTime = std::chrono::steady_clock::now();
+
+        m_openedStreams[key]         = std::move( stream );
+        const int32_t streamConfigId = m_nextStreamConfigId++;
+        lock.unlock();
+
+        metricsDevice.SetStreamPaused( oaConcurrentGroup.IsIoStreamPaused() );
+        metricsDevice.SetStreamConfigId( streamConfigId );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Replayed oa stream opened, periodNs: %u, bufferSize: %u", nsTimerPeriod, bufferSize );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     ReadIoStream
+    //
+    // Description:
+    //     Returns recorded reports of the opened stream.
+    //
+    // Input:
+    //     COAConcurrentGroup&              oaConcurrentGroup - oa concurrent group
+    //     uint32_t                         readFlags         - read flags
+    //     char*                            reportData        - (out) pointer to the read data
+    //     uint32_t&                        reportsCount      - (in/out) reports read/to read from the stream
+    //     uint32_t&                        frequency         - (out) frequency of the recorded reports
+    //     GTDIReadCounterStreamExceptions& exceptions        - (out) recorded exceptions
+    //
+    // Output:
+    //     TCompletionCode                                    - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::ReadIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, char* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        auto metricSet = oaConcurrentGroup.GetIoMetricSet();
+
+        MD_CHECK_PTR_RET_A( m_adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, reportData, CC_ERROR_INVALID_PARAMETER );
+
+        const TDriverRecordStream recordStream = { oaConcurrentGroup.GetMetricsDevice().GetSubDeviceIndex(), static_cast<uint32_t>( oaConcurrentGroup.GetOaBufferType() ) };
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto stream = m_openedStreams.find( CDriverInterfaceLinuxRecorder::GetStreamKey( recordStream ) );
+        if( stream == m_openedStreams.end() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Oa stream not opened" );
+            reportsCount = 0;
+            return CC_ERROR_GENERAL;
+        }
+
+        return TakeReports( stream->second, metricSet->GetParams()->RawReportSize, reinterpret_cast<uint8_t*>( reportData ), reportsCount, frequency, exceptions );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     ReadIoStreamView
+    //
+    // Description:
+    //     Copies recorded reports of the opened stream to the metrics device
+    //     stream buffer, described by a single stream span.
+    //
+    // Input:
+    //     COAConcurrentGroup&              oaConcurrentGroup - oa concurrent group
+    //     uint32_t                         readFlags         - read flags
+    //     uint32_t&                        reportsCount      - (in/out) reports read/to read from the stream
+    //     uint32_t&                        frequency         - (out) frequency of the recorded reports
+    //     GTDIReadCounterStreamExceptions& exceptions        - (out) recorded exceptions
+    //
+    // Output:
+    //     TCompletionCode                                    - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        auto& metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+        auto& streamBuffer  = metricsDevice.GetStreamBuffer();
+        auto& streamSpans   = metricsDevice.GetStreamSpans();
+        auto  metricSet     = oaConcurrentGroup.GetIoMetricSet();
+
+        MD_CHECK_PTR_RET_A( m_adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
+
+        const uint32_t reportSize = metricSet->GetParams()->RawReportSize;
+        const size_t   bytes      = static_cast<size_t>( reportsCount ) * reportSize;
+
+        streamSpans.clear();
+
+        if( streamBuffer.GetSize() < bytes && streamBuffer.Resize( bytes ) != CC_OK )
+        {
+            reportsCount = 0;
+            return CC_ERROR_NO_MEMORY;
+        }
+
+        const TDriverRecordStream recordStream = { metricsDevice.GetSubDeviceIndex(), static_cast<uint32_t>( oaConcurrentGroup.GetOaBufferType() ) };
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto stream = m_openedStreams.find( CDriverInterfaceLinuxRecorder::GetStreamKey( recordStream ) );
+        if( stream == m_openedStreams.end() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Oa stream not opened" );
+            reportsCount = 0;
+            return CC_ERROR_GENERAL;
+        }
+
+        const TCompletionCode ret = TakeReports( stream->second, reportSize, streamBuffer.GetData(), reportsCount, frequency, exceptions );
+
+        if( reportsCount )
+        {
+            streamSpans.push_back( { streamBuffer.GetData(), reportSize, reportsCount } );
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     SwitchIoStream
+    //
+    // Description:
+    //     Switches the opened stream to another metric set. Recorded reports are
+    //     replayed unchanged.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group with an opened stream
+    //     CMetricSet&         metricSet         - metric set to switch to
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::SwitchIoStream( COAConcurrentGroup& oaConcurrentGroup, CMetricSet& metricSet )
+    {
+        auto& metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+
+        if( metricsDevice.GetStreamConfigId() == -1 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Oa stream not opened" );
+            return CC_ERROR_GENERAL;
+        }
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        metricsDevice.SetStreamConfigId( m_nextStreamConfigId++ );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     CloseIoStream
+    //
+    // Description:
+    //     Closes the replayed stream. Its remaining recorded reports are dropped.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::CloseIoStream( COAConcurrentGroup& oaConcurrentGroup )
+    {
+        auto& metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+        auto  metricSet     = oaConcurrentGroup.GetIoMetricSet();
+
+        MD_CHECK_PTR_RET_A( m_adapterId, metricSet, CC_ERROR_INVALID_PARAMETER );
+
+        const TDriverRecordStream recordStream = { metricsDevice.GetSubDeviceIndex(), static_cast<uint32_t>( oaConcurrentGroup.GetOaBufferType() ) };
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_openedStreams.erase( CDriverInterfaceLinuxRecorder::GetStreamKey( recordStream ) );
+        }
+        m_readCondition.notify_all();
+
+        metricsDevice.SetStreamPaused( false );
+        metricsDevice.SetStreamConfigId( -1 );
+
+        return metricSet->Deactivate();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     WaitForIoStreamReports
+    //
+    // Description:
+    //     Waits until the next recorded reports of the opened stream are
+    //     available. Without pacing recorded reports are available at once.
+    //
+    // Input:
+    //     COAConcurrentGroup& oaConcurrentGroup - oa concurrent group
+    //     const uint32_t      milliseconds      - timeout in milliseconds
+    //
+    // Output:
+    //     TCompletionCode                       - *CC_OK* if reports are available,
+    //                                             *CC_WAIT_TIMEOUT* on timeout
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::WaitForIoStreamReports( COAConcurrentGroup& oaConcurrentGroup, const uint32_t milliseconds )
+    {
+        const TDriverRecordStream recordStream = { oaConcurrentGroup.GetMetricsDevice().GetSubDeviceIndex(), static_cast<uint32_t>( oaConcurrentGroup.GetOaBufferType() ) };
+        const uint64_t            key          = CDriverInterfaceLinuxRecorder::GetStreamKey( recordStream );
+        const auto                deadline     = std::chrono::steady_clock::now() + std::chrono::milliseconds( milliseconds );
+
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        while( true )
+        {
+            auto stream = m_openedStreams.find( key );
+            if( stream == m_openedStreams.end() )
+            {
+                return CC_ERROR_GENERAL;
+            }
+
+            // Once the recorded stream ends, waits until the timeout or until the stream is closed
+            auto  wakeup = deadline;
+            auto& reads  = stream->second.Reads;
+            if( !reads.empty() )
+            {
+                if( IsReadAvailable( stream->second, reads.front() ) )
+                {
+                    return CC_OK;
+                }
+
+                wakeup = std::min( deadline, stream->second.OpenTime + std::chrono::nanoseconds( reads.front().Read.TimeNs ) );
+            }
+
+            if( std::chrono::steady_clock::now() >= deadline )
+            {
+                return CC_WAIT_TIMEOUT;
+            }
+
+            m_readCondition.wait_until( lock, wakeup );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     CreateIoStreamGroup
+    //
+    // Description:
+    //     Stream groups wait on stream file descriptors, not available in replay.
+    //
+    // Output:
+    //     IInternalIoStreamGroup* - nullptr
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    IInternalIoStreamGroup* CDriverInterfaceLinuxReplay::CreateIoStreamGroup()
+    {
+        MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Stream groups are not supported in replay" );
+        return nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetOaStreamBufferSize
+    //
+    // Description:
+    //     Returns the size of a buffer for the given reports.
+    //
+    // Input:
+    //     const uint32_t reportSize    - report size in bytes
+    //     const uint32_t reportsToRead - reports count
+    //
+    // Output:
+    //     size_t                       - buffer size in bytes
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    size_t CDriverInterfaceLinuxReplay::GetOaStreamBufferSize( const uint32_t reportSize, const uint32_t reportsToRead )
+    {
+        return static_cast<size_t>( reportSize ) * reportsToRead;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     SetFrequencyOverride
+    //
+    // Description:
+    //     Overrides are not replayed.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::SetFrequencyOverride( const TSetFrequencyOverrideParams_1_2* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     SetQueryOverride
+    //
+    // Description:
+    //     Overrides are not replayed.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::SetQueryOverride( TOverrideType overrideType, uint32_t oaBufferSize, const TSetQueryOverrideParams_1_2* params )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     SetFreqChangeReportsOverride
+    //
+    // Description:
+    //     Overrides are not replayed.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::SetFreqChangeReportsOverride( bool enable )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     IsOverrideAvailable
+    //
+    // Description:
+    //     Overrides are not replayed.
+    //
+    // Output:
+    //     bool - *false*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxReplay::IsOverrideAvailable( TOverrideType overrideType )
+    {
+        return false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     IsSubDeviceSupported
+    //
+    // Description:
+    //     Returns the recorded sub device support.
+    //
+    // Output:
+    //     bool - *true* if sub devices are supported
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxReplay::IsSubDeviceSupported()
+    {
+        const std::array<uint32_t, 5> key = { DRIVER_RECORD_QUERY_SUB_DEVICE_SUPPORTED, 0, 0, 0, 0 };
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto query = m_queries.find( key );
+        return ( query != m_queries.end() ) && query->second;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     EnumerateSubDevices
+    //
+    // Description:
+    //     Adds recorded sub devices and their engines.
+    //
+    // Input:
+    //     CSubDevices& subDevices - sub devices
+    //
+    // Output:
+    //     TCompletionCode         - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::EnumerateSubDevices( CSubDevices& subDevices )
+    {
+        if( m_subDeviceEngines.empty() )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Platform without sub devices" );
+            return CC_OK;
+        }
+
+        for( const auto& engines : m_subDeviceEngines )
+        {
+            subDevices.AppendSubDeviceEngine();
+
+            for( const auto& engine : engines )
+            {
+                TCompletionCode ret = subDevices.AddEngine( engine.Class, engine.Instance );
+                MD_CHECK_CC_RET_A( m_adapterId, ret );
+            }
+        }
+
+        subDevices.MakeSpaceForMetricsDevices();
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Sub devices count %u", subDevices.GetAllEnginesCount() );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetEuCoresTotalCount
+    //
+    // Description:
+    //     Global symbols are read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetEuCoresTotalCount( GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetEuCoresPerSubsliceCount
+    //
+    // Description:
+    //     Global symbols are read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetEuCoresPerSubsliceCount( GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetSliceMask
+    //
+    // Description:
+    //     Global symbols are read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetSliceMask( int32_t* sliceMask, CMetricsDevice* metricsDevice )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetSubsliceMask
+    //
+    // Description:
+    //     Global symbols are read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetSubsliceMask( int64_t* subsliceMask, CMetricsDevice* metricsDevice )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     OpenOaStream
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::OpenOaStream( CMetricsDevice& metricsDevice, uint32_t oaMetricSetId, uint32_t oaReportType, uint32_t timerPeriodExponent, uint32_t& bufferSize, const GTDI_OA_BUFFER_TYPE oaBufferType, const uint32_t pollPeriodNs, const bool disabled )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     ReadOaStream
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::ReadOaStream( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, char* reportData, uint32_t& readBytes, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     ReadOaStreamView
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::ReadOaStreamView( CMetricsDevice& metricsDevice, uint32_t reportSize, uint32_t reportsToRead, uint32_t& readReports, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     ChangeOaStreamConfig
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::ChangeOaStreamConfig( CMetricsDevice& metricsDevice, const int32_t oaMetricSetId )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     AddOaConfig
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::AddOaConfig( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, const char* requestedGuid, int32_t& addedConfigId, bool* added )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     RemoveOaConfig
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::RemoveOaConfig( int32_t oaConfigId )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetOaTimestampFrequency
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetOaTimestampFrequency( uint64_t& frequency )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetCsTimestampFrequency
+    //
+    // Description:
+    //     Replayed streams are opened and read at the IO Stream level, there is
+    //     no OA stream or configuration underneath.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetCsTimestampFrequency( uint64_t& frequency )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     EnableOaStream
+    //
+    // Description:
+    //     Pausing a replayed stream has no effect on the recorded reports.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::EnableOaStream( CMetricsDevice& metricsDevice, const bool enable )
+    {
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetOaReportType
+    //
+    // Description:
+    //     No OA stream is opened in replay.
+    //
+    // Output:
+    //     uint32_t - -1
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CDriverInterfaceLinuxReplay::GetOaReportType( const TReportType reportType )
+    {
+        return static_cast<uint32_t>( -1 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetDeviceId
+    //
+    // Description:
+    //     Device info is read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetDeviceId( int32_t& deviceId )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetRevisionId
+    //
+    // Description:
+    //     Device info is read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetRevisionId( int32_t& revisionId )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetOaBufferSupportedSizes
+    //
+    // Description:
+    //     Device info is read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetOaBufferSupportedSizes( const uint32_t platformId, uint32_t& minSize, uint32_t& maxSize )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     GetOaBufferCount
+    //
+    // Description:
+    //     Device info is read through recorded device params only.
+    //
+    // Output:
+    //     TCompletionCode - *CC_ERROR_NOT_SUPPORTED*
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::GetOaBufferCount( CMetricsDevice& metricsDevice, uint32_t& oaBufferCount )
+    {
+        return CC_ERROR_NOT_SUPPORTED;
+    }
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     ParseRecords
+    //
+    // Description:
+    //     Splits the driver record file into replayed device params, timestamps,
+    //     queries, sub devices and streams. A truncated last record, e.g. of
+    //     a recorded process that was killed, is ignored.
+    //
+    // Input:
+    //     const std::vector<uint8_t>& file - driver record file
+    //
+    // Output:
+    //     TCompletionCode                  - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::ParseRecords( const std::vector<uint8_t>& file )
+    {
+        std::map<uint64_t, TReplayStream*> recordedStreams; // Opened while recording, key is GetStreamKey
+        size_t                             offset = sizeof( TDriverRecordFileHeader );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        while( offset + sizeof( TDriverRecordHeader ) <= file.size() )
+        {
+            TDriverRecordHeader recordHeader = {};
+            memcpy( &recordHeader, file.data() + offset, sizeof( recordHeader ) );
+            offset += sizeof( recordHeader );
+
+            if( offset + recordHeader.Size > file.size() )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Truncated record ignored" );
+                break;
+            }
+
+            const uint8_t* record = file.data() + offset;
+            offset += recordHeader.Size;
+
+            switch( recordHeader.Type )
+            {
+                case DRIVER_RECORD_ADAPTER:
+                    break;
+
+                case DRIVER_RECORD_DEVICE_PARAM:
+                {
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( TDriverRecordDeviceParam ) ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    TDriverRecordDeviceParam deviceParam = {};
+                    memcpy( &deviceParam, record, sizeof( deviceParam ) );
+
+                    m_deviceParams[( static_cast<uint64_t>( deviceParam.Param ) << 32 ) | deviceParam.SubDeviceIndex].push_back( deviceParam );
+                    break;
+                }
+
+                case DRIVER_RECORD_TIMESTAMPS:
+                {
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( TDriverRecordTimestamps ) ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    TDriverRecordTimestamps timestamps = {};
+                    memcpy( &timestamps, record, sizeof( timestamps ) );
+
+                    auto& replay = m_timestamps[timestamps.SubDeviceIndex];
+                    if( !replay.Timestamps.empty() && timestamps.Result == CC_OK && replay.Timestamps.back().Result == CC_OK )
+                    {
+                        replay.GpuDelta = timestamps.GpuTimestamp - replay.Timestamps.back().GpuTimestamp;
+                        replay.CpuDelta = timestamps.CpuTimestamp - replay.Timestamps.back().CpuTimestamp;
+                    }
+                    replay.Timestamps.push_back( timestamps );
+                    break;
+                }
+
+                case DRIVER_RECORD_QUERY:
+                {
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( TDriverRecordQuery ) ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    TDriverRecordQuery query = {};
+                    memcpy( &query, record, sizeof( query ) );
+
+                    m_queries[{ query.Query, query.Arguments[0], query.Arguments[1], query.Arguments[2], query.Arguments[3] }] = query.Result != 0;
+                    break;
+                }
+
+                case DRIVER_RECORD_SUB_DEVICE:
+                {
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( TDriverRecordSubDevice ) ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    TDriverRecordSubDevice subDevice = {};
+                    memcpy( &subDevice, record, sizeof( subDevice ) );
+
+                    const size_t enginesSize = static_cast<size_t>( subDevice.EngineCount ) * sizeof( TEngineIdClassInstance_1_9 );
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( subDevice ) + enginesSize ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    // Sub devices are recorded again by each enumeration, the last one is replayed
+                    if( subDevice.SubDeviceIndex == 0 )
+                    {
+                        m_subDeviceEngines.clear();
+                    }
+
+                    std::vector<TEngineIdClassInstance_1_9> engines( subDevice.EngineCount );
+                    memcpy( engines.data(), record + sizeof( subDevice ), enginesSize );
+
+                    m_subDeviceEngines.push_back( std::move( engines ) );
+                    break;
+                }
+
+                case DRIVER_RECORD_STREAM_OPEN:
+                {
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( TDriverRecordStreamOpen ) ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    TReplayStream stream = {};
+                    memcpy( &stream.Open, record, sizeof( stream.Open ) );
+
+                    const uint64_t key     = CDriverInterfaceLinuxRecorder::GetStreamKey( stream.Open.Stream );
+                    auto&          streams = m_streams[key];
+
+                    streams.push_back( std::move( stream ) );
+
+                    // Only opened streams are read, failed ones are replayed as failed opens
+                    if( streams.back().Open.Result == CC_OK )
+                    {
+                        recordedStreams[key] = &streams.back();
+                    }
+                    break;
+                }
+
+                case DRIVER_RECORD_STREAM_READ:
+                {
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( TDriverRecordStreamRead ) ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    TReplayStreamRead read = {};
+                    memcpy( &read.Read, record, sizeof( read.Read ) );
+
+                    const size_t reportsSize = static_cast<size_t>( read.Read.ReportCount ) * read.Read.ReportSize;
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( read.Read ) + reportsSize ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    auto stream = recordedStreams.find( CDriverInterfaceLinuxRecorder::GetStreamKey( read.Read.Stream ) );
+                    if( stream == recordedStreams.end() )
+                    {
+                        MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Read of a not opened stream ignored" );
+                        break;
+                    }
+
+                    read.Reports.assign( record + sizeof( read.Read ), record + sizeof( read.Read ) + reportsSize );
+                    stream->second->Reads.push_back( std::move( read ) );
+                    break;
+                }
+
+                case DRIVER_RECORD_STREAM_CLOSE:
+                {
+                    MD_CHECK_CC_RET_A( m_adapterId, ( recordHeader.Size >= sizeof( TDriverRecordStream ) ) ? CC_OK : CC_ERROR_GENERAL );
+
+                    TDriverRecordStream stream = {};
+                    memcpy( &stream, record, sizeof( stream ) );
+
+                    recordedStreams.erase( CDriverInterfaceLinuxRecorder::GetStreamKey( stream ) );
+                    break;
+                }
+
+                default:
+                    MD_LOG_A( m_adapterId, LOG_DEBUG, "Unknown record type %u ignored", recordHeader.Type );
+                    break;
+            }
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     TakeReports
+    //
+    // Description:
+    //     Copies available recorded reports of the stream, across recorded reads.
+    //     A recorded read error is returned once all reports before it are taken.
+    //     Must be called with m_mutex locked.
+    //
+    // Input:
+    //     TReplayStream&                   stream       - opened stream
+    //     const uint32_t                   reportSize   - report size of the opened metric set
+    //     uint8_t*                         reportData   - (out) reports
+    //     uint32_t&                        reportsCount - (in/out) reports taken/to take
+    //     uint32_t&                        frequency    - (out) frequency of the taken reports
+    //     GTDIReadCounterStreamExceptions& exceptions   - (out) exceptions of the taken reads
+    //
+    // Output:
+    //     TCompletionCode                               - *CC_OK* or *CC_READ_PENDING* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::TakeReports( TReplayStream& stream, const uint32_t reportSize, uint8_t* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        const uint32_t  reportsToTake = reportsCount;
+        TCompletionCode ret           = CC_OK;
+
+        reportsCount = 0;
+
+        while( reportsCount < reportsToTake && !stream.Reads.empty() )
+        {
+            auto& read = stream.Reads.front();
+
+            if( !IsReadAvailable( stream, read ) )
+            {
+                break;
+            }
+
+            const TCompletionCode readResult = static_cast<TCompletionCode>( read.Read.Result );
+            if( readResult != CC_OK && readResult != CC_READ_PENDING )
+            {
+                if( reportsCount == 0 )
+                {
+                    ret = readResult;
+                    stream.Reads.pop_front();
+                }
+                break;
+            }
+
+            if( read.Read.ReportCount && read.Read.ReportSize != reportSize )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Recorded report size %u, opened metric set report size %u", read.Read.ReportSize, reportSize );
+                ret = CC_ERROR_GENERAL;
+                break;
+            }
+
+            // Exceptions are returned with the first report of the read
+            if( read.ReportOffset == 0 )
+            {
+                exceptions.ReportLost |= read.Read.Exceptions.ReportLost;
+                exceptions.BufferOverflow |= read.Read.Exceptions.BufferOverflow;
+                exceptions.BufferOverrun |= read.Read.Exceptions.BufferOverrun;
+                exceptions.CountersOverflow |= read.Read.Exceptions.CountersOverflow;
+                exceptions.FrequencyChanged |= read.Read.Exceptions.FrequencyChanged;
+            }
+
+            const uint32_t count = std::min( read.Read.ReportCount - read.ReportOffset, reportsToTake - reportsCount );
+
+            if( count )
+            {
+                memcpy( reportData + static_cast<size_t>( reportsCount ) * reportSize, read.Reports.data() + static_cast<size_t>( read.ReportOffset ) * reportSize, static_cast<size_t>( count ) * reportSize );
+            }
+
+            read.ReportOffset += count;
+            reportsCount += count;
+            stream.Frequency = read.Read.Frequency;
+
+            if( read.ReportOffset == read.Read.ReportCount )
+            {
+                stream.Reads.pop_front();
+            }
+        }
+
+        frequency = stream.Frequency;
+
+        if( ret == CC_OK && reportsCount < reportsToTake )
+        {
+            ret = CC_READ_PENDING;
+        }
+
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     IsReadAvailable
+    //
+    // Description:
+    //     Checks if a recorded read may be returned. Paced reads are available
+    //     once the time they were recorded at since the stream opened passes.
+    //
+    // Input:
+    //     const TReplayStream&     stream - opened stream
+    //     const TReplayStreamRead& read   - recorded read
+    //
+    // Output:
+    //     bool                            - *true* if the read is available
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CDriverInterfaceLinuxReplay::IsReadAvailable( const TReplayStream& stream, const TReplayStreamRead& read ) const
+    {
+        if( !m_paced )
+        {
+            return true;
+        }
+
+        return std::chrono::steady_clock::now() >= stream.OpenTime + std::chrono::nanoseconds( read.Read.TimeNs );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CDriverInterfaceLinuxReplay
+    //
+    // Method:
+    //     LoadFile
+    //
+    // Description:
+    //     Reads the whole driver record file and validates its header.
+    //
+    // Input:
+    //     const char*           fileName - driver record file
+    //     std::vector<uint8_t>& file     - (out) file contents
+    //
+    // Output:
+    //     TCompletionCode                - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CDriverInterfaceLinuxReplay::LoadFile( const char* fileName, std::vector<uint8_t>& file )
+    {
+        MD_CHECK_PTR_RET( fileName, CC_ERROR_INVALID_PARAMETER );
+
+        FILE* stream = nullptr;
+        iu_fopen_s( &stream, fileName, "rb" );
+        if( stream == nullptr )
+        {
+            MD_LOG( LOG_ERROR, "ERROR: Cannot open driver record file %s", fileName );
+            return CC_ERROR_FILE_NOT_FOUND;
+        }
+
+        fseek( stream, 0, SEEK_END );
+        const long size = ftell( stream );
+        fseek( stream, 0, SEEK_SET );
+
+        if( size > 0 )
+        {
+            file.resize( static_cast<size_t>( size ) );
+            file.resize( iu_fread_s( file.data(), file.size(), 1, file.size(), stream ) );
+        }
+
+        fclose( stream );
+
+        TDriverRecordFileHeader header = {};
+        if( file.size() >= sizeof( header ) )
+        {
+            memcpy( &header, file.data(), sizeof( header ) );
+        }
+
+        if( header.Magic != MD_DRIVER_RECORD_MAGIC || header.Version != MD_DRIVER_RECORD_VERSION )
+        {
+            MD_LOG( LOG_ERROR, "ERROR: Invalid driver record file %s", fileName );
+            return CC_ERROR_GENERAL;
+        }
+
+        return CC_OK;
+    }
+} // namespace MetricsDiscoveryInternal
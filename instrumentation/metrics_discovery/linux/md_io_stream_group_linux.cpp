@@ -0,0 +1,1021 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_group_linux.cpp
+//
+//     Abstract:   C++ epoll and io_uring based IoStream group for Linux
+
+#include "md_io_stream_group_linux.h"
+#include "md_io_uring_linux.h"
+#include "md_driver_ifc_linux_common.h"
+#include "md_oa_concurrent_group.h"
+#include "md_metric_set.h"
+#include "md_metrics_device.h"
+#include "md_utils.h"
+
+#include <algorithm>
+#include <errno.h>
+
+#include <poll.h>
+#include <unistd.h> // close
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     CIoStreamGroupLinux constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     const uint32_t               adapterId       - adapter id for logging
+    //     CDriverInterfaceLinuxCommon& driverInterface - driver interface owning the streams
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamGroupLinux::CIoStreamGroupLinux( const uint32_t adapterId, CDriverInterfaceLinuxCommon& driverInterface )
+        : m_adapterId( adapterId )
+        , m_driverInterface( driverInterface )
+        , m_epollFd( -1 )
+        , m_entries()
+        , m_events()
+        , m_readyGroups()
+        , m_nextEntryId( 1 )
+        , m_ioUring( nullptr )
+        , m_buffers()
+        , m_useFixedBuffers( true )
+        , m_orphanedBuffers()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     ~CIoStreamGroupLinux
+    //
+    // Description:
+    //     Destructor. Cancels io_uring reads and closes the epoll instance.
+    //     Registered streams are not closed, they are still owned by their
+    //     concurrent groups.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamGroupLinux::~CIoStreamGroupLinux()
+    {
+        if( m_ioUring )
+        {
+            CancelReads();
+            MD_SAFE_DELETE( m_ioUring );
+        }
+
+        for( auto& entry : m_entries )
+        {
+            MD_SAFE_DELETE( entry.Buffer );
+        }
+        for( auto& buffer : m_orphanedBuffers )
+        {
+            MD_SAFE_DELETE( buffer );
+        }
+
+        if( m_epollFd >= 0 )
+        {
+            close( m_epollFd );
+            m_epollFd = -1;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     Initialize
+    //
+    // Description:
+    //     Creates the epoll instance.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::Initialize()
+    {
+        m_epollFd = epoll_create1( EPOLL_CLOEXEC );
+        if( m_epollFd < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: cannot create epoll instance, errno: %d", errno );
+            return CC_ERROR_GENERAL;
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     AddStream
+    //
+    // Description:
+    //     Registers the opened IO stream of the given concurrent group.
+    //
+    // Input:
+    //     IConcurrentGroupLatest* concurrentGroup - concurrent group with an opened IO stream
+    //
+    // Output:
+    //     TCompletionCode                         - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::AddStream( IConcurrentGroupLatest* concurrentGroup )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, concurrentGroup, CC_ERROR_INVALID_PARAMETER );
+
+        CConcurrentGroup* group            = static_cast<CConcurrentGroup*>( concurrentGroup );
+        const int32_t     streamId         = group->GetMetricsDevice().GetStreamId();
+        const uint32_t    streamGeneration = group->GetMetricsDevice().GetStreamGeneration();
+
+        if( streamId < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream not opened" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        for( const auto& entry : m_entries )
+        {
+            if( entry.ConcurrentGroup == group || entry.StreamId == streamId )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream already added" );
+                return CC_ALREADY_INITIALIZED;
+            }
+        }
+
+        epoll_event event = {};
+        event.events      = EPOLLIN;
+        event.data.ptr    = group;
+
+        if( epoll_ctl( m_epollFd, EPOLL_CTL_ADD, streamId, &event ) != 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: cannot add stream %d to epoll, errno: %d", streamId, errno );
+            return CC_ERROR_GENERAL;
+        }
+
+        CStreamBuffer* buffer = new( std::nothrow ) CStreamBuffer();
+        if( buffer == nullptr )
+        {
+            epoll_ctl( m_epollFd, EPOLL_CTL_DEL, streamId, nullptr );
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: cannot allocate stream read buffer" );
+            return CC_ERROR_NO_MEMORY;
+        }
+
+        m_entries.push_back( { group, streamId, streamGeneration, m_nextEntryId++, 0, false, 0, 0, 0, -1, buffer } );
+        m_events.resize( m_entries.size() );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     RemoveStream
+    //
+    // Description:
+    //     Unregisters the IO stream of the given concurrent group. A pending
+    //     io_uring read of the stream is cancelled, so the stream must be removed
+    //     before it is closed.
+    //
+    // Input:
+    //     IConcurrentGroupLatest* concurrentGroup - previously added concurrent group
+    //
+    // Output:
+    //     TCompletionCode                         - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::RemoveStream( IConcurrentGroupLatest* concurrentGroup )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, concurrentGroup, CC_ERROR_INVALID_PARAMETER );
+
+        CConcurrentGroup* group = static_cast<CConcurrentGroup*>( concurrentGroup );
+
+        for( auto it = m_entries.begin(); it != m_entries.end(); ++it )
+        {
+            if( it->ConcurrentGroup == group )
+            {
+                if( m_ioUring )
+                {
+                    CancelRead( *it );
+                }
+
+                // Stream closed before removal is already dropped from the epoll set.
+                if( epoll_ctl( m_epollFd, EPOLL_CTL_DEL, it->StreamId, nullptr ) != 0 && errno != EBADF && errno != ENOENT )
+                {
+                    MD_LOG_A( m_adapterId, LOG_WARNING, "warning: cannot remove stream %d from epoll, errno: %d", it->StreamId, errno );
+                }
+
+                DeleteBuffer( *it );
+                m_entries.erase( it );
+                m_events.resize( m_entries.size() );
+                return CC_OK;
+            }
+        }
+
+        MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream not found in the stream group" );
+        return CC_ERROR_INVALID_PARAMETER;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     GetStreamCount
+    //
+    // Description:
+    //     Returns the number of registered streams.
+    //
+    // Output:
+    //     uint32_t - stream count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamGroupLinux::GetStreamCount( void )
+    {
+        return static_cast<uint32_t>( m_entries.size() );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     WaitForReports
+    //
+    // Description:
+    //     Waits with a single epoll_wait until any of the registered streams has
+    //     reports available and returns concurrent groups of ready streams.
+    //     Streams signaling an error are returned too, so the following
+    //     ReadIoStream reports the failure to the client.
+    //
+    // Input:
+    //     uint32_t                 milliseconds        - wait timeout in milliseconds
+    //     IConcurrentGroupLatest** outReadyGroups      - [out] concurrent groups of ready streams
+    //     uint32_t                 outReadyGroupsCount - outReadyGroups array size
+    //     uint32_t*                outReadyCount       - [out] number of ready streams
+    //
+    // Output:
+    //     TCompletionCode                              - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::WaitForReports( uint32_t milliseconds, IConcurrentGroupLatest** outReadyGroups, uint32_t outReadyGroupsCount, uint32_t* outReadyCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, outReadyGroups, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, outReadyCount, CC_ERROR_INVALID_PARAMETER );
+
+        *outReadyCount = 0;
+
+        UpdateStreams();
+
+        if( m_entries.empty() || outReadyGroupsCount == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: no streams or empty output" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        const uint32_t maxEvents = std::min<uint32_t>( outReadyGroupsCount, static_cast<uint32_t>( m_events.size() ) );
+        const int32_t  result    = epoll_wait( m_epollFd, m_events.data(), maxEvents, static_cast<int32_t>( milliseconds ) );
+
+        if( result == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "Wait timeout" );
+            return CC_WAIT_TIMEOUT;
+        }
+        else if( result < 0 )
+        {
+            if( errno == EINTR )
+            {
+                MD_LOG_A( m_adapterId, LOG_DEBUG, "Wait interrupted" );
+                return CC_INTERRUPTED;
+            }
+
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: epoll wait failed, errno: %d", errno );
+            return CC_ERROR_GENERAL;
+        }
+
+        for( int32_t i = 0; i < result; ++i )
+        {
+            if( m_events[i].events & ( EPOLLIN | EPOLLERR | EPOLLHUP ) )
+            {
+                outReadyGroups[( *outReadyCount )++] = static_cast<CConcurrentGroup*>( m_events[i].data.ptr );
+            }
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     SetReadBackend
+    //
+    // Description:
+    //     Selects how ReadReports reads the streams. If io_uring is not available
+    //     (kernel older than 5.11 or disabled), poll backend stays selected.
+    //
+    // Input:
+    //     TIoStreamGroupBackend backend - read backend
+    //
+    // Output:
+    //     TCompletionCode               - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::SetReadBackend( TIoStreamGroupBackend backend )
+    {
+        switch( backend )
+        {
+            case IO_STREAM_GROUP_BACKEND_POLL:
+                if( m_ioUring )
+                {
+                    CancelReads();
+                    MD_SAFE_DELETE( m_ioUring );
+                    m_buffers.clear();
+
+                    for( auto& buffer : m_orphanedBuffers )
+                    {
+                        MD_SAFE_DELETE( buffer );
+                    }
+                    m_orphanedBuffers.clear();
+                }
+                return CC_OK;
+
+            case IO_STREAM_GROUP_BACKEND_IO_URING:
+            {
+                if( m_ioUring )
+                {
+                    return CC_OK;
+                }
+
+                m_ioUring = new( std::nothrow ) CIoUringLinux( m_adapterId );
+                MD_CHECK_PTR_RET_A( m_adapterId, m_ioUring, CC_ERROR_NO_MEMORY );
+
+                TCompletionCode ret = m_ioUring->Initialize( MD_IO_STREAM_GROUP_IO_URING_ENTRIES );
+                if( ret != CC_OK )
+                {
+                    MD_LOG_A( m_adapterId, LOG_INFO, "io_uring not available, poll backend used" );
+                    MD_SAFE_DELETE( m_ioUring );
+                    return CC_ERROR_NOT_SUPPORTED;
+                }
+
+                m_useFixedBuffers = true;
+                return CC_OK;
+            }
+
+            default:
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: unknown read backend: %u", backend );
+                return CC_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     ReadReports
+    //
+    // Description:
+    //     Waits until any of the registered streams has reports available and
+    //     reads the ready streams. Each read is returned as a view valid until
+    //     the next read of the stream, as from ReadIoStreamView.
+    //
+    // Input:
+    //     uint32_t            milliseconds   - wait timeout in milliseconds
+    //     uint32_t            maxReportCount - reports to read from a single stream
+    //     TIoStreamGroupRead* outReads       - [out] reads of ready streams
+    //     uint32_t            outReadsCount  - outReads array size
+    //     uint32_t*           outReadCount   - [out] number of returned reads
+    //
+    // Output:
+    //     TCompletionCode                    - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::ReadReports( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, outReads, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, outReadCount, CC_ERROR_INVALID_PARAMETER );
+
+        *outReadCount = 0;
+
+        if( m_entries.empty() || outReadsCount == 0 || maxReportCount == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: no streams, empty output or 0 reports to read" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        return m_ioUring
+            ? ReadReportsIoUring( milliseconds, maxReportCount, outReads, outReadsCount, outReadCount )
+            : ReadReportsPoll( milliseconds, maxReportCount, outReads, outReadsCount, outReadCount );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     ReadReportsPoll
+    //
+    // Description:
+    //     Poll backend of ReadReports. Waits with epoll, then reads every ready
+    //     stream with a separate read syscall.
+    //
+    // Input:
+    //     uint32_t            milliseconds   - wait timeout in milliseconds
+    //     uint32_t            maxReportCount - reports to read from a single stream
+    //     TIoStreamGroupRead* outReads       - [out] reads of ready streams
+    //     uint32_t            outReadsCount  - outReads array size
+    //     uint32_t*           outReadCount   - [out] number of returned reads
+    //
+    // Output:
+    //     TCompletionCode                    - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::ReadReportsPoll( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount )
+    {
+        uint32_t readyCount = 0;
+
+        m_readyGroups.resize( std::min<size_t>( outReadsCount, m_entries.size() ) );
+
+        TCompletionCode ret = WaitForReports( milliseconds, m_readyGroups.data(), static_cast<uint32_t>( m_readyGroups.size() ), &readyCount );
+        if( ret != CC_OK )
+        {
+            return ret;
+        }
+
+        for( uint32_t i = 0; i < readyCount; ++i )
+        {
+            auto&    read        = outReads[i];
+            uint32_t reportCount = maxReportCount;
+
+            read.ConcurrentGroup = m_readyGroups[i];
+            read.Result          = static_cast<CConcurrentGroup*>( m_readyGroups[i] )->ReadIoStreamView( &reportCount, &read.View, 0 );
+        }
+
+        *outReadCount = readyCount;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     ReadReportsIoUring
+    //
+    // Description:
+    //     io_uring backend of ReadReports. Every idle stream gets a poll linked
+    //     with a read into its stream buffer, all of them are submitted and waited
+    //     for with a single io_uring_enter. Completed reads are then parsed by
+    //     ReadIoStreamView without another syscall. Reads not returned because of
+    //     a small output array are returned by the next call.
+    //
+    // Input:
+    //     uint32_t            milliseconds   - wait timeout in milliseconds
+    //     uint32_t            maxReportCount - reports to read from a single stream
+    //     TIoStreamGroupRead* outReads       - [out] reads of ready streams
+    //     uint32_t            outReadsCount  - outReads array size
+    //     uint32_t*           outReadCount   - [out] number of returned reads
+    //
+    // Output:
+    //     TCompletionCode                    - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::ReadReportsIoUring( uint32_t milliseconds, uint32_t maxReportCount, TIoStreamGroupRead* outReads, uint32_t outReadsCount, uint32_t* outReadCount )
+    {
+        TCompletionCode ret          = CC_OK;
+        bool            completed    = false;
+        bool            inFlight     = false;
+        bool            unregistered = false;
+
+        UpdateStreams();
+
+        if( m_entries.empty() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: no streams" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        // 1. PREPARE STREAM BUFFERS OF IDLE STREAMS
+        for( auto& entry : m_entries )
+        {
+            inFlight |= entry.PendingCqeCount > 0;
+
+            if( entry.PendingCqeCount == 0 && !entry.Completed )
+            {
+                PrepareRead( entry, maxReportCount );
+
+                unregistered |= entry.ReadSize && entry.BufferIndex < 0;
+            }
+
+            completed |= entry.Completed;
+        }
+
+        // 2. REGISTER STREAM BUFFERS, ONLY WHEN NO READ IS IN FLIGHT
+        if( unregistered && !inFlight && m_useFixedBuffers )
+        {
+            RegisterBuffers();
+        }
+
+        // 3. SUBMIT AND WAIT
+        for( auto& entry : m_entries )
+        {
+            if( entry.PendingCqeCount == 0 && !entry.Completed )
+            {
+                ret = SubmitRead( entry );
+                MD_CHECK_CC_RET_A( m_adapterId, ret );
+            }
+        }
+
+        // Reads already completed are returned without waiting
+        ret = m_ioUring->Submit( completed ? 0 : 1, milliseconds );
+        if( ret != CC_OK && ret != CC_WAIT_TIMEOUT && ret != CC_INTERRUPTED )
+        {
+            return ret;
+        }
+
+        io_uring_cqe cqe = {};
+        while( m_ioUring->PopCqe( cqe ) )
+        {
+            HandleCompletion( cqe );
+        }
+
+        // 4. PARSE COMPLETED READS
+        for( auto& entry : m_entries )
+        {
+            if( !entry.Completed || *outReadCount >= outReadsCount )
+            {
+                continue;
+            }
+
+            auto&    metricsDevice = entry.ConcurrentGroup->GetMetricsDevice();
+            auto&    read          = outReads[( *outReadCount )++];
+            uint32_t reportCount   = entry.ReportCount;
+
+            if( entry.ReadSize )
+            {
+                m_driverInterface.SetCompletedOaStreamRead( metricsDevice, entry.ReadResult, entry.Buffer->GetData() );
+            }
+
+            read.ConcurrentGroup = entry.ConcurrentGroup;
+            read.Result          = entry.ConcurrentGroup->ReadIoStreamView( &reportCount, &read.View, 0 );
+            entry.Completed      = false;
+        }
+
+        if( *outReadCount )
+        {
+            return CC_OK;
+        }
+
+        return ( ret == CC_OK ) ? CC_WAIT_TIMEOUT : ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     UpdateStreams
+    //
+    // Description:
+    //     Checks registered streams against current streams of their metrics
+    //     devices. A stream reopened by its concurrent group, e.g. to change
+    //     the sampling period, is registered again with the new fd. A closed
+    //     stream is dropped from the group with an error, so the group does not
+    //     wait on a stale fd.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamGroupLinux::UpdateStreams()
+    {
+        for( auto it = m_entries.begin(); it != m_entries.end(); )
+        {
+            auto&          metricsDevice    = it->ConcurrentGroup->GetMetricsDevice();
+            const int32_t  streamId         = metricsDevice.GetStreamId();
+            const uint32_t streamGeneration = metricsDevice.GetStreamGeneration();
+
+            if( streamId == it->StreamId && streamGeneration == it->StreamGeneration )
+            {
+                ++it;
+                continue;
+            }
+
+            if( m_ioUring )
+            {
+                CancelRead( *it );
+            }
+
+            // Closed stream fd is already dropped from the epoll set, its number may belong to the new stream.
+            if( epoll_ctl( m_epollFd, EPOLL_CTL_DEL, it->StreamId, nullptr ) != 0 && errno != EBADF && errno != ENOENT )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "warning: cannot remove stream %d from epoll, errno: %d", it->StreamId, errno );
+            }
+
+            if( streamId >= 0 )
+            {
+                epoll_event event = {};
+                event.events      = EPOLLIN;
+                event.data.ptr    = it->ConcurrentGroup;
+
+                if( epoll_ctl( m_epollFd, EPOLL_CTL_ADD, streamId, &event ) == 0 )
+                {
+                    MD_LOG_A( m_adapterId, LOG_DEBUG, "stream %d reopened as %d, registered again", it->StreamId, streamId );
+
+                    it->StreamId         = streamId;
+                    it->StreamGeneration = streamGeneration;
+                    it->BufferIndex      = -1;
+                    ++it;
+                    continue;
+                }
+
+                MD_LOG_A( m_adapterId, LOG_ERROR, "error: cannot add reopened stream %d to epoll, errno: %d", streamId, errno );
+            }
+
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: stream %d closed or lost, removed from the stream group", it->StreamId );
+            DeleteBuffer( *it );
+            it = m_entries.erase( it );
+        }
+
+        m_events.resize( m_entries.size() );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     PrepareRead
+    //
+    // Description:
+    //     Sizes the group buffer of the stream for the next io_uring read.
+    //     Streams drained by a background reader or already closed are not read,
+    //     they are completed at once and ReadIoStreamView reports the error.
+    //
+    // Input:
+    //     TIoStreamGroupEntry& entry          - stream entry
+    //     const uint32_t       maxReportCount - reports to read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamGroupLinux::PrepareRead( TIoStreamGroupEntry& entry, const uint32_t maxReportCount )
+    {
+        auto& metricsDevice = entry.ConcurrentGroup->GetMetricsDevice();
+
+        entry.ReportCount = maxReportCount;
+        entry.ReadResult  = 0;
+        entry.ReadSize    = 0;
+
+        auto metricSet = static_cast<COAConcurrentGroup*>( entry.ConcurrentGroup )->GetIoMetricSet();
+        if( metricSet == nullptr || m_driverInterface.HasIoStreamReader( metricsDevice ) )
+        {
+            entry.Completed = true;
+            return;
+        }
+
+        auto& streamBuffer = *entry.Buffer;
+
+        entry.ReadSize = m_driverInterface.GetOaStreamBufferSize( metricSet->GetParams()->RawReportSize, maxReportCount );
+
+        if( streamBuffer.GetSize() < entry.ReadSize && streamBuffer.Resize( entry.ReadSize ) != CC_OK )
+        {
+            // Left to the stream read, which reports the error
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Cannot allocate stream buffer, size: %zu", entry.ReadSize );
+            entry.ReadSize  = 0;
+            entry.Completed = true;
+            return;
+        }
+
+        entry.BufferIndex = FindBuffer( entry );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     SubmitRead
+    //
+    // Description:
+    //     Prepares a poll of the stream linked with a read into its group buffer.
+    //     A fixed buffer read is used if the buffer is registered.
+    //
+    // Input:
+    //     TIoStreamGroupEntry& entry - prepared stream entry
+    //
+    // Output:
+    //     TCompletionCode            - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamGroupLinux::SubmitRead( TIoStreamGroupEntry& entry )
+    {
+        // Linked entries must be passed to the kernel together
+        if( m_ioUring->GetSqeSpace() < 2 )
+        {
+            TCompletionCode ret = m_ioUring->Submit( 0, 0 );
+            MD_CHECK_CC_RET_A( m_adapterId, ret );
+        }
+
+        io_uring_sqe* pollSqe = m_ioUring->GetSqe();
+        io_uring_sqe* readSqe = m_ioUring->GetSqe();
+
+        MD_CHECK_PTR_RET_A( m_adapterId, pollSqe, CC_ERROR_GENERAL );
+        MD_CHECK_PTR_RET_A( m_adapterId, readSqe, CC_ERROR_GENERAL );
+
+        auto& streamBuffer = *entry.Buffer;
+
+        pollSqe->opcode        = IORING_OP_POLL_ADD;
+        pollSqe->flags         = IOSQE_IO_LINK;
+        pollSqe->fd            = entry.StreamId;
+        pollSqe->poll32_events = POLLIN;
+        pollSqe->user_data     = ( entry.Id << 2 ) | MD_IO_STREAM_GROUP_OP_POLL;
+
+        readSqe->opcode    = ( entry.BufferIndex >= 0 ) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        readSqe->fd        = entry.StreamId;
+        readSqe->addr      = reinterpret_cast<uint64_t>( streamBuffer.GetData() );
+        readSqe->len       = static_cast<uint32_t>( entry.ReadSize );
+        readSqe->buf_index = static_cast<uint16_t>( std::max( entry.BufferIndex, 0 ) );
+        readSqe->user_data = ( entry.Id << 2 ) | MD_IO_STREAM_GROUP_OP_READ;
+
+        entry.PendingCqeCount = 2;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     RegisterBuffers
+    //
+    // Description:
+    //     Registers group buffers of all streams as io_uring fixed buffers, so
+    //     their pages are not pinned for every read. On failure plain reads are
+    //     used from now on.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamGroupLinux::RegisterBuffers()
+    {
+        m_buffers.clear();
+
+        for( auto& entry : m_entries )
+        {
+            auto& streamBuffer = *entry.Buffer;
+            if( !streamBuffer.IsEmpty() )
+            {
+                m_buffers.push_back( { streamBuffer.GetData(), streamBuffer.GetSize() } );
+            }
+        }
+
+        if( m_buffers.empty() || m_ioUring->RegisterBuffers( m_buffers.data(), static_cast<uint32_t>( m_buffers.size() ) ) != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: stream buffers not registered, plain reads used" );
+            m_buffers.clear();
+            m_useFixedBuffers = false;
+            return;
+        }
+
+        for( auto& entry : m_entries )
+        {
+            if( entry.ReadSize && !entry.Completed )
+            {
+                entry.BufferIndex = FindBuffer( entry );
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     FindBuffer
+    //
+    // Description:
+    //     Returns index of the registered buffer matching the group buffer of the stream.
+    //
+    // Input:
+    //     const TIoStreamGroupEntry& entry - prepared stream entry
+    //
+    // Output:
+    //     int32_t                          - registered buffer index, -1 if not registered
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    int32_t CIoStreamGroupLinux::FindBuffer( const TIoStreamGroupEntry& entry )
+    {
+        const uint8_t* data = entry.Buffer->GetData();
+
+        for( size_t i = 0; i < m_buffers.size(); ++i )
+        {
+            if( m_buffers[i].iov_base == data && m_buffers[i].iov_len >= entry.ReadSize )
+            {
+                return static_cast<int32_t>( i );
+            }
+        }
+
+        return -1;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     HandleCompletion
+    //
+    // Description:
+    //     Stores the result of a completed read. Completions of removed streams
+    //     and of cancel requests are ignored.
+    //
+    // Input:
+    //     const io_uring_cqe& cqe - completion
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamGroupLinux::HandleCompletion( const io_uring_cqe& cqe )
+    {
+        const uint64_t       operation = cqe.user_data & MD_IO_STREAM_GROUP_OP_MASK;
+        TIoStreamGroupEntry* entry     = FindEntry( cqe.user_data >> 2 );
+
+        if( entry == nullptr || operation == MD_IO_STREAM_GROUP_OP_CANCEL || entry->PendingCqeCount == 0 )
+        {
+            return;
+        }
+
+        --entry->PendingCqeCount;
+
+        if( operation == MD_IO_STREAM_GROUP_OP_READ )
+        {
+            entry->ReadResult = cqe.res;
+            entry->Completed  = true;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     CancelRead
+    //
+    // Description:
+    //     Cancels the io_uring read of the stream and waits until the kernel
+    //     releases its group buffer. Completions of other streams received
+    //     meanwhile are kept for the next ReadReports.
+    //
+    // Input:
+    //     TIoStreamGroupEntry& entry - stream entry
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamGroupLinux::CancelRead( TIoStreamGroupEntry& entry )
+    {
+        if( entry.PendingCqeCount )
+        {
+            for( const uint64_t operation : { MD_IO_STREAM_GROUP_OP_POLL, MD_IO_STREAM_GROUP_OP_READ } )
+            {
+                if( m_ioUring->GetSqeSpace() == 0 )
+                {
+                    m_ioUring->Submit( 0, 0 );
+                }
+
+                io_uring_sqe* sqe = m_ioUring->GetSqe();
+                if( sqe )
+                {
+                    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+                    sqe->addr      = ( entry.Id << 2 ) | operation;
+                    sqe->user_data = ( entry.Id << 2 ) | MD_IO_STREAM_GROUP_OP_CANCEL;
+                }
+            }
+
+            io_uring_cqe cqe = {};
+            while( entry.PendingCqeCount && m_ioUring->Submit( 1, MD_IO_STREAM_GROUP_CANCEL_WAIT_MS ) == CC_OK )
+            {
+                while( m_ioUring->PopCqe( cqe ) )
+                {
+                    HandleCompletion( cqe );
+                }
+            }
+
+            if( entry.PendingCqeCount )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: io_uring read of stream %d not cancelled", entry.StreamId );
+            }
+        }
+
+        entry.Completed = false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     CancelReads
+    //
+    // Description:
+    //     Cancels io_uring reads of all streams. Completed reads not returned yet
+    //     are dropped.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamGroupLinux::CancelReads()
+    {
+        for( auto& entry : m_entries )
+        {
+            CancelRead( entry );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     DeleteBuffer
+    //
+    // Description:
+    //     Deletes the group buffer of a removed stream. If its read could not be
+    //     cancelled, the kernel may still write into the buffer, so it is kept
+    //     until the io_uring instance is deleted.
+    //
+    // Input:
+    //     TIoStreamGroupEntry& entry - stream entry being removed
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamGroupLinux::DeleteBuffer( TIoStreamGroupEntry& entry )
+    {
+        if( entry.PendingCqeCount )
+        {
+            m_orphanedBuffers.push_back( entry.Buffer );
+            entry.Buffer = nullptr;
+            return;
+        }
+
+        MD_SAFE_DELETE( entry.Buffer );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamGroupLinux
+    //
+    // Method:
+    //     FindEntry
+    //
+    // Description:
+    //     Returns stream entry with the given id.
+    //
+    // Input:
+    //     const uint64_t id - stream entry id
+    //
+    // Output:
+    //     TIoStreamGroupEntry* - stream entry, nullptr if the stream was removed
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TIoStreamGroupEntry* CIoStreamGroupLinux::FindEntry( const uint64_t id )
+    {
+        for( auto& entry : m_entries )
+        {
+            if( entry.Id == id )
+            {
+                return &entry;
+            }
+        }
+
+        return nullptr;
+    }
+} // namespace MetricsDiscoveryInternal
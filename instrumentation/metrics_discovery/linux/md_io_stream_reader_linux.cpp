@@ -0,0 +1,585 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_stream_reader_linux.cpp
+//
+//     Abstract:   C++ background IoStream reader for Linux
+
+#include "md_io_stream_reader_linux.h"
+#include "md_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     CIoStreamReader constructor
+    //
+    // Description:
+    //     Constructor. The ring of raw reports is allocated on Start.
+    //
+    // Input:
+    //     const uint32_t               adapterId      - adapter id for logging
+    //     const uint32_t               reportSize     - raw report size in bytes
+    //     const TIoStreamReaderParams& params         - reader parameters
+    //     CBufferProviderLinux&        bufferProvider - provider of the ring
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamReader::CIoStreamReader( const uint32_t adapterId, const uint32_t reportSize, const TIoStreamReaderParams& params, CBufferProviderLinux& bufferProvider )
+        : m_adapterId( adapterId )
+        , m_reportSize( reportSize )
+        , m_params( params )
+        , m_capacity( params.RingReportCount ? params.RingReportCount : MD_IO_STREAM_READER_RING_REPORT_COUNT )
+        , m_bufferProvider( bufferProvider )
+        , m_ring()
+        , m_head( 0 )
+        , m_tail( 0 )
+        , m_reportLost( false )
+        , m_bufferOverflow( false )
+        , m_bufferOverrun( false )
+        , m_droppedReportCount( 0 )
+        , m_threadResult( CC_OK )
+        , m_drainRequest( 0 )
+        , m_drainCompleted( 0 )
+        , m_thread()
+        , m_stop( false )
+        , m_waitMutex()
+        , m_waitCondition()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     ~CIoStreamReader
+    //
+    // Description:
+    //     Destructor. Stops the reader thread.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoStreamReader::~CIoStreamReader()
+    {
+        Stop();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     Start
+    //
+    // Description:
+    //     Allocates the ring and starts the reader thread. Thread function should
+    //     drain the stream until IsStopRequested returns true.
+    //
+    // Input:
+    //     std::function<void( CIoStreamReader& )> threadFunction - reader thread body
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamReader::Start( std::function<void( CIoStreamReader& )> threadFunction )
+    {
+        if( m_thread.joinable() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: IoStream reader already started" );
+            return CC_ERROR_GENERAL;
+        }
+        if( m_reportSize == 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: invalid report size" );
+            return CC_ERROR_INVALID_PARAMETER;
+        }
+
+        m_ring.SetProvider( &m_bufferProvider );
+        if( m_ring.Resize( static_cast<size_t>( m_capacity ) * m_reportSize ) != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "error: cannot allocate IoStream reader ring" );
+            return CC_ERROR_NO_MEMORY;
+        }
+
+        m_head         = 0;
+        m_tail         = 0;
+        m_stop         = false;
+        m_threadResult = CC_OK;
+
+        m_thread = std::thread(
+            [this, threadFunction]()
+            {
+                ApplyThreadParams();
+                threadFunction( *this );
+            } );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "IoStream reader started, ring reports: %u, report size: %u", m_capacity, m_reportSize );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     Stop
+    //
+    // Description:
+    //     Requests the reader thread to stop and waits for it.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReader::Stop()
+    {
+        m_stop = true;
+        m_waitCondition.notify_all();
+
+        if( m_thread.joinable() )
+        {
+            m_thread.join();
+
+            MD_LOG_A( m_adapterId, LOG_DEBUG, "IoStream reader stopped, dropped reports: %llu", static_cast<unsigned long long>( m_droppedReportCount.load() ) );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     IsStopRequested
+    //
+    // Output:
+    //     bool - true if the reader thread should exit
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoStreamReader::IsStopRequested() const
+    {
+        return m_stop.load( std::memory_order_relaxed );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     GetBatchReportCount
+    //
+    // Description:
+    //     Returns how many reports the reader thread should read at once. The stream
+    //     is drained even if the ring is full, so the kernel buffer doesn't overflow.
+    //
+    // Output:
+    //     uint32_t - report count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamReader::GetBatchReportCount() const
+    {
+        return std::min<uint32_t>( m_capacity, MD_IO_STREAM_READER_BATCH_REPORTS );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     Push
+    //
+    // Description:
+    //     Copies a single raw report to the ring. If the ring is full, the report
+    //     is dropped and buffer overrun exception is reported on the next pop.
+    //     Called by the reader thread only.
+    //
+    // Input:
+    //     const uint8_t* report - raw report
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReader::Push( const uint8_t* report )
+    {
+        const uint64_t head = m_head.load( std::memory_order_relaxed );
+        const uint64_t tail = m_tail.load( std::memory_order_acquire );
+
+        if( head - tail >= m_capacity )
+        {
+            m_droppedReportCount.fetch_add( 1, std::memory_order_relaxed );
+            m_bufferOverrun.store( true, std::memory_order_relaxed );
+            return;
+        }
+
+        iu_memcpy_s( m_ring.GetData() + ( head % m_capacity ) * m_reportSize, m_reportSize, report, m_reportSize );
+
+        m_head.store( head + 1, std::memory_order_release );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     AddExceptions
+    //
+    // Description:
+    //     Accumulates stream exceptions reported by the driver until the next pop.
+    //
+    // Input:
+    //     const GTDIReadCounterStreamExceptions& exceptions - exceptions of a single read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReader::AddExceptions( const GTDIReadCounterStreamExceptions& exceptions )
+    {
+        if( exceptions.ReportLost )
+        {
+            m_reportLost.store( true, std::memory_order_relaxed );
+        }
+        if( exceptions.BufferOverflow )
+        {
+            m_bufferOverflow.store( true, std::memory_order_relaxed );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     NotifyReports
+    //
+    // Description:
+    //     Wakes up the client thread waiting in WaitForReports.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReader::NotifyReports()
+    {
+        std::lock_guard<std::mutex> lock( m_waitMutex );
+        m_waitCondition.notify_all();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     SetThreadResult
+    //
+    // Description:
+    //     Stores the error the reader thread exits with and wakes up the client
+    //     thread, so it does not wait for reports that will never come.
+    //     Called by the reader thread only.
+    //
+    // Input:
+    //     const TCompletionCode result - reader thread error
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReader::SetThreadResult( const TCompletionCode result )
+    {
+        m_threadResult.store( result, std::memory_order_release );
+        NotifyReports();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     GetDrainRequest
+    //
+    // Description:
+    //     Returns the last drain request. Loaded by the reader thread before
+    //     it waits for the stream, so only a read started after the request
+    //     completes it. Called by the reader thread only.
+    //
+    // Output:
+    //     uint64_t - last drain request, 0 if none
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CIoStreamReader::GetDrainRequest() const
+    {
+        return m_drainRequest.load( std::memory_order_acquire );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     CompleteDrain
+    //
+    // Description:
+    //     Marks drain requests up to the given one as completed, after a read
+    //     found the stream empty, and wakes up the client thread waiting in Drain.
+    //     Called by the reader thread only.
+    //
+    // Input:
+    //     const uint64_t drainRequest - drain request loaded before the read
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReader::CompleteDrain( const uint64_t drainRequest )
+    {
+        if( drainRequest == m_drainCompleted.load( std::memory_order_relaxed ) )
+        {
+            return;
+        }
+
+        m_drainCompleted.store( drainRequest, std::memory_order_release );
+        NotifyReports();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     GetThreadResult
+    //
+    // Output:
+    //     TCompletionCode - error the reader thread exited with, *CC_OK* if running
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamReader::GetThreadResult() const
+    {
+        return m_threadResult.load( std::memory_order_acquire );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     Pop
+    //
+    // Description:
+    //     Copies up to the given number of reports from the ring to the output buffer
+    //     and returns exceptions accumulated since the previous pop.
+    //     Called by the client thread only.
+    //
+    // Input:
+    //     char*                            reportData   - (OUT) buffer for reports
+    //     const uint32_t                   reportsCount - max reports to copy
+    //     GTDIReadCounterStreamExceptions& exceptions   - (OUT) accumulated exceptions
+    //
+    // Output:
+    //     uint32_t - copied report count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoStreamReader::Pop( char* reportData, const uint32_t reportsCount, GTDIReadCounterStreamExceptions& exceptions )
+    {
+        const uint64_t tail      = m_tail.load( std::memory_order_relaxed );
+        const uint64_t head      = m_head.load( std::memory_order_acquire );
+        const uint32_t available = static_cast<uint32_t>( head - tail );
+        const uint32_t count     = std::min( available, reportsCount );
+        const size_t   outSize   = static_cast<size_t>( reportsCount ) * m_reportSize;
+
+        // Copy in at most two chunks, the second one after the ring wraps
+        const uint32_t first  = static_cast<uint32_t>( tail % m_capacity );
+        const uint32_t chunk1 = std::min( count, m_capacity - first );
+        const uint32_t chunk2 = count - chunk1;
+
+        iu_memcpy_s( reportData, outSize, m_ring.GetData() + static_cast<size_t>( first ) * m_reportSize, static_cast<size_t>( chunk1 ) * m_reportSize );
+        if( chunk2 )
+        {
+            iu_memcpy_s( reportData + static_cast<size_t>( chunk1 ) * m_reportSize, outSize - static_cast<size_t>( chunk1 ) * m_reportSize, m_ring.GetData(), static_cast<size_t>( chunk2 ) * m_reportSize );
+        }
+
+        m_tail.store( tail + count, std::memory_order_release );
+
+        exceptions.ReportLost     = m_reportLost.exchange( false, std::memory_order_relaxed );
+        exceptions.BufferOverflow = m_bufferOverflow.exchange( false, std::memory_order_relaxed );
+        exceptions.BufferOverrun  = m_bufferOverrun.exchange( false, std::memory_order_relaxed );
+
+        return count;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     WaitForReports
+    //
+    // Description:
+    //     Waits the given number of milliseconds for reports in the ring.
+    //
+    // Input:
+    //     const uint32_t milliseconds - wait timeout
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* if reports available, *CC_WAIT_TIMEOUT* otherwise,
+    //                       reader thread error if it exited and the ring is drained
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamReader::WaitForReports( const uint32_t milliseconds )
+    {
+        auto isRingEmpty = [this]()
+        {
+            return m_head.load( std::memory_order_acquire ) == m_tail.load( std::memory_order_relaxed );
+        };
+        auto reportsAvailable = [this, &isRingEmpty]()
+        {
+            return !isRingEmpty() || GetThreadResult() != CC_OK || IsStopRequested();
+        };
+
+        std::unique_lock<std::mutex> lock( m_waitMutex );
+
+        m_waitCondition.wait_for( lock, std::chrono::milliseconds( milliseconds ), reportsAvailable );
+
+        // Result is loaded first, reports pushed before the thread exited are visible then
+        const TCompletionCode threadResult = GetThreadResult();
+
+        if( !isRingEmpty() )
+        {
+            return CC_OK;
+        }
+        if( threadResult != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: IoStream reader exited, error: %u", threadResult );
+            return threadResult;
+        }
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Wait timeout" );
+        return CC_WAIT_TIMEOUT;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     Drain
+    //
+    // Description:
+    //     Requests the reader thread to read all reports available in the stream
+    //     into the ring and waits until it finds the stream empty. Used before
+    //     the stream is disabled, so reports sampled so far are not lost.
+    //     Called by the client thread only.
+    //
+    // Input:
+    //     const uint32_t milliseconds - max wait time
+    //
+    // Output:
+    //     TCompletionCode             - *CC_OK* if drained, *CC_WAIT_TIMEOUT* on timeout,
+    //                                   reader thread error if it exited
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoStreamReader::Drain( const uint32_t milliseconds )
+    {
+        const uint64_t drainRequest = m_drainRequest.fetch_add( 1, std::memory_order_acq_rel ) + 1;
+
+        auto drainFinished = [this, drainRequest]()
+        {
+            return m_drainCompleted.load( std::memory_order_acquire ) >= drainRequest || GetThreadResult() != CC_OK || IsStopRequested();
+        };
+
+        std::unique_lock<std::mutex> lock( m_waitMutex );
+
+        m_waitCondition.wait_for( lock, std::chrono::milliseconds( milliseconds ), drainFinished );
+
+        if( m_drainCompleted.load( std::memory_order_acquire ) >= drainRequest )
+        {
+            return CC_OK;
+        }
+
+        const TCompletionCode threadResult = GetThreadResult();
+        if( threadResult != CC_OK )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: IoStream reader exited, error: %u", threadResult );
+            return threadResult;
+        }
+
+        MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: IoStream reader drain timeout" );
+        return CC_WAIT_TIMEOUT;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoStreamReader
+    //
+    // Method:
+    //     ApplyThreadParams
+    //
+    // Description:
+    //     Binds the calling (reader) thread to the requested CPU, or to CPUs local
+    //     to the device, and sets its nice value. Failures are logged only,
+    //     the reader works with default settings.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoStreamReader::ApplyThreadParams()
+    {
+        if( m_params.CpuAffinity == MD_IO_STREAM_READER_CPU_AFFINITY_DEVICE )
+        {
+            cpu_set_t cpuSet;
+
+            if( !m_bufferProvider.GetLocalCpus( cpuSet ) )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "Device local cpus not known, IoStream reader affinity not set" );
+            }
+            else
+            {
+                const int32_t result = pthread_setaffinity_np( pthread_self(), sizeof( cpuSet ), &cpuSet );
+                if( result != 0 )
+                {
+                    MD_LOG_A( m_adapterId, LOG_WARNING, "Cannot set IoStream reader affinity to device local cpus, error: %d (%s)", result, strerror( result ) );
+                }
+            }
+        }
+        else if( m_params.CpuAffinity >= CPU_SETSIZE || m_params.CpuAffinity >= sysconf( _SC_NPROCESSORS_CONF ) )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "Invalid cpu %d, IoStream reader affinity not set", m_params.CpuAffinity );
+        }
+        else if( m_params.CpuAffinity >= 0 )
+        {
+            cpu_set_t cpuSet;
+            CPU_ZERO( &cpuSet );
+            CPU_SET( m_params.CpuAffinity, &cpuSet );
+
+            const int32_t result = pthread_setaffinity_np( pthread_self(), sizeof( cpuSet ), &cpuSet );
+            if( result != 0 )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "Cannot set IoStream reader affinity to cpu %d, error: %d (%s)", m_params.CpuAffinity, result, strerror( result ) );
+            }
+        }
+
+        if( m_params.Priority != 0 )
+        {
+            const pid_t tid = static_cast<pid_t>( syscall( SYS_gettid ) );
+
+            if( setpriority( PRIO_PROCESS, tid, m_params.Priority ) != 0 )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "Cannot set IoStream reader priority to %d, errno: %d (%s)", m_params.Priority, errno, strerror( errno ) );
+            }
+        }
+    }
+} // namespace MetricsDiscoveryInternal
@@ -0,0 +1,423 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_io_uring_linux.cpp
+//
+//     Abstract:   C++ minimal io_uring wrapper for Linux
+
+#include "md_io_uring_linux.h"
+#include "md_utils.h"
+
+#include <cstring>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     CIoUringLinux constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    // Input:
+    //     const uint32_t adapterId - adapter id for logging
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoUringLinux::CIoUringLinux( const uint32_t adapterId )
+        : m_adapterId( adapterId )
+        , m_ringFd( -1 )
+        , m_buffersRegistered( false )
+        , m_ringMemory( MAP_FAILED )
+        , m_ringMemorySize( 0 )
+        , m_sqeMemory( MAP_FAILED )
+        , m_sqeMemorySize( 0 )
+        , m_sqHead( nullptr )
+        , m_sqTail( nullptr )
+        , m_sqMask( nullptr )
+        , m_sqArray( nullptr )
+        , m_sqes( nullptr )
+        , m_sqPendingTail( 0 )
+        , m_cqHead( nullptr )
+        , m_cqTail( nullptr )
+        , m_cqMask( nullptr )
+        , m_cqes( nullptr )
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     ~CIoUringLinux
+    //
+    // Description:
+    //     Destructor. Unmaps the rings and closes the ring.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CIoUringLinux::~CIoUringLinux()
+    {
+        Deinitialize();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     Initialize
+    //
+    // Description:
+    //     Creates the ring and maps its submission and completion queues.
+    //
+    // Input:
+    //     const uint32_t entryCount - submission queue size
+    //
+    // Output:
+    //     TCompletionCode           - *CC_OK* means success, *CC_ERROR_NOT_SUPPORTED*
+    //                                 if io_uring or required features are not available
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoUringLinux::Initialize( const uint32_t entryCount )
+    {
+#if defined( __NR_io_uring_setup )
+        io_uring_params params = {};
+
+        m_ringFd = static_cast<int32_t>( syscall( __NR_io_uring_setup, entryCount, &params ) );
+        if( m_ringFd < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: io_uring not available, error: %d (%s)", errno, strerror( errno ) );
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        if( !( params.features & IORING_FEAT_SINGLE_MMAP ) || !( params.features & IORING_FEAT_EXT_ARG ) )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: io_uring features not supported: 0x%x", params.features );
+            Deinitialize();
+            return CC_ERROR_NOT_SUPPORTED;
+        }
+
+        // 1. MAP RINGS, with single mmap SQ and CQ rings share one mapping
+        const size_t sqRingSize = params.sq_off.array + params.sq_entries * sizeof( uint32_t );
+        const size_t cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+
+        m_ringMemorySize = ( sqRingSize > cqRingSize ) ? sqRingSize : cqRingSize;
+        m_ringMemory     = mmap( nullptr, m_ringMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING );
+        if( m_ringMemory == MAP_FAILED )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: io_uring ring mmap failed, error: %d (%s)", errno, strerror( errno ) );
+            Deinitialize();
+            return CC_ERROR_GENERAL;
+        }
+
+        m_sqeMemorySize = params.sq_entries * sizeof( io_uring_sqe );
+        m_sqeMemory     = mmap( nullptr, m_sqeMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES );
+        if( m_sqeMemory == MAP_FAILED )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: io_uring sqe mmap failed, error: %d (%s)", errno, strerror( errno ) );
+            Deinitialize();
+            return CC_ERROR_GENERAL;
+        }
+
+        // 2. RESOLVE RING FIELDS
+        uint8_t* ring = static_cast<uint8_t*>( m_ringMemory );
+
+        m_sqHead        = reinterpret_cast<uint32_t*>( ring + params.sq_off.head );
+        m_sqTail        = reinterpret_cast<uint32_t*>( ring + params.sq_off.tail );
+        m_sqMask        = reinterpret_cast<uint32_t*>( ring + params.sq_off.ring_mask );
+        m_sqArray       = reinterpret_cast<uint32_t*>( ring + params.sq_off.array );
+        m_sqes          = static_cast<io_uring_sqe*>( m_sqeMemory );
+        m_sqPendingTail = *m_sqTail;
+
+        m_cqHead = reinterpret_cast<uint32_t*>( ring + params.cq_off.head );
+        m_cqTail = reinterpret_cast<uint32_t*>( ring + params.cq_off.tail );
+        m_cqMask = reinterpret_cast<uint32_t*>( ring + params.cq_off.ring_mask );
+        m_cqes   = reinterpret_cast<io_uring_cqe*>( ring + params.cq_off.cqes );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "io_uring initialized, sq entries: %u, cq entries: %u", params.sq_entries, params.cq_entries );
+        return CC_OK;
+#else
+        MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: io_uring not available" );
+        return CC_ERROR_NOT_SUPPORTED;
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     Deinitialize
+    //
+    // Description:
+    //     Unmaps the rings and closes the ring.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoUringLinux::Deinitialize()
+    {
+        UnregisterBuffers();
+
+        if( m_sqeMemory != MAP_FAILED )
+        {
+            munmap( m_sqeMemory, m_sqeMemorySize );
+            m_sqeMemory = MAP_FAILED;
+        }
+        if( m_ringMemory != MAP_FAILED )
+        {
+            munmap( m_ringMemory, m_ringMemorySize );
+            m_ringMemory = MAP_FAILED;
+        }
+        if( m_ringFd >= 0 )
+        {
+            close( m_ringFd );
+            m_ringFd = -1;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     RegisterBuffers
+    //
+    // Description:
+    //     Registers fixed buffers used by IORING_OP_READ_FIXED. Previously
+    //     registered buffers are unregistered first.
+    //
+    // Input:
+    //     const iovec*   buffers     - buffers to register
+    //     const uint32_t bufferCount - buffer count
+    //
+    // Output:
+    //     TCompletionCode            - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoUringLinux::RegisterBuffers( const iovec* buffers, const uint32_t bufferCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, buffers, CC_ERROR_INVALID_PARAMETER );
+
+        UnregisterBuffers();
+
+#if defined( __NR_io_uring_register )
+        if( syscall( __NR_io_uring_register, m_ringFd, IORING_REGISTER_BUFFERS, buffers, bufferCount ) < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: io_uring buffer registration failed, error: %d (%s)", errno, strerror( errno ) );
+            return CC_ERROR_GENERAL;
+        }
+
+        m_buffersRegistered = true;
+        return CC_OK;
+#else
+        return CC_ERROR_NOT_SUPPORTED;
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     UnregisterBuffers
+    //
+    // Description:
+    //     Unregisters fixed buffers, if registered.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CIoUringLinux::UnregisterBuffers()
+    {
+#if defined( __NR_io_uring_register )
+        if( m_buffersRegistered )
+        {
+            syscall( __NR_io_uring_register, m_ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0 );
+            m_buffersRegistered = false;
+        }
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     GetSqe
+    //
+    // Description:
+    //     Returns a cleared submission queue entry to prepare. Prepared entries
+    //     are passed to the kernel with the next Submit.
+    //
+    // Output:
+    //     io_uring_sqe* - submission queue entry, nullptr if the queue is full
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    io_uring_sqe* CIoUringLinux::GetSqe()
+    {
+        const uint32_t head = __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+        if( m_sqPendingTail - head > *m_sqMask )
+        {
+            return nullptr;
+        }
+
+        const uint32_t index = m_sqPendingTail & *m_sqMask;
+        io_uring_sqe*  sqe   = &m_sqes[index];
+
+        memset( sqe, 0, sizeof( *sqe ) );
+        m_sqArray[index] = index;
+        ++m_sqPendingTail;
+
+        return sqe;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     GetSqeSpace
+    //
+    // Description:
+    //     Returns the number of submission queue entries that can be prepared
+    //     before Submit, e.g. to keep linked entries in a single submission.
+    //
+    // Output:
+    //     uint32_t - free submission queue entries
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CIoUringLinux::GetSqeSpace()
+    {
+        const uint32_t head = __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+
+        return *m_sqMask + 1 - ( m_sqPendingTail - head );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     Submit
+    //
+    // Description:
+    //     Submits prepared entries and waits until the given number of completions
+    //     is available or the timeout expires, with a single io_uring_enter.
+    //     If the kernel takes only a part of the entries, the rest is submitted
+    //     again. Entries the kernel does not take at all stay queued for the next
+    //     Submit.
+    //
+    // Input:
+    //     const uint32_t waitCount    - completions to wait for, 0 means submit only
+    //     const uint32_t milliseconds - wait timeout in milliseconds
+    //
+    // Output:
+    //     TCompletionCode             - *CC_OK* means success, *CC_WAIT_TIMEOUT* on timeout
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CIoUringLinux::Submit( const uint32_t waitCount, const uint32_t milliseconds )
+    {
+#if defined( __NR_io_uring_enter )
+        // Entries left by a previous partial submission are already published, so count from the head
+        uint32_t submitCount = m_sqPendingTail - __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+
+        __atomic_store_n( m_sqTail, m_sqPendingTail, __ATOMIC_RELEASE );
+
+        __kernel_timespec      timeout = { static_cast<long long>( milliseconds / 1000 ), static_cast<long long>( milliseconds % 1000 ) * 1000000LL };
+        io_uring_getevents_arg arg     = {};
+        uint32_t               flags   = IORING_ENTER_EXT_ARG;
+
+        arg.ts = reinterpret_cast<uint64_t>( &timeout );
+        if( waitCount )
+        {
+            flags |= IORING_ENTER_GETEVENTS;
+        }
+
+        while( true )
+        {
+            const int32_t ret = static_cast<int32_t>( syscall( __NR_io_uring_enter, m_ringFd, submitCount, waitCount, flags, &arg, sizeof( arg ) ) );
+            if( ret < 0 )
+            {
+                if( errno == ETIME )
+                {
+                    return CC_WAIT_TIMEOUT;
+                }
+                if( errno == EINTR )
+                {
+                    return CC_INTERRUPTED;
+                }
+
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: io_uring enter failed, error: %d (%s)", errno, strerror( errno ) );
+                return CC_ERROR_GENERAL;
+            }
+
+            // Kernel does not wait after a partial submission
+            if( static_cast<uint32_t>( ret ) >= submitCount )
+            {
+                return CC_OK;
+            }
+            if( ret == 0 )
+            {
+                MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: io_uring entries not submitted: %u", submitCount );
+                return CC_ERROR_GENERAL;
+            }
+
+            submitCount -= static_cast<uint32_t>( ret );
+        }
+#else
+        return CC_ERROR_NOT_SUPPORTED;
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CIoUringLinux
+    //
+    // Method:
+    //     PopCqe
+    //
+    // Description:
+    //     Takes the next available completion, without any syscall.
+    //
+    // Input:
+    //     io_uring_cqe& cqe - (OUT) completion
+    //
+    // Output:
+    //     bool              - *true* if a completion was available
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool CIoUringLinux::PopCqe( io_uring_cqe& cqe )
+    {
+        const uint32_t head = *m_cqHead;
+        if( head == __atomic_load_n( m_cqTail, __ATOMIC_ACQUIRE ) )
+        {
+            return false;
+        }
+
+        cqe = m_cqes[head & *m_cqMask];
+        __atomic_store_n( m_cqHead, head + 1, __ATOMIC_RELEASE );
+
+        return true;
+    }
+} // namespace MetricsDiscoveryInternal
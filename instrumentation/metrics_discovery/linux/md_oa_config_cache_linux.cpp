@@ -0,0 +1,380 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_oa_config_cache_linux.cpp
+//
+//     Abstract:   C++ content addressed OA configuration cache for Linux
+
+#include "md_oa_config_cache_linux.h"
+
+#include <cstdio>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Description:
+    //     MurmurHash3 x64 128 bit finalization mix.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static inline uint64_t OaConfigHashMix( uint64_t k )
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    static inline uint64_t OaConfigHashRotate( const uint64_t x, const int32_t r )
+    {
+        return ( x << r ) | ( x >> ( 64 - r ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     COaConfigCache constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    COaConfigCache::COaConfigCache()
+        : m_entries()
+        , m_discardedEntries()
+        , m_useCounter( 0 )
+        , m_mutex()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     ~COaConfigCache
+    //
+    // Description:
+    //     Destructor. Configurations have to be removed from the kernel by
+    //     the driver interface, see Clear.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    COaConfigCache::~COaConfigCache()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     GetGuid
+    //
+    // Description:
+    //     Generates configuration GUID from MurmurHash3 x64 128 of the register
+    //     (type, offset, value) tuples in order, seeded with the sub device index.
+    //     All 128 bits are used, formatted like "%08x-%04x-%04x-%04x-%012x".
+    //
+    // Input:
+    //     TRegister**    regVector      - configuration registers, null entries are skipped
+    //     const uint32_t regCount       - register count
+    //     const uint32_t subDeviceIndex - sub device index
+    //     char*          guid           - (out) generated GUID
+    //     const uint32_t guidSize       - guid buffer size, at least MD_PERF_GUID_LENGTH
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COaConfigCache::GetGuid( TRegister** regVector, const uint32_t regCount, const uint32_t subDeviceIndex, char* guid, const uint32_t guidSize )
+    {
+        const uint64_t c1     = 0x87c37b91114253d5ULL;
+        const uint64_t c2     = 0x4cf5ad432745937fULL;
+        uint64_t       h1     = subDeviceIndex;
+        uint64_t       h2     = subDeviceIndex;
+        uint64_t       length = 0;
+
+        // Each register is a 16 byte block: type and offset, value and padding
+        for( uint32_t i = 0; i < regCount; ++i )
+        {
+            if( regVector[i] == nullptr )
+            {
+                continue;
+            }
+
+            uint64_t k1 = ( static_cast<uint64_t>( regVector[i]->type ) << 32 ) | regVector[i]->offset;
+            uint64_t k2 = regVector[i]->value;
+
+            k1 *= c1;
+            k1 = OaConfigHashRotate( k1, 31 );
+            k1 *= c2;
+            h1 ^= k1;
+            h1 = OaConfigHashRotate( h1, 27 );
+            h1 += h2;
+            h1 = h1 * 5 + 0x52dce729;
+
+            k2 *= c2;
+            k2 = OaConfigHashRotate( k2, 33 );
+            k2 *= c1;
+            h2 ^= k2;
+            h2 = OaConfigHashRotate( h2, 31 );
+            h2 += h1;
+            h2 = h2 * 5 + 0x38495ab5;
+
+            length += 16;
+        }
+
+        h1 ^= length;
+        h2 ^= length;
+        h1 += h2;
+        h2 += h1;
+        h1 = OaConfigHashMix( h1 );
+        h2 = OaConfigHashMix( h2 );
+        h1 += h2;
+        h2 += h1;
+
+        snprintf( guid, guidSize, "%08x-%04x-%04x-%04x-%012llx", static_cast<uint32_t>( h1 >> 32 ), static_cast<uint32_t>( ( h1 >> 16 ) & 0xffff ), static_cast<uint32_t>( h1 & 0xffff ), static_cast<uint32_t>( h2 >> 48 ), static_cast<unsigned long long>( h2 & 0xffffffffffffULL ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     Acquire
+    //
+    // Description:
+    //     Looks up a cached configuration and takes a reference on it.
+    //
+    // Input:
+    //     const char* guid     - configuration GUID
+    //     int32_t&    configId - (out) cached configuration id
+    //     bool&       owned    - (out) *true* if added by this process
+    //
+    // Output:
+    //     bool                 - *true* if the configuration is cached
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool COaConfigCache::Acquire( const char* guid, int32_t& configId, bool& owned )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto entry = m_entries.find( guid );
+        if( entry == m_entries.end() )
+        {
+            return false;
+        }
+
+        ++entry->second.RefCount;
+        configId = entry->second.ConfigId;
+        owned    = entry->second.Owned;
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     Discard
+    //
+    // Description:
+    //     Drops the reference taken by Acquire on a configuration found no longer
+    //     valid and removes it from lookup. If other references remain, the entry
+    //     is kept apart, so their Release still finds it.
+    //
+    // Input:
+    //     const char* guid - configuration GUID
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COaConfigCache::Discard( const char* guid )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto entry = m_entries.find( guid );
+        if( entry == m_entries.end() )
+        {
+            return;
+        }
+
+        if( --entry->second.RefCount )
+        {
+            m_discardedEntries.push_back( entry->second );
+        }
+        m_entries.erase( entry );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     Insert
+    //
+    // Description:
+    //     Caches a configuration added to or found in the kernel, with a single
+    //     reference taken.
+    //
+    // Input:
+    //     const char*   guid     - configuration GUID
+    //     const int32_t configId - kernel configuration id
+    //     const bool    owned    - *true* if added by this process
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COaConfigCache::Insert( const char* guid, const int32_t configId, const bool owned )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto& entry = m_entries[guid];
+
+        entry.ConfigId    = configId;
+        entry.RefCount    = entry.RefCount + 1;
+        entry.Owned       = entry.Owned || owned;
+        entry.LastUseTime = ++m_useCounter;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     Release
+    //
+    // Description:
+    //     Drops a reference taken with Acquire or Insert. Configuration stays
+    //     cached, but least recently used idle configurations above the limit
+    //     are evicted.
+    //
+    // Input:
+    //     const int32_t         configId         - kernel configuration id
+    //     std::vector<int32_t>& evictedConfigIds - (out) appended ids of evicted owned configurations to remove from the kernel
+    //
+    // Output:
+    //     bool                                   - *false* if the configuration is not cached
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    bool COaConfigCache::Release( const int32_t configId, std::vector<int32_t>& evictedConfigIds )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        // Kernel may reuse the id of a discarded configuration
+        for( auto entry = m_discardedEntries.begin(); entry != m_discardedEntries.end(); ++entry )
+        {
+            if( entry->ConfigId == configId )
+            {
+                if( --entry->RefCount == 0 )
+                {
+                    m_discardedEntries.erase( entry );
+                }
+                return true;
+            }
+        }
+
+        for( auto& entry : m_entries )
+        {
+            if( entry.second.ConfigId == configId && entry.second.RefCount )
+            {
+                --entry.second.RefCount;
+                entry.second.LastUseTime = ++m_useCounter;
+
+                Evict( evictedConfigIds );
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     Clear
+    //
+    // Description:
+    //     Empties the cache.
+    //
+    // Input:
+    //     std::vector<int32_t>& ownedConfigIds - (out) appended ids of owned configurations to remove from the kernel
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COaConfigCache::Clear( std::vector<int32_t>& ownedConfigIds )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        for( auto& entry : m_entries )
+        {
+            if( entry.second.Owned )
+            {
+                ownedConfigIds.push_back( entry.second.ConfigId );
+            }
+        }
+
+        m_entries.clear();
+        m_discardedEntries.clear();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     COaConfigCache
+    //
+    // Method:
+    //     Evict
+    //
+    // Description:
+    //     Drops least recently used idle configurations above the idle limit.
+    //     Must be called with the mutex held.
+    //
+    // Input:
+    //     std::vector<int32_t>& evictedConfigIds - (out) appended ids of evicted owned configurations
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void COaConfigCache::Evict( std::vector<int32_t>& evictedConfigIds )
+    {
+        while( true )
+        {
+            uint32_t idleCount = 0;
+            auto     oldest    = m_entries.end();
+
+            for( auto entry = m_entries.begin(); entry != m_entries.end(); ++entry )
+            {
+                if( entry->second.RefCount == 0 )
+                {
+                    ++idleCount;
+                    if( oldest == m_entries.end() || entry->second.LastUseTime < oldest->second.LastUseTime )
+                    {
+                        oldest = entry;
+                    }
+                }
+            }
+
+            if( idleCount <= MD_OA_CONFIG_CACHE_MAX_IDLE )
+            {
+                return;
+            }
+
+            if( oldest->second.Owned )
+            {
+                evictedConfigIds.push_back( oldest->second.ConfigId );
+            }
+            m_entries.erase( oldest );
+        }
+    }
+} // namespace MetricsDiscoveryInternal
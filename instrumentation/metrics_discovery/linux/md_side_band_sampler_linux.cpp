@@ -0,0 +1,501 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_side_band_sampler_linux.cpp
+//
+//     Abstract:   C++ SysFs / hwmon side-band sampler for Linux
+
+#include "md_side_band_sampler_linux.h"
+#include "md_utils.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <glob.h>
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Description:
+    //     Default attributes, relative to the DRM card SysFs directory.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    static const char* const DefaultAttributes[MD_SIDE_BAND_DEFAULT_ATTRIBUTE_COUNT] = {
+        "gt_act_freq_mhz",                   // Actual GPU frequency in MHz
+        "power/rc6_residency_ms",            // RC6 residency in ms
+        "gt/gt0/throttle_reason_status",     // Any throttle reason active
+        "device/hwmon/hwmon*/energy1_input", // Energy in uJ
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     CSideBandSamplerLinux constructor
+    //
+    // Description:
+    //     Constructor. Zero period and sample count mean defaults, too short
+    //     period is clamped. Attributes are opened in Initialize.
+    //
+    // Input:
+    //     const uint32_t                adapterId - adapter id for logging
+    //     const TSideBandSamplerParams& params    - sampler parameters
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CSideBandSamplerLinux::CSideBandSamplerLinux( const uint32_t adapterId, const TSideBandSamplerParams& params )
+        : m_adapterId( adapterId )
+        , m_periodUs( params.PeriodUs ? std::max<uint32_t>( params.PeriodUs, MD_SIDE_BAND_MIN_PERIOD_US ) : MD_SIDE_BAND_DEFAULT_PERIOD_US )
+        , m_capacity( params.SampleCount ? params.SampleCount : MD_SIDE_BAND_DEFAULT_SAMPLE_COUNT )
+        , m_attributeNames()
+        , m_attributeFiles()
+        , m_sysFsCache()
+        , m_samples()
+        , m_sampleIndex( 0 )
+        , m_samplesMutex()
+        , m_thread()
+        , m_stop( false )
+        , m_stopMutex()
+        , m_stopCondition()
+    {
+        const bool     useDefaults    = params.AttributeCount == 0;
+        const uint32_t attributeCount = useDefaults ? MD_SIDE_BAND_DEFAULT_ATTRIBUTE_COUNT : std::min<uint32_t>( params.AttributeCount, MD_SIDE_BAND_ATTRIBUTE_COUNT_MAX );
+
+        for( uint32_t i = 0; i < attributeCount; ++i )
+        {
+            const char* attribute = useDefaults ? DefaultAttributes[i] : params.Attributes[i];
+            m_attributeNames.emplace_back( attribute ? attribute : "" );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     ~CSideBandSamplerLinux
+    //
+    // Description:
+    //     Destructor. Stops sampling, attribute files are closed by the cache.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CSideBandSamplerLinux::~CSideBandSamplerLinux()
+    {
+        Stop();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     Initialize
+    //
+    // Description:
+    //     Resolves attribute files, checks them with an uncached read and allocates
+    //     the sample ring. Attributes that cannot be read are only logged, so
+    //     a sampler on a kernel without e.g. hwmon support still samples
+    //     the remaining attributes, without keeping their files open.
+    //
+    // Input:
+    //     const char* directory - directory relative attributes are opened in
+    //
+    // Output:
+    //     TCompletionCode       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSideBandSamplerLinux::Initialize( const char* directory )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, directory, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_CC_RET_A( m_adapterId, m_sysFsCache.Initialize( m_adapterId, directory ) );
+
+        bool anyAvailable = false;
+
+        for( const auto& attribute : m_attributeNames )
+        {
+            std::string file  = ResolveAttribute( directory, attribute.c_str() );
+            uint64_t    value = 0;
+
+            if( !file.empty() && m_sysFsCache.ReadUncached( file.c_str(), &value ) != CC_OK )
+            {
+                MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Side-band attribute %s not available", file.c_str() );
+                file.clear();
+            }
+
+            anyAvailable |= !file.empty();
+            m_attributeFiles.push_back( file );
+        }
+
+        if( !anyAvailable )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: No side-band attribute available in %s", directory );
+            return CC_ERROR_FILE_NOT_FOUND;
+        }
+
+        m_samples.resize( m_capacity );
+
+        MD_LOG_A( m_adapterId, LOG_INFO, "Side-band sampler: %zu attributes, period %u us, %u samples", m_attributeNames.size(), m_periodUs, m_capacity );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     GetAttributeCount
+    //
+    // Description:
+    //     Returns the attribute count, including unavailable attributes.
+    //
+    // Output:
+    //     uint32_t - attribute count
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint32_t CSideBandSamplerLinux::GetAttributeCount( void )
+    {
+        return static_cast<uint32_t>( m_attributeNames.size() );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     GetAttributeName
+    //
+    // Description:
+    //     Returns the attribute path as requested. Unavailable attributes are
+    //     returned too, their values are never valid.
+    //
+    // Input:
+    //     uint32_t index - attribute index
+    //
+    // Output:
+    //     const char*    - attribute path, nullptr if out of range
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    const char* CSideBandSamplerLinux::GetAttributeName( uint32_t index )
+    {
+        return index < m_attributeNames.size() ? m_attributeNames[index].c_str() : nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     Start
+    //
+    // Description:
+    //     Starts the sampling thread. Samples taken before are kept.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSideBandSamplerLinux::Start( void )
+    {
+        if( m_thread.joinable() )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Side-band sampler already started" );
+            return CC_ALREADY_INITIALIZED;
+        }
+
+        m_stop   = false;
+        m_thread = std::thread( &CSideBandSamplerLinux::ThreadFunction, this );
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     Stop
+    //
+    // Description:
+    //     Stops the sampling thread and waits for it. Samples are kept.
+    //
+    // Output:
+    //     TCompletionCode - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSideBandSamplerLinux::Stop( void )
+    {
+        if( !m_thread.joinable() )
+        {
+            return CC_OK;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_stopMutex );
+            m_stop = true;
+        }
+        m_stopCondition.notify_all();
+
+        m_thread.join();
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     GetSamples
+    //
+    // Description:
+    //     Copies samples with timestamps within [beginCpuNs, endCpuNs], oldest
+    //     first. If outSamples is null, only the sample count in the range is
+    //     returned. May be called while sampling.
+    //
+    // Input:
+    //     uint64_t         beginCpuNs  - range begin, CPU time in ns
+    //     uint64_t         endCpuNs    - range end, CPU time in ns
+    //     TSideBandSample* outSamples  - (out) samples, may be null
+    //     uint32_t*        sampleCount - (in/out) outSamples size / returned sample count
+    //
+    // Output:
+    //     TCompletionCode              - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSideBandSamplerLinux::GetSamples( uint64_t beginCpuNs, uint64_t endCpuNs, TSideBandSample* outSamples, uint32_t* sampleCount )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, sampleCount, CC_ERROR_INVALID_PARAMETER );
+
+        std::lock_guard<std::mutex> lock( m_samplesMutex );
+
+        const uint64_t begin = FindSample( beginCpuNs );
+        const uint64_t end   = endCpuNs == UINT64_MAX ? m_sampleIndex : FindSample( endCpuNs + 1 );
+        uint64_t       count = end > begin ? end - begin : 0;
+
+        if( outSamples == nullptr )
+        {
+            *sampleCount = static_cast<uint32_t>( count );
+            return CC_OK;
+        }
+
+        count = std::min<uint64_t>( count, *sampleCount );
+
+        for( uint64_t i = 0; i < count; ++i )
+        {
+            outSamples[i] = m_samples[( begin + i ) % m_capacity];
+        }
+
+        *sampleCount = static_cast<uint32_t>( count );
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     GetSampleAt
+    //
+    // Description:
+    //     Returns the newest sample taken at or before the given CPU time, i.e.
+    //     the GPU state valid at that time.
+    //
+    // Input:
+    //     uint64_t         cpuTimestampNs - CPU time in ns
+    //     TSideBandSample* outSample      - (out) sample
+    //
+    // Output:
+    //     TCompletionCode                 - *CC_OK* means success, *CC_ERROR_GENERAL*
+    //                                       if there is no such sample
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSideBandSamplerLinux::GetSampleAt( uint64_t cpuTimestampNs, TSideBandSample* outSample )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, outSample, CC_ERROR_INVALID_PARAMETER );
+
+        std::lock_guard<std::mutex> lock( m_samplesMutex );
+
+        const uint64_t oldest = m_sampleIndex > m_capacity ? m_sampleIndex - m_capacity : 0;
+        const uint64_t next   = cpuTimestampNs == UINT64_MAX ? m_sampleIndex : FindSample( cpuTimestampNs + 1 );
+
+        if( next == oldest )
+        {
+            return CC_ERROR_GENERAL;
+        }
+
+        *outSample = m_samples[( next - 1 ) % m_capacity];
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     ResolveAttribute
+    //
+    // Description:
+    //     Resolves an attribute file path. Relative paths are resolved against
+    //     the given directory, glob patterns (e.g. hwmon*) to the first match.
+    //
+    // Input:
+    //     const std::string& directory - directory of relative attributes
+    //     const char*        attribute - attribute path
+    //
+    // Output:
+    //     std::string                  - absolute file path, empty if no attribute is given
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    std::string CSideBandSamplerLinux::ResolveAttribute( const std::string& directory, const char* attribute )
+    {
+        if( attribute[0] == '\0' )
+        {
+            return std::string();
+        }
+
+        std::string path = attribute[0] == '/' ? std::string( attribute ) : directory + "/" + attribute;
+
+        glob_t globResult = {};
+        if( glob( path.c_str(), 0, nullptr, &globResult ) == 0 && globResult.gl_pathc > 0 )
+        {
+            path = globResult.gl_pathv[0];
+        }
+        globfree( &globResult );
+
+        MD_LOG_A( m_adapterId, LOG_DEBUG, "Side-band attribute: %s", path.c_str() );
+        return path;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     ThreadFunction
+    //
+    // Description:
+    //     Sampling thread. Samples are taken on a fixed cadence rather than with
+    //     a fixed sleep, so read time does not accumulate into drift. Ticks
+    //     missed e.g. due to preemption are skipped, not caught up.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CSideBandSamplerLinux::ThreadFunction()
+    {
+        const auto period = std::chrono::microseconds( m_periodUs );
+        auto       next   = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock( m_stopMutex );
+
+        while( !m_stop )
+        {
+            lock.unlock();
+            TakeSample();
+            lock.lock();
+
+            next += period;
+
+            const auto now = std::chrono::steady_clock::now();
+            if( next < now )
+            {
+                next += period * ( ( now - next ) / period + 1 );
+            }
+
+            m_stopCondition.wait_until( lock, next, [this] { return m_stop; } );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     TakeSample
+    //
+    // Description:
+    //     Reads all available attributes through the cached file handles and
+    //     stores the sample in the ring. The sample is timestamped with
+    //     the middle of the reads.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CSideBandSamplerLinux::TakeSample()
+    {
+        TSideBandSample sample  = {};
+        const uint64_t  beginNs = GetTimeNs();
+
+        for( uint32_t i = 0; i < m_attributeFiles.size(); ++i )
+        {
+            if( m_attributeFiles[i].empty() || m_sysFsCache.Read( m_attributeFiles[i].c_str(), &sample.Values[i] ) != CC_OK )
+            {
+                continue;
+            }
+
+            sample.ValidMask |= 1u << i;
+        }
+
+        const uint64_t endNs  = GetTimeNs();
+        sample.CpuTimestampNs = beginNs + ( endNs - beginNs ) / 2;
+
+        std::lock_guard<std::mutex> lock( m_samplesMutex );
+
+        m_samples[m_sampleIndex % m_capacity] = sample;
+        ++m_sampleIndex;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSideBandSamplerLinux
+    //
+    // Method:
+    //     FindSample
+    //
+    // Description:
+    //     Returns the position of the first kept sample taken at or after
+    //     the given time, binary searched as samples are ordered by time.
+    //     Samples mutex has to be locked.
+    //
+    // Input:
+    //     const uint64_t cpuTimestampNs - CPU time in ns
+    //
+    // Output:
+    //     uint64_t                      - sample position, m_sampleIndex if none
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    uint64_t CSideBandSamplerLinux::FindSample( const uint64_t cpuTimestampNs )
+    {
+        uint64_t first = m_sampleIndex > m_capacity ? m_sampleIndex - m_capacity : 0;
+        uint64_t last  = m_sampleIndex;
+
+        while( first < last )
+        {
+            const uint64_t middle = first + ( last - first ) / 2;
+            if( m_samples[middle % m_capacity].CpuTimestampNs < cpuTimestampNs )
+            {
+                first = middle + 1;
+            }
+            else
+            {
+                last = middle;
+            }
+        }
+
+        return first;
+    }
+} // namespace MetricsDiscoveryInternal
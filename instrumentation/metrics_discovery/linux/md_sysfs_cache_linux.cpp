@@ -0,0 +1,444 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_sysfs_cache_linux.cpp
+//
+//     Abstract:   C++ persistent SysFs file handle cache for Linux
+
+#include "md_sysfs_cache_linux.h"
+#include "md_driver_ifc_linux_common.h"
+#include "md_utils.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <unistd.h> // close, pread
+
+namespace MetricsDiscoveryInternal
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     CSysFsCache constructor
+    //
+    // Description:
+    //     Constructor.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CSysFsCache::CSysFsCache()
+        : m_adapterId( IU_ADAPTER_ID_UNKNOWN )
+        , m_directoryFd( -1 )
+        , m_refreshIntervalNs( MD_SYSFS_CACHE_DEFAULT_REFRESH_INTERVAL_US * 1000ULL )
+        , m_entries()
+        , m_mutex()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     ~CSysFsCache
+    //
+    // Description:
+    //     Destructor. Closes all cached files.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    CSysFsCache::~CSysFsCache()
+    {
+        Clear();
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     Initialize
+    //
+    // Description:
+    //     Opens SysFs directory of the given DRM card, used for relative file names.
+    //     Refresh interval may be overridden with MD_SYSFS_REFRESH_INTERVAL_US
+    //     environment variable.
+    //
+    // Input:
+    //     const uint32_t adapterId     - adapter id for logging
+    //     const int32_t  drmCardNumber - DRM card number
+    //
+    // Output:
+    //     TCompletionCode              - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSysFsCache::Initialize( const uint32_t adapterId, const int32_t drmCardNumber )
+    {
+        char directoryPath[MD_MAX_PATH_LENGTH] = { 0 };
+        snprintf( directoryPath, sizeof( directoryPath ), "/sys/class/drm/card%d", drmCardNumber );
+
+        return Initialize( adapterId, directoryPath );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     Initialize
+    //
+    // Description:
+    //     Opens the given directory, used for relative file names, e.g. a copy
+    //     of the SysFs tree. Refresh interval may be overridden with
+    //     MD_SYSFS_REFRESH_INTERVAL_US environment variable.
+    //
+    // Input:
+    //     const uint32_t adapterId - adapter id for logging
+    //     const char*    directory - directory path
+    //
+    // Output:
+    //     TCompletionCode          - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSysFsCache::Initialize( const uint32_t adapterId, const char* directory )
+    {
+        MD_CHECK_PTR_RET_A( adapterId, directory, CC_ERROR_INVALID_PARAMETER );
+
+        Clear();
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        m_adapterId = adapterId;
+
+        m_directoryFd = open( directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+        if( m_directoryFd < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Failed to open %s, error: %d (%s)", directory, errno, strerror( errno ) );
+            return CC_ERROR_FILE_NOT_FOUND;
+        }
+
+        const char* refreshInterval = iu_dupenv_s( MD_SYSFS_REFRESH_INTERVAL );
+        if( refreshInterval != nullptr )
+        {
+            m_refreshIntervalNs = strtoull( refreshInterval, nullptr, 0 ) * 1000ULL;
+            MD_LOG_A( m_adapterId, LOG_INFO, "SysFs refresh interval: %llu ns", static_cast<unsigned long long>( m_refreshIntervalNs ) );
+
+            free( (void*) refreshInterval );
+        }
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     Clear
+    //
+    // Description:
+    //     Closes all cached files and the SysFs directory.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CSysFsCache::Clear()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        for( auto& entry : m_entries )
+        {
+            CloseEntry( entry.second );
+        }
+        m_entries.clear();
+
+        if( m_directoryFd >= 0 )
+        {
+            close( m_directoryFd );
+            m_directoryFd = -1;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     SetRefreshInterval
+    //
+    // Description:
+    //     Sets the minimal interval between two reads of a rate limited file.
+    //     Zero disables rate limiting.
+    //
+    // Input:
+    //     const uint64_t refreshIntervalNs - refresh interval in nanoseconds
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CSysFsCache::SetRefreshInterval( const uint64_t refreshIntervalNs )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        m_refreshIntervalNs = refreshIntervalNs;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     Read
+    //
+    // Description:
+    //     Reads 64-bit unsigned value from the given SysFs file. The file is opened
+    //     on the first read and kept open. If the kept handle became stale (e.g.
+    //     oa config was removed and added again), the file is reopened once.
+    //
+    // Input:
+    //     const char* fileName    - file name relative to DRM card SysFs directory or absolute path
+    //     uint64_t*   readValue   - (OUT) read value, not changed in case of error
+    //     const bool  rateLimited - if true, value younger than refresh interval is not read again
+    //
+    // Output:
+    //     TCompletionCode         - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSysFsCache::Read( const char* fileName, uint64_t* readValue, const bool rateLimited /* = false */ )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, fileName, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, readValue, CC_ERROR_INVALID_PARAMETER );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        TSysFsCacheEntry* entry = GetEntry( fileName );
+        if( entry == nullptr )
+        {
+            return CC_ERROR_FILE_NOT_FOUND;
+        }
+
+        if( rateLimited && entry->ReadTimeNs && ( GetTimeNs() - entry->ReadTimeNs ) < m_refreshIntervalNs )
+        {
+            *readValue = entry->Value;
+            return CC_OK;
+        }
+
+        TCompletionCode ret = ReadEntry( fileName, *entry );
+        if( ret != CC_OK )
+        {
+            // Retry once with a freshly opened file
+            RemoveEntry( fileName );
+
+            entry = GetEntry( fileName );
+            if( entry == nullptr )
+            {
+                return CC_ERROR_FILE_NOT_FOUND;
+            }
+
+            ret = ReadEntry( fileName, *entry );
+            MD_CHECK_CC_RET_A( m_adapterId, ret );
+        }
+
+        *readValue = entry->Value;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     ReadUncached
+    //
+    // Description:
+    //     Reads 64-bit unsigned value from the given SysFs file, which is closed
+    //     right after the read. Used for files removed with the objects they
+    //     describe, so their handles do not accumulate in the cache.
+    //
+    // Input:
+    //     const char* fileName  - file name relative to DRM card SysFs directory or absolute path
+    //     uint64_t*   readValue - (OUT) read value, not changed in case of error
+    //
+    // Output:
+    //     TCompletionCode       - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSysFsCache::ReadUncached( const char* fileName, uint64_t* readValue )
+    {
+        MD_CHECK_PTR_RET_A( m_adapterId, fileName, CC_ERROR_INVALID_PARAMETER );
+        MD_CHECK_PTR_RET_A( m_adapterId, readValue, CC_ERROR_INVALID_PARAMETER );
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        TSysFsCacheEntry entry = { openat( m_directoryFd, fileName, O_RDONLY | O_CLOEXEC ), 0, 0 };
+        if( entry.Fd < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Failed to open %s, error: %d (%s)", fileName, errno, strerror( errno ) );
+            return CC_ERROR_FILE_NOT_FOUND;
+        }
+
+        const TCompletionCode ret = ReadEntry( fileName, entry );
+        CloseEntry( entry );
+        MD_CHECK_CC_RET_A( m_adapterId, ret );
+
+        *readValue = entry.Value;
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     Invalidate
+    //
+    // Description:
+    //     Closes the given file if cached, e.g. after writing to it. The next read
+    //     reopens the file.
+    //
+    // Input:
+    //     const char* fileName - file name used for reading
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CSysFsCache::Invalidate( const char* fileName )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        RemoveEntry( fileName );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     RemoveEntry
+    //
+    // Description:
+    //     Closes and removes cache entry of the given file, if exists.
+    //
+    // Input:
+    //     const char* fileName - file name used for reading
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CSysFsCache::RemoveEntry( const char* fileName )
+    {
+        auto it = m_entries.find( fileName );
+        if( it != m_entries.end() )
+        {
+            CloseEntry( it->second );
+            m_entries.erase( it );
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     GetEntry
+    //
+    // Description:
+    //     Returns cache entry of the given file, opening the file if needed.
+    //
+    // Input:
+    //     const char* fileName - file name relative to DRM card SysFs directory or absolute path
+    //
+    // Output:
+    //     TSysFsCacheEntry*    - cache entry, nullptr if the file cannot be opened
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TSysFsCacheEntry* CSysFsCache::GetEntry( const char* fileName )
+    {
+        auto it = m_entries.find( fileName );
+        if( it != m_entries.end() )
+        {
+            return &it->second;
+        }
+
+        const int32_t fd = openat( m_directoryFd, fileName, O_RDONLY | O_CLOEXEC );
+        if( fd < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_ERROR, "ERROR: Failed to open %s, error: %d (%s)", fileName, errno, strerror( errno ) );
+            return nullptr;
+        }
+
+        return &m_entries.emplace( fileName, TSysFsCacheEntry{ fd, 0, 0 } ).first->second;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     ReadEntry
+    //
+    // Description:
+    //     Reads the value of an opened file with a single pread from offset 0.
+    //     Based on GpuTop read_file_uint64().
+    //
+    // Input:
+    //     const char*       fileName - file name for logging
+    //     TSysFsCacheEntry& entry    - opened cache entry
+    //
+    // Output:
+    //     TCompletionCode            - *CC_OK* means success
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    TCompletionCode CSysFsCache::ReadEntry( const char* fileName, TSysFsCacheEntry& entry )
+    {
+        char buffer[MD_SYSFS_CACHE_MAX_VALUE_LENGTH] = { 0 };
+
+        const ssize_t readBytes = pread( entry.Fd, buffer, sizeof( buffer ) - 1, 0 );
+        if( readBytes < 0 )
+        {
+            MD_LOG_A( m_adapterId, LOG_WARNING, "WARNING: Failed to read %s, error: %d (%s)", fileName, errno, strerror( errno ) );
+            return CC_ERROR_GENERAL;
+        }
+
+        buffer[readBytes] = '\0';
+        entry.Value       = strtoull( buffer, 0, 0 );
+        entry.ReadTimeNs  = GetTimeNs();
+
+        return CC_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSysFsCache
+    //
+    // Method:
+    //     CloseEntry
+    //
+    // Description:
+    //     Closes the file of the given cache entry.
+    //
+    // Input:
+    //     TSysFsCacheEntry& entry - cache entry
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CSysFsCache::CloseEntry( TSysFsCacheEntry& entry )
+    {
+        if( entry.Fd >= 0 )
+        {
+            close( entry.Fd );
+            entry.Fd = -1;
+        }
+    }
+} // namespace MetricsDiscoveryInternal
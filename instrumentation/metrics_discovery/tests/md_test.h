@@ -0,0 +1,62 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_test.h
+
+//     Abstract:   C++ Metrics Discovery test checks header
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Test checks. A failed check is printed and counted and the test goes on,
+//     so one run reports all failures. MD_TEST_CHECK_RET returns from the test
+//     instead, for checks the rest of the test depends on. MD_TEST_RESULT is
+//     the exit code of the test executable.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define MD_TEST_CHECK( condition )                                                                  \
+    do                                                                                              \
+    {                                                                                               \
+        if( !( condition ) )                                                                        \
+        {                                                                                           \
+            printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition );                  \
+            ++MetricsDiscoveryTest::g_failedCheckCount;                                             \
+        }                                                                                           \
+    } while( 0 )
+
+#define MD_TEST_CHECK_RET( condition )                                                              \
+    do                                                                                              \
+    {                                                                                               \
+        if( !( condition ) )                                                                        \
+        {                                                                                           \
+            printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition );                  \
+            ++MetricsDiscoveryTest::g_failedCheckCount;                                             \
+            return;                                                                                 \
+        }                                                                                           \
+    } while( 0 )
+
+#define MD_TEST_RUN( test )                                                                         \
+    do                                                                                              \
+    {                                                                                               \
+        const uint32_t failedCount = MetricsDiscoveryTest::g_failedCheckCount;                      \
+        test();                                                                                     \
+        const bool     passed      = MetricsDiscoveryTest::g_failedCheckCount == failedCount;       \
+        printf( "%s %s\n", passed ? "PASSED" : "FAILED", #test );                                   \
+    } while( 0 )
+
+#define MD_TEST_RESULT() ( ( MetricsDiscoveryTest::g_failedCheckCount == 0 ) ? 0 : 1 )
+
+namespace MetricsDiscoveryTest
+{
+    inline uint32_t g_failedCheckCount = 0;
+} // namespace MetricsDiscoveryTest
@@ -0,0 +1,470 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_test_io_stream_group.cpp
+
+//     Abstract:   C++ Metrics Discovery test of the Linux IoStream group
+
+#include "md_test.h"
+
+#include "md_adapter.h"
+#include "md_adapter_group.h"
+#include "md_driver_ifc_linux_perf.h"
+#include "md_io_stream_group_linux.h"
+#include "md_metric_set.h"
+#include "md_metrics_device.h"
+#include "md_oa_concurrent_group.h"
+#include "md_utils.h"
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace MetricsDiscoveryInternal;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Streams of the test: count, raw report layout and read timeouts.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define TEST_STREAM_COUNT  2
+#define TEST_REPORT_SIZE   256
+#define TEST_REPORT_TYPE   OA_REPORT_TYPE_256B_A45_NOA16
+#define TEST_READ_TIMEOUT  1000 // Reports are written before the read, so it does not wait
+#define TEST_EMPTY_TIMEOUT 10
+
+namespace
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTestAdapterGroup
+    //
+    // Description:
+    //     Adapter group without adapters, only a parent of the test adapter.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CTestAdapterGroup : public CAdapterGroup
+    {
+    public:
+        CTestAdapterGroup()  = default;
+        ~CTestAdapterGroup() = default;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CPipeDriverInterface
+    //
+    // Description:
+    //     i915 Perf driver interface of a simulated TGL GT2 device with pipes
+    //     instead of Perf streams. The read end of a pipe is the stream fd, so
+    //     stream reads, record parsing and the stream group run unchanged,
+    //     reports are written to the other end as i915 Perf sample records.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CPipeDriverInterface : public CDriverInterfaceLinuxPerf
+    {
+    public:
+        CPipeDriverInterface( CAdapterHandle& adapterHandle )
+            : CDriverInterfaceLinuxPerf( adapterHandle )
+            , m_writeFds()
+        {
+            // Stream reads query the GPU frequency, SysFs reads fail as the SysFs cache is not initialized
+            m_DrmCardNumber = 0;
+        }
+
+        ~CPipeDriverInterface()
+        {
+            for( auto& writeFd : m_writeFds )
+            {
+                close( writeFd.second );
+            }
+        }
+
+        virtual TCompletionCode SendDeviceInfoParamEscape( GTDI_DEVICE_PARAM param, GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice = nullptr )
+        {
+            switch( param )
+            {
+                case GTDI_DEVICE_PARAM_PLATFORM_INDEX:
+                    out->ValueUint32 = GENERATION_TGL;
+                    return CC_OK;
+
+                case GTDI_DEVICE_PARAM_GT_TYPE:
+                    out->ValueUint32 = 1; // GT_TYPE_GT2
+                    return CC_OK;
+
+                default:
+                    return CC_ERROR_NOT_SUPPORTED;
+            }
+        }
+
+        virtual TCompletionCode OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize )
+        {
+            auto&   metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+            int32_t fds[2]        = { -1, -1 };
+
+            // i915 Perf streams are opened nonblocking too
+            if( pipe2( fds, O_NONBLOCK | O_CLOEXEC ) != 0 )
+            {
+                return CC_ERROR_GENERAL;
+            }
+
+            metricsDevice.SetStreamId( fds[0] );
+            m_writeFds[&metricsDevice] = fds[1];
+
+            bufferSize = ( bufferSize != 0 ) ? bufferSize : 16 * MD_MBYTE;
+            return CC_OK;
+        }
+
+        virtual TCompletionCode CloseIoStream( COAConcurrentGroup& oaConcurrentGroup )
+        {
+            auto& metricsDevice = oaConcurrentGroup.GetMetricsDevice();
+            auto  writeFd       = m_writeFds.find( &metricsDevice );
+
+            if( writeFd != m_writeFds.end() )
+            {
+                close( writeFd->second );
+                m_writeFds.erase( writeFd );
+            }
+
+            return CloseOaStream( metricsDevice );
+        }
+
+        // Writes reports with the given timestamps to the stream of the metrics device.
+        bool WriteReports( CMetricsDevice& metricsDevice, const std::vector<uint32_t>& timestamps )
+        {
+            constexpr size_t  recordSize = sizeof( drm_i915_perf_record_header ) + TEST_REPORT_SIZE;
+            std::vector<char> records( timestamps.size() * recordSize );
+
+            for( size_t i = 0; i < timestamps.size(); ++i )
+            {
+                char*                       record = records.data() + i * recordSize;
+                drm_i915_perf_record_header header = {};
+
+                header.type = DRM_I915_PERF_RECORD_SAMPLE;
+                header.size = recordSize;
+
+                memcpy( record, &header, sizeof( header ) );
+                memcpy( record + sizeof( header ) + sizeof( uint32_t ), &timestamps[i], sizeof( uint32_t ) );
+            }
+
+            auto writeFd = m_writeFds.find( &metricsDevice );
+            return writeFd != m_writeFds.end() && write( writeFd->second, records.data(), records.size() ) == static_cast<ssize_t>( records.size() );
+        }
+
+    private:
+        std::map<CMetricsDevice*, int32_t> m_writeFds; // Write ends of stream pipes
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTestStreams
+    //
+    // Description:
+    //     Metrics devices sharing the pipe driver interface, as sub devices of
+    //     an adapter do, each with an OA concurrent group and a stream group
+    //     created by the first one.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CTestStreams
+    {
+    public:
+        CTestStreams()
+            : m_adapterGroup()
+            , m_adapter( nullptr )
+            , m_driverInterface( nullptr )
+            , m_devices{}
+            , m_groups{}
+            , m_metricSets{}
+            , m_streamGroup( nullptr )
+        {
+            TAdapterParamsLatest adapterParams = {};
+
+            // No DRM device behind the handle, the adapter does not create a driver interface
+            auto adapterHandle = new( std::nothrow ) CAdapterHandleLinux( -1 );
+
+            m_adapter         = new( std::nothrow ) CAdapter( m_adapterGroup, adapterParams, *adapterHandle );
+            m_driverInterface = new( std::nothrow ) CPipeDriverInterface( *adapterHandle );
+
+            uint8_t          platformMaskByteArray[MD_PLATFORM_MASK_BYTE_ARRAY_SIZE] = {};
+            TByteArrayLatest platformMask                                            = { MD_PLATFORM_MASK_BYTE_ARRAY_SIZE, platformMaskByteArray };
+
+            SetPlatformMask( m_adapter->GetAdapterId(), &platformMask, nullptr, false, GENERATION_TGL );
+
+            for( uint32_t i = 0; i < TEST_STREAM_COUNT; ++i )
+            {
+                m_devices[i]    = new( std::nothrow ) CMetricsDevice( *m_adapter, *m_driverInterface );
+                m_groups[i]     = new( std::nothrow ) COAConcurrentGroup( *m_devices[i], "OA", "OA Unit Metrics", MEASUREMENT_TYPE_SNAPSHOT_IO );
+                m_metricSets[i] = m_groups[i]->AddMetricSet( "Test", "Test Set", API_TYPE_IOSTREAM, GPU_RENDER, TEST_REPORT_SIZE, TEST_REPORT_SIZE, TEST_REPORT_TYPE, &platformMask );
+            }
+
+            m_streamGroup = m_groups[0]->CreateIoStreamGroup();
+        }
+
+        ~CTestStreams()
+        {
+            for( uint32_t i = 0; i < TEST_STREAM_COUNT; ++i )
+            {
+                if( m_groups[i] && m_groups[i]->GetIoMetricSet() )
+                {
+                    m_groups[i]->CloseIoStream();
+                }
+            }
+
+            // Deletes the stream group too
+            for( uint32_t i = 0; i < TEST_STREAM_COUNT; ++i )
+            {
+                MD_SAFE_DELETE( m_groups[i] );
+                MD_SAFE_DELETE( m_devices[i] );
+            }
+
+            MD_SAFE_DELETE( m_driverInterface );
+            MD_SAFE_DELETE( m_adapter );
+        }
+
+        bool IsValid() const
+        {
+            for( uint32_t i = 0; i < TEST_STREAM_COUNT; ++i )
+            {
+                if( m_metricSets[i] == nullptr )
+                {
+                    return false;
+                }
+            }
+
+            return m_streamGroup != nullptr;
+        }
+
+        // Opens streams of all concurrent groups and adds them to the stream group.
+        bool OpenAll()
+        {
+            for( uint32_t i = 0; i < TEST_STREAM_COUNT; ++i )
+            {
+                if( Open( i ) != CC_OK || m_streamGroup->AddStream( m_groups[i] ) != CC_OK )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        TCompletionCode Open( const uint32_t index )
+        {
+            uint32_t nsTimerPeriod = 100 * MD_NSEC_PER_USEC;
+            uint32_t oaBufferSize  = 0;
+
+            return m_groups[index]->OpenIoStream( m_metricSets[index], 0, &nsTimerPeriod, &oaBufferSize );
+        }
+
+        bool Write( const uint32_t index, const std::vector<uint32_t>& timestamps )
+        {
+            return m_driverInterface->WriteReports( *m_devices[index], timestamps );
+        }
+
+        // Reads all ready streams and returns timestamps of the read reports per stream.
+        std::vector<std::vector<uint32_t>> Read( const uint32_t milliseconds, const uint32_t maxReportCount, TCompletionCode& result )
+        {
+            std::vector<std::vector<uint32_t>> timestamps( TEST_STREAM_COUNT );
+            TIoStreamGroupRead                 reads[TEST_STREAM_COUNT] = {};
+            uint32_t                           readCount                = 0;
+
+            result = m_streamGroup->ReadReports( milliseconds, maxReportCount, reads, TEST_STREAM_COUNT, &readCount );
+
+            for( uint32_t i = 0; i < readCount; ++i )
+            {
+                const uint32_t index = GetIndex( reads[i].ConcurrentGroup );
+
+                if( index == TEST_STREAM_COUNT || ( reads[i].Result != CC_OK && reads[i].Result != CC_READ_PENDING ) )
+                {
+                    result = CC_ERROR_GENERAL;
+                    continue;
+                }
+
+                for( uint32_t span = 0; span < reads[i].View.SpanCount; ++span )
+                {
+                    auto& streamSpan = reads[i].View.Spans[span];
+
+                    for( uint32_t report = 0; report < streamSpan.ReportCount; ++report )
+                    {
+                        uint32_t timestamp = 0;
+                        memcpy( &timestamp, streamSpan.Data + report * streamSpan.Stride + sizeof( uint32_t ), sizeof( uint32_t ) );
+                        timestamps[index].push_back( timestamp );
+                    }
+                }
+            }
+
+            return timestamps;
+        }
+
+    private:
+        uint32_t GetIndex( IConcurrentGroupLatest* concurrentGroup )
+        {
+            for( uint32_t i = 0; i < TEST_STREAM_COUNT; ++i )
+            {
+                if( m_groups[i] == concurrentGroup )
+                {
+                    return i;
+                }
+            }
+
+            return TEST_STREAM_COUNT;
+        }
+
+    public:
+        CTestAdapterGroup       m_adapterGroup;
+        CAdapter*               m_adapter;
+        CPipeDriverInterface*   m_driverInterface;
+        CMetricsDevice*         m_devices[TEST_STREAM_COUNT];
+        COAConcurrentGroup*     m_groups[TEST_STREAM_COUNT];
+        CMetricSet*             m_metricSets[TEST_STREAM_COUNT];
+        IInternalIoStreamGroup* m_streamGroup;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Description:
+    //     Reads only ready streams, all reports of a ready stream at once, and
+    //     times out when no stream is ready.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CheckReadReports( CTestStreams& test )
+    {
+        TCompletionCode result = CC_OK;
+
+        MD_TEST_CHECK( test.Write( 0, { 0x100, 0x200, 0x300 } ) );
+
+        auto read = test.Read( TEST_READ_TIMEOUT, 16, result );
+        MD_TEST_CHECK( result == CC_OK );
+        MD_TEST_CHECK( read[0] == std::vector<uint32_t>( { 0x100, 0x200, 0x300 } ) );
+        MD_TEST_CHECK( read[1].empty() );
+
+        MD_TEST_CHECK( test.Write( 0, { 0x400 } ) );
+        MD_TEST_CHECK( test.Write( 1, { 0x1100, 0x1200 } ) );
+
+        read = test.Read( TEST_READ_TIMEOUT, 16, result );
+        MD_TEST_CHECK( result == CC_OK );
+        MD_TEST_CHECK( read[0] == std::vector<uint32_t>( { 0x400 } ) );
+        MD_TEST_CHECK( read[1] == std::vector<uint32_t>( { 0x1100, 0x1200 } ) );
+
+        // Reports written separately are read at once, pipes do not keep records whole in split reads
+        MD_TEST_CHECK( test.Write( 1, { 0x1300 } ) );
+        MD_TEST_CHECK( test.Write( 1, { 0x1400, 0x1500 } ) );
+
+        read = test.Read( TEST_READ_TIMEOUT, 3, result );
+        MD_TEST_CHECK( result == CC_OK );
+        MD_TEST_CHECK( read[0].empty() );
+        MD_TEST_CHECK( read[1] == std::vector<uint32_t>( { 0x1300, 0x1400, 0x1500 } ) );
+
+        read = test.Read( TEST_EMPTY_TIMEOUT, 16, result );
+        MD_TEST_CHECK( result == CC_WAIT_TIMEOUT );
+        MD_TEST_CHECK( read[0].empty() && read[1].empty() );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Description:
+    //     A reopened stream is registered again, also if its fd is reused, and
+    //     a closed stream is removed from the stream group.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void CheckReopenedStreams( CTestStreams& test )
+    {
+        TCompletionCode result = CC_OK;
+
+        // A stream reopened with data pending in the old one
+        MD_TEST_CHECK( test.Write( 0, { 0x100 } ) );
+        MD_TEST_CHECK( test.m_groups[0]->CloseIoStream() == CC_OK );
+        MD_TEST_CHECK_RET( test.Open( 0 ) == CC_OK );
+        MD_TEST_CHECK( test.Write( 0, { 0x2100 } ) );
+
+        auto read = test.Read( TEST_READ_TIMEOUT, 16, result );
+        MD_TEST_CHECK( result == CC_OK );
+        MD_TEST_CHECK( read[0] == std::vector<uint32_t>( { 0x2100 } ) );
+        MD_TEST_CHECK( test.m_streamGroup->GetStreamCount() == TEST_STREAM_COUNT );
+
+        MD_TEST_CHECK( test.m_groups[1]->CloseIoStream() == CC_OK );
+        MD_TEST_CHECK( test.Write( 0, { 0x2200 } ) );
+
+        read = test.Read( TEST_READ_TIMEOUT, 16, result );
+        MD_TEST_CHECK( result == CC_OK );
+        MD_TEST_CHECK( read[0] == std::vector<uint32_t>( { 0x2200 } ) );
+        MD_TEST_CHECK( test.m_streamGroup->GetStreamCount() == 1 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestReadReportsPoll
+    //
+    // Description:
+    //     Stream group reads with the epoll backend.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestReadReportsPoll()
+    {
+        CTestStreams test;
+        MD_TEST_CHECK_RET( test.IsValid() );
+        MD_TEST_CHECK_RET( test.OpenAll() );
+        MD_TEST_CHECK_RET( test.m_streamGroup->SetReadBackend( IO_STREAM_GROUP_BACKEND_POLL ) == CC_OK );
+
+        CheckReadReports( test );
+        CheckReopenedStreams( test );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestReadReportsIoUring
+    //
+    // Description:
+    //     Stream group reads with the io_uring backend, skipped where io_uring
+    //     is not available. Reads stay in flight between the calls.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestReadReportsIoUring()
+    {
+        CTestStreams test;
+        MD_TEST_CHECK_RET( test.IsValid() );
+        MD_TEST_CHECK_RET( test.OpenAll() );
+
+        const TCompletionCode ret = test.m_streamGroup->SetReadBackend( IO_STREAM_GROUP_BACKEND_IO_URING );
+        if( ret == CC_ERROR_NOT_SUPPORTED )
+        {
+            printf( "io_uring not available, skipped\n" );
+            return;
+        }
+        MD_TEST_CHECK_RET( ret == CC_OK );
+
+        CheckReadReports( test );
+        CheckReopenedStreams( test );
+
+        // Back to epoll with reads in flight
+        MD_TEST_CHECK( test.m_streamGroup->SetReadBackend( IO_STREAM_GROUP_BACKEND_POLL ) == CC_OK );
+        MD_TEST_CHECK( test.Write( 0, { 0x3100 } ) );
+
+        TCompletionCode result = CC_OK;
+        auto            read   = test.Read( TEST_READ_TIMEOUT, 16, result );
+        MD_TEST_CHECK( result == CC_OK );
+        MD_TEST_CHECK( read[0] == std::vector<uint32_t>( { 0x3100 } ) );
+    }
+} // namespace
+
+int main()
+{
+    MD_TEST_RUN( TestReadReportsPoll );
+    MD_TEST_RUN( TestReadReportsIoUring );
+
+    return MD_TEST_RESULT();
+}
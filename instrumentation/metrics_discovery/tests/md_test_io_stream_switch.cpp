@@ -0,0 +1,392 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_test_io_stream_switch.cpp
+
+//     Abstract:   C++ Metrics Discovery test of IoStream metric set switches
+
+#include "md_test.h"
+
+#include "md_adapter.h"
+#include "md_adapter_group.h"
+#include "md_driver_ifc.h"
+#include "md_driver_ifc_linux_common.h"
+#include "md_metric_set.h"
+#include "md_metrics_device.h"
+#include "md_oa_concurrent_group.h"
+#include "md_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace MetricsDiscoveryInternal;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Simulated GPU timestamp: frequency, ticks the stream is opened at, a few
+//     ms before the 32 bit timestamp wraps, and ticks a switch takes.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define TEST_TIMESTAMP_FREQUENCY 12000000
+#define TEST_OPEN_TICKS          0xFFFF0000ULL
+#define TEST_SWITCH_TICKS        0x100
+#define TEST_REPORT_SIZE         256
+#define TEST_REPORT_TYPE         OA_REPORT_TYPE_256B_A45_NOA16
+
+namespace
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTestAdapterGroup
+    //
+    // Description:
+    //     Adapter group without adapters, only a parent of the test adapter.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CTestAdapterGroup : public CAdapterGroup
+    {
+    public:
+        CTestAdapterGroup()  = default;
+        ~CTestAdapterGroup() = default;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CFakeDriverInterface
+    //
+    // Description:
+    //     Driver interface of a simulated TGL GT2 device. GPU timestamps are
+    //     returned in ns scaled from 32 bit ticks, as the i915 driver does, so
+    //     they wrap. Each read returns the queued reports, a switch takes
+    //     TEST_SWITCH_TICKS.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CFakeDriverInterface : public CDriverInterface
+    {
+    public:
+        uint64_t              m_gpuTicks    = TEST_OPEN_TICKS;
+        uint32_t              m_switchCount = 0;
+        std::vector<uint32_t> m_reportTimestamps; // Reports returned by the next read
+
+        // General:
+        virtual TCompletionCode ForceSupportDisable() { return CC_OK; }
+        virtual TCompletionCode SendSupportEnableEscape( bool enable ) { return CC_OK; }
+        virtual TCompletionCode GetMaxMinOaBufferSize( const GTDI_OA_BUFFER_TYPE oaBufferType, const GTDI_DEVICE_PARAM param, GTDIDeviceInfoParamExtOut& out ) { return CC_ERROR_NOT_SUPPORTED; }
+        virtual TCompletionCode SendPmRegsConfig( TRegister** regVector, const uint32_t regCount, const uint32_t apiMask, const uint32_t subDeviceIndex, const GTDI_OA_BUFFER_TYPE oaBufferType ) { return CC_OK; }
+        virtual TCompletionCode SendReadRegsConfig( TRegister** regVector, uint32_t regCount, uint32_t apiMask ) { return CC_OK; }
+        virtual TCompletionCode GetPmRegsConfigHandles( uint32_t configId, uint32_t* oaConfigHandle, uint32_t* gpConfigHandle, uint32_t* rrConfigHandle ) { return CC_ERROR_NOT_SUPPORTED; }
+        virtual TCompletionCode ValidatePmRegsConfig( TRegister* regVector, uint32_t regCount, uint32_t platform ) { return CC_OK; }
+        virtual TCompletionCode SendGetCtxIdTagsEscape( TGetCtxTagsIdParams* params ) { return CC_ERROR_NOT_SUPPORTED; }
+        virtual bool            IsOaBufferSupported( const GTDI_OA_BUFFER_TYPE oaBufferType, CMetricsDevice* metricsDevice = nullptr ) { return oaBufferType == GTDI_OA_BUFFER_TYPE_DEFAULT; }
+        virtual uint32_t        GetAdapterId() { return m_adapterId; }
+
+        virtual TCompletionCode SendDeviceInfoParamEscape( GTDI_DEVICE_PARAM param, GTDIDeviceInfoParamExtOut* out, CMetricsDevice* metricsDevice = nullptr )
+        {
+            switch( param )
+            {
+                case GTDI_DEVICE_PARAM_PLATFORM_INDEX:
+                    out->ValueUint32 = GENERATION_TGL;
+                    return CC_OK;
+
+                case GTDI_DEVICE_PARAM_GT_TYPE:
+                    out->ValueUint32 = 1; // GT_TYPE_GT2
+                    return CC_OK;
+
+                default:
+                    return CC_ERROR_NOT_SUPPORTED;
+            }
+        }
+
+        virtual TCompletionCode GetGpuCpuTimestamps( CMetricsDevice& device, uint64_t* gpuTimestamp, uint64_t* cpuTimestamp, uint32_t* cpuId, uint64_t* correlationIndicator )
+        {
+            *gpuTimestamp         = ( m_gpuTicks & UINT32_MAX ) * MD_SECOND_IN_NS / TEST_TIMESTAMP_FREQUENCY;
+            *cpuTimestamp         = GetTimeNs();
+            *cpuId                = 0;
+            *correlationIndicator = 0;
+            return CC_OK;
+        }
+
+        // Synchronization:
+        virtual TCompletionCode LockConcurrentGroup( const char* name, void** semaphore ) { return CC_OK; }
+        virtual TCompletionCode UnlockConcurrentGroup( const char* name, void** semaphore ) { return CC_OK; }
+
+        // Stream:
+        virtual TCompletionCode OpenIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& nsTimerPeriod, uint32_t& bufferSize )
+        {
+            bufferSize = ( bufferSize != 0 ) ? bufferSize : 16 * MD_MBYTE;
+            return CC_OK;
+        }
+
+        virtual TCompletionCode ReadIoStream( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, char* reportData, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions )
+        {
+            reportsCount = std::min<uint32_t>( reportsCount, m_reportTimestamps.size() );
+
+            for( uint32_t i = 0; i < reportsCount; ++i )
+            {
+                uint8_t* report = reinterpret_cast<uint8_t*>( reportData ) + i * TEST_REPORT_SIZE;
+
+                memset( report, 0, TEST_REPORT_SIZE );
+                memcpy( report + sizeof( uint32_t ), &m_reportTimestamps[i], sizeof( uint32_t ) );
+            }
+
+            m_reportTimestamps.erase( m_reportTimestamps.begin(), m_reportTimestamps.begin() + reportsCount );
+            return CC_OK;
+        }
+
+        virtual TCompletionCode SwitchIoStream( COAConcurrentGroup& oaConcurrentGroup, CMetricSet& metricSet )
+        {
+            m_gpuTicks += TEST_SWITCH_TICKS;
+            ++m_switchCount;
+            return CC_OK;
+        }
+
+        virtual TCompletionCode ReadIoStreamView( COAConcurrentGroup& oaConcurrentGroup, const uint32_t readFlags, uint32_t& reportsCount, uint32_t& frequency, GTDIReadCounterStreamExceptions& exceptions ) { return CC_ERROR_NOT_SUPPORTED; }
+        virtual TCompletionCode PauseIoStream( COAConcurrentGroup& oaConcurrentGroup, const bool pause ) { return CC_OK; }
+        virtual TCompletionCode CloseIoStream( COAConcurrentGroup& oaConcurrentGroup ) { return CC_OK; }
+        virtual TCompletionCode HandleIoStreamExceptions( COAConcurrentGroup& oaConcurrentGroup, const uint32_t processId, uint32_t& reportCount, const GTDIReadCounterStreamExceptions exceptions ) { return CC_OK; }
+        virtual TCompletionCode WaitForIoStreamReports( COAConcurrentGroup& oaConcurrentGroup, const uint32_t milliseconds ) { return CC_OK; }
+        virtual bool            IsIoMeasurementInfoAvailable( const TIoMeasurementInfoType ioMeasurementInfoType ) { return false; }
+        virtual bool            IsStreamTypeSupported( const TStreamType streamType ) { return streamType == STREAM_TYPE_OA; }
+
+        // Stream group:
+        virtual IInternalIoStreamGroup* CreateIoStreamGroup() { return nullptr; }
+
+        // Side-band:
+        virtual IInternalSideBandSampler* CreateSideBandSampler( const TSideBandSamplerParams& params ) { return nullptr; }
+
+        // Overrides:
+        virtual TCompletionCode SetFrequencyOverride( const TSetFrequencyOverrideParams_1_2* params ) { return CC_ERROR_NOT_SUPPORTED; }
+        virtual TCompletionCode SetQueryOverride( TOverrideType overrideType, uint32_t oaBufferSize, const TSetQueryOverrideParams_1_2* params ) { return CC_ERROR_NOT_SUPPORTED; }
+        virtual TCompletionCode SetFreqChangeReportsOverride( bool enable ) { return CC_ERROR_NOT_SUPPORTED; }
+        virtual bool            IsOverrideAvailable( TOverrideType overrideType ) { return false; }
+        virtual bool            IsSubDeviceSupported() { return false; }
+
+    protected:
+        virtual bool CreateContext() { return true; }
+        virtual void DeleteContext() {}
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CTestDevice
+    //
+    // Description:
+    //     Metrics device on the fake driver interface with an OA concurrent group
+    //     of two metric sets sharing the report format.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CTestDevice
+    {
+    public:
+        CTestDevice()
+            : m_adapterGroup()
+            , m_adapter( nullptr )
+            , m_driverInterface()
+            , m_device( nullptr )
+            , m_group( nullptr )
+            , m_setA( nullptr )
+            , m_setB( nullptr )
+        {
+            TAdapterParamsLatest adapterParams = {};
+
+            // No DRM device behind the handle, the adapter does not create a driver interface
+            m_adapter = new( std::nothrow ) CAdapter( m_adapterGroup, adapterParams, *new( std::nothrow ) CAdapterHandleLinux( -1 ) );
+            m_device  = new( std::nothrow ) CMetricsDevice( *m_adapter, m_driverInterface );
+            m_device->GetSymbolSet().AddSymbolUINT32( "GpuTimestampFrequency", TEST_TIMESTAMP_FREQUENCY, SYMBOL_TYPE_IMMEDIATE );
+
+            uint8_t          platformMaskByteArray[MD_PLATFORM_MASK_BYTE_ARRAY_SIZE] = {};
+            TByteArrayLatest platformMask                                            = { MD_PLATFORM_MASK_BYTE_ARRAY_SIZE, platformMaskByteArray };
+
+            SetPlatformMask( m_adapter->GetAdapterId(), &platformMask, nullptr, false, GENERATION_TGL );
+
+            m_group = new( std::nothrow ) COAConcurrentGroup( *m_device, "OA", "OA Unit Metrics", MEASUREMENT_TYPE_SNAPSHOT_IO );
+            m_setA  = m_group->AddMetricSet( "TestA", "Test Set A", API_TYPE_IOSTREAM, GPU_RENDER, TEST_REPORT_SIZE, TEST_REPORT_SIZE, TEST_REPORT_TYPE, &platformMask );
+            m_setB  = m_group->AddMetricSet( "TestB", "Test Set B", API_TYPE_IOSTREAM, GPU_RENDER, TEST_REPORT_SIZE, TEST_REPORT_SIZE, TEST_REPORT_TYPE, &platformMask );
+        }
+
+        ~CTestDevice()
+        {
+            MD_SAFE_DELETE( m_group );
+            MD_SAFE_DELETE( m_device );
+            MD_SAFE_DELETE( m_adapter );
+        }
+
+        bool IsValid() const
+        {
+            return m_setA != nullptr && m_setB != nullptr;
+        }
+
+        TCompletionCode Open()
+        {
+            uint32_t nsTimerPeriod = 100 * MD_NSEC_PER_USEC;
+            uint32_t oaBufferSize  = 0;
+
+            return m_group->OpenIoStream( m_setA, 0, &nsTimerPeriod, &oaBufferSize );
+        }
+
+        // Reads reports with the given timestamps and returns their metric sets.
+        std::vector<IMetricSetLatest*> Read( const std::vector<uint32_t>& timestamps )
+        {
+            std::vector<char>              reports( timestamps.size() * TEST_REPORT_SIZE );
+            std::vector<IMetricSetLatest*> metricSets;
+            uint32_t                       reportCount = timestamps.size();
+
+            m_driverInterface.m_reportTimestamps = timestamps;
+
+            if( m_group->ReadIoStream( &reportCount, reports.data(), 0 ) == CC_OK )
+            {
+                for( uint32_t i = 0; i < reportCount; ++i )
+                {
+                    metricSets.push_back( GetMetricSet( reports.data() + i * TEST_REPORT_SIZE ) );
+                }
+            }
+
+            m_readReports.insert( m_readReports.end(), reports.begin(), reports.end() );
+            return metricSets;
+        }
+
+        // Returns metric set of a report read before.
+        IMetricSetLatest* GetReadMetricSet( const uint32_t readIndex )
+        {
+            return GetMetricSet( m_readReports.data() + readIndex * TEST_REPORT_SIZE );
+        }
+
+    private:
+        IMetricSetLatest* GetMetricSet( const char* report )
+        {
+            return m_group->GetIoStreamReportMetricSet( reinterpret_cast<const uint8_t*>( report ) );
+        }
+
+    public:
+        CTestAdapterGroup    m_adapterGroup;
+        CAdapter*            m_adapter;
+        CFakeDriverInterface m_driverInterface;
+        CMetricsDevice*      m_device;
+        COAConcurrentGroup*  m_group;
+        CMetricSet*          m_setA;
+        CMetricSet*          m_setB;
+        std::vector<char>    m_readReports; // All reads in order
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestReportsAcrossSwitch
+    //
+    // Description:
+    //     Reports sampled before a switch but read after it keep the previous
+    //     metric set, reports sampled while the switch is programmed have none
+    //     and later ones have the new metric set. Switch to the same metric set
+    //     is not recorded.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestReportsAcrossSwitch()
+    {
+        CTestDevice test;
+        MD_TEST_CHECK_RET( test.IsValid() );
+        MD_TEST_CHECK_RET( test.Open() == CC_OK );
+
+        const uint32_t start = 0x10000000;
+
+        test.m_driverInterface.m_gpuTicks = start + 0x1000;
+
+        auto read = test.Read( { start + 0x100, start + 0x200 } );
+        MD_TEST_CHECK( read.size() == 2 && read[0] == test.m_setA && read[1] == test.m_setA );
+
+        MD_TEST_CHECK_RET( test.m_group->SwitchIoStreamMetricSet( test.m_setB ) == CC_OK );
+        MD_TEST_CHECK( test.m_group->SwitchIoStreamMetricSet( test.m_setB ) == CC_OK );
+        MD_TEST_CHECK( test.m_driverInterface.m_switchCount == 1 );
+        MD_TEST_CHECK( test.m_group->GetIoMetricSet() == test.m_setB );
+
+        read = test.Read( { start + 0x300, start + 0x1000 + TEST_SWITCH_TICKS / 2, start + 0x1000 + TEST_SWITCH_TICKS, start + 0x2000 } );
+        MD_TEST_CHECK( read.size() == 4 );
+        MD_TEST_CHECK( read[0] == test.m_setA );
+        MD_TEST_CHECK( read[1] == nullptr );
+        MD_TEST_CHECK( read[2] == test.m_setB );
+        MD_TEST_CHECK( read[3] == test.m_setB );
+
+        // Reports of the first read are attributed by timestamps now
+        MD_TEST_CHECK( test.GetReadMetricSet( 0 ) == test.m_setA );
+
+        TIoStreamMetricSetSwitch switches[3] = {};
+        uint32_t                 switchCount = 3;
+        MD_TEST_CHECK( test.m_group->GetIoStreamMetricSetSwitches( switches, &switchCount ) == CC_OK );
+        MD_TEST_CHECK_RET( switchCount == 2 );
+        MD_TEST_CHECK( switches[0].MetricSet == test.m_setA );
+        MD_TEST_CHECK( switches[1].MetricSet == test.m_setB );
+        MD_TEST_CHECK( switches[1].GpuTimestampEnd - switches[1].GpuTimestamp == TEST_SWITCH_TICKS );
+
+        MD_TEST_CHECK( test.m_group->CloseIoStream() == CC_OK );
+        MD_TEST_CHECK( test.m_group->GetIoStreamReportMetricSet( reinterpret_cast<const uint8_t*>( test.m_readReports.data() ) ) == nullptr );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestReportsAcrossTimestampWrap
+    //
+    // Description:
+    //     Switches made before and after the 32 bit report timestamp wraps are
+    //     ordered by extended timestamps, and reports of both sides of the wrap
+    //     are attributed to the right switch, also when read later.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestReportsAcrossTimestampWrap()
+    {
+        CTestDevice test;
+        MD_TEST_CHECK_RET( test.IsValid() );
+        MD_TEST_CHECK_RET( test.Open() == CC_OK );
+
+        // Switch to B a few ms before the wrap
+        test.m_driverInterface.m_gpuTicks = TEST_OPEN_TICKS + 0x1000;
+        MD_TEST_CHECK_RET( test.m_group->SwitchIoStreamMetricSet( test.m_setB ) == CC_OK );
+
+        // The timestamp wraps
+        auto read = test.Read( { TEST_OPEN_TICKS + 0x800, TEST_OPEN_TICKS + 0x2000, 0x100, 0x1000 } );
+        MD_TEST_CHECK( read.size() == 4 );
+        MD_TEST_CHECK( read[0] == test.m_setA );
+        MD_TEST_CHECK( read[1] == test.m_setB );
+        MD_TEST_CHECK( read[2] == test.m_setB );
+        MD_TEST_CHECK( read[3] == test.m_setB );
+
+        // Switch back to A after the wrap
+        test.m_driverInterface.m_gpuTicks = ( 1ULL << 32 ) + 0x2000;
+        MD_TEST_CHECK_RET( test.m_group->SwitchIoStreamMetricSet( test.m_setA ) == CC_OK );
+
+        read = test.Read( { 0x1800, 0x2000 + TEST_SWITCH_TICKS / 2, 0x3000 } );
+        MD_TEST_CHECK( read.size() == 3 );
+        MD_TEST_CHECK( read[0] == test.m_setB );
+        MD_TEST_CHECK( read[1] == nullptr );
+        MD_TEST_CHECK( read[2] == test.m_setA );
+
+        // Reports read before the wrap and the second switch
+        MD_TEST_CHECK( test.GetReadMetricSet( 0 ) == test.m_setA );
+        MD_TEST_CHECK( test.GetReadMetricSet( 1 ) == test.m_setB );
+        MD_TEST_CHECK( test.GetReadMetricSet( 3 ) == test.m_setB );
+
+        TIoStreamMetricSetSwitch switches[3] = {};
+        uint32_t                 switchCount = 3;
+        MD_TEST_CHECK( test.m_group->GetIoStreamMetricSetSwitches( switches, &switchCount ) == CC_OK );
+        MD_TEST_CHECK_RET( switchCount == 3 );
+        MD_TEST_CHECK( switches[2].GpuTimestamp > switches[1].GpuTimestampEnd );
+        MD_TEST_CHECK( switches[2].GpuTimestamp - switches[1].GpuTimestamp == 0x2000 + 0x10000 - 0x1000 );
+    }
+} // namespace
+
+int main()
+{
+    MD_TEST_RUN( TestReportsAcrossSwitch );
+    MD_TEST_RUN( TestReportsAcrossTimestampWrap );
+
+    return MD_TEST_RESULT();
+}
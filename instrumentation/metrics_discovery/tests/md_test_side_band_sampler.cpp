@@ -0,0 +1,305 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_test_side_band_sampler.cpp
+
+//     Abstract:   C++ Metrics Discovery test of the Linux side-band sampler
+
+#include "md_test.h"
+
+#include "md_side_band_sampler_linux.h"
+#include "md_utils.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace MetricsDiscoveryInternal;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Sampling parameters of the test and the longest wait for samples.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define TEST_PERIOD_US       MD_SIDE_BAND_MIN_PERIOD_US
+#define TEST_SAMPLE_COUNT    8
+#define TEST_WAIT_TIMEOUT_MS 5000
+
+namespace
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CFakeSysFs
+    //
+    // Description:
+    //     Temporary directory laid out as the SysFs directory of a DRM card.
+    //     Files and directories are removed with it.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CFakeSysFs
+    {
+    public:
+        CFakeSysFs()
+            : m_directory()
+            , m_paths()
+        {
+            char directory[] = "/tmp/md_test_sysfs_XXXXXX";
+
+            if( mkdtemp( directory ) != nullptr )
+            {
+                m_directory = directory;
+            }
+        }
+
+        ~CFakeSysFs()
+        {
+            for( auto it = m_paths.rbegin(); it != m_paths.rend(); ++it )
+            {
+                remove( it->c_str() );
+            }
+
+            if( !m_directory.empty() )
+            {
+                rmdir( m_directory.c_str() );
+            }
+        }
+
+        bool IsValid() const
+        {
+            return !m_directory.empty();
+        }
+
+        const char* GetDirectory() const
+        {
+            return m_directory.c_str();
+        }
+
+        // Creates or rewrites the file, with its parent directories.
+        bool Write( const std::string& file, const uint64_t value )
+        {
+            for( size_t slash = file.find( '/' ); slash != std::string::npos; slash = file.find( '/', slash + 1 ) )
+            {
+                const std::string directory = m_directory + "/" + file.substr( 0, slash );
+
+                if( mkdir( directory.c_str(), 0755 ) == 0 )
+                {
+                    m_paths.push_back( directory );
+                }
+            }
+
+            const std::string path     = m_directory + "/" + file;
+            const bool        existing = access( path.c_str(), F_OK ) == 0;
+
+            // Truncated, not replaced, as SysFs files keep their inode
+            FILE* stream = fopen( path.c_str(), "w" );
+            if( stream == nullptr )
+            {
+                return false;
+            }
+
+            if( !existing )
+            {
+                m_paths.push_back( path );
+            }
+
+            const bool written = fprintf( stream, "%llu\n", static_cast<unsigned long long>( value ) ) > 0;
+            return fclose( stream ) == 0 && written;
+        }
+
+    private:
+        std::string              m_directory;
+        std::vector<std::string> m_paths; // In creation order
+    };
+
+    // Samples until the given count of samples is kept, then stops.
+    bool Sample( CSideBandSamplerLinux& sampler, const uint32_t sampleCount )
+    {
+        const auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds( TEST_WAIT_TIMEOUT_MS );
+        uint32_t   count   = 0;
+
+        if( sampler.Start() != CC_OK )
+        {
+            return false;
+        }
+
+        while( count < sampleCount && std::chrono::steady_clock::now() < timeout )
+        {
+            std::this_thread::sleep_for( std::chrono::microseconds( TEST_PERIOD_US ) );
+            sampler.GetSamples( 0, UINT64_MAX, nullptr, &count );
+        }
+
+        return sampler.Stop() == CC_OK && count >= sampleCount;
+    }
+
+    // Returns all kept samples.
+    std::vector<TSideBandSample> GetSamples( CSideBandSamplerLinux& sampler )
+    {
+        uint32_t count = 0;
+        sampler.GetSamples( 0, UINT64_MAX, nullptr, &count );
+
+        std::vector<TSideBandSample> samples( count );
+        sampler.GetSamples( 0, UINT64_MAX, samples.data(), &count );
+        samples.resize( count );
+
+        return samples;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestDefaultAttributes
+    //
+    // Description:
+    //     Default attributes are resolved in the card directory, including
+    //     the hwmon glob. A missing attribute keeps its index and is invalid in
+    //     every sample. Rewritten files are read again by the kept open files.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestDefaultAttributes()
+    {
+        CFakeSysFs sysFs;
+        MD_TEST_CHECK_RET( sysFs.IsValid() );
+        MD_TEST_CHECK_RET( sysFs.Write( "gt_act_freq_mhz", 1100 ) );
+        MD_TEST_CHECK_RET( sysFs.Write( "power/rc6_residency_ms", 5000 ) );
+        MD_TEST_CHECK_RET( sysFs.Write( "device/hwmon/hwmon3/energy1_input", 123456 ) );
+
+        TSideBandSamplerParams params = {};
+        params.PeriodUs               = TEST_PERIOD_US;
+
+        CSideBandSamplerLinux sampler( 0, params );
+        MD_TEST_CHECK_RET( sampler.Initialize( sysFs.GetDirectory() ) == CC_OK );
+        MD_TEST_CHECK( sampler.GetAttributeCount() == MD_SIDE_BAND_DEFAULT_ATTRIBUTE_COUNT );
+        MD_TEST_CHECK( std::string( sampler.GetAttributeName( 0 ) ) == "gt_act_freq_mhz" );
+        MD_TEST_CHECK( sampler.GetAttributeName( MD_SIDE_BAND_DEFAULT_ATTRIBUTE_COUNT ) == nullptr );
+
+        MD_TEST_CHECK_RET( Sample( sampler, 2 ) );
+
+        auto samples = GetSamples( sampler );
+        MD_TEST_CHECK_RET( samples.size() >= 2 );
+
+        for( size_t i = 0; i < samples.size(); ++i )
+        {
+            MD_TEST_CHECK( samples[i].ValidMask == 0xB ); // Throttle reasons missing
+            MD_TEST_CHECK( samples[i].Values[0] == 1100 );
+            MD_TEST_CHECK( samples[i].Values[1] == 5000 );
+            MD_TEST_CHECK( samples[i].Values[3] == 123456 );
+            MD_TEST_CHECK( i == 0 || samples[i].CpuTimestampNs > samples[i - 1].CpuTimestampNs );
+        }
+
+        const size_t oldCount = samples.size();
+        MD_TEST_CHECK_RET( sysFs.Write( "gt_act_freq_mhz", 300 ) );
+        MD_TEST_CHECK_RET( Sample( sampler, oldCount + 1 ) );
+
+        samples = GetSamples( sampler );
+        MD_TEST_CHECK_RET( samples.size() > oldCount );
+        MD_TEST_CHECK( samples[oldCount - 1].Values[0] == 1100 );
+        MD_TEST_CHECK( samples.back().Values[0] == 300 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestSampleRing
+    //
+    // Description:
+    //     Only the newest samples are kept. Samples are found by CPU time:
+    //     a time range is inclusive, a sample at a time is the newest one not
+    //     later than the time and there is none before the oldest sample.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestSampleRing()
+    {
+        CFakeSysFs sysFs;
+        MD_TEST_CHECK_RET( sysFs.IsValid() );
+        MD_TEST_CHECK_RET( sysFs.Write( "gt_act_freq_mhz", 1100 ) );
+
+        TSideBandSamplerParams params = {};
+        params.PeriodUs               = TEST_PERIOD_US;
+        params.SampleCount            = TEST_SAMPLE_COUNT;
+        params.AttributeCount         = 2;
+        params.Attributes[0]          = "missing";
+        params.Attributes[1]          = "gt_act_freq_mhz";
+
+        CSideBandSamplerLinux sampler( 0, params );
+        MD_TEST_CHECK_RET( sampler.Initialize( sysFs.GetDirectory() ) == CC_OK );
+
+        MD_TEST_CHECK_RET( Sample( sampler, TEST_SAMPLE_COUNT ) );
+
+        const uint64_t  newestCpuNs = GetSamples( sampler ).back().CpuTimestampNs;
+        const auto      timeout     = std::chrono::steady_clock::now() + std::chrono::milliseconds( TEST_WAIT_TIMEOUT_MS );
+        TSideBandSample sample      = {};
+
+        // Until the whole ring is overwritten
+        MD_TEST_CHECK_RET( sampler.Start() == CC_OK );
+        while( sampler.GetSampleAt( newestCpuNs, &sample ) == CC_OK && std::chrono::steady_clock::now() < timeout )
+        {
+            std::this_thread::sleep_for( std::chrono::microseconds( TEST_PERIOD_US ) );
+        }
+        MD_TEST_CHECK_RET( sampler.Stop() == CC_OK );
+
+        auto samples = GetSamples( sampler );
+        MD_TEST_CHECK_RET( samples.size() == TEST_SAMPLE_COUNT );
+        MD_TEST_CHECK( samples[0].CpuTimestampNs > newestCpuNs );
+
+        for( size_t i = 0; i < samples.size(); ++i )
+        {
+            MD_TEST_CHECK( samples[i].ValidMask == 0x2 );
+            MD_TEST_CHECK( samples[i].Values[1] == 1100 );
+            MD_TEST_CHECK( i == 0 || samples[i].CpuTimestampNs > samples[i - 1].CpuTimestampNs );
+        }
+
+        TSideBandSample samplesInRange[TEST_SAMPLE_COUNT] = {};
+        uint32_t        count                             = TEST_SAMPLE_COUNT;
+        MD_TEST_CHECK( sampler.GetSamples( samples[2].CpuTimestampNs, samples[5].CpuTimestampNs, samplesInRange, &count ) == CC_OK );
+        MD_TEST_CHECK( count == 4 );
+        MD_TEST_CHECK( samplesInRange[0].CpuTimestampNs == samples[2].CpuTimestampNs );
+
+        MD_TEST_CHECK( sampler.GetSampleAt( samples[3].CpuTimestampNs, &sample ) == CC_OK && sample.CpuTimestampNs == samples[3].CpuTimestampNs );
+        MD_TEST_CHECK( sampler.GetSampleAt( samples[3].CpuTimestampNs - 1, &sample ) == CC_OK && sample.CpuTimestampNs == samples[2].CpuTimestampNs );
+        MD_TEST_CHECK( sampler.GetSampleAt( UINT64_MAX, &sample ) == CC_OK && sample.CpuTimestampNs == samples.back().CpuTimestampNs );
+        MD_TEST_CHECK( sampler.GetSampleAt( samples[0].CpuTimestampNs - 1, &sample ) != CC_OK );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestNoAttributes
+    //
+    // Description:
+    //     Initialization fails without any readable attribute or directory.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestNoAttributes()
+    {
+        CFakeSysFs sysFs;
+        MD_TEST_CHECK_RET( sysFs.IsValid() );
+
+        TSideBandSamplerParams params = {};
+
+        CSideBandSamplerLinux sampler( 0, params );
+        MD_TEST_CHECK( sampler.Initialize( sysFs.GetDirectory() ) == CC_ERROR_FILE_NOT_FOUND );
+
+        CSideBandSamplerLinux noDirectory( 0, params );
+        MD_TEST_CHECK( noDirectory.Initialize( "/nonexistent" ) != CC_OK );
+    }
+} // namespace
+
+int main()
+{
+    MD_TEST_RUN( TestDefaultAttributes );
+    MD_TEST_RUN( TestSampleRing );
+    MD_TEST_RUN( TestNoAttributes );
+
+    return MD_TEST_RESULT();
+}
@@ -0,0 +1,252 @@
+/*========================== begin_copyright_notice ============================
+
+Copyright (C) 2024 Intel Corporation
+
+SPDX-License-Identifier: MIT
+
+============================= end_copyright_notice ===========================*/
+
+//     File Name:  md_test_timestamp_correlation.cpp
+
+//     Abstract:   C++ Metrics Discovery test of GPU to CPU timestamp correlation
+
+#include "md_test.h"
+
+#include "md_timestamp_correlation.h"
+#include "md_utils.h"
+
+#include <cmath>
+
+using namespace MetricsDiscoveryInternal;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// Description:
+//     Simulated clocks: GPU timestamp frequency, 32 bit timestamps wrap every
+//     ~358 s, CPU time the clocks start at, sampling jitter and the accepted
+//     conversion error on top of the model error bound.
+//
+//////////////////////////////////////////////////////////////////////////////
+#define TEST_TIMESTAMP_FREQUENCY 12000000
+#define TEST_START_CPU_NS        ( 1000 * MD_SECOND_IN_NS )
+#define TEST_JITTER_NS           50
+#define TEST_TOLERANCE_NS        100
+
+namespace
+{
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Class:
+    //     CSimulatedClock
+    //
+    // Description:
+    //     GPU timestamp counter running off the CPU clock with a constant drift.
+    //     GPU ticks are unwrapped, only their low 32 bits are sampled.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    class CSimulatedClock
+    {
+    public:
+        CSimulatedClock( const uint64_t startTicks, const double driftPpm )
+            : m_startTicks( startTicks )
+            , m_ticksPerNs( TEST_TIMESTAMP_FREQUENCY * ( 1.0 + driftPpm / 1000000.0 ) / MD_SECOND_IN_NS )
+        {
+        }
+
+        uint64_t GetTicks( const uint64_t cpuNs ) const
+        {
+            return m_startTicks + static_cast<uint64_t>( std::llround( ( cpuNs - TEST_START_CPU_NS ) * m_ticksPerNs ) );
+        }
+
+        uint64_t GetCpuNs( const uint64_t ticks ) const
+        {
+            return TEST_START_CPU_NS + static_cast<uint64_t>( std::llround( ( ticks - m_startTicks ) / m_ticksPerNs ) );
+        }
+
+        // Adds samples taken every interval, CPU time of odd ones is read late.
+        void AddSamples( CTimestampCorrelation& correlation, const uint32_t count, const uint64_t intervalNs )
+        {
+            for( uint32_t i = 0; i < count; ++i, m_cpuNs += intervalNs )
+            {
+                correlation.AddSample( GetTicks( m_cpuNs ), m_cpuNs + ( i % 2 ) * TEST_JITTER_NS, m_cpuNs );
+            }
+        }
+
+        uint64_t GetLastCpuNs() const
+        {
+            return m_cpuNs;
+        }
+
+    private:
+        const uint64_t m_startTicks;
+        const double   m_ticksPerNs;
+        uint64_t       m_cpuNs = TEST_START_CPU_NS;
+    };
+
+    // Checks conversion of the given unwrapped GPU ticks, using only their low 32 bits.
+    bool IsConverted( const CTimestampCorrelation& correlation, const CSimulatedClock& clock, const uint64_t ticks, const uint64_t errorBoundNs )
+    {
+        const int64_t error = static_cast<int64_t>( correlation.GpuTicksToCpuNs( ticks & MD_GPU_TIMESTAMP_MASK_32 ) - clock.GetCpuNs( ticks ) );
+
+        return static_cast<uint64_t>( std::llabs( error ) ) <= errorBoundNs + TEST_TOLERANCE_NS;
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestSampling
+    //
+    // Description:
+    //     Samples are ignored until the frequency is known and rate limited
+    //     afterwards. A frequency change drops the model.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestSampling()
+    {
+        CTimestampCorrelation      correlation;
+        CSimulatedClock            clock( 0x1000, 0.0 );
+        TTimestampCorrelationModel model = {};
+        TTimestampCorrelationInfo  info  = {};
+
+        clock.AddSamples( correlation, 1, 0 );
+        MD_TEST_CHECK( !correlation.GetModel( model ) );
+        MD_TEST_CHECK( correlation.GpuTicksToCpuNs( 0x1000 ) == 0 );
+
+        correlation.SetFrequency( TEST_TIMESTAMP_FREQUENCY );
+        MD_TEST_CHECK( correlation.IsSampleNeeded( TEST_START_CPU_NS ) );
+
+        clock.AddSamples( correlation, 1, MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS );
+        MD_TEST_CHECK( correlation.GetModel( model ) );
+        MD_TEST_CHECK( !correlation.IsSampleNeeded( TEST_START_CPU_NS + MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS - 1 ) );
+        MD_TEST_CHECK( correlation.IsSampleNeeded( TEST_START_CPU_NS + MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS ) );
+
+        // A single sample uses the nominal period
+        MD_TEST_CHECK( correlation.GpuTicksToCpuNs( 0x1000 + TEST_TIMESTAMP_FREQUENCY ) == TEST_START_CPU_NS + MD_SECOND_IN_NS );
+
+        // Samples not newer than the newest one are ignored
+        correlation.AddSample( 0x2000, TEST_START_CPU_NS, TEST_START_CPU_NS + MD_SECOND_IN_NS );
+        correlation.GetInfo( info );
+        MD_TEST_CHECK( info.SampleCount == 1 );
+        MD_TEST_CHECK( info.LastSampleCpuNs == TEST_START_CPU_NS );
+
+        correlation.SetFrequency( TEST_TIMESTAMP_FREQUENCY );
+        MD_TEST_CHECK( correlation.GetModel( model ) );
+
+        correlation.SetFrequency( TEST_TIMESTAMP_FREQUENCY / 2 );
+        correlation.GetInfo( info );
+        MD_TEST_CHECK( !correlation.GetModel( model ) );
+        MD_TEST_CHECK( info.SampleCount == 0 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestConversionAcrossWrap
+    //
+    // Description:
+    //     Samples taken across the 32 bit GPU timestamp wrap are unwrapped and
+    //     timestamps on both sides of the wrap convert to continuous CPU time.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestConversionAcrossWrap()
+    {
+        CTimestampCorrelation correlation;
+        CSimulatedClock       clock( 0xFFF00000, 0.0 ); // ~87 ms before the wrap
+
+        correlation.SetFrequency( TEST_TIMESTAMP_FREQUENCY );
+        clock.AddSamples( correlation, MD_TIMESTAMP_CORRELATION_SAMPLES, MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS );
+
+        TTimestampCorrelationInfo info = {};
+        correlation.GetInfo( info );
+        MD_TEST_CHECK_RET( info.SampleCount == MD_TIMESTAMP_CORRELATION_SAMPLES );
+        MD_TEST_CHECK( info.ErrorBoundNs <= TEST_JITTER_NS );
+
+        for( const uint64_t ticks : { 0xFFF00000ULL, 0xFFFFFFFFULL, 1ULL << 32, ( 1ULL << 32 ) + TEST_TIMESTAMP_FREQUENCY } )
+        {
+            MD_TEST_CHECK( IsConverted( correlation, clock, ticks, info.ErrorBoundNs ) );
+        }
+
+        // One tick across the wrap
+        const uint64_t beforeWrapNs = correlation.GpuTicksToCpuNs( 0xFFFFFFFF );
+        const uint64_t afterWrapNs  = correlation.GpuTicksToCpuNs( 0 );
+        MD_TEST_CHECK( afterWrapNs > beforeWrapNs && afterWrapNs - beforeWrapNs < 100 );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestDrift
+    //
+    // Description:
+    //     The fitted period follows GPU clock drift, so timestamps a second
+    //     from the newest sample still convert within the error bound. Drift
+    //     above the limit is treated as a bad fit and the nominal period is used.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestDrift()
+    {
+        const double   nominalNsPerTick = static_cast<double>( MD_SECOND_IN_NS ) / TEST_TIMESTAMP_FREQUENCY;
+        const double   driftPpm         = 200.0;
+        const uint64_t startTicks       = ( 1ULL << 32 ) - 8 * TEST_TIMESTAMP_FREQUENCY / 10;
+
+        CTimestampCorrelation     correlation;
+        CSimulatedClock           clock( startTicks, driftPpm );
+        TTimestampCorrelationInfo info = {};
+
+        correlation.SetFrequency( TEST_TIMESTAMP_FREQUENCY );
+        clock.AddSamples( correlation, MD_TIMESTAMP_CORRELATION_SAMPLES, MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS );
+        correlation.GetInfo( info );
+
+        MD_TEST_CHECK( std::fabs( info.NsPerGpuTick - nominalNsPerTick / ( 1.0 + driftPpm / 1000000.0 ) ) < nominalNsPerTick * 1e-6 );
+
+        // Nominal period would be off by 200 us here
+        const uint64_t laterTicks = clock.GetTicks( clock.GetLastCpuNs() + MD_SECOND_IN_NS );
+        MD_TEST_CHECK( IsConverted( correlation, clock, laterTicks, info.ErrorBoundNs ) );
+
+        CTimestampCorrelation bad;
+        CSimulatedClock       badClock( startTicks, 5 * MD_TIMESTAMP_CORRELATION_MAX_DRIFT_PPM );
+
+        bad.SetFrequency( TEST_TIMESTAMP_FREQUENCY );
+        badClock.AddSamples( bad, MD_TIMESTAMP_CORRELATION_SAMPLES, MD_TIMESTAMP_CORRELATION_MIN_INTERVAL_NS );
+        bad.GetInfo( info );
+
+        MD_TEST_CHECK( info.NsPerGpuTick == nominalNsPerTick );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////
+    //
+    // Test:
+    //     TestSparseSamples
+    //
+    // Description:
+    //     Samples further apart than the 32 bit wrap period are unwrapped with
+    //     the GPU time predicted from the elapsed CPU time.
+    //
+    //////////////////////////////////////////////////////////////////////////////
+    void TestSparseSamples()
+    {
+        CTimestampCorrelation     correlation;
+        CSimulatedClock           clock( 0x80000000, 100.0 );
+        TTimestampCorrelationInfo info = {};
+
+        correlation.SetFrequency( TEST_TIMESTAMP_FREQUENCY );
+        clock.AddSamples( correlation, 4, 500 * MD_SECOND_IN_NS );
+        correlation.GetInfo( info );
+
+        MD_TEST_CHECK( info.SampleCount == 4 );
+        MD_TEST_CHECK( info.ErrorBoundNs <= TEST_JITTER_NS );
+
+        // Ten seconds after the newest sample
+        MD_TEST_CHECK( IsConverted( correlation, clock, clock.GetTicks( clock.GetLastCpuNs() - 490 * MD_SECOND_IN_NS ), info.ErrorBoundNs ) );
+    }
+} // namespace
+
+int main()
+{
+    MD_TEST_RUN( TestSampling );
+    MD_TEST_RUN( TestConversionAcrossWrap );
+    MD_TEST_RUN( TestDrift );
+    MD_TEST_RUN( TestSparseSamples );
+
+    return MD_TEST_RESULT();
+}
@@ -65,6 +65,7 @@ extern "C"
     // Files
     bool   iu_fopen_s( FILE** pFile, const char* filename, const char* mode );
     size_t iu_fread_s( void* buff, size_t buffSize, size_t elemSize, size_t count, FILE* stream );
+    bool   iu_fdirect( FILE* stream, bool enable );
 
     // Environment variable
     const char* iu_dupenv_s( const char* varName );
@@ -24,6 +24,8 @@ SPDX-License-Identifier: MIT
 #include <memory.h>
 #include <syslog.h>
 
+#include <fcntl.h>
+
 extern "C"
 {
     ///////////////////////////////////////////////////////////////////////////////
@@ -796,6 +798,44 @@ extern "C"
         return fread( buff, elemSize, count, stream );
     }
 
+    ///////////////////////////////////////////////////////////////////////////////
+    //
+    // Group:
+    //     Instrumentation Utils Standard OS Specific Functions
+    //
+    // Method:
+    //     iu_fdirect
+    //
+    // Description:
+    //     Enables or disables direct IO (O_DIRECT) for the opened file. With
+    //     direct IO enabled, writes must use aligned buffers, sizes and offsets.
+    //
+    // Input:
+    //     FILE* stream - file
+    //     bool  enable - true to bypass the page cache
+    //
+    // Output:
+    //     bool - false if not supported, e.g. by the file system
+    //
+    ///////////////////////////////////////////////////////////////////////////////
+    bool iu_fdirect( FILE* stream, bool enable )
+    {
+        if( stream == NULL )
+        {
+            IU_ASSERT( false );
+            return false;
+        }
+
+        const int32_t fd    = fileno( stream );
+        const int32_t flags = fcntl( fd, F_GETFL );
+        if( flags < 0 )
+        {
+            return false;
+        }
+
+        return fcntl( fd, F_SETFL, enable ? ( flags | O_DIRECT ) : ( flags & ~O_DIRECT ) ) == 0;
+    }
+
     ///////////////////////////////////////////////////////////////////////////////
     //
     // Group: